@@ -462,9 +462,13 @@
         'callback_unittest.nc',
         'cancelable_callback_unittest.cc',
         'command_line_unittest.cc',
+        'containers/btree_map_unittest.cc',
+        'containers/btree_map_unittest.nc',
+        'containers/flat_hash_map_unittest.cc',
         'containers/hash_tables_unittest.cc',
         'containers/linked_list_unittest.cc',
         'containers/mru_cache_unittest.cc',
+        'containers/sharded_mru_cache_unittest.cc',
         'containers/small_map_unittest.cc',
         'containers/stack_container_unittest.cc',
         'cpu_unittest.cc',
@@ -484,6 +488,7 @@
         'file_version_info_unittest.cc',
         'files/dir_reader_posix_unittest.cc',
         'files/file_path_unittest.cc',
+        'files/file_tree_walker_unittest.cc',
         'files/file_unittest.cc',
         'files/file_util_proxy_unittest.cc',
         'files/important_file_writer_unittest.cc',
@@ -589,6 +594,7 @@
         'strings/nullable_string16_unittest.cc',
         'strings/safe_sprintf_unittest.cc',
         'strings/string16_unittest.cc',
+        'strings/string_atom_unittest.cc',
         'strings/stringprintf_unittest.cc',
         'strings/string_number_conversions_unittest.cc',
         'strings/string_piece_unittest.cc',
@@ -604,6 +610,7 @@
         'synchronization/cancellation_flag_unittest.cc',
         'synchronization/condition_variable_unittest.cc',
         'synchronization/lock_unittest.cc',
+        'synchronization/read_write_lock_unittest.cc',
         'synchronization/waitable_event_unittest.cc',
         'synchronization/waitable_event_watcher_unittest.cc',
         'sys_info_unittest.cc',
@@ -833,6 +840,21 @@
         'i18n/streaming_utf8_validator_perftest.cc',
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': '<(gtest_target_type)',
+      'dependencies': [
+        'test_support_base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+        'base',
+      ],
+      'sources': [
+        'containers/containers_perftest.cc',
+        'containers/sharded_mru_cache_perftest.cc',
+        'values_perftest.cc',
+      ],
+    },
     {
       'target_name': 'test_support_base',
       'type': 'static_library',
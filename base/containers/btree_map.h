@@ -0,0 +1,719 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_BTREE_MAP_H_
+#define BASE_CONTAINERS_BTREE_MAP_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+
+namespace base {
+
+// An ordered map implemented as a B+tree: the elements are stored in sorted
+// arrays in the leaves of the tree, and the internal nodes only contain
+// copies of keys to guide the search. Each node holds around 256 bytes of
+// elements, so the tree is a few levels deep, a lookup touches a few cache
+// lines instead of one per level of a red-black tree, iterating is a linear
+// scan of the leaves, and the per element overhead is small.
+//
+// The interface is a subset of std::map's, with these differences:
+//  - Inserting and erasing move the other elements of the affected nodes,
+//    which invalidates all iterators and pointers to elements. erase()
+//    returns an iterator to the next element to allow erasing while
+//    iterating.
+//  - Key must be default constructible and assignable, in addition to being
+//    copyable; Key and Value are copied when elements move.
+//
+// Example:
+//   base::BTreeMap<int, std::string> map;
+//   map[1] = "one";
+//   for (base::BTreeMap<int, std::string>::iterator it = map.begin();
+//        it != map.end(); ) {
+//     if (ShouldRemove(*it))
+//       it = map.erase(it);
+//     else
+//       ++it;
+//   }
+template <typename Key,
+          typename Value,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value> > >
+class BTreeMap {
+ private:
+  struct LeafNode;
+
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const Key, Value> value_type;
+  typedef Compare key_compare;
+  typedef Allocator allocator_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef value_type* pointer;
+  typedef const value_type* const_pointer;
+
+  template <typename Reference, typename Pointer>
+  class Iterator : public std::iterator<std::bidirectional_iterator_tag,
+                                        value_type, ptrdiff_t, Pointer,
+                                        Reference> {
+   public:
+    Iterator() : node_(NULL), position_(0) {}
+    Iterator(LeafNode* node, int position)
+        : node_(node), position_(position) {}
+
+    // Allows converting an iterator to a const_iterator, but not the other
+    // way around, which would allow modifying a const map.  For iterator
+    // itself this is the copy constructor.
+    Iterator(const Iterator<value_type&, value_type*>& other)
+        : node_(other.node()), position_(other.position()) {}
+
+    Reference operator*() const { return node_->values()[position_]; }
+    Pointer operator->() const { return &node_->values()[position_]; }
+
+    Iterator& operator++() {
+      ++position_;
+      // The end iterator is past the last element of the last leaf.
+      if (position_ == node_->count && node_->next) {
+        node_ = node_->next;
+        position_ = 0;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator result(*this);
+      ++(*this);
+      return result;
+    }
+
+    Iterator& operator--() {
+      if (position_ == 0) {
+        node_ = node_->prev;
+        position_ = node_->count;
+      }
+      --position_;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator result(*this);
+      --(*this);
+      return result;
+    }
+
+    template <typename OtherReference, typename OtherPointer>
+    bool operator==(const Iterator<OtherReference, OtherPointer>& other) const {
+      return node_ == other.node() && position_ == other.position();
+    }
+
+    template <typename OtherReference, typename OtherPointer>
+    bool operator!=(const Iterator<OtherReference, OtherPointer>& other) const {
+      return !(*this == other);
+    }
+
+    LeafNode* node() const { return node_; }
+    int position() const { return position_; }
+
+   private:
+    LeafNode* node_;
+    int position_;
+  };
+
+  typedef Iterator<value_type&, value_type*> iterator;
+  typedef Iterator<const value_type&, const value_type*> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  BTreeMap()
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0) {
+  }
+
+  BTreeMap(const BTreeMap& other)
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        compare_(other.compare_),
+        allocator_(other.allocator_) {
+    insert(other.begin(), other.end());
+  }
+
+  ~BTreeMap() {
+    clear();
+  }
+
+  BTreeMap& operator=(const BTreeMap& other) {
+    if (this != &other) {
+      BTreeMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  iterator begin() { return iterator(leftmost_, 0); }
+  iterator end() {
+    return iterator(rightmost_, rightmost_ ? rightmost_->count : 0);
+  }
+  const_iterator begin() const { return const_iterator(leftmost_, 0); }
+  const_iterator end() const {
+    return const_iterator(rightmost_, rightmost_ ? rightmost_->count : 0);
+  }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+
+  key_compare key_comp() const { return compare_; }
+
+  iterator lower_bound(const key_type& key) {
+    return LowerBound(key);
+  }
+  const_iterator lower_bound(const key_type& key) const {
+    return LowerBound(key);
+  }
+
+  iterator upper_bound(const key_type& key) {
+    return UpperBound(key);
+  }
+  const_iterator upper_bound(const key_type& key) const {
+    return UpperBound(key);
+  }
+
+  iterator find(const key_type& key) {
+    iterator it = LowerBound(key);
+    if (it == end() || compare_(key, it->first))
+      return end();
+    return it;
+  }
+
+  const_iterator find(const key_type& key) const {
+    return const_cast<BTreeMap*>(this)->find(key);
+  }
+
+  size_type count(const key_type& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return insert(value_type(key, mapped_type())).first->second;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    if (!root_) {
+      LeafNode* leaf = NewLeaf();
+      root_ = leftmost_ = rightmost_ = leaf;
+    }
+    LeafNode* leaf = FindLeaf(value.first);
+    int position = LeafLowerBound(leaf, value.first);
+    if (position < leaf->count &&
+        !compare_(value.first, leaf->values()[position].first)) {
+      return std::make_pair(iterator(leaf, position), false);
+    }
+    // The leaf has room for one more element than its capacity, so that it
+    // can be split after the insertion.
+    InsertValue(leaf, position, value);
+    ++size_;
+    if (leaf->count <= kLeafSlots)
+      return std::make_pair(iterator(leaf, position), true);
+
+    LeafNode* right = SplitLeaf(leaf);
+    if (position >= leaf->count)
+      return std::make_pair(iterator(right, position - leaf->count), true);
+    return std::make_pair(iterator(leaf, position), true);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  // Returns an iterator to the element following the erased one.
+  iterator erase(iterator position) {
+    LeafNode* leaf = position.node();
+    int index = position.position();
+    DCHECK(leaf);
+    DCHECK_LT(index, leaf->count);
+    RemoveValue(leaf, index);
+    --size_;
+
+    if (leaf == root_) {
+      if (!leaf->count) {
+        DeleteLeaf(leaf);
+        root_ = leftmost_ = rightmost_ = NULL;
+        return end();
+      }
+      return iterator(leaf, index);
+    }
+    if (leaf->count >= kMinLeafSlots) {
+      if (index == leaf->count && leaf->next)
+        return iterator(leaf->next, 0);
+      return iterator(leaf, index);
+    }
+
+    // Rebalancing moves elements across nodes, so find the next element
+    // again afterwards.
+    iterator next(leaf, index);
+    if (index == leaf->count) {
+      if (!leaf->next) {
+        RebalanceLeaf(leaf);
+        return end();
+      }
+      next = iterator(leaf->next, 0);
+    }
+    key_type next_key = next->first;
+    RebalanceLeaf(leaf);
+    return LowerBound(next_key);
+  }
+
+  size_type erase(const key_type& key) {
+    iterator it = find(key);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  void clear() {
+    if (root_)
+      DeleteSubtree(root_);
+    root_ = leftmost_ = rightmost_ = NULL;
+    size_ = 0;
+  }
+
+  void swap(BTreeMap& other) {
+    std::swap(root_, other.root_);
+    std::swap(leftmost_, other.leftmost_);
+    std::swap(rightmost_, other.rightmost_);
+    std::swap(size_, other.size_);
+    std::swap(compare_, other.compare_);
+    std::swap(allocator_, other.allocator_);
+  }
+
+ private:
+  struct InternalNode;
+
+  // Nodes are sized to hold about this many bytes of elements or keys.
+  static const size_t kNodeTargetSize = 256;
+  static const int kLeafSlots =
+      sizeof(value_type) * 4 > kNodeTargetSize ?
+          4 : static_cast<int>(kNodeTargetSize / sizeof(value_type));
+  static const int kInternalSlots =
+      (sizeof(Key) + sizeof(void*)) * 4 > kNodeTargetSize ?
+          4 : static_cast<int>(kNodeTargetSize /
+                               (sizeof(Key) + sizeof(void*)));
+  // Nodes other than the root are kept at least half full.
+  static const int kMinLeafSlots = kLeafSlots / 2;
+  static const int kMinInternalSlots = kInternalSlots / 2;
+
+  struct NodeBase {
+    explicit NodeBase(bool is_leaf)
+        : parent(NULL), position(0), count(0), leaf(is_leaf) {}
+
+    InternalNode* parent;
+    // Index of this node in parent->children.
+    int position;
+    // Number of elements of a leaf, or of keys of an internal node.
+    int count;
+    bool leaf;
+  };
+
+  // Holds count sorted elements. Leaves are linked in order.
+  struct LeafNode : public NodeBase {
+    LeafNode() : NodeBase(true), prev(NULL), next(NULL) {}
+
+    value_type* values() { return storage.template data_as<value_type>(); }
+
+    LeafNode* prev;
+    LeafNode* next;
+    // The elements are constructed in place, so that Value doesn't need to be
+    // default constructible.
+    AlignedMemory<sizeof(value_type) * (kLeafSlots + 1),
+                  ALIGNOF(value_type)> storage;
+  };
+
+  // Holds count keys and count + 1 children. All the keys of children[i] are
+  // less than keys[i], which is less than or equal to all the keys of
+  // children[i + 1]. Erasing may leave keys[i] out of the tree, which
+  // doesn't break this property.
+  struct InternalNode : public NodeBase {
+    InternalNode() : NodeBase(false) {}
+
+    Key keys[kInternalSlots + 1];
+    NodeBase* children[kInternalSlots + 2];
+  };
+
+  typedef typename Allocator::template rebind<LeafNode>::other LeafAllocator;
+  typedef typename Allocator::template rebind<InternalNode>::other
+      InternalAllocator;
+
+  LeafNode* NewLeaf() {
+    LeafNode* leaf = LeafAllocator(allocator_).allocate(1);
+    new (leaf) LeafNode();
+    return leaf;
+  }
+
+  void DeleteLeaf(LeafNode* leaf) {
+    leaf->~LeafNode();
+    LeafAllocator(allocator_).deallocate(leaf, 1);
+  }
+
+  InternalNode* NewInternal() {
+    InternalNode* node = InternalAllocator(allocator_).allocate(1);
+    new (node) InternalNode();
+    return node;
+  }
+
+  void DeleteInternal(InternalNode* node) {
+    node->~InternalNode();
+    InternalAllocator(allocator_).deallocate(node, 1);
+  }
+
+  void DeleteSubtree(NodeBase* node) {
+    if (node->leaf) {
+      LeafNode* leaf = static_cast<LeafNode*>(node);
+      for (int i = 0; i < leaf->count; ++i)
+        leaf->values()[i].~value_type();
+      DeleteLeaf(leaf);
+      return;
+    }
+    InternalNode* internal = static_cast<InternalNode*>(node);
+    for (int i = 0; i <= internal->count; ++i)
+      DeleteSubtree(internal->children[i]);
+    DeleteInternal(internal);
+  }
+
+  // Returns the leaf which contains |key| if it is in the tree. The tree must
+  // not be empty.
+  LeafNode* FindLeaf(const key_type& key) const {
+    NodeBase* node = root_;
+    while (!node->leaf) {
+      InternalNode* internal = static_cast<InternalNode*>(node);
+      int index = static_cast<int>(
+          std::upper_bound(internal->keys, internal->keys + internal->count,
+                           key, compare_) - internal->keys);
+      node = internal->children[index];
+    }
+    return static_cast<LeafNode*>(node);
+  }
+
+  int LeafLowerBound(LeafNode* leaf, const key_type& key) const {
+    int low = 0;
+    int high = leaf->count;
+    value_type* values = leaf->values();
+    while (low < high) {
+      int middle = (low + high) / 2;
+      if (compare_(values[middle].first, key))
+        low = middle + 1;
+      else
+        high = middle;
+    }
+    return low;
+  }
+
+  int LeafUpperBound(LeafNode* leaf, const key_type& key) const {
+    int low = 0;
+    int high = leaf->count;
+    value_type* values = leaf->values();
+    while (low < high) {
+      int middle = (low + high) / 2;
+      if (compare_(key, values[middle].first))
+        high = middle;
+      else
+        low = middle + 1;
+    }
+    return low;
+  }
+
+  // Returns |position| in |leaf|, or the first element of the next leaf if
+  // |position| is past the end of |leaf|.
+  iterator MakeIterator(LeafNode* leaf, int position) const {
+    if (position == leaf->count && leaf->next)
+      return iterator(leaf->next, 0);
+    return iterator(leaf, position);
+  }
+
+  iterator LowerBound(const key_type& key) const {
+    if (!root_)
+      return iterator(NULL, 0);
+    LeafNode* leaf = FindLeaf(key);
+    return MakeIterator(leaf, LeafLowerBound(leaf, key));
+  }
+
+  iterator UpperBound(const key_type& key) const {
+    if (!root_)
+      return iterator(NULL, 0);
+    LeafNode* leaf = FindLeaf(key);
+    return MakeIterator(leaf, LeafUpperBound(leaf, key));
+  }
+
+  // Elements are copied rather than assigned when they move, since their key
+  // is const.
+  static void MoveValue(value_type* from, value_type* to) {
+    new (to) value_type(*from);
+    from->~value_type();
+  }
+
+  void InsertValue(LeafNode* leaf, int position, const value_type& value) {
+    value_type* values = leaf->values();
+    for (int i = leaf->count; i > position; --i)
+      MoveValue(&values[i - 1], &values[i]);
+    new (&values[position]) value_type(value);
+    ++leaf->count;
+  }
+
+  void RemoveValue(LeafNode* leaf, int position) {
+    value_type* values = leaf->values();
+    values[position].~value_type();
+    for (int i = position + 1; i < leaf->count; ++i)
+      MoveValue(&values[i], &values[i - 1]);
+    --leaf->count;
+  }
+
+  // Moves the upper half of the elements of |leaf| to a new leaf, which is
+  // added to the parent of |leaf|. Returns the new leaf.
+  LeafNode* SplitLeaf(LeafNode* leaf) {
+    LeafNode* right = NewLeaf();
+    int middle = leaf->count / 2;
+    value_type* values = leaf->values();
+    for (int i = middle; i < leaf->count; ++i)
+      MoveValue(&values[i], &right->values()[i - middle]);
+    right->count = leaf->count - middle;
+    leaf->count = middle;
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+      leaf->next->prev = right;
+    else
+      rightmost_ = right;
+    leaf->next = right;
+
+    InsertChild(leaf, right->values()[0].first, right);
+    return right;
+  }
+
+  // Inserts |right| after |node| in the parent of |node|, separated by |key|.
+  // Splits the parent if it overflows.
+  void InsertChild(NodeBase* node, const key_type& key, NodeBase* right) {
+    if (node == root_) {
+      InternalNode* root = NewInternal();
+      root->keys[0] = key;
+      root->children[0] = node;
+      root->children[1] = right;
+      root->count = 1;
+      SetChildParent(root, 0);
+      SetChildParent(root, 1);
+      root_ = root;
+      return;
+    }
+
+    InternalNode* parent = node->parent;
+    int position = node->position;
+    for (int i = parent->count; i > position; --i) {
+      parent->keys[i] = parent->keys[i - 1];
+      parent->children[i + 1] = parent->children[i];
+      SetChildParent(parent, i + 1);
+    }
+    parent->keys[position] = key;
+    parent->children[position + 1] = right;
+    SetChildParent(parent, position + 1);
+    ++parent->count;
+    if (parent->count <= kInternalSlots)
+      return;
+
+    // The middle key moves up to the grandparent.
+    InternalNode* new_node = NewInternal();
+    int middle = parent->count / 2;
+    for (int i = middle + 1; i < parent->count; ++i)
+      new_node->keys[i - middle - 1] = parent->keys[i];
+    for (int i = middle + 1; i <= parent->count; ++i) {
+      new_node->children[i - middle - 1] = parent->children[i];
+      SetChildParent(new_node, i - middle - 1);
+    }
+    new_node->count = parent->count - middle - 1;
+    parent->count = middle;
+    InsertChild(parent, parent->keys[middle], new_node);
+  }
+
+  // Removes keys[position] and children[position + 1] from |node|.
+  void RemoveChild(InternalNode* node, int position) {
+    for (int i = position + 1; i < node->count; ++i) {
+      node->keys[i - 1] = node->keys[i];
+      node->children[i] = node->children[i + 1];
+      SetChildParent(node, i);
+    }
+    --node->count;
+  }
+
+  static void SetChildParent(InternalNode* node, int position) {
+    node->children[position]->parent = node;
+    node->children[position]->position = position;
+  }
+
+  // Restores the minimum fill of |leaf| after an element was removed from it,
+  // by taking an element from a sibling or merging with one.
+  void RebalanceLeaf(LeafNode* leaf) {
+    InternalNode* parent = leaf->parent;
+    int position = leaf->position;
+    LeafNode* left = position > 0 ?
+        static_cast<LeafNode*>(parent->children[position - 1]) : NULL;
+    LeafNode* right = position < parent->count ?
+        static_cast<LeafNode*>(parent->children[position + 1]) : NULL;
+
+    if (left && left->count > kMinLeafSlots) {
+      InsertValue(leaf, 0, left->values()[left->count - 1]);
+      RemoveValue(left, left->count - 1);
+      parent->keys[position - 1] = leaf->values()[0].first;
+      return;
+    }
+    if (right && right->count > kMinLeafSlots) {
+      InsertValue(leaf, leaf->count, right->values()[0]);
+      RemoveValue(right, 0);
+      parent->keys[position] = right->values()[0].first;
+      return;
+    }
+
+    // Merge with a sibling, which is at minimum fill.
+    if (left) {
+      MergeLeaves(left, leaf);
+      RemoveChild(parent, position - 1);
+    } else {
+      MergeLeaves(leaf, right);
+      RemoveChild(parent, position);
+    }
+    RebalanceInternal(parent);
+  }
+
+  // Moves the elements of |right| to |left|, and deletes |right|.
+  void MergeLeaves(LeafNode* left, LeafNode* right) {
+    value_type* values = left->values();
+    for (int i = 0; i < right->count; ++i)
+      MoveValue(&right->values()[i], &values[left->count + i]);
+    left->count += right->count;
+
+    left->next = right->next;
+    if (right->next)
+      right->next->prev = left;
+    else
+      rightmost_ = left;
+    DeleteLeaf(right);
+  }
+
+  // Restores the minimum fill of |node| after a child was removed from it.
+  void RebalanceInternal(InternalNode* node) {
+    if (node == root_) {
+      if (!node->count) {
+        root_ = node->children[0];
+        root_->parent = NULL;
+        root_->position = 0;
+        DeleteInternal(node);
+      }
+      return;
+    }
+    if (node->count >= kMinInternalSlots)
+      return;
+
+    InternalNode* parent = node->parent;
+    int position = node->position;
+    InternalNode* left = position > 0 ?
+        static_cast<InternalNode*>(parent->children[position - 1]) : NULL;
+    InternalNode* right = position < parent->count ?
+        static_cast<InternalNode*>(parent->children[position + 1]) : NULL;
+
+    if (left && left->count > kMinInternalSlots) {
+      // Rotate the last child of |left| through the parent.
+      for (int i = node->count; i > 0; --i)
+        node->keys[i] = node->keys[i - 1];
+      for (int i = node->count + 1; i > 0; --i) {
+        node->children[i] = node->children[i - 1];
+        SetChildParent(node, i);
+      }
+      node->keys[0] = parent->keys[position - 1];
+      node->children[0] = left->children[left->count];
+      SetChildParent(node, 0);
+      ++node->count;
+      parent->keys[position - 1] = left->keys[left->count - 1];
+      --left->count;
+      return;
+    }
+    if (right && right->count > kMinInternalSlots) {
+      // Rotate the first child of |right| through the parent.
+      node->keys[node->count] = parent->keys[position];
+      node->children[node->count + 1] = right->children[0];
+      SetChildParent(node, node->count + 1);
+      ++node->count;
+      parent->keys[position] = right->keys[0];
+      for (int i = 1; i < right->count; ++i)
+        right->keys[i - 1] = right->keys[i];
+      for (int i = 1; i <= right->count; ++i) {
+        right->children[i - 1] = right->children[i];
+        SetChildParent(right, i - 1);
+      }
+      --right->count;
+      return;
+    }
+
+    // Merge with a sibling, which is at minimum fill.
+    if (left) {
+      MergeInternals(left, parent->keys[position - 1], node);
+      RemoveChild(parent, position - 1);
+    } else {
+      MergeInternals(node, parent->keys[position], right);
+      RemoveChild(parent, position);
+    }
+    RebalanceInternal(parent);
+  }
+
+  // Appends |key| and the keys and children of |right| to |left|, and deletes
+  // |right|.
+  void MergeInternals(InternalNode* left,
+                      const key_type& key,
+                      InternalNode* right) {
+    left->keys[left->count] = key;
+    for (int i = 0; i < right->count; ++i)
+      left->keys[left->count + 1 + i] = right->keys[i];
+    for (int i = 0; i <= right->count; ++i) {
+      left->children[left->count + 1 + i] = right->children[i];
+      SetChildParent(left, left->count + 1 + i);
+    }
+    left->count += right->count + 1;
+    DeleteInternal(right);
+  }
+
+  NodeBase* root_;
+  // The first and last leaves, for begin() and end().
+  LeafNode* leftmost_;
+  LeafNode* rightmost_;
+  size_t size_;
+  key_compare compare_;
+  allocator_type allocator_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_BTREE_MAP_H_
@@ -0,0 +1,195 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/btree_map.h"
+
+#include <map>
+#include <string>
+
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// A value which isn't default constructible.
+class Value {
+ public:
+  explicit Value(int value) : value_(value) { ++live_count_; }
+  Value(const Value& other) : value_(other.value_) { ++live_count_; }
+  ~Value() { --live_count_; }
+
+  int value() const { return value_; }
+
+  static int live_count() { return live_count_; }
+
+ private:
+  int value_;
+  static int live_count_;
+
+  // Not assignable.
+  void operator=(const Value&);
+};
+
+int Value::live_count_ = 0;
+
+// Checks that iterating |map| forwards and backwards gives the elements of
+// |expected|.
+template <typename Map>
+void ExpectSameContents(const std::map<int, int>& expected, const Map& map) {
+  ASSERT_EQ(expected.size(), map.size());
+  typename Map::const_iterator it = map.begin();
+  for (std::map<int, int>::const_iterator expected_it = expected.begin();
+       expected_it != expected.end(); ++expected_it, ++it) {
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(expected_it->first, it->first);
+    EXPECT_EQ(expected_it->second, it->second);
+  }
+  EXPECT_TRUE(it == map.end());
+
+  typename Map::const_reverse_iterator reverse_it = map.rbegin();
+  for (std::map<int, int>::const_reverse_iterator expected_it =
+           expected.rbegin();
+       expected_it != expected.rend(); ++expected_it, ++reverse_it) {
+    ASSERT_TRUE(reverse_it != map.rend());
+    EXPECT_EQ(expected_it->first, reverse_it->first);
+  }
+  EXPECT_TRUE(reverse_it == map.rend());
+}
+
+}  // namespace
+
+TEST(BTreeMapTest, Basic) {
+  BTreeMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(1) == map.end());
+  EXPECT_TRUE(map.lower_bound(1) == map.end());
+
+  map[2] = "two";
+  map[1] = "one";
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ("one", map.begin()->second);
+  EXPECT_EQ("two", map.find(2)->second);
+  EXPECT_EQ(1u, map.count(1));
+  EXPECT_EQ(0u, map.count(3));
+
+  std::pair<BTreeMap<int, std::string>::iterator, bool> result =
+      map.insert(std::make_pair(1, std::string("uno")));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ("one", result.first->second);
+
+  EXPECT_EQ(1u, map.erase(1));
+  EXPECT_EQ(0u, map.erase(1));
+  EXPECT_EQ(1u, map.size());
+  EXPECT_EQ(2, map.begin()->first);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(BTreeMapTest, Bounds) {
+  BTreeMap<int, int> map;
+  for (int i = 0; i < 1000; i += 2)
+    map[i] = i;
+
+  EXPECT_EQ(0, map.lower_bound(-1)->first);
+  EXPECT_EQ(10, map.lower_bound(10)->first);
+  EXPECT_EQ(12, map.lower_bound(11)->first);
+  EXPECT_EQ(12, map.upper_bound(10)->first);
+  EXPECT_EQ(12, map.upper_bound(11)->first);
+  EXPECT_TRUE(map.lower_bound(999) == map.end());
+  EXPECT_TRUE(map.upper_bound(998) == map.end());
+  EXPECT_TRUE(map.find(11) == map.end());
+}
+
+TEST(BTreeMapTest, EraseWhileIterating) {
+  BTreeMap<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  for (BTreeMap<int, int>::iterator it = map.begin(); it != map.end();) {
+    if (it->first % 3)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  std::map<int, int> expected;
+  for (int i = 0; i < 1000; i += 3)
+    expected[i] = i;
+  ExpectSameContents(expected, map);
+}
+
+// Compares against std::map under random insertions and erasures, which
+// split, merge and rebalance nodes at all levels.
+TEST(BTreeMapTest, MatchesStdMap) {
+  BTreeMap<int, int> map;
+  std::map<int, int> expected;
+  unsigned int random = 1;
+  for (int i = 0; i < 100000; ++i) {
+    random = random * 1103515245 + 12345;
+    int key = (random >> 8) % 5000;
+    // Grow then shrink the map.
+    if ((random >> 4) % 4 < (i < 50000 ? 3u : 1u)) {
+      map[key] = i;
+      expected[key] = i;
+    } else {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+    if (i % 10000 == 0)
+      ExpectSameContents(expected, map);
+  }
+  ExpectSameContents(expected, map);
+
+  while (!expected.empty()) {
+    EXPECT_EQ(1u, map.erase(expected.begin()->first));
+    expected.erase(expected.begin());
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(BTreeMapTest, StringKeys) {
+  BTreeMap<std::string, int> map;
+  for (int i = 0; i < 500; ++i)
+    map[IntToString(i)] = i;
+  EXPECT_EQ("0", map.begin()->first);
+  EXPECT_EQ("99", map.rbegin()->first);
+  EXPECT_EQ(250, map.find("250")->second);
+}
+
+TEST(BTreeMapTest, CopyAndSwap) {
+  BTreeMap<int, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+
+  BTreeMap<int, int> copy(map);
+  copy.erase(0);
+  EXPECT_EQ(100u, map.size());
+  EXPECT_EQ(99u, copy.size());
+
+  BTreeMap<int, int> other;
+  other = copy;
+  EXPECT_EQ(99u, other.size());
+  other.swap(map);
+  EXPECT_EQ(100u, other.size());
+  EXPECT_EQ(1, map.begin()->first);
+}
+
+TEST(BTreeMapTest, NonDefaultConstructibleValues) {
+  {
+    BTreeMap<int, Value> map;
+    for (int i = 0; i < 1000; ++i)
+      map.insert(std::make_pair(i, Value(i)));
+    EXPECT_EQ(1000, Value::live_count());
+    for (int i = 0; i < 1000; i += 2)
+      map.erase(i);
+    EXPECT_EQ(500, Value::live_count());
+    EXPECT_EQ(501, map.find(501)->second.value());
+  }
+  EXPECT_EQ(0, Value::live_count());
+}
+
+}  // namespace base
@@ -0,0 +1,26 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/btree_map.h"
+
+namespace base {
+
+#if defined(NCTEST_CONST_ITERATOR_TO_ITERATOR)  // [r"conversion from"]
+
+void WontCompile() {
+  const BTreeMap<int, int> map;
+  BTreeMap<int, int>::iterator it = map.begin();
+}
+
+#elif defined(NCTEST_CONST_ITERATOR_TO_ITERATOR_CAST)  // [r"no matching function"]
+
+void WontCompile() {
+  const BTreeMap<int, int> map;
+  BTreeMap<int, int>::iterator it =
+      static_cast<BTreeMap<int, int>::iterator>(map.begin());
+}
+
+#endif
+
+}  // namespace base
@@ -0,0 +1,210 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the associative containers of base with the STL ones: the time to
+// insert, look up and iterate over integer keys, and the memory used, for
+// sizes of 8 to 10M elements. Small containers are measured many times over,
+// so that each measurement does at least kMinOperations operations.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/containers/btree_map.h"
+#include "base/containers/flat_hash_map.h"
+#include "base/containers/hash_tables.h"
+#include "base/containers/small_map.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const size_t kMinOperations = 1000000;
+
+// Number of bytes allocated through CountingAllocator.
+size_t g_allocated_bytes = 0;
+
+// Allocator recording the memory used by the containers.
+template <typename T>
+class CountingAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef CountingAllocator<U> other;
+  };
+
+  CountingAllocator() {}
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  pointer allocate(size_type count, const void* hint = NULL) {
+    g_allocated_bytes += count * sizeof(T);
+    return static_cast<pointer>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type count) {
+    g_allocated_bytes -= count * sizeof(T);
+    ::operator delete(p);
+  }
+
+  size_type max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+  void construct(pointer p, const T& value) { new (p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+typedef std::pair<const int, int> IntPair;
+typedef CountingAllocator<IntPair> IntPairAllocator;
+
+typedef std::map<int, int, std::less<int>, IntPairAllocator> StdMap;
+#if defined(COMPILER_MSVC)
+typedef hash_map<int, int, BASE_HASH_NAMESPACE::hash_compare<int>,
+                 IntPairAllocator> HashMap;
+#else
+typedef hash_map<int, int, BASE_HASH_NAMESPACE::hash<int>, std::equal_to<int>,
+                 IntPairAllocator> HashMap;
+#endif
+typedef SmallMap<StdMap> SmallStdMap;
+typedef FlatHashMap<int, int, internal::DefaultFlatHash<int>,
+                    std::equal_to<int>, IntPairAllocator> FlatMap;
+typedef BTreeMap<int, int, std::less<int>, IntPairAllocator> BTree;
+
+// Deterministic pseudo random numbers, so that all runs do the same work.
+class RandomSequence {
+ public:
+  RandomSequence() : state_(1) {}
+
+  uint32 Next() {
+    state_ = state_ * 1103515245 + 12345;
+    return state_ >> 8;
+  }
+
+ private:
+  uint32 state_;
+};
+
+}  // namespace
+
+class ContainersPerfTest : public testing::Test {
+ protected:
+  // Runs the benchmarks of |Map| for all the sizes.
+  template <typename Map>
+  void RunBenchmarks(const std::string& name) {
+    const size_t kSizes[] = { 8, 64, 1024, 64 * 1024, 1024 * 1024,
+                              10 * 1024 * 1024 };
+    for (size_t i = 0; i < arraysize(kSizes); ++i)
+      RunBenchmark<Map>(name, kSizes[i]);
+  }
+
+  // Fills |copies| maps with |size| random keys, then looks up the keys in
+  // another order and iterates over the maps. Reports the time per element
+  // of each phase, and the memory used per element.
+  template <typename Map>
+  void RunBenchmark(const std::string& name, size_t size) {
+    std::vector<int> keys;
+    RandomSequence random;
+    for (size_t i = 0; i < size; ++i)
+      keys.push_back(static_cast<int>(random.Next()));
+    std::vector<int> lookups(keys);
+    std::random_shuffle(lookups.begin(), lookups.end());
+
+    const size_t copies = std::max(static_cast<size_t>(1),
+                                   kMinOperations / size);
+    const double operations = static_cast<double>(copies * size);
+    std::vector<Map> maps(copies);
+    size_t allocated_bytes = g_allocated_bytes;
+
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    for (size_t i = 0; i < copies; ++i) {
+      Map& map = maps[i];
+      for (size_t j = 0; j < size; ++j)
+        map[keys[j]] = static_cast<int>(j);
+    }
+    base::TimeDelta insert_time = base::TimeTicks::HighResNow() - start;
+    allocated_bytes = (g_allocated_bytes - allocated_bytes) / copies;
+
+    // The sums keep the compiler from optimizing the loops away.
+    int64 sum = 0;
+    start = base::TimeTicks::HighResNow();
+    for (size_t i = 0; i < copies; ++i) {
+      const Map& map = maps[i];
+      for (size_t j = 0; j < size; ++j)
+        sum += map.find(lookups[j])->second;
+    }
+    base::TimeDelta lookup_time = base::TimeTicks::HighResNow() - start;
+
+    start = base::TimeTicks::HighResNow();
+    for (size_t i = 0; i < copies; ++i) {
+      const Map& map = maps[i];
+      for (typename Map::const_iterator it = map.begin(); it != map.end();
+           ++it) {
+        sum += it->second;
+      }
+    }
+    base::TimeDelta iterate_time = base::TimeTicks::HighResNow() - start;
+    EXPECT_NE(0, sum);
+
+    const std::string trace = StringPrintf("%d", static_cast<int>(size));
+    perf_test::PrintResult("containers_insert", "_" + name, trace,
+                           insert_time.InMicrosecondsF() * 1000 / operations,
+                           "ns", true);
+    perf_test::PrintResult("containers_lookup", "_" + name, trace,
+                           lookup_time.InMicrosecondsF() * 1000 / operations,
+                           "ns", true);
+    perf_test::PrintResult("containers_iterate", "_" + name, trace,
+                           iterate_time.InMicrosecondsF() * 1000 / operations,
+                           "ns", true);
+    // Keys are random, so a few may be duplicates.
+    perf_test::PrintResult(
+        "containers_memory", "_" + name, trace,
+        static_cast<double>(sizeof(Map) + allocated_bytes) / maps[0].size(),
+        "bytes", true);
+  }
+};
+
+TEST_F(ContainersPerfTest, StdMap) {
+  RunBenchmarks<StdMap>("std_map");
+}
+
+TEST_F(ContainersPerfTest, HashMap) {
+  RunBenchmarks<HashMap>("hash_map");
+}
+
+TEST_F(ContainersPerfTest, SmallMap) {
+  RunBenchmarks<SmallStdMap>("small_map");
+}
+
+TEST_F(ContainersPerfTest, FlatHashMap) {
+  RunBenchmarks<FlatMap>("flat_hash_map");
+}
+
+TEST_F(ContainersPerfTest, BTreeMap) {
+  RunBenchmarks<BTree>("btree_map");
+}
+
+}  // namespace base
@@ -0,0 +1,119 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_MAP_H_
+#define BASE_CONTAINERS_FLAT_HASH_MAP_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "base/containers/flat_hash_table_internal.h"
+
+namespace base {
+
+// A hash map storing its elements in one contiguous array, using open
+// addressing with linear probing. Compared to base::hash_map, it doesn't
+// allocate a node per element, and lookups touch one or two cache lines
+// instead of following a bucket list, which makes it faster and smaller for
+// small keys and values.
+//
+// The interface is a subset of base::hash_map's, with these differences:
+//  - Inserting may move all the elements, which invalidates all iterators
+//    and pointers to elements. Use reserve() beforehand to avoid it.
+//  - Erasing doesn't move elements, and only invalidates iterators to the
+//    erased element, so erase(it++) works while iterating.
+//  - Key and Value must be copyable, and large values waste the space of the
+//    empty slots; consider storing them by pointer.
+//
+// Example:
+//   base::FlatHashMap<int, std::string> map;
+//   map[1] = "one";
+//   base::FlatHashMap<int, std::string>::iterator it = map.find(1);
+template <typename Key,
+          typename Value,
+          typename Hash = internal::DefaultFlatHash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value> > >
+class FlatHashMap {
+ private:
+  typedef internal::FlatHashTable<std::pair<const Key, Value>,
+                                  Key,
+                                  internal::SelectFirst<
+                                      std::pair<const Key, Value> >,
+                                  Hash,
+                                  KeyEqual,
+                                  Allocator> Table;
+
+ public:
+  typedef typename Table::key_type key_type;
+  typedef Value mapped_type;
+  typedef typename Table::value_type value_type;
+  typedef typename Table::hasher hasher;
+  typedef typename Table::key_equal key_equal;
+  typedef typename Table::allocator_type allocator_type;
+  typedef typename Table::size_type size_type;
+  typedef typename Table::difference_type difference_type;
+  typedef typename Table::reference reference;
+  typedef typename Table::const_reference const_reference;
+  typedef typename Table::pointer pointer;
+  typedef typename Table::const_pointer const_pointer;
+  typedef typename Table::iterator iterator;
+  typedef typename Table::const_iterator const_iterator;
+
+  FlatHashMap() {}
+
+  template <typename InputIterator>
+  FlatHashMap(InputIterator first, InputIterator last) {
+    insert(first, last);
+  }
+
+  // Copyable, like the STL containers.
+
+  iterator begin() { return table_.begin(); }
+  iterator end() { return table_.end(); }
+  const_iterator begin() const { return table_.begin(); }
+  const_iterator end() const { return table_.end(); }
+
+  bool empty() const { return table_.empty(); }
+  size_type size() const { return table_.size(); }
+  size_type bucket_count() const { return table_.bucket_count(); }
+
+  hasher hash_function() const { return table_.hash_function(); }
+  key_equal key_eq() const { return table_.key_eq(); }
+
+  iterator find(const key_type& key) { return table_.find(key); }
+  const_iterator find(const key_type& key) const { return table_.find(key); }
+  size_type count(const key_type& key) const { return table_.count(key); }
+
+  mapped_type& operator[](const key_type& key) {
+    iterator it = table_.find(key);
+    if (it == table_.end())
+      it = table_.insert(value_type(key, mapped_type())).first;
+    return it->second;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return table_.insert(value);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    table_.insert(first, last);
+  }
+
+  void erase(iterator position) { table_.erase(position); }
+  size_type erase(const key_type& key) { return table_.erase(key); }
+
+  void clear() { table_.clear(); }
+  void reserve(size_type count) { table_.reserve(count); }
+  void swap(FlatHashMap& other) { table_.swap(other.table_); }
+
+ private:
+  Table table_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_MAP_H_
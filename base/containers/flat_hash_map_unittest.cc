@@ -0,0 +1,233 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/flat_hash_map.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "base/containers/flat_hash_set.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Counts the live instances, to check that the elements are destroyed.
+class Counted {
+ public:
+  Counted() : value_(0) { ++live_count_; }
+  explicit Counted(int value) : value_(value) { ++live_count_; }
+  Counted(const Counted& other) : value_(other.value_) { ++live_count_; }
+  ~Counted() { --live_count_; }
+
+  Counted& operator=(const Counted& other) {
+    value_ = other.value_;
+    return *this;
+  }
+
+  int value() const { return value_; }
+
+  static int live_count() { return live_count_; }
+
+ private:
+  int value_;
+  static int live_count_;
+};
+
+int Counted::live_count_ = 0;
+
+// Maps all the keys to a few buckets, to exercise the probing.
+struct BadHash {
+  size_t operator()(int key) const { return key % 4; }
+};
+
+}  // namespace
+
+TEST(FlatHashMapTest, Basic) {
+  FlatHashMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(1) == map.end());
+
+  map[1] = "one";
+  map[2] = "two";
+  EXPECT_FALSE(map.empty());
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ("one", map[1]);
+  EXPECT_EQ("two", map.find(2)->second);
+  EXPECT_EQ(1u, map.count(1));
+  EXPECT_EQ(0u, map.count(3));
+
+  std::pair<FlatHashMap<int, std::string>::iterator, bool> result =
+      map.insert(std::make_pair(1, std::string("uno")));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ("one", result.first->second);
+  result = map.insert(std::make_pair(3, std::string("three")));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(3, result.first->first);
+
+  EXPECT_EQ(1u, map.erase(2));
+  EXPECT_EQ(0u, map.erase(2));
+  EXPECT_TRUE(map.find(2) == map.end());
+  EXPECT_EQ(2u, map.size());
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(FlatHashMapTest, Iteration) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[i] = i * 2;
+
+  std::set<int> seen;
+  const FlatHashMap<int, int>& const_map = map;
+  for (FlatHashMap<int, int>::const_iterator it = const_map.begin();
+       it != const_map.end(); ++it) {
+    EXPECT_EQ(it->first * 2, it->second);
+    EXPECT_TRUE(seen.insert(it->first).second);
+  }
+  EXPECT_EQ(100u, seen.size());
+}
+
+TEST(FlatHashMapTest, EraseWhileIterating) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  for (FlatHashMap<int, int>::iterator it = map.begin(); it != map.end();) {
+    if (it->first % 3)
+      map.erase(it++);
+    else
+      ++it;
+  }
+  EXPECT_EQ(334u, map.size());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 3 ? 0u : 1u, map.count(i)) << i;
+}
+
+TEST(FlatHashMapTest, Collisions) {
+  FlatHashMap<int, int, BadHash> map;
+  for (int i = 0; i < 200; ++i)
+    map[i] = i;
+  for (int i = 0; i < 200; i += 2)
+    EXPECT_EQ(1u, map.erase(i));
+  for (int i = 0; i < 200; ++i) {
+    if (i % 2)
+      EXPECT_EQ(i, map.find(i)->second);
+    else
+      EXPECT_TRUE(map.find(i) == map.end());
+  }
+}
+
+// Compares against std::map under random insertions and erasures, which
+// create and reuse tombstones.
+TEST(FlatHashMapTest, MatchesStdMap) {
+  FlatHashMap<int, int> map;
+  std::map<int, int> expected;
+  unsigned int random = 1;
+  for (int i = 0; i < 100000; ++i) {
+    random = random * 1103515245 + 12345;
+    int key = (random >> 8) % 2000;
+    if ((random >> 4) % 3) {
+      map[key] = i;
+      expected[key] = i;
+    } else {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+  }
+  ASSERT_EQ(expected.size(), map.size());
+  // The table doesn't grow because of the tombstones.
+  EXPECT_LE(map.bucket_count(), 8 * expected.size());
+  for (std::map<int, int>::iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    FlatHashMap<int, int>::iterator found = map.find(it->first);
+    ASSERT_TRUE(found != map.end());
+    EXPECT_EQ(it->second, found->second);
+  }
+}
+
+TEST(FlatHashMapTest, Reserve) {
+  FlatHashMap<int, int> map;
+  map.reserve(1000);
+  size_t bucket_count = map.bucket_count();
+  EXPECT_GE(bucket_count, 1000u);
+  map[0] = 0;
+  FlatHashMap<int, int>::iterator it = map.find(0);
+  for (int i = 1; i < 1000; ++i)
+    map[i] = i;
+  EXPECT_EQ(bucket_count, map.bucket_count());
+  // Nothing moved.
+  EXPECT_TRUE(it == map.find(0));
+}
+
+TEST(FlatHashMapTest, CopyAndSwap) {
+  FlatHashMap<std::string, int> map;
+  map["a"] = 1;
+  map["b"] = 2;
+
+  FlatHashMap<std::string, int> copy(map);
+  EXPECT_EQ(2u, copy.size());
+  EXPECT_EQ(1, copy["a"]);
+  copy["c"] = 3;
+  EXPECT_EQ(0u, map.count("c"));
+
+  FlatHashMap<std::string, int> other;
+  other = copy;
+  EXPECT_EQ(3u, other.size());
+
+  other.swap(map);
+  EXPECT_EQ(2u, other.size());
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(3, map["c"]);
+}
+
+TEST(FlatHashMapTest, DestroysElements) {
+  {
+    FlatHashMap<int, Counted> map;
+    for (int i = 0; i < 100; ++i)
+      map[i] = Counted(i);
+    EXPECT_EQ(100, Counted::live_count());
+    for (int i = 0; i < 50; ++i)
+      map.erase(i);
+    EXPECT_EQ(50, Counted::live_count());
+    EXPECT_EQ(99, map.find(99)->second.value());
+  }
+  EXPECT_EQ(0, Counted::live_count());
+
+  FlatHashMap<int, Counted> map;
+  map[1] = Counted(1);
+  map.clear();
+  EXPECT_EQ(0, Counted::live_count());
+}
+
+TEST(FlatHashSetTest, Basic) {
+  FlatHashSet<std::string> set;
+  EXPECT_TRUE(set.insert("a").second);
+  EXPECT_TRUE(set.insert("b").second);
+  EXPECT_FALSE(set.insert("a").second);
+  EXPECT_EQ(2u, set.size());
+  EXPECT_EQ(1u, set.count("a"));
+  EXPECT_EQ("b", *set.find("b"));
+  EXPECT_TRUE(set.find("c") == set.end());
+
+  set.erase(set.find("a"));
+  EXPECT_EQ(0u, set.count("a"));
+  EXPECT_EQ(1u, set.erase("b"));
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(FlatHashSetTest, RangeConstructor) {
+  const int kValues[] = { 5, 3, 5, 1, 3 };
+  FlatHashSet<int> set(kValues, kValues + arraysize(kValues));
+  EXPECT_EQ(3u, set.size());
+  std::set<int> contents(set.begin(), set.end());
+  EXPECT_EQ(std::set<int>(kValues, kValues + arraysize(kValues)), contents);
+}
+
+}  // namespace base
@@ -0,0 +1,95 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_SET_H_
+#define BASE_CONTAINERS_FLAT_HASH_SET_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "base/containers/flat_hash_table_internal.h"
+
+namespace base {
+
+// A hash set storing its elements in one contiguous array. See FlatHashMap
+// for the tradeoffs against base::hash_set and the iterator invalidation
+// rules, which are the same.
+template <typename Key,
+          typename Hash = internal::DefaultFlatHash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key> >
+class FlatHashSet {
+ private:
+  typedef internal::FlatHashTable<Key,
+                                  Key,
+                                  internal::Identity<Key>,
+                                  Hash,
+                                  KeyEqual,
+                                  Allocator> Table;
+
+ public:
+  typedef typename Table::key_type key_type;
+  typedef typename Table::value_type value_type;
+  typedef typename Table::hasher hasher;
+  typedef typename Table::key_equal key_equal;
+  typedef typename Table::allocator_type allocator_type;
+  typedef typename Table::size_type size_type;
+  typedef typename Table::difference_type difference_type;
+  typedef typename Table::const_reference reference;
+  typedef typename Table::const_reference const_reference;
+  typedef typename Table::const_pointer pointer;
+  typedef typename Table::const_pointer const_pointer;
+  // Elements can't be modified in place, since that would change their hash.
+  typedef typename Table::const_iterator iterator;
+  typedef typename Table::const_iterator const_iterator;
+
+  FlatHashSet() {}
+
+  template <typename InputIterator>
+  FlatHashSet(InputIterator first, InputIterator last) {
+    insert(first, last);
+  }
+
+  // Copyable, like the STL containers.
+
+  const_iterator begin() const { return table_.begin(); }
+  const_iterator end() const { return table_.end(); }
+
+  bool empty() const { return table_.empty(); }
+  size_type size() const { return table_.size(); }
+  size_type bucket_count() const { return table_.bucket_count(); }
+
+  hasher hash_function() const { return table_.hash_function(); }
+  key_equal key_eq() const { return table_.key_eq(); }
+
+  const_iterator find(const key_type& key) const { return table_.find(key); }
+  size_type count(const key_type& key) const { return table_.count(key); }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return table_.insert(value);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    table_.insert(first, last);
+  }
+
+  void erase(const_iterator position) {
+    table_.erase(typename Table::iterator(
+        const_cast<Table*>(position.table()), position.index()));
+  }
+  size_type erase(const key_type& key) { return table_.erase(key); }
+
+  void clear() { table_.clear(); }
+  void reserve(size_type count) { table_.reserve(count); }
+  void swap(FlatHashSet& other) { table_.swap(other.table_); }
+
+ private:
+  Table table_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_SET_H_
@@ -0,0 +1,394 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains the open addressing hash table shared by FlatHashMap and
+// FlatHashSet. Do not use it directly.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_TABLE_INTERNAL_H_
+#define BASE_CONTAINERS_FLAT_HASH_TABLE_INTERNAL_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/logging.h"
+
+namespace base {
+namespace internal {
+
+// Hash table storing its elements inline in a single array of slots, probed
+// linearly. A parallel array of one byte per slot tells whether the slot is
+// empty, full, or was erased. Erased slots ("tombstones") keep the probe
+// sequences of the other elements valid and iterators stable, and are
+// reclaimed when the table is rehashed.
+//
+// KeyOfValue is a functor returning the key of a Value.
+template <typename Value,
+          typename Key,
+          typename KeyOfValue,
+          typename Hash,
+          typename KeyEqual,
+          typename Allocator>
+class FlatHashTable {
+ public:
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef Hash hasher;
+  typedef KeyEqual key_equal;
+  typedef Allocator allocator_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef Value& reference;
+  typedef const Value& const_reference;
+  typedef Value* pointer;
+  typedef const Value* const_pointer;
+
+  template <typename TablePointer, typename Reference, typename Pointer>
+  class Iterator : public std::iterator<std::forward_iterator_tag, Value,
+                                        ptrdiff_t, Pointer, Reference> {
+   public:
+    Iterator() : table_(NULL), index_(0) {}
+    Iterator(TablePointer table, size_t index)
+        : table_(table), index_(index) {}
+
+    // Allows converting an iterator to a const_iterator.
+    template <typename OtherTablePointer,
+              typename OtherReference,
+              typename OtherPointer>
+    Iterator(const Iterator<OtherTablePointer, OtherReference, OtherPointer>&
+                 other)
+        : table_(other.table()), index_(other.index()) {}
+
+    Reference operator*() const { return table_->slots_[index_]; }
+    Pointer operator->() const { return &table_->slots_[index_]; }
+
+    Iterator& operator++() {
+      index_ = table_->NextFull(index_ + 1);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator result(*this);
+      ++(*this);
+      return result;
+    }
+
+    template <typename OtherTablePointer,
+              typename OtherReference,
+              typename OtherPointer>
+    bool operator==(const Iterator<OtherTablePointer,
+                                   OtherReference,
+                                   OtherPointer>& other) const {
+      return index_ == other.index();
+    }
+
+    template <typename OtherTablePointer,
+              typename OtherReference,
+              typename OtherPointer>
+    bool operator!=(const Iterator<OtherTablePointer,
+                                   OtherReference,
+                                   OtherPointer>& other) const {
+      return index_ != other.index();
+    }
+
+    TablePointer table() const { return table_; }
+    size_t index() const { return index_; }
+
+   private:
+    TablePointer table_;
+    size_t index_;
+  };
+
+  typedef Iterator<FlatHashTable*, Value&, Value*> iterator;
+  typedef Iterator<const FlatHashTable*, const Value&, const Value*>
+      const_iterator;
+
+  FlatHashTable()
+      : slots_(NULL),
+        states_(NULL),
+        capacity_(0),
+        shift_(64),
+        size_(0),
+        erased_(0) {
+  }
+
+  FlatHashTable(const FlatHashTable& other)
+      : slots_(NULL),
+        states_(NULL),
+        capacity_(0),
+        shift_(64),
+        size_(0),
+        erased_(0),
+        hash_(other.hash_),
+        key_equal_(other.key_equal_),
+        allocator_(other.allocator_) {
+    reserve(other.size());
+    insert(other.begin(), other.end());
+  }
+
+  ~FlatHashTable() {
+    DestroyAndDeallocate(slots_, states_, capacity_);
+  }
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      FlatHashTable copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  iterator begin() { return iterator(this, NextFull(0)); }
+  iterator end() { return iterator(this, capacity_); }
+  const_iterator begin() const { return const_iterator(this, NextFull(0)); }
+  const_iterator end() const { return const_iterator(this, capacity_); }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+
+  // Number of slots, which is at least 8/7 of the number of elements.
+  size_type bucket_count() const { return capacity_; }
+
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return key_equal_; }
+
+  iterator find(const key_type& key) {
+    return iterator(this, FindIndex(key));
+  }
+
+  const_iterator find(const key_type& key) const {
+    return const_iterator(this, FindIndex(key));
+  }
+
+  size_type count(const key_type& key) const {
+    return FindIndex(key) != capacity_ ? 1 : 0;
+  }
+
+  // Invalidates all iterators if the table has to grow.
+  std::pair<iterator, bool> insert(const value_type& value) {
+    const key_type& key = KeyOfValue()(value);
+    size_t index = FindIndex(key);
+    if (index != capacity_)
+      return std::make_pair(iterator(this, index), false);
+    if ((size_ + erased_ + 1) * kMaxLoadDenominator >
+        capacity_ * kMaxLoadNumerator) {
+      // Only grow if the table would be more than half full without its
+      // tombstones, otherwise just get rid of them.
+      Rehash(std::max(static_cast<size_t>(kMinCapacity),
+                      (size_ + 1) * 2 > capacity_ ? capacity_ * 2 :
+                                                    capacity_));
+    }
+    index = FindSlotForInsert(key);
+    if (states_[index] == kErased)
+      --erased_;
+    new (&slots_[index]) Value(value);
+    states_[index] = kFull;
+    ++size_;
+    return std::make_pair(iterator(this, index), true);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  // Doesn't invalidate the other iterators.
+  void erase(iterator position) {
+    DCHECK_LT(position.index(), capacity_);
+    size_t index = position.index();
+    DCHECK_EQ(kFull, states_[index]);
+    slots_[index].~Value();
+    --size_;
+    // The slot can be made empty if no probe sequence goes through it.
+    if (states_[(index + 1) & (capacity_ - 1)] == kEmpty) {
+      states_[index] = kEmpty;
+    } else {
+      states_[index] = kErased;
+      ++erased_;
+    }
+  }
+
+  size_type erase(const key_type& key) {
+    size_t index = FindIndex(key);
+    if (index == capacity_)
+      return 0;
+    erase(iterator(this, index));
+    return 1;
+  }
+
+  void clear() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (states_[i] == kFull)
+        slots_[i].~Value();
+    }
+    if (capacity_)
+      memset(states_, kEmpty, capacity_);
+    size_ = 0;
+    erased_ = 0;
+  }
+
+  // Makes room for |count| elements without rehashing.
+  void reserve(size_type count) {
+    size_t capacity = kMinCapacity;
+    while (count * kMaxLoadDenominator > capacity * kMaxLoadNumerator)
+      capacity *= 2;
+    if (capacity > capacity_)
+      Rehash(capacity);
+  }
+
+  void swap(FlatHashTable& other) {
+    std::swap(slots_, other.slots_);
+    std::swap(states_, other.states_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(shift_, other.shift_);
+    std::swap(size_, other.size_);
+    std::swap(erased_, other.erased_);
+    std::swap(hash_, other.hash_);
+    std::swap(key_equal_, other.key_equal_);
+    std::swap(allocator_, other.allocator_);
+  }
+
+ private:
+  enum SlotState {
+    kEmpty = 0,
+    kFull,
+    kErased
+  };
+
+  // The table is at most 7/8 full, counting tombstones.
+  static const size_t kMaxLoadNumerator = 7;
+  static const size_t kMaxLoadDenominator = 8;
+  static const size_t kMinCapacity = 8;
+
+  typedef typename Allocator::template rebind<Value>::other SlotAllocator;
+  typedef typename Allocator::template rebind<uint8>::other StateAllocator;
+
+  // Returns the first slot of the probe sequence of |key|. The hash is
+  // multiplied by 2^64 / phi and the top bits are kept, so that hash
+  // functions with poorly distributed low bits (the default ones are the
+  // identity for integers) still spread the keys over the table.
+  size_t Bucket(const key_type& key) const {
+    uint64 hash = static_cast<uint64>(hash_(key)) *
+                  GG_UINT64_C(0x9E3779B97F4A7C15);
+    return static_cast<size_t>(hash >> shift_);
+  }
+
+  // Returns the slot of |key|, or capacity_ if not found.
+  size_t FindIndex(const key_type& key) const {
+    if (!size_)
+      return capacity_;
+    const size_t mask = capacity_ - 1;
+    for (size_t index = Bucket(key); ; index = (index + 1) & mask) {
+      if (states_[index] == kEmpty)
+        return capacity_;
+      if (states_[index] == kFull &&
+          key_equal_(KeyOfValue()(slots_[index]), key)) {
+        return index;
+      }
+    }
+  }
+
+  // Returns the slot where to insert |key|, which isn't in the table: the
+  // first tombstone or empty slot of its probe sequence.
+  size_t FindSlotForInsert(const key_type& key) const {
+    const size_t mask = capacity_ - 1;
+    size_t index = Bucket(key);
+    while (states_[index] == kFull)
+      index = (index + 1) & mask;
+    return index;
+  }
+
+  // Returns the first full slot at or after |index|, or capacity_.
+  size_t NextFull(size_t index) const {
+    while (index < capacity_ && states_[index] != kFull)
+      ++index;
+    return index;
+  }
+
+  void Rehash(size_t capacity) {
+    DCHECK_GE(capacity, size_);
+    DCHECK_EQ(0u, capacity & (capacity - 1));
+    Value* old_slots = slots_;
+    uint8* old_states = states_;
+    size_t old_capacity = capacity_;
+
+    slots_ = SlotAllocator(allocator_).allocate(capacity);
+    states_ = StateAllocator(allocator_).allocate(capacity);
+    memset(states_, kEmpty, capacity);
+    capacity_ = capacity;
+    shift_ = 64;
+    for (size_t i = capacity; i > 1; i >>= 1)
+      --shift_;
+    erased_ = 0;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_states[i] != kFull)
+        continue;
+      size_t index = FindSlotForInsert(KeyOfValue()(old_slots[i]));
+      new (&slots_[index]) Value(old_slots[i]);
+      states_[index] = kFull;
+    }
+    DestroyAndDeallocate(old_slots, old_states, old_capacity);
+  }
+
+  void DestroyAndDeallocate(Value* slots, uint8* states, size_t capacity) {
+    if (!capacity)
+      return;
+    for (size_t i = 0; i < capacity; ++i) {
+      if (states[i] == kFull)
+        slots[i].~Value();
+    }
+    SlotAllocator(allocator_).deallocate(slots, capacity);
+    StateAllocator(allocator_).deallocate(states, capacity);
+  }
+
+  Value* slots_;
+  uint8* states_;
+  // Zero or a power of two.
+  size_t capacity_;
+  // 64 - log2(capacity_).
+  int shift_;
+  size_t size_;
+  // Number of tombstones.
+  size_t erased_;
+  hasher hash_;
+  key_equal key_equal_;
+  allocator_type allocator_;
+};
+
+// Default hash function of the flat containers: the one base::hash_map uses.
+#if defined(COMPILER_MSVC)
+template <typename Key>
+struct DefaultFlatHash : public stdext::hash_compare<Key> {};
+#else
+template <typename Key>
+struct DefaultFlatHash : public BASE_HASH_NAMESPACE::hash<Key> {};
+#endif
+
+// Returns the first member of a pair, for maps.
+template <typename Pair>
+struct SelectFirst {
+  const typename Pair::first_type& operator()(const Pair& pair) const {
+    return pair.first;
+  }
+};
+
+// Returns its argument, for sets.
+template <typename T>
+struct Identity {
+  const T& operator()(const T& value) const {
+    return value;
+  }
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_TABLE_INTERNAL_H_
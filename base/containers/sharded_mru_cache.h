@@ -0,0 +1,183 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains a thread-safe variant of HashingMRUCache, for caches
+// shared between threads. The keys are spread over independent shards, each
+// an MRU cache with its own lock, so that threads accessing different keys
+// rarely contend. The price is that recency is only tracked per shard: when a
+// shard is full, it evicts its own least recently used item, which may be
+// more recent than the least recently used item of the whole cache.
+//
+// Since items may be removed by other threads at any time, the interface
+// returns copies of the payloads rather than iterators. Payloads should
+// therefore be cheap to copy, e.g. scoped_refptrs to immutable data, and the
+// cache doesn't support owning them like OwningMRUCache.
+
+#ifndef BASE_CONTAINERS_SHARDED_MRU_CACHE_H_
+#define BASE_CONTAINERS_SHARDED_MRU_CACHE_H_
+
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/containers/mru_cache.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+// Hash function used to pick the shard of a key: the one used by
+// base::hash_map, which the shards use as their index.
+#if defined(COMPILER_MSVC)
+template <class KeyType>
+struct ShardedMRUCacheHash : public stdext::hash_compare<KeyType> {};
+#else
+template <class KeyType>
+struct ShardedMRUCacheHash : public BASE_HASH_NAMESPACE::hash<KeyType> {};
+#endif
+
+template <class KeyType,
+          class PayloadType,
+          class HashType = ShardedMRUCacheHash<KeyType> >
+class ShardedMRUCache {
+ public:
+  typedef size_t size_type;
+
+  enum { NO_AUTO_EVICT = 0 };
+
+  // Enough shards for the threads of a browser process to rarely contend.
+  static const size_type kDefaultShardCount = 16;
+
+  // The max_size is split evenly between the shards. As for MRUCache,
+  // NO_AUTO_EVICT doesn't restrict the cache size.
+  explicit ShardedMRUCache(size_type max_size) : max_size_(max_size) {
+    Init(kDefaultShardCount);
+  }
+
+  // |shard_count| must be a power of two.
+  ShardedMRUCache(size_type max_size, size_type shard_count)
+      : max_size_(max_size) {
+    Init(shard_count);
+  }
+
+  ~ShardedMRUCache() {}
+
+  size_type max_size() const { return max_size_; }
+
+  // Inserts a payload item with the given key, replacing any existing item
+  // with the same key. The least recently used item of the shard of |key|
+  // may be evicted.
+  void Put(const KeyType& key, const PayloadType& payload) {
+    Shard* shard = GetShard(key);
+    AutoLock lock(shard->lock);
+    shard->cache.Put(key, payload);
+  }
+
+  // Copies the payload associated with |key| to |payload| and returns true,
+  // or returns false if there is none. Marks the item as the most recently
+  // used of its shard.
+  bool Get(const KeyType& key, PayloadType* payload) {
+    Shard* shard = GetShard(key);
+    AutoLock lock(shard->lock);
+    typename Cache::iterator it = shard->cache.Get(key);
+    if (it == shard->cache.end())
+      return false;
+    *payload = it->second;
+    return true;
+  }
+
+  // Like Get(), without affecting the recency of the item.
+  bool Peek(const KeyType& key, PayloadType* payload) const {
+    Shard* shard = GetShard(key);
+    AutoLock lock(shard->lock);
+    typename Cache::iterator it = shard->cache.Peek(key);
+    if (it == shard->cache.end())
+      return false;
+    *payload = it->second;
+    return true;
+  }
+
+  // Removes the item with the given key. Returns false if there was none.
+  bool Erase(const KeyType& key) {
+    Shard* shard = GetShard(key);
+    AutoLock lock(shard->lock);
+    typename Cache::iterator it = shard->cache.Peek(key);
+    if (it == shard->cache.end())
+      return false;
+    shard->cache.Erase(it);
+    return true;
+  }
+
+  // Deletes everything from the cache. Items inserted concurrently may
+  // remain.
+  void Clear() {
+    for (size_type i = 0; i < shards_.size(); ++i) {
+      AutoLock lock(shards_[i]->lock);
+      shards_[i]->cache.Clear();
+    }
+  }
+
+  // Returns the number of items in the cache. The result may be outdated as
+  // soon as it is returned if other threads modify the cache.
+  size_type size() const {
+    size_type size = 0;
+    for (size_type i = 0; i < shards_.size(); ++i) {
+      AutoLock lock(shards_[i]->lock);
+      size += shards_[i]->cache.size();
+    }
+    return size;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_type shard_count() const { return shards_.size(); }
+
+ private:
+  typedef HashingMRUCache<KeyType, PayloadType> Cache;
+
+  struct Shard {
+    explicit Shard(size_type max_size) : cache(max_size) {}
+
+    Lock lock;
+    Cache cache;
+  };
+
+  void Init(size_type shard_count) {
+    DCHECK_GT(shard_count, 0u);
+    DCHECK_EQ(0u, shard_count & (shard_count - 1));
+    shard_shift_ = 64;
+    for (size_type i = shard_count; i > 1; i >>= 1)
+      --shard_shift_;
+    // Round up, so that the cache can hold max_size_ items if they are evenly
+    // distributed.
+    size_type shard_max_size = (max_size_ + shard_count - 1) / shard_count;
+    for (size_type i = 0; i < shard_count; ++i)
+      shards_.push_back(new Shard(shard_max_size));
+  }
+
+  Shard* GetShard(const KeyType& key) const {
+    if (shard_shift_ == 64)
+      return shards_[0];
+    // The shards use the low bits of the hash to find their buckets, so take
+    // the high bits of the hash multiplied by 2^64 / phi instead.
+    uint64 hash = static_cast<uint64>(hash_(key)) *
+                  GG_UINT64_C(0x9E3779B97F4A7C15);
+    return shards_[static_cast<size_type>(hash >> shard_shift_)];
+  }
+
+  const size_type max_size_;
+  // 64 - log2(number of shards).
+  int shard_shift_;
+  HashType hash_;
+  ScopedVector<Shard> shards_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedMRUCache);
+};
+
+template <class KeyType, class PayloadType, class HashType>
+const typename ShardedMRUCache<KeyType, PayloadType, HashType>::size_type
+    ShardedMRUCache<KeyType, PayloadType, HashType>::kDefaultShardCount;
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_SHARDED_MRU_CACHE_H_
@@ -0,0 +1,122 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the hit throughput of a cache shared by 1 to 32 threads: a
+// HashingMRUCache behind a single lock, as caches shared between threads use
+// today, against a ShardedMRUCache.
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/containers/sharded_mru_cache.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kCachedItems = 10000;
+const int kLookupsPerThread = 200000;
+
+// A HashingMRUCache protected by one lock, with the interface of
+// ShardedMRUCache.
+class LockedMRUCache {
+ public:
+  explicit LockedMRUCache(size_t max_size) : cache_(max_size) {}
+
+  void Put(int key, int payload) {
+    AutoLock auto_lock(lock_);
+    cache_.Put(key, payload);
+  }
+
+  bool Get(int key, int* payload) {
+    AutoLock auto_lock(lock_);
+    HashingMRUCache<int, int>::iterator it = cache_.Get(key);
+    if (it == cache_.end())
+      return false;
+    *payload = it->second;
+    return true;
+  }
+
+ private:
+  Lock lock_;
+  HashingMRUCache<int, int> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedMRUCache);
+};
+
+// Looks up random cached keys.
+template <typename Cache>
+class CacheReader : public DelegateSimpleThread::Delegate {
+ public:
+  CacheReader(Cache* cache, uint32 seed)
+      : cache_(cache), random_(seed), hits_(0) {}
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < kLookupsPerThread; ++i) {
+      random_ = random_ * 1103515245 + 12345;
+      int payload;
+      if (cache_->Get((random_ >> 8) % kCachedItems, &payload))
+        ++hits_;
+    }
+  }
+
+  int hits() const { return hits_; }
+
+ private:
+  Cache* cache_;
+  uint32 random_;
+  int hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(CacheReader);
+};
+
+template <typename Cache>
+void RunHitBenchmark(const std::string& name, int thread_count) {
+  Cache cache(kCachedItems * 2);
+  for (int i = 0; i < kCachedItems; ++i)
+    cache.Put(i, i);
+
+  ScopedVector<CacheReader<Cache> > readers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    readers.push_back(new CacheReader<Cache>(&cache, i + 1));
+    threads.push_back(new DelegateSimpleThread(readers.back(), "CacheReader"));
+  }
+
+  TimeTicks start = TimeTicks::HighResNow();
+  for (int i = 0; i < thread_count; ++i)
+    threads[i]->Start();
+  for (int i = 0; i < thread_count; ++i)
+    threads[i]->Join();
+  TimeDelta elapsed = TimeTicks::HighResNow() - start;
+
+  int hits = 0;
+  for (int i = 0; i < thread_count; ++i)
+    hits += readers[i]->hits();
+  EXPECT_EQ(thread_count * kLookupsPerThread, hits);
+
+  perf_test::PrintResult("mru_cache_hits", "_" + name,
+                         StringPrintf("%d_threads", thread_count),
+                         hits / elapsed.InSecondsF(), "hits/s", true);
+}
+
+}  // namespace
+
+TEST(ShardedMRUCachePerfTest, Hits) {
+  const int kThreadCounts[] = { 1, 2, 4, 8, 16, 32 };
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i) {
+    RunHitBenchmark<LockedMRUCache>("locked", kThreadCounts[i]);
+    RunHitBenchmark<ShardedMRUCache<int, int> >("sharded", kThreadCounts[i]);
+  }
+}
+
+}  // namespace base
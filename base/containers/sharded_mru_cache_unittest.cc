@@ -0,0 +1,140 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/sharded_mru_cache.h"
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+typedef ShardedMRUCache<int, std::string> Cache;
+
+// Puts, gets and erases the keys of a range, overlapping with the ranges of
+// the other threads.
+class CacheUser : public DelegateSimpleThread::Delegate {
+ public:
+  CacheUser(Cache* cache, int first_key)
+      : cache_(cache), first_key_(first_key), hits_(0) {}
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < 10000; ++i) {
+      int key = first_key_ + i % 500;
+      std::string payload;
+      if (cache_->Get(key, &payload)) {
+        EXPECT_EQ(IntToString(key), payload);
+        ++hits_;
+      }
+      if (i % 3 == 0) {
+        cache_->Put(key, IntToString(key));
+      } else if (i % 7 == 0) {
+        cache_->Erase(key);
+      }
+    }
+  }
+
+  int hits() const { return hits_; }
+
+ private:
+  Cache* cache_;
+  int first_key_;
+  int hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(CacheUser);
+};
+
+}  // namespace
+
+TEST(ShardedMRUCacheTest, Basic) {
+  Cache cache(Cache::NO_AUTO_EVICT);
+  EXPECT_TRUE(cache.empty());
+  EXPECT_EQ(Cache::kDefaultShardCount, cache.shard_count());
+
+  std::string payload;
+  EXPECT_FALSE(cache.Get(1, &payload));
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Get(1, &payload));
+  EXPECT_EQ("one", payload);
+  EXPECT_TRUE(cache.Peek(2, &payload));
+  EXPECT_EQ("two", payload);
+
+  cache.Put(1, "uno");
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Get(1, &payload));
+  EXPECT_EQ("uno", payload);
+
+  EXPECT_TRUE(cache.Erase(1));
+  EXPECT_FALSE(cache.Erase(1));
+  EXPECT_FALSE(cache.Get(1, &payload));
+  EXPECT_EQ(1u, cache.size());
+
+  cache.Clear();
+  EXPECT_TRUE(cache.empty());
+}
+
+// With one shard, the cache behaves like an MRUCache.
+TEST(ShardedMRUCacheTest, SingleShardEviction) {
+  Cache cache(2, 1);
+  std::string payload;
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  // Makes 1 the most recently used item, so that 2 gets evicted.
+  EXPECT_TRUE(cache.Get(1, &payload));
+  cache.Put(3, "three");
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Peek(1, &payload));
+  EXPECT_FALSE(cache.Peek(2, &payload));
+  EXPECT_TRUE(cache.Peek(3, &payload));
+
+  // Peek doesn't change the recency, so 1 is evicted.
+  cache.Put(4, "four");
+  EXPECT_FALSE(cache.Peek(1, &payload));
+  EXPECT_TRUE(cache.Peek(3, &payload));
+}
+
+TEST(ShardedMRUCacheTest, MaxSizeIsSplitBetweenShards) {
+  Cache cache(64, 8);
+  EXPECT_EQ(64u, cache.max_size());
+  for (int i = 0; i < 1000; ++i)
+    cache.Put(i, "payload");
+  // Each shard holds at most 8 items.
+  EXPECT_LE(cache.size(), 64u);
+  // The keys are spread over all the shards.
+  EXPECT_GT(cache.size(), 48u);
+
+  // The most recent item is never evicted.
+  std::string payload;
+  EXPECT_TRUE(cache.Get(999, &payload));
+}
+
+TEST(ShardedMRUCacheTest, ConcurrentAccess) {
+  Cache cache(1000);
+  ScopedVector<CacheUser> users;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < 8; ++i) {
+    users.push_back(new CacheUser(&cache, i * 250));
+    threads.push_back(new DelegateSimpleThread(users.back(), "CacheUser"));
+    threads.back()->Start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+
+  EXPECT_LE(cache.size(), 1000u + Cache::kDefaultShardCount);
+  int hits = 0;
+  for (size_t i = 0; i < users.size(); ++i)
+    hits += users[i]->hits();
+  EXPECT_GT(hits, 0);
+}
+
+}  // namespace base
@@ -36,6 +36,7 @@ CPU::CPU()
     has_sse41_(false),
     has_sse42_(false),
     has_avx_(false),
+    has_avx2_(false),
     has_avx_hardware_(false),
     has_aesni_(false),
     has_non_stop_time_stamp_counter_(false),
@@ -50,28 +51,32 @@ namespace {
 
 #if defined(__pic__) && defined(__i386__)
 
-void __cpuid(int cpu_info[4], int info_type) {
+void __cpuidex(int cpu_info[4], int info_type, int info_index) {
   __asm__ volatile (
     "mov %%ebx, %%edi\n"
     "cpuid\n"
     "xchg %%edi, %%ebx\n"
     : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
-    : "a"(info_type)
+    : "a"(info_type), "c"(info_index)
   );
 }
 
 #else
 
-void __cpuid(int cpu_info[4], int info_type) {
+void __cpuidex(int cpu_info[4], int info_type, int info_index) {
   __asm__ volatile (
     "cpuid \n\t"
     : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
-    : "a"(info_type)
+    : "a"(info_type), "c"(info_index)
   );
 }
 
 #endif
 
+void __cpuid(int cpu_info[4], int info_type) {
+  __cpuidex(cpu_info, info_type, 0);
+}
+
 // _xgetbv returns the value of an Intel Extended Control Register (XCR).
 // Currently only XCR0 is defined by Intel so |xcr| should always be zero.
 uint64 _xgetbv(uint32 xcr) {
@@ -135,6 +140,13 @@ void CPU::Initialize() {
     has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
   }
 
+  // AVX2 is reported in the extended feature flags (leaf 7, sub-leaf 0) and
+  // needs the same OS support for the YMM state as AVX.
+  if (num_ids >= 7) {
+    __cpuidex(cpu_info, 7, 0);
+    has_avx2_ = has_avx_ && (cpu_info[1] & 0x00000020) != 0;
+  }
+
   // Get the brand string of the cpu.
   __cpuid(cpu_info, 0x80000000);
   const int parameter_end = 0x80000004;
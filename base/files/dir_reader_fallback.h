@@ -23,6 +23,9 @@ class DirReaderFallback {
   // Return the name of the current directory entry.
   const char* name() { return 0;}
 
+  // Return the type of the current directory entry, always DT_UNKNOWN.
+  unsigned char type() const { return 0; }
+
   // Return the file descriptor which is being used.
   int fd() const { return -1; }
 
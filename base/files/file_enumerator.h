@@ -63,6 +63,7 @@ class BASE_EXPORT FileEnumerator {
 
    private:
     friend class FileEnumerator;
+    friend class FileTreeWalker;
 
 #if defined(OS_WIN)
     WIN32_FIND_DATA find_data_;
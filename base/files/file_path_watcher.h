@@ -94,7 +94,9 @@ class BASE_EXPORT FilePathWatcher {
   // the same loop. Returns true on success.
   //
   // NOTE: Recursive watch is not supported on all platforms and file systems.
-  // Watch() will return false in the case of failure.
+  // Watch() will return false in the case of failure. On Linux, a recursive
+  // watch fails if there are too many directories to watch, and reports a
+  // burst of changes under |path| with a single, slightly delayed callback.
   bool Watch(const FilePath& path, bool recursive, const Callback& callback);
 
  private:
@@ -12,6 +12,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <map>
 #include <set>
 #include <utility>
 #include <vector>
@@ -20,6 +21,7 @@
 #include "base/containers/hash_tables.h"
 #include "base/debug/trace_event.h"
 #include "base/file_util.h"
+#include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/lazy_instance.h"
 #include "base/location.h"
@@ -28,13 +30,23 @@
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_loop_proxy.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/stl_util.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/thread.h"
+#include "base/time/time.h"
 
 namespace base {
 
 namespace {
 
+// Most systems let a user have 8192 inotify watches in all, so a recursive
+// watch of a large tree gives up instead of using all of them.
+const size_t kMaxRecursiveWatches = 4096;
+
+// Changes under a recursive watch are reported at most once per this delay,
+// so that a burst of changes, such as a copy into the tree, is reported once.
+const int kRecursiveNotificationDelayMs = 100;
+
 class FilePathWatcherImpl;
 
 // Singleton to manage all inotify watches.
@@ -55,6 +67,10 @@ class InotifyReader {
   // Callback for InotifyReaderTask.
   void OnInotifyEvent(const inotify_event* event);
 
+  // Called when the inotify event queue overflowed. All watchers are told,
+  // since the lost events can't be attributed.
+  void OnEventsLost();
+
  private:
   friend struct DefaultLazyInstanceTraits<InotifyReader>;
 
@@ -92,10 +108,15 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate,
   // Called for each event coming from the watch. |fired_watch| identifies the
   // watch that fired, |child| indicates what has changed, and is relative to
   // the currently watched path for |fired_watch|. The flag |created| is true if
-  // the object appears.
+  // the object appears, and |is_dir| is true if it is a directory.
   void OnFilePathChanged(InotifyReader::Watch fired_watch,
                          const FilePath::StringType& child,
-                         bool created);
+                         bool created,
+                         bool is_dir);
+
+  // Called when inotify events were lost. Re-reads the watched tree and
+  // reports a change.
+  void OnEventsLost();
 
   // Start watching |path| for changes and notify |delegate| on each change.
   // Returns true if watch for |path| has been added successfully.
@@ -115,9 +136,17 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate,
   virtual ~FilePathWatcherImpl() {}
 
  private:
+  typedef std::map<InotifyReader::Watch, FilePath> PathByWatchMap;
+  typedef std::map<FilePath, InotifyReader::Watch> WatchByPathMap;
+
   // Cleans up and stops observing the |message_loop_| thread.
   virtual void CancelOnMessageLoopThread() OVERRIDE;
 
+  // Reports a change of |target_|, right away for a plain watch, or for a
+  // recursive one once the delay for coalescing changes has passed.
+  void NotifyChange();
+  void RunPendingNotification();
+
   // Inotify watches are installed for all directory components of |target_|. A
   // WatchEntry instance holds the watch descriptor for a component and the
   // subdirectory for that identifies the next component. If a symbolic link
@@ -137,6 +166,25 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate,
   // that exists. Updates |watched_path_|. Returns true on success.
   bool UpdateWatches() WARN_UNUSED_RESULT;
 
+  // For a recursive watch, replaces the watches below |target_| with watches
+  // of all the directories there now. Returns false if there are too many.
+  bool UpdateRecursiveWatches() WARN_UNUSED_RESULT;
+
+  // Adds or removes the watches for directory |path| below |target_| and the
+  // directories below it, after |path| was created or deleted. Returns false
+  // if there are too many directories to watch.
+  bool UpdateRecursiveWatchesForPath(const FilePath& path,
+                                     bool created) WARN_UNUSED_RESULT;
+
+  // Watches |path|, unless it is |target_|, and the directories below it.
+  // Returns false if that would exceed kMaxRecursiveWatches.
+  bool AddRecursiveWatches(const FilePath& path) WARN_UNUSED_RESULT;
+  bool AddRecursiveWatch(const FilePath& path) WARN_UNUSED_RESULT;
+
+  // Removes the watches for |path| and the directories below it.
+  void RemoveRecursiveWatches(const FilePath& path);
+  void RemoveAllRecursiveWatches();
+
   // Callback to notify upon changes.
   FilePathWatcher::Callback callback_;
 
@@ -148,6 +196,16 @@ class FilePathWatcherImpl : public FilePathWatcher::PlatformDelegate,
   // |target_| and always stores an empty next component name in |subdir_|.
   WatchVector watches_;
 
+  // Whether the directories below |target_| are watched too.
+  bool recursive_;
+
+  // The watches of the directories below |target_|, for a recursive watch.
+  PathByWatchMap recursive_paths_by_watch_;
+  WatchByPathMap recursive_watches_by_path_;
+
+  // True while a coalesced change notification is posted but hasn't run.
+  bool notification_pending_;
+
   DISALLOW_COPY_AND_ASSIGN(FilePathWatcherImpl);
 };
 
@@ -288,6 +346,11 @@ void InotifyReader::OnInotifyEvent(const inotify_event* event) {
   if (event->mask & IN_IGNORED)
     return;
 
+  if (event->mask & IN_Q_OVERFLOW) {
+    OnEventsLost();
+    return;
+  }
+
   FilePath::StringType child(event->len ? event->name : FILE_PATH_LITERAL(""));
   AutoLock auto_lock(lock_);
 
@@ -296,16 +359,34 @@ void InotifyReader::OnInotifyEvent(const inotify_event* event) {
        ++watcher) {
     (*watcher)->OnFilePathChanged(event->wd,
                                   child,
-                                  event->mask & (IN_CREATE | IN_MOVED_TO));
+                                  event->mask & (IN_CREATE | IN_MOVED_TO),
+                                  event->mask & IN_ISDIR);
+  }
+}
+
+void InotifyReader::OnEventsLost() {
+  AutoLock auto_lock(lock_);
+
+  WatcherSet all_watchers;
+  for (hash_map<Watch, WatcherSet>::const_iterator it = watchers_.begin();
+       it != watchers_.end(); ++it) {
+    all_watchers.insert(it->second.begin(), it->second.end());
+  }
+  for (WatcherSet::iterator watcher = all_watchers.begin();
+       watcher != all_watchers.end(); ++watcher) {
+    (*watcher)->OnEventsLost();
   }
 }
 
-FilePathWatcherImpl::FilePathWatcherImpl() {
+FilePathWatcherImpl::FilePathWatcherImpl()
+    : recursive_(false),
+      notification_pending_(false) {
 }
 
 void FilePathWatcherImpl::OnFilePathChanged(InotifyReader::Watch fired_watch,
                                             const FilePath::StringType& child,
-                                            bool created) {
+                                            bool created,
+                                            bool is_dir) {
   if (!message_loop()->BelongsToCurrentThread()) {
     // Switch to message_loop_ to access watches_ safely.
     message_loop()->PostTask(FROM_HERE,
@@ -313,7 +394,8 @@ void FilePathWatcherImpl::OnFilePathChanged(InotifyReader::Watch fired_watch,
                    this,
                    fired_watch,
                    child,
-                   created));
+                   created,
+                   is_dir));
     return;
   }
 
@@ -358,11 +440,52 @@ void FilePathWatcherImpl::OnFilePathChanged(InotifyReader::Watch fired_watch,
       if (target_changed ||
           (change_on_target_path && !created) ||
           (change_on_target_path && PathExists(target_))) {
-        callback_.Run(target_, false);
+        // A directory appearing in or leaving |target_| itself.
+        if (recursive_ && is_dir && !child.empty() &&
+            watch_entry->subdir_.empty() && watch_entry->linkname_.empty() &&
+            !UpdateRecursiveWatchesForPath(target_.Append(child), created)) {
+          callback_.Run(target_, true /* error */);
+          return;
+        }
+        NotifyChange();
         return;
       }
     }
   }
+
+  // Otherwise the change may be further below |target_|.
+  PathByWatchMap::const_iterator recursive_watch =
+      recursive_paths_by_watch_.find(fired_watch);
+  if (recursive_watch == recursive_paths_by_watch_.end())
+    return;
+
+  if (is_dir && !child.empty()) {
+    FilePath changed_dir = recursive_watch->second.Append(child);
+    if (!UpdateRecursiveWatchesForPath(changed_dir, created)) {
+      callback_.Run(target_, true /* error */);
+      return;
+    }
+  }
+  NotifyChange();
+}
+
+void FilePathWatcherImpl::OnEventsLost() {
+  if (!message_loop()->BelongsToCurrentThread()) {
+    message_loop()->PostTask(FROM_HERE,
+        Bind(&FilePathWatcherImpl::OnEventsLost, this));
+    return;
+  }
+
+  // The watch was cancelled already.
+  if (watches_.empty())
+    return;
+
+  // Directories may have come and gone unnoticed, so watch them all again.
+  if (!UpdateWatches() || !UpdateRecursiveWatches()) {
+    callback_.Run(target_, true /* error */);
+    return;
+  }
+  NotifyChange();
 }
 
 bool FilePathWatcherImpl::Watch(const FilePath& path,
@@ -370,15 +493,11 @@ bool FilePathWatcherImpl::Watch(const FilePath& path,
                                 const FilePathWatcher::Callback& callback) {
   DCHECK(target_.empty());
   DCHECK(MessageLoopForIO::current());
-  if (recursive) {
-    // Recursive watch is not supported on this platform.
-    NOTIMPLEMENTED();
-    return false;
-  }
 
   set_message_loop(MessageLoopProxy::current().get());
   callback_ = callback;
   target_ = path;
+  recursive_ = recursive;
   MessageLoop::current()->AddDestructionObserver(this);
 
   std::vector<FilePath::StringType> comps;
@@ -425,6 +544,7 @@ void FilePathWatcherImpl::CancelOnMessageLoopThread() {
       g_inotify_reader.Get().RemoveWatch(watch_entry->watch_, this);
   }
   watches_.clear();
+  RemoveAllRecursiveWatches();
   target_.clear();
 }
 
@@ -437,6 +557,9 @@ bool FilePathWatcherImpl::UpdateWatches() {
   // concurrency issues.
   DCHECK(message_loop()->BelongsToCurrentThread());
 
+  // The watch of |target_| itself, which changes when |target_| is replaced.
+  InotifyReader::Watch old_target_watch = watches_.back().watch_;
+
   // Walk the list of watches and update them as we go.
   FilePath path(FILE_PATH_LITERAL("/"));
   bool path_valid = true;
@@ -481,9 +604,120 @@ bool FilePathWatcherImpl::UpdateWatches() {
     path = path.Append(watch_entry->subdir_);
   }
 
+  if (watches_.back().watch_ != old_target_watch)
+    return UpdateRecursiveWatches();
   return true;
 }
 
+void FilePathWatcherImpl::NotifyChange() {
+  if (!recursive_) {
+    callback_.Run(target_, false);
+    return;
+  }
+
+  if (notification_pending_)
+    return;
+  notification_pending_ = true;
+  message_loop()->PostDelayedTask(
+      FROM_HERE,
+      Bind(&FilePathWatcherImpl::RunPendingNotification, this),
+      TimeDelta::FromMilliseconds(kRecursiveNotificationDelayMs));
+}
+
+void FilePathWatcherImpl::RunPendingNotification() {
+  notification_pending_ = false;
+  // The watch may have been cancelled in the meantime.
+  if (!callback_.is_null())
+    callback_.Run(target_, false);
+}
+
+bool FilePathWatcherImpl::UpdateRecursiveWatches() {
+  RemoveAllRecursiveWatches();
+  if (!recursive_ || watches_.back().watch_ == InotifyReader::kInvalidWatch)
+    return true;
+
+  if (!AddRecursiveWatches(target_)) {
+    RemoveAllRecursiveWatches();
+    return false;
+  }
+  return true;
+}
+
+bool FilePathWatcherImpl::UpdateRecursiveWatchesForPath(const FilePath& path,
+                                                        bool created) {
+  if (!created) {
+    RemoveRecursiveWatches(path);
+    return true;
+  }
+
+  if (!AddRecursiveWatches(path)) {
+    RemoveAllRecursiveWatches();
+    return false;
+  }
+  return true;
+}
+
+bool FilePathWatcherImpl::AddRecursiveWatches(const FilePath& path) {
+  if (path != target_ && !AddRecursiveWatch(path))
+    return false;
+
+  // Symbolic links aren't followed, which also keeps out cycles.
+  FileEnumerator enumerator(
+      path, true, FileEnumerator::DIRECTORIES | FileEnumerator::SHOW_SYM_LINKS);
+  for (FilePath dir = enumerator.Next(); !dir.empty();
+       dir = enumerator.Next()) {
+    if (!AddRecursiveWatch(dir))
+      return false;
+  }
+  return true;
+}
+
+bool FilePathWatcherImpl::AddRecursiveWatch(const FilePath& path) {
+  if (ContainsKey(recursive_watches_by_path_, path))
+    return true;
+
+  if (recursive_watches_by_path_.size() >= kMaxRecursiveWatches) {
+    LOG(WARNING) << "Too many directories to watch below " << target_.value();
+    return false;
+  }
+
+  // A directory that is gone already is skipped; its parent's watch reports
+  // its deletion.  So is a second path to a directory watched already.
+  InotifyReader::Watch watch = g_inotify_reader.Get().AddWatch(path, this);
+  if (watch == InotifyReader::kInvalidWatch ||
+      ContainsKey(recursive_paths_by_watch_, watch)) {
+    return true;
+  }
+
+  recursive_paths_by_watch_[watch] = path;
+  recursive_watches_by_path_[path] = watch;
+  return true;
+}
+
+void FilePathWatcherImpl::RemoveRecursiveWatches(const FilePath& path) {
+  // Paths below |path| sort after it, among others sharing its prefix.
+  WatchByPathMap::iterator it = recursive_watches_by_path_.lower_bound(path);
+  while (it != recursive_watches_by_path_.end() &&
+         it->first.value().compare(0, path.value().size(), path.value()) == 0) {
+    if (it->first == path || path.IsParent(it->first)) {
+      g_inotify_reader.Get().RemoveWatch(it->second, this);
+      recursive_paths_by_watch_.erase(it->second);
+      recursive_watches_by_path_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void FilePathWatcherImpl::RemoveAllRecursiveWatches() {
+  for (PathByWatchMap::const_iterator it = recursive_paths_by_watch_.begin();
+       it != recursive_paths_by_watch_.end(); ++it) {
+    g_inotify_reader.Get().RemoveWatch(it->first, this);
+  }
+  recursive_paths_by_watch_.clear();
+  recursive_watches_by_path_.clear();
+}
+
 }  // namespace
 
 FilePathWatcher::FilePathWatcher() {
@@ -0,0 +1,179 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/file_tree_walker.h"
+
+#include "build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#endif
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/thread_restrictions.h"
+
+#if defined(OS_POSIX)
+#include "base/files/dir_reader_posix.h"
+#endif
+
+namespace base {
+
+namespace {
+
+#if defined(OS_POSIX)
+// Returns the stat() file type bits matching |type|, a DT_* value.
+mode_t FileTypeFromDirentType(unsigned char type) {
+  switch (type) {
+    case DT_BLK:
+      return S_IFBLK;
+    case DT_CHR:
+      return S_IFCHR;
+    case DT_DIR:
+      return S_IFDIR;
+    case DT_FIFO:
+      return S_IFIFO;
+    case DT_LNK:
+      return S_IFLNK;
+    case DT_REG:
+      return S_IFREG;
+    case DT_SOCK:
+      return S_IFSOCK;
+    default:
+      return 0;
+  }
+}
+#endif
+
+}  // namespace
+
+FileTreeWalker::FileTreeWalker(int thread_count, int options)
+    : thread_count_(thread_count),
+      options_(options),
+      visitor_(NULL),
+      work_available_(&lock_),
+      busy_threads_(0) {
+  DCHECK_GE(thread_count_, 1);
+}
+
+FileTreeWalker::~FileTreeWalker() {
+}
+
+bool FileTreeWalker::Walk(const FilePath& root_path, Visitor* visitor) {
+  ThreadRestrictions::AssertIOAllowed();
+  DCHECK(visitor);
+  DCHECK(!visitor_) << "Walk() is not reentrant";
+
+#if defined(OS_POSIX)
+  if (!DirReaderPosix::IsFallback()) {
+    if (!DirReaderPosix(root_path.value().c_str()).IsValid())
+      return false;
+
+    visitor_ = visitor;
+    pending_paths_.push_back(root_path);
+
+    ScopedVector<DelegateSimpleThread> threads;
+    for (int i = 1; i < thread_count_; ++i) {
+      threads.push_back(new DelegateSimpleThread(this, "FileTreeWalker"));
+      threads.back()->Start();
+    }
+    Run();
+    for (size_t i = 0; i < threads.size(); ++i)
+      threads[i]->Join();
+
+    DCHECK(pending_paths_.empty());
+    visitor_ = NULL;
+    return true;
+  }
+#endif
+
+  if (!DirectoryExists(root_path))
+    return false;
+
+  int file_type = FileEnumerator::FILES | FileEnumerator::DIRECTORIES;
+#if defined(OS_POSIX)
+  file_type |= FileEnumerator::SHOW_SYM_LINKS;
+#endif
+  FileEnumerator enumerator(root_path, true, file_type);
+  for (FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    visitor->OnEntry(path, enumerator.GetInfo());
+  }
+  return true;
+}
+
+void FileTreeWalker::Run() {
+  std::vector<FilePath> subdirectories;
+
+  AutoLock auto_lock(lock_);
+  while (true) {
+    while (pending_paths_.empty() && busy_threads_ > 0)
+      work_available_.Wait();
+    if (pending_paths_.empty())
+      return;
+
+    // Reading the most recently found directory first keeps the stack of
+    // pending directories short, as in a depth-first search.
+    FilePath dir = pending_paths_.back();
+    pending_paths_.pop_back();
+    ++busy_threads_;
+    {
+      AutoUnlock auto_unlock(lock_);
+      subdirectories.clear();
+      ReadDirectory(dir, &subdirectories);
+    }
+    --busy_threads_;
+
+    pending_paths_.insert(pending_paths_.end(), subdirectories.begin(),
+                          subdirectories.end());
+    // Wake up the threads waiting for work, or for the walk to end.
+    if (!subdirectories.empty() || busy_threads_ == 0)
+      work_available_.Broadcast();
+  }
+}
+
+void FileTreeWalker::ReadDirectory(const FilePath& dir,
+                                   std::vector<FilePath>* subdirectories) {
+#if defined(OS_POSIX)
+  DirReaderPosix reader(dir.value().c_str());
+  if (!reader.IsValid()) {
+    DPLOG(WARNING) << "Couldn't open " << dir.value();
+    return;
+  }
+
+  while (reader.Next()) {
+    const char* name = reader.name();
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+      continue;
+
+    FileEnumerator::FileInfo info;
+    info.filename_ = FilePath(name);
+    unsigned char type = reader.type();
+    if ((options_ & STAT_ENTRIES) || type == DT_UNKNOWN) {
+      if (fstatat(reader.fd(), name, &info.stat_, AT_SYMLINK_NOFOLLOW) < 0) {
+        // The entry may have been deleted since the directory was read.
+        DPLOG_IF(ERROR, errno != ENOENT) << "Couldn't stat "
+                                         << dir.Append(name).value();
+        memset(&info.stat_, 0, sizeof(info.stat_));
+      }
+    } else {
+      info.stat_.st_mode = FileTypeFromDirentType(type);
+    }
+
+    FilePath path = dir.Append(info.filename_);
+    if (info.IsDirectory())
+      subdirectories->push_back(path);
+    visitor_->OnEntry(path, info);
+  }
+#else
+  NOTREACHED();
+#endif
+}
+
+}  // namespace base
@@ -0,0 +1,220 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/file_tree_walker.h"
+
+#include <map>
+#include <set>
+
+#include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the entries it is given, with their sizes.
+class RecordingVisitor : public FileTreeWalker::Visitor {
+ public:
+  RecordingVisitor() {}
+  virtual ~RecordingVisitor() {}
+
+  virtual void OnEntry(const FilePath& path,
+                       const FileEnumerator::FileInfo& info) OVERRIDE {
+    AutoLock auto_lock(lock_);
+    EXPECT_EQ(path.BaseName(), info.GetName());
+    EXPECT_FALSE(ContainsPath(path)) << path.value();
+    if (info.IsDirectory())
+      directories_.insert(path);
+    else
+      file_sizes_[path] = info.GetSize();
+  }
+
+  const std::set<FilePath>& directories() const { return directories_; }
+  const std::map<FilePath, int64>& file_sizes() const { return file_sizes_; }
+
+ private:
+  bool ContainsPath(const FilePath& path) const {
+    return directories_.count(path) || file_sizes_.count(path);
+  }
+
+  Lock lock_;
+  std::set<FilePath> directories_;
+  std::map<FilePath, int64> file_sizes_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingVisitor);
+};
+
+// Counts the entries it is given.
+class CountingVisitor : public FileTreeWalker::Visitor {
+ public:
+  CountingVisitor() : count_(0) {}
+  virtual ~CountingVisitor() {}
+
+  virtual void OnEntry(const FilePath& path,
+                       const FileEnumerator::FileInfo& info) OVERRIDE {
+    AutoLock auto_lock(lock_);
+    ++count_;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  Lock lock_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingVisitor);
+};
+
+bool CreateTextFile(const FilePath& path, const std::string& contents) {
+  return file_util::WriteFile(path, contents.data(), contents.size()) ==
+      static_cast<int>(contents.size());
+}
+
+}  // namespace
+
+class FileTreeWalkerTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  // Creates |dir_count| directories below the temp dir, each nested in the
+  // previous one every third time, with |files_per_dir| files in each.
+  void CreateTree(int dir_count, int files_per_dir) {
+    FilePath parent = temp_dir_.path();
+    for (int i = 0; i < dir_count; ++i) {
+      FilePath dir = parent.AppendASCII("dir" + IntToString(i));
+      ASSERT_TRUE(CreateDirectory(dir));
+      for (int j = 0; j < files_per_dir; ++j) {
+        ASSERT_TRUE(CreateTextFile(dir.AppendASCII("file" + IntToString(j)),
+                                   std::string(j, 'x')));
+      }
+      if (i % 3 == 0)
+        parent = dir;
+    }
+  }
+
+  ScopedTempDir temp_dir_;
+};
+
+TEST_F(FileTreeWalkerTest, VisitsEveryEntry) {
+  CreateTree(20, 10);
+
+  RecordingVisitor visitor;
+  FileTreeWalker walker(4, FileTreeWalker::STAT_ENTRIES);
+  ASSERT_TRUE(walker.Walk(temp_dir_.path(), &visitor));
+
+  // Compare to what FileEnumerator finds.
+  std::set<FilePath> directories;
+  std::map<FilePath, int64> file_sizes;
+  FileEnumerator enumerator(temp_dir_.path(), true,
+                            FileEnumerator::FILES |
+                            FileEnumerator::DIRECTORIES);
+  for (FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    if (enumerator.GetInfo().IsDirectory())
+      directories.insert(path);
+    else
+      file_sizes[path] = enumerator.GetInfo().GetSize();
+  }
+  EXPECT_EQ(20u, directories.size());
+  EXPECT_EQ(200u, file_sizes.size());
+  EXPECT_TRUE(directories == visitor.directories());
+  EXPECT_TRUE(file_sizes == visitor.file_sizes());
+}
+
+TEST_F(FileTreeWalkerTest, WithoutStat) {
+  CreateTree(10, 5);
+
+  RecordingVisitor visitor;
+  FileTreeWalker walker(3, 0);
+  ASSERT_TRUE(walker.Walk(temp_dir_.path(), &visitor));
+  EXPECT_EQ(10u, visitor.directories().size());
+  EXPECT_EQ(50u, visitor.file_sizes().size());
+}
+
+TEST_F(FileTreeWalkerTest, EmptyDirectory) {
+  RecordingVisitor visitor;
+  FileTreeWalker walker(4, 0);
+  ASSERT_TRUE(walker.Walk(temp_dir_.path(), &visitor));
+  EXPECT_TRUE(visitor.directories().empty());
+  EXPECT_TRUE(visitor.file_sizes().empty());
+}
+
+TEST_F(FileTreeWalkerTest, NonExistentDirectory) {
+  RecordingVisitor visitor;
+  FileTreeWalker walker(4, 0);
+  EXPECT_FALSE(walker.Walk(temp_dir_.path().AppendASCII("missing"),
+                           &visitor));
+}
+
+#if defined(OS_POSIX)
+TEST_F(FileTreeWalkerTest, SymbolicLinksAreNotFollowed) {
+  FilePath dir = temp_dir_.path().AppendASCII("dir");
+  ASSERT_TRUE(CreateDirectory(dir));
+  ASSERT_TRUE(CreateTextFile(dir.AppendASCII("file"), "content"));
+  // A link back up the tree, which would make a cycle if followed.
+  FilePath link = dir.AppendASCII("link");
+  ASSERT_TRUE(CreateSymbolicLink(temp_dir_.path(), link));
+
+  RecordingVisitor visitor;
+  FileTreeWalker walker(2, 0);
+  ASSERT_TRUE(walker.Walk(temp_dir_.path(), &visitor));
+  EXPECT_EQ(1u, visitor.directories().size());
+  EXPECT_EQ(2u, visitor.file_sizes().size());
+  EXPECT_EQ(1u, visitor.file_sizes().count(link));
+}
+#endif  // defined(OS_POSIX)
+
+// Compares walking a tree of 1M files to enumerating it with FileEnumerator.
+// The tree stays in the page cache after being created, so this measures the
+// CPU side of the scan.  Disabled since it is a benchmark.
+TEST_F(FileTreeWalkerTest, DISABLED_MillionFiles) {
+  const int kDirCount = 1000;
+  const int kFilesPerDir = 1000;
+  for (int i = 0; i < kDirCount; ++i) {
+    FilePath dir = temp_dir_.path().AppendASCII("dir" + IntToString(i));
+    ASSERT_TRUE(CreateDirectory(dir));
+    for (int j = 0; j < kFilesPerDir; ++j)
+      ASSERT_TRUE(CreateTextFile(dir.AppendASCII(IntToString(j)), ""));
+  }
+  const int kEntryCount = kDirCount * (kFilesPerDir + 1);
+
+  TimeTicks start = TimeTicks::Now();
+  int count = 0;
+  FileEnumerator enumerator(temp_dir_.path(), true,
+                            FileEnumerator::FILES |
+                            FileEnumerator::DIRECTORIES);
+  for (FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    ++count;
+  }
+  EXPECT_EQ(kEntryCount, count);
+  LOG(INFO) << "FileEnumerator: "
+            << (TimeTicks::Now() - start).InMilliseconds() << " ms";
+
+  const int kThreadCounts[] = { 1, 4, 8 };
+  for (size_t i = 0; i < arraysize(kThreadCounts); ++i) {
+    for (int options = 0; options <= FileTreeWalker::STAT_ENTRIES;
+         options += FileTreeWalker::STAT_ENTRIES) {
+      start = TimeTicks::Now();
+      CountingVisitor visitor;
+      FileTreeWalker walker(kThreadCounts[i], options);
+      ASSERT_TRUE(walker.Walk(temp_dir_.path(), &visitor));
+      EXPECT_EQ(kEntryCount, visitor.count());
+      LOG(INFO) << "FileTreeWalker, " << kThreadCounts[i] << " threads"
+                << (options ? ", with stat: " : ": ")
+                << (TimeTicks::Now() - start).InMilliseconds() << " ms";
+    }
+  }
+}
+
+}  // namespace base
@@ -13,15 +13,20 @@
 #include <stdio.h>
 
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/critical_closure.h"
 #include "base/file_util.h"
 #include "base/files/file.h"
 #include "base/files/file_path.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
 #include "base/metrics/histogram.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
 #include "base/task_runner.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
@@ -49,48 +54,138 @@ void LogFailure(const FilePath& path, TempFileFailure failure_code,
                  << " : " << message;
 }
 
-}  // namespace
+// A write waiting to be committed by an AtomicWriteGroup.
+struct PendingWrite {
+  PendingWrite(const FilePath& path, const std::string& data)
+      : path(path),
+        data(data),
+        committed(false),
+        success(false) {}
 
-// static
-bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
-                                              const std::string& data) {
-  // Write the data to a temp file then rename to avoid data loss if we crash
-  // while writing the file. Ensure that the temp file is on the same volume
-  // as target file, so it can be moved in one step, and that the temp file
-  // is securely created.
+  const FilePath& path;
+  const std::string& data;
   FilePath tmp_file_path;
-  if (!base::CreateTemporaryFileInDir(path.DirName(), &tmp_file_path)) {
-    LogFailure(path, FAILED_CREATING, "could not create temporary file");
-    return false;
-  }
+  bool committed;
+  bool success;
+};
 
-  File tmp_file(tmp_file_path, File::FLAG_OPEN | File::FLAG_WRITE);
-  if (!tmp_file.IsValid()) {
-    LogFailure(path, FAILED_OPENING, "could not open temporary file");
-    return false;
+// Commits the atomic writes of all threads together: while one thread writes
+// and flushes a batch, writes from other threads queue up, and the first of
+// them to run next commits the whole queue at once.  All the files of a batch
+// are written before any is flushed, so that the file system gets to schedule
+// all the data together, and the later flushes find little left to do.
+class AtomicWriteGroup {
+ public:
+  AtomicWriteGroup() : committed_(&lock_), committing_(false) {}
+
+  // Blocks until |data| has been written to |path| in an atomic manner.
+  bool Write(const FilePath& path, const std::string& data) {
+    PendingWrite write(path, data);
+
+    AutoLock auto_lock(lock_);
+    queue_.push_back(&write);
+    while (committing_ && !write.committed)
+      committed_.Wait();
+    if (write.committed)
+      return write.success;
+
+    std::vector<PendingWrite*> batch;
+    batch.swap(queue_);
+    committing_ = true;
+    {
+      AutoUnlock auto_unlock(lock_);
+      CommitBatch(batch);
+    }
+    committing_ = false;
+    committed_.Broadcast();
+
+    DCHECK(write.committed);
+    return write.success;
   }
 
-  // If this happens in the wild something really bad is going on.
-  CHECK_LE(data.length(), static_cast<size_t>(kint32max));
-  int bytes_written = tmp_file.Write(0, data.data(),
-                                     static_cast<int>(data.length()));
-  tmp_file.Flush();  // Ignore return value.
-  tmp_file.Close();
-
-  if (bytes_written < static_cast<int>(data.length())) {
-    LogFailure(path, FAILED_WRITING, "error writing, bytes_written=" +
-               IntToString(bytes_written));
-    base::DeleteFile(tmp_file_path, false);
-    return false;
+ private:
+  // Write the data to temp files then rename them to avoid data loss if we
+  // crash while writing the files. Ensure that the temp files are on the same
+  // volume as target files, so they can be moved in one step, and that the
+  // temp files are securely created.
+  static void CommitBatch(const std::vector<PendingWrite*>& batch) {
+    ScopedVector<File> tmp_files;
+    for (size_t i = 0; i < batch.size(); ++i)
+      tmp_files.push_back(WriteTempFile(batch[i]));
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (tmp_files[i]) {
+        tmp_files[i]->Flush();  // Ignore return value.
+        tmp_files[i]->Close();
+      }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      PendingWrite* write = batch[i];
+      if (tmp_files[i]) {
+        write->success =
+            base::ReplaceFile(write->tmp_file_path, write->path, NULL);
+        if (!write->success) {
+          LogFailure(write->path, FAILED_RENAMING,
+                     "could not rename temporary file");
+          base::DeleteFile(write->tmp_file_path, false);
+        }
+      }
+      write->committed = true;
+    }
   }
 
-  if (!base::ReplaceFile(tmp_file_path, path, NULL)) {
-    LogFailure(path, FAILED_RENAMING, "could not rename temporary file");
-    base::DeleteFile(tmp_file_path, false);
-    return false;
+  // Returns the temp file holding the data of |write|, still open so that it
+  // can be flushed, or NULL if it couldn't be written.
+  static File* WriteTempFile(PendingWrite* write) {
+    if (!base::CreateTemporaryFileInDir(write->path.DirName(),
+                                        &write->tmp_file_path)) {
+      LogFailure(write->path, FAILED_CREATING,
+                 "could not create temporary file");
+      return NULL;
+    }
+
+    scoped_ptr<File> tmp_file(
+        new File(write->tmp_file_path, File::FLAG_OPEN | File::FLAG_WRITE));
+    if (!tmp_file->IsValid()) {
+      LogFailure(write->path, FAILED_OPENING, "could not open temporary file");
+      return NULL;
+    }
+
+    // If this happens in the wild something really bad is going on.
+    CHECK_LE(write->data.length(), static_cast<size_t>(kint32max));
+    int bytes_written = tmp_file->Write(0, write->data.data(),
+                                        static_cast<int>(write->data.length()));
+    if (bytes_written < static_cast<int>(write->data.length())) {
+      LogFailure(write->path, FAILED_WRITING, "error writing, bytes_written=" +
+                 IntToString(bytes_written));
+      tmp_file->Close();
+      base::DeleteFile(write->tmp_file_path, false);
+      return NULL;
+    }
+    return tmp_file.release();
   }
 
-  return true;
+  // Protects the members below.
+  Lock lock_;
+  ConditionVariable committed_;
+
+  // Writes waiting for the next batch.
+  std::vector<PendingWrite*> queue_;
+  bool committing_;
+
+  DISALLOW_COPY_AND_ASSIGN(AtomicWriteGroup);
+};
+
+LazyInstance<AtomicWriteGroup>::Leaky g_write_group =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
+                                              const std::string& data) {
+  return g_write_group.Get().Write(path, data);
 }
 
 ImportantFileWriter::ImportantFileWriter(
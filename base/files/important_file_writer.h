@@ -52,7 +52,10 @@ class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
   };
 
   // Save |data| to |path| in an atomic manner (see the class comment above).
-  // Blocks and writes data on the current thread.
+  // Blocks and writes data on the current thread.  Calls made at the same
+  // time on several threads, such as the writes of many ImportantFileWriters
+  // at shutdown, are committed as one batch: all the files are written before
+  // any of them is flushed, instead of paying for a write and a flush per file.
   static bool WriteFileAtomically(const FilePath& path,
                                   const std::string& data);
 
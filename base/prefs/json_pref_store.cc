@@ -8,13 +8,21 @@
 
 #include "base/bind.h"
 #include "base/callback.h"
+#include "base/location.h"
+#include "base/critical_closure.h"
 #include "base/file_util.h"
+#include "base/files/file.h"
+#include "base/files/important_file_writer.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_reader.h"
 #include "base/json/json_string_value_serializer.h"
+#include "base/json/json_writer.h"
+#include "base/md5.h"
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop_proxy.h"
 #include "base/prefs/pref_filter.h"
 #include "base/sequenced_task_runner.h"
+#include "base/strings/string_split.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "base/values.h"
 
@@ -22,6 +30,166 @@ namespace {
 
 // Some extensions we'll tack on to copies of the Preferences files.
 const base::FilePath::CharType* kBadExtension = FILE_PATH_LITERAL("bad");
+const base::FilePath::CharType* kLogExtension = FILE_PATH_LITERAL("log");
+
+// Same as the default commit interval of ImportantFileWriter.
+const int kCommitIntervalMs = 10000;
+
+// The change log is folded into the file once it is larger than both the file
+// and this size, so that small files aren't rewritten on every other commit.
+const size_t kMinLogSizeToCompact = 64 * 1024;
+
+// Keys of a change log record.  A record without a value removes the pref.
+const char kLogKey[] = "key";
+const char kLogValue[] = "value";
+
+// Key of the first line of a change log, which holds the MD5 of the file the
+// log applies to.
+const char kLogSnapshot[] = "snapshot";
+
+base::FilePath GetChangeLogPath(const base::FilePath& path) {
+  return path.AddExtension(kLogExtension);
+}
+
+std::string MakeChangeLogHeader(const std::string& snapshot_hash) {
+  base::DictionaryValue header;
+  header.SetStringWithoutPathExpansion(kLogSnapshot, snapshot_hash);
+  std::string line;
+  base::JSONWriter::Write(&header, &line);
+  line.push_back('\n');
+  return line;
+}
+
+// Applies the records of the change log for |path| to |prefs|, if the log
+// applies to a file with the MD5 |snapshot_hash|.  Returns the size of the log
+// replayed.  A record that can't be parsed, such as one cut short by a crash,
+// is skipped.
+size_t ReplayChangeLog(const base::FilePath& path,
+                       const std::string& snapshot_hash,
+                       base::DictionaryValue* prefs) {
+  std::string log;
+  if (!base::ReadFileToString(GetChangeLogPath(path), &log))
+    return 0;
+
+  // A log for another version of the file was left behind by a crash while
+  // the file was being rewritten, and is older than the file.
+  const std::string header = MakeChangeLogHeader(snapshot_hash);
+  if (log.compare(0, header.size(), header) != 0) {
+    DLOG(WARNING) << "Ignoring stale change log of " << path.value();
+    return 0;
+  }
+
+  std::vector<std::string> lines;
+  base::SplitString(log.substr(header.size()), '\n', &lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (lines[i].empty())
+      continue;
+    scoped_ptr<base::Value> record_value(base::JSONReader::Read(lines[i]));
+    base::DictionaryValue* record = NULL;
+    std::string key;
+    if (!record_value || !record_value->GetAsDictionary(&record) ||
+        !record->GetStringWithoutPathExpansion(kLogKey, &key)) {
+      DLOG(WARNING) << "Skipping bad record in " << path.value();
+      continue;
+    }
+    scoped_ptr<base::Value> value;
+    if (record->RemoveWithoutPathExpansion(kLogValue, &value))
+      prefs->Set(key, value.release());
+    else
+      prefs->RemovePath(key, NULL);
+  }
+  return log.size();
+}
+
+}  // namespace
+
+// Writes the file and its change log.  Only used on the sequenced task
+// runner, where it knows which version of the file is on disk even when a
+// write fails.
+class JsonPrefStore::ChangeLogWriter
+    : public base::RefCountedThreadSafe<ChangeLogWriter> {
+ public:
+  explicit ChangeLogWriter(const base::FilePath& path)
+      : path_(path), log_path_(GetChangeLogPath(path)) {}
+
+  // Records that the file on disk has the MD5 |snapshot_hash|.
+  void SetSnapshotHash(const std::string& snapshot_hash) {
+    snapshot_hash_ = snapshot_hash;
+  }
+
+  // Appends |records| to the change log, first starting a new log if the one
+  // on disk is missing or applies to another version of the file.  A record
+  // left without its newline by a crash is ended first, so that it doesn't
+  // swallow the first of |records|.
+  void AppendToChangeLog(const std::string& records) {
+    if (snapshot_hash_.empty()) {
+      DLOG(WARNING) << "No file to log changes to " << path_.value();
+      return;
+    }
+
+    base::File log(log_path_, base::File::FLAG_OPEN_ALWAYS |
+                                  base::File::FLAG_READ |
+                                  base::File::FLAG_APPEND);
+    if (!log.IsValid()) {
+      DPLOG(WARNING) << "Failed to open " << log_path_.value();
+      return;
+    }
+
+    std::string data;
+    const std::string header = MakeChangeLogHeader(snapshot_hash_);
+    std::string existing_header(header.size(), '\0');
+    int bytes_read = log.Read(0, &existing_header[0],
+                              static_cast<int>(existing_header.size()));
+    if (bytes_read != static_cast<int>(header.size()) ||
+        existing_header != header) {
+      log.SetLength(0);
+      data = header;
+    } else {
+      int64 length = log.GetLength();
+      char last = '\n';
+      if (length > static_cast<int64>(header.size()) &&
+          log.Read(length - 1, &last, 1) == 1 && last != '\n') {
+        data.push_back('\n');
+      }
+    }
+    data.append(records);
+
+    int bytes_written =
+        log.WriteAtCurrentPos(data.data(), static_cast<int>(data.size()));
+    log.Flush();  // Ignore return value.
+    if (bytes_written != static_cast<int>(data.size()))
+      DPLOG(WARNING) << "Failed to append to " << log_path_.value();
+  }
+
+  // Writes |data| to the file, then deletes the change log it supersedes.
+  // The log is kept if the write fails, since the old file still needs it.
+  // Whether the write succeeded is posted to |on_written| on |reply_loop|.
+  void WriteSnapshot(const std::string& data,
+                     const std::string& snapshot_hash,
+                     const scoped_refptr<base::MessageLoopProxy>& reply_loop,
+                     const base::Callback<void(bool)>& on_written) {
+    bool success = base::ImportantFileWriter::WriteFileAtomically(path_, data);
+    if (success) {
+      snapshot_hash_ = snapshot_hash;
+      base::DeleteFile(log_path_, false);
+    }
+    reply_loop->PostTask(FROM_HERE, base::Bind(on_written, success));
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ChangeLogWriter>;
+  ~ChangeLogWriter() {}
+
+  const base::FilePath path_;
+  const base::FilePath log_path_;
+
+  // MD5 of the file on disk, or empty if there is none.
+  std::string snapshot_hash_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChangeLogWriter);
+};
+
+namespace {
 
 // Differentiates file loading between origin thread and passed
 // (aka file) thread.
@@ -49,7 +217,7 @@ class FileThreadDeserializer
   void ReadFileAndReport(const base::FilePath& path) {
     DCHECK(sequenced_task_runner_->RunsTasksOnCurrentThread());
 
-    value_.reset(DoReading(path, &error_, &no_dir_));
+    value_.reset(DoReading(path, &error_, &no_dir_, &read_state_));
 
     origin_loop_proxy_->PostTask(
         FROM_HERE,
@@ -59,17 +227,27 @@ class FileThreadDeserializer
   // Reports deserialization result on the origin thread.
   void ReportOnOriginThread() {
     DCHECK(origin_loop_proxy_->BelongsToCurrentThread());
-    delegate_->OnFileRead(value_.release(), error_, no_dir_);
+    delegate_->OnFileRead(value_.release(), error_, no_dir_, read_state_);
   }
 
   static base::Value* DoReading(const base::FilePath& path,
                                 PersistentPrefStore::PrefReadError* error,
-                                bool* no_dir) {
+                                bool* no_dir,
+                                JsonPrefStore::ReadState* read_state) {
     int error_code;
     std::string error_msg;
     JSONFileValueSerializer serializer(path);
     base::Value* value = serializer.Deserialize(&error_code, &error_msg);
     HandleErrors(value, path, error_code, error_msg, error);
+    std::string contents;
+    if (*error == PersistentPrefStore::PREF_READ_ERROR_NONE &&
+        base::ReadFileToString(path, &contents)) {
+      read_state->snapshot_hash = base::MD5String(contents);
+      read_state->snapshot_size = contents.size();
+      read_state->log_size =
+          ReplayChangeLog(path, read_state->snapshot_hash,
+                          static_cast<base::DictionaryValue*>(value));
+    }
     *no_dir = !base::PathExists(path.DirName());
     return value;
   }
@@ -86,6 +264,7 @@ class FileThreadDeserializer
 
   bool no_dir_;
   PersistentPrefStore::PrefReadError error_;
+  JsonPrefStore::ReadState read_state_;
   scoped_ptr<base::Value> value_;
   const scoped_refptr<JsonPrefStore> delegate_;
   const scoped_refptr<base::SequencedTaskRunner> sequenced_task_runner_;
@@ -151,17 +330,23 @@ scoped_refptr<base::SequencedTaskRunner> JsonPrefStore::GetTaskRunnerForFile(
       base::SequencedWorkerPool::BLOCK_SHUTDOWN);
 }
 
+JsonPrefStore::ReadState::ReadState() : snapshot_size(0), log_size(0) {}
+
 JsonPrefStore::JsonPrefStore(const base::FilePath& filename,
                              base::SequencedTaskRunner* sequenced_task_runner,
                              scoped_ptr<PrefFilter> pref_filter)
     : path_(filename),
       sequenced_task_runner_(sequenced_task_runner),
+      writer_(new ChangeLogWriter(filename)),
       prefs_(new base::DictionaryValue()),
       read_only_(false),
-      writer_(filename, sequenced_task_runner),
+      needs_snapshot_(true),
+      snapshot_size_(0),
+      log_size_(0),
       pref_filter_(pref_filter.Pass()),
       initialized_(false),
-      read_error_(PREF_READ_ERROR_OTHER) {}
+      read_error_(PREF_READ_ERROR_OTHER),
+      weak_ptr_factory_(this) {}
 
 bool JsonPrefStore::GetValue(const std::string& key,
                              const base::Value** result) const {
@@ -214,8 +399,7 @@ void JsonPrefStore::SetValueSilently(const std::string& key,
   prefs_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
     prefs_->Set(key, new_value.release());
-    if (!read_only_)
-      writer_.ScheduleWrite(this);
+    ScheduleCommit(key);
   }
 }
 
@@ -234,15 +418,16 @@ PersistentPrefStore::PrefReadError JsonPrefStore::GetReadError() const {
 
 PersistentPrefStore::PrefReadError JsonPrefStore::ReadPrefs() {
   if (path_.empty()) {
-    OnFileRead(NULL, PREF_READ_ERROR_FILE_NOT_SPECIFIED, false);
+    OnFileRead(NULL, PREF_READ_ERROR_FILE_NOT_SPECIFIED, false, ReadState());
     return PREF_READ_ERROR_FILE_NOT_SPECIFIED;
   }
 
   PrefReadError error;
   bool no_dir;
+  ReadState read_state;
   base::Value* value =
-      FileThreadDeserializer::DoReading(path_, &error, &no_dir);
-  OnFileRead(value, error, no_dir);
+      FileThreadDeserializer::DoReading(path_, &error, &no_dir, &read_state);
+  OnFileRead(value, error, no_dir, read_state);
   return error;
 }
 
@@ -250,7 +435,7 @@ void JsonPrefStore::ReadPrefsAsync(ReadErrorDelegate *error_delegate) {
   initialized_ = false;
   error_delegate_.reset(error_delegate);
   if (path_.empty()) {
-    OnFileRead(NULL, PREF_READ_ERROR_FILE_NOT_SPECIFIED, false);
+    OnFileRead(NULL, PREF_READ_ERROR_FILE_NOT_SPECIFIED, false, ReadState());
     return;
   }
 
@@ -262,8 +447,10 @@ void JsonPrefStore::ReadPrefsAsync(ReadErrorDelegate *error_delegate) {
 }
 
 void JsonPrefStore::CommitPendingWrite() {
-  if (writer_.HasPendingWrite() && !read_only_)
-    writer_.DoScheduledWrite();
+  if (commit_timer_.IsRunning() && !read_only_) {
+    commit_timer_.Stop();
+    DoScheduledCommit();
+  }
 }
 
 void JsonPrefStore::ReportValueChanged(const std::string& key) {
@@ -272,13 +459,13 @@ void JsonPrefStore::ReportValueChanged(const std::string& key) {
 
   FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
 
-  if (!read_only_)
-    writer_.ScheduleWrite(this);
+  ScheduleCommit(key);
 }
 
 void JsonPrefStore::OnFileRead(base::Value* value_owned,
                                PersistentPrefStore::PrefReadError error,
-                               bool no_dir) {
+                               bool no_dir,
+                               const ReadState& read_state) {
   scoped_ptr<base::Value> value(value_owned);
   read_error_ = error;
 
@@ -302,6 +489,16 @@ void JsonPrefStore::OnFileRead(base::Value* value_owned,
     case PREF_READ_ERROR_NONE:
       DCHECK(value.get());
       prefs_.reset(static_cast<base::DictionaryValue*>(value.release()));
+      if (!read_state.snapshot_hash.empty()) {
+        // Keep logging changes against the file that was read.
+        needs_snapshot_ = false;
+        snapshot_size_ = read_state.snapshot_size;
+        log_size_ = read_state.log_size;
+        sequenced_task_runner_->PostTask(
+            FROM_HERE,
+            base::Bind(&ChangeLogWriter::SetSnapshotHash, writer_,
+                       read_state.snapshot_hash));
+      }
       break;
     case PREF_READ_ERROR_NO_FILE:
       // If the file just doesn't exist, maybe this is first run.  In any case
@@ -314,8 +511,16 @@ void JsonPrefStore::OnFileRead(base::Value* value_owned,
       NOTREACHED() << "Unknown error: " << error;
   }
 
-  if (pref_filter_)
+  if (pref_filter_) {
+    // The filter may change prefs without reporting which, so any change it
+    // makes is only persisted by rewriting the whole file.
+    scoped_ptr<base::DictionaryValue> loaded_prefs;
+    if (!needs_snapshot_)
+      loaded_prefs.reset(prefs_->DeepCopy());
     pref_filter_->FilterOnLoad(prefs_.get());
+    if (loaded_prefs && !loaded_prefs->Equals(prefs_.get()))
+      needs_snapshot_ = true;
+  }
 
   if (error_delegate_.get() && error != PREF_READ_ERROR_NONE)
     error_delegate_->OnError(error);
@@ -329,6 +534,98 @@ JsonPrefStore::~JsonPrefStore() {
   CommitPendingWrite();
 }
 
+void JsonPrefStore::ScheduleCommit(const std::string& key) {
+  if (read_only_)
+    return;
+
+  changed_keys_.insert(key);
+  if (!commit_timer_.IsRunning()) {
+    commit_timer_.Start(FROM_HERE,
+                        base::TimeDelta::FromMilliseconds(kCommitIntervalMs),
+                        this,
+                        &JsonPrefStore::DoScheduledCommit);
+  }
+}
+
+void JsonPrefStore::DoScheduledCommit() {
+  if (needs_snapshot_) {
+    WriteSnapshot();
+    return;
+  }
+
+  if (pref_filter_)
+    pref_filter_->FilterSerializeData(prefs_.get());
+
+  // Changed keys are written parent first, since a path sorts before the paths
+  // under it.  Each record holds the current value, so a later record for a
+  // child agrees with the earlier one for its parent.
+  std::string records;
+  for (std::set<std::string>::const_iterator it = changed_keys_.begin();
+       it != changed_keys_.end(); ++it) {
+    base::DictionaryValue record;
+    record.SetStringWithoutPathExpansion(kLogKey, *it);
+    const base::Value* value = NULL;
+    if (prefs_->Get(*it, &value))
+      record.SetWithoutPathExpansion(kLogValue, value->DeepCopy());
+
+    std::string line;
+    base::JSONWriter::Write(&record, &line);
+    records.append(line);
+    records.push_back('\n');
+  }
+  changed_keys_.clear();
+
+  if (log_size_ + records.size() >
+      std::max(kMinLogSizeToCompact, snapshot_size_)) {
+    WriteSnapshot();
+    return;
+  }
+
+  log_size_ += records.size();
+  sequenced_task_runner_->PostTask(
+      FROM_HERE,
+      base::MakeCriticalClosure(
+          base::Bind(&ChangeLogWriter::AppendToChangeLog, writer_, records)));
+}
+
+void JsonPrefStore::WriteSnapshot() {
+  std::string data;
+  if (!SerializeData(&data)) {
+    DLOG(WARNING) << "Failed to serialize " << path_.value();
+    return;
+  }
+
+  changed_keys_.clear();
+  needs_snapshot_ = false;
+  snapshot_size_ = data.size();
+  log_size_ = 0;
+  sequenced_task_runner_->PostTask(
+      FROM_HERE,
+      base::MakeCriticalClosure(
+          base::Bind(&ChangeLogWriter::WriteSnapshot, writer_, data,
+                     base::MD5String(data),
+                     base::MessageLoopProxy::current(),
+                     base::Bind(&JsonPrefStore::OnSnapshotWritten,
+                                weak_ptr_factory_.GetWeakPtr()))));
+}
+
+void JsonPrefStore::OnSnapshotWritten(bool success) {
+  if (success)
+    return;
+
+  // The file on disk is older than the changes the failed write held, and
+  // commits since then were logged against the wrong file, or not at all if
+  // there was none, so they can only be saved by rewriting it.
+  DLOG(WARNING) << "Failed to write " << path_.value();
+  needs_snapshot_ = true;
+  if (log_size_ > 0 && !commit_timer_.IsRunning()) {
+    commit_timer_.Start(FROM_HERE,
+                        base::TimeDelta::FromMilliseconds(kCommitIntervalMs),
+                        this,
+                        &JsonPrefStore::DoScheduledCommit);
+  }
+}
+
 bool JsonPrefStore::SerializeData(std::string* output) {
   if (pref_filter_)
     pref_filter_->FilterSerializeData(prefs_.get());
@@ -11,12 +11,13 @@
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
 #include "base/files/file_path.h"
-#include "base/files/important_file_writer.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop_proxy.h"
 #include "base/observer_list.h"
 #include "base/prefs/base_prefs_export.h"
 #include "base/prefs/persistent_pref_store.h"
+#include "base/timer/timer.h"
 
 class PrefFilter;
 
@@ -30,9 +31,15 @@ class Value;
 
 
 // A writable PrefStore implementation that is used for user preferences.
-class BASE_PREFS_EXPORT JsonPrefStore
-    : public PersistentPrefStore,
-      public base::ImportantFileWriter::DataSerializer {
+//
+// Commits append the changed prefs to a change log next to the JSON file (the
+// file name with ".log" added), one JSON record per line, until the log grows
+// larger than the file itself; the next commit then rewrites the file
+// atomically and deletes the log.  The log starts with the MD5 of the file it
+// applies to, and loading only replays it over that same file, so a log left
+// behind by a crash during a rewrite is ignored.  The file is rewritten
+// whole when there is no valid file to log changes against.
+class BASE_PREFS_EXPORT JsonPrefStore : public PersistentPrefStore {
  public:
   // Returns instance of SequencedTaskRunner which guarantees that file
   // operations on the same file will be executed in sequenced order.
@@ -68,27 +75,71 @@ class BASE_PREFS_EXPORT JsonPrefStore
   virtual void CommitPendingWrite() OVERRIDE;
   virtual void ReportValueChanged(const std::string& key) OVERRIDE;
 
+  // What was read along with the prefs, for OnFileRead().
+  struct ReadState {
+    ReadState();
+
+    // MD5 and size of the JSON file, if it was read and parsed.
+    std::string snapshot_hash;
+    size_t snapshot_size;
+
+    // Size of the change log replayed over the file, if any.
+    size_t log_size;
+  };
+
   // This method is called after JSON file has been read. Method takes
   // ownership of the |value| pointer. Note, this method is used with
   // asynchronous file reading, so class exposes it only for the internal needs.
   // (read: do not call it manually).
-  void OnFileRead(base::Value* value_owned, PrefReadError error, bool no_dir);
+  void OnFileRead(base::Value* value_owned,
+                  PrefReadError error,
+                  bool no_dir,
+                  const ReadState& read_state);
 
  private:
+  class ChangeLogWriter;
+
   virtual ~JsonPrefStore();
 
-  // ImportantFileWriter::DataSerializer overrides:
-  virtual bool SerializeData(std::string* output) OVERRIDE;
+  // Records that |key| changed and starts the commit timer if needed.
+  void ScheduleCommit(const std::string& key);
+
+  // Writes the changes recorded since the last commit, either by appending
+  // them to the change log or by rewriting the whole file.
+  void DoScheduledCommit();
+
+  // Rewrites the whole file, then deletes the change log it replaces.
+  void WriteSnapshot();
+
+  // Called on the origin thread once the write posted by WriteSnapshot() has
+  // run.  A failed write makes the next commit rewrite the file again.
+  void OnSnapshotWritten(bool success);
+
+  bool SerializeData(std::string* output);
 
   base::FilePath path_;
   const scoped_refptr<base::SequencedTaskRunner> sequenced_task_runner_;
 
+  // Writes the file and the change log on |sequenced_task_runner_|.
+  const scoped_refptr<ChangeLogWriter> writer_;
+
   scoped_ptr<base::DictionaryValue> prefs_;
 
   bool read_only_;
 
-  // Helper for safely writing pref data.
-  base::ImportantFileWriter writer_;
+  // Delays commits so that changes made close together are written at once.
+  base::OneShotTimer<JsonPrefStore> commit_timer_;
+
+  // Keys changed since the last commit.
+  std::set<std::string> changed_keys_;
+
+  // True if the next commit must rewrite the whole file, because there is no
+  // valid file on disk for the change log to apply to.
+  bool needs_snapshot_;
+
+  // Sizes of the last whole file written and of the change log since then.
+  size_t snapshot_size_;
+  size_t log_size_;
 
   scoped_ptr<PrefFilter> pref_filter_;
   ObserverList<PrefStore::Observer, true> observers_;
@@ -100,6 +151,8 @@ class BASE_PREFS_EXPORT JsonPrefStore
 
   std::set<std::string> keys_need_empty_value_;
 
+  base::WeakPtrFactory<JsonPrefStore> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(JsonPrefStore);
 };
 
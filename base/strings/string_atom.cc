@@ -0,0 +1,85 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/string_atom.h"
+
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/containers/hash_tables.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+namespace {
+
+// The atoms are indexed by their string.
+typedef hash_map<StringPiece, const StringAtom*> AtomMap;
+
+struct AtomTable {
+  Lock lock;
+  AtomMap atoms;
+};
+
+LazyInstance<AtomTable>::Leaky g_atom_table = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+const StringAtom* StringAtom::Intern(const StringPiece& string) {
+  AtomTable& table = g_atom_table.Get();
+  AutoLock lock(table.lock);
+  AtomMap::iterator it = table.atoms.find(string);
+  if (it != table.atoms.end()) {
+    if (it->second->TryAddRef())
+      return it->second;
+    // The last reference to the atom was released on another thread, which
+    // will delete it once it gets the lock.
+    table.atoms.erase(it);
+  }
+  StringAtom* atom = new StringAtom(string);
+  table.atoms.insert(std::make_pair(StringPiece(atom->string_), atom));
+  return atom;
+}
+
+void StringAtom::AddRef() const {
+  AtomicRefCountInc(&ref_count_);
+}
+
+void StringAtom::Release() const {
+  if (AtomicRefCountDec(&ref_count_))
+    return;
+  AtomTable& table = g_atom_table.Get();
+  {
+    AutoLock lock(table.lock);
+    // The atom may have been replaced by Intern() in the meantime.
+    AtomMap::iterator it = table.atoms.find(string_);
+    if (it != table.atoms.end() && it->second == this)
+      table.atoms.erase(it);
+  }
+  delete this;
+}
+
+StringAtom::StringAtom(const StringPiece& string)
+    : ref_count_(1),
+      string_(string.data(), string.size()) {
+}
+
+StringAtom::~StringAtom() {
+}
+
+bool StringAtom::TryAddRef() const {
+  for (;;) {
+    subtle::Atomic32 count = subtle::NoBarrier_Load(&ref_count_);
+    if (!count)
+      return false;
+    if (subtle::NoBarrier_CompareAndSwap(&ref_count_, count, count + 1) ==
+        count) {
+      return true;
+    }
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,58 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A StringAtom is an immutable string shared by all its users: interning
+// the same string twice gives the same StringAtom, so that it is stored only
+// once, and two atoms are equal if and only if they are the same object.
+// This saves memory when the same strings are stored many times, like the
+// keys of DictionaryValue.
+//
+// Atoms are reference counted, and can be used from any thread. They are
+// deleted, and removed from the table of atoms, when their last reference is
+// released.
+//
+// Example:
+//   const StringAtom* atom = StringAtom::Intern("key");
+//   DCHECK_EQ(atom, StringAtom::Intern("key"));  // Leaks a reference.
+//   atom->Release();
+
+#ifndef BASE_STRINGS_STRING_ATOM_H_
+#define BASE_STRINGS_STRING_ATOM_H_
+
+#include <string>
+
+#include "base/atomic_ref_count.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+class BASE_EXPORT StringAtom {
+ public:
+  // Returns the atom of |string|, with a reference for the caller.
+  static const StringAtom* Intern(const StringPiece& string);
+
+  void AddRef() const;
+  void Release() const;
+
+  const std::string& string() const { return string_; }
+
+ private:
+  explicit StringAtom(const StringPiece& string);
+  ~StringAtom();
+
+  // Adds a reference, unless the last one was released. The table of atoms
+  // must be locked.
+  bool TryAddRef() const;
+
+  mutable AtomicRefCount ref_count_;
+  const std::string string_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringAtom);
+};
+
+}  // namespace base
+
+#endif  // BASE_STRINGS_STRING_ATOM_H_
@@ -0,0 +1,78 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/string_atom.h"
+
+#include <string>
+
+#include "base/memory/scoped_vector.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Interns and releases the same few strings as the other threads.
+class AtomUser : public DelegateSimpleThread::Delegate {
+ public:
+  AtomUser() {}
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < 10000; ++i) {
+      std::string string = IntToString(i % 10);
+      const StringAtom* atom = StringAtom::Intern(string);
+      EXPECT_EQ(string, atom->string());
+      atom->Release();
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(AtomUser);
+};
+
+}  // namespace
+
+TEST(StringAtomTest, Intern) {
+  const StringAtom* atom = StringAtom::Intern("key");
+  EXPECT_EQ("key", atom->string());
+  const StringAtom* same_atom = StringAtom::Intern(std::string("key"));
+  EXPECT_EQ(atom, same_atom);
+  const StringAtom* other_atom = StringAtom::Intern("other key");
+  EXPECT_NE(atom, other_atom);
+  EXPECT_EQ("other key", other_atom->string());
+
+  same_atom->Release();
+  other_atom->Release();
+  atom->AddRef();
+  atom->Release();
+  EXPECT_EQ(atom, StringAtom::Intern("key"));
+  atom->Release();
+  atom->Release();
+}
+
+TEST(StringAtomTest, EmptyString) {
+  const StringAtom* atom = StringAtom::Intern("");
+  EXPECT_TRUE(atom->string().empty());
+  EXPECT_EQ(atom, StringAtom::Intern(std::string()));
+  atom->Release();
+  atom->Release();
+}
+
+// Atoms released on one thread while another interns the same string are
+// either reused or replaced, never used after being deleted.
+TEST(StringAtomTest, ConcurrentInternAndRelease) {
+  ScopedVector<AtomUser> users;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < 4; ++i) {
+    users.push_back(new AtomUser);
+    threads.push_back(new DelegateSimpleThread(users.back(), "AtomUser"));
+    threads.back()->Start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+}
+
+}  // namespace base
@@ -0,0 +1,78 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/read_write_lock.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+ReadWriteLock::ReadWriteLock()
+    : readers_can_enter_(&lock_),
+      writer_can_enter_(&lock_),
+      active_readers_(0),
+      waiting_writers_(0),
+      writer_active_(false),
+      writer_thread_id_(kInvalidThreadId) {
+}
+
+ReadWriteLock::~ReadWriteLock() {
+  DCHECK_EQ(0, active_readers_);
+  DCHECK_EQ(0, waiting_writers_);
+  DCHECK(!writer_active_);
+}
+
+void ReadWriteLock::ReadAcquire() {
+  AutoLock auto_lock(lock_);
+  while (writer_active_ || waiting_writers_ > 0)
+    readers_can_enter_.Wait();
+  ++active_readers_;
+}
+
+void ReadWriteLock::ReadRelease() {
+  AutoLock auto_lock(lock_);
+  DCHECK_GT(active_readers_, 0);
+  --active_readers_;
+  if (active_readers_ == 0 && waiting_writers_ > 0)
+    writer_can_enter_.Signal();
+}
+
+void ReadWriteLock::WriteAcquire() {
+  AutoLock auto_lock(lock_);
+  ++waiting_writers_;
+  while (writer_active_ || active_readers_ > 0)
+    writer_can_enter_.Wait();
+  --waiting_writers_;
+  writer_active_ = true;
+  writer_thread_id_ = PlatformThread::CurrentId();
+}
+
+void ReadWriteLock::WriteRelease() {
+  AutoLock auto_lock(lock_);
+  DCHECK(writer_active_);
+  DCHECK_EQ(writer_thread_id_, PlatformThread::CurrentId());
+  writer_thread_id_ = kInvalidThreadId;
+  writer_active_ = false;
+  if (waiting_writers_ > 0)
+    writer_can_enter_.Signal();
+  else
+    readers_can_enter_.Broadcast();
+}
+
+void ReadWriteLock::AssertAcquired() const {
+#if !defined(NDEBUG)
+  AutoLock auto_lock(lock_);
+  DCHECK(writer_active_ || active_readers_ > 0);
+#endif
+}
+
+void ReadWriteLock::AssertWriteAcquired() const {
+#if !defined(NDEBUG)
+  AutoLock auto_lock(lock_);
+  DCHECK(writer_active_);
+  DCHECK_EQ(writer_thread_id_, PlatformThread::CurrentId());
+#endif
+}
+
+}  // namespace base
@@ -0,0 +1,87 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SYNCHRONIZATION_READ_WRITE_LOCK_H_
+#define BASE_SYNCHRONIZATION_READ_WRITE_LOCK_H_
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+
+namespace base {
+
+// A lock that is held either by any number of readers, or by a single writer.
+//
+// Writers are preferred: once a writer waits for the lock, new readers wait
+// until it has been released, so that a steady flow of readers can't starve
+// the writers.  As with Lock, recursive acquisition is not allowed, in either
+// mode: a reader acquiring the lock again would deadlock with a waiting
+// writer.
+class BASE_EXPORT ReadWriteLock {
+ public:
+  ReadWriteLock();
+  ~ReadWriteLock();
+
+  void ReadAcquire();
+  void ReadRelease();
+
+  void WriteAcquire();
+  void WriteRelease();
+
+  // Check that the lock is held, in either mode for AssertAcquired(), and by
+  // the current thread as a writer for AssertWriteAcquired().  They do
+  // nothing in release builds.
+  void AssertAcquired() const;
+  void AssertWriteAcquired() const;
+
+ private:
+  // Protects the members below.
+  mutable Lock lock_;
+  ConditionVariable readers_can_enter_;
+  ConditionVariable writer_can_enter_;
+
+  int active_readers_;
+  int waiting_writers_;
+  bool writer_active_;
+  PlatformThreadId writer_thread_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadWriteLock);
+};
+
+// Helpers that hold a ReadWriteLock for their scope.
+class AutoReadLock {
+ public:
+  explicit AutoReadLock(ReadWriteLock& lock) : lock_(lock) {
+    lock_.ReadAcquire();
+  }
+
+  ~AutoReadLock() {
+    lock_.ReadRelease();
+  }
+
+ private:
+  ReadWriteLock& lock_;
+  DISALLOW_COPY_AND_ASSIGN(AutoReadLock);
+};
+
+class AutoWriteLock {
+ public:
+  explicit AutoWriteLock(ReadWriteLock& lock) : lock_(lock) {
+    lock_.WriteAcquire();
+  }
+
+  ~AutoWriteLock() {
+    lock_.WriteRelease();
+  }
+
+ private:
+  ReadWriteLock& lock_;
+  DISALLOW_COPY_AND_ASSIGN(AutoWriteLock);
+};
+
+}  // namespace base
+
+#endif  // BASE_SYNCHRONIZATION_READ_WRITE_LOCK_H_
@@ -0,0 +1,115 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/read_write_lock.h"
+
+#include <stdlib.h>
+
+#include "base/compiler_specific.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+// Test that readers don't exclude each other ----------------------------------
+
+class ReadLockTestThread : public PlatformThread::Delegate {
+ public:
+  explicit ReadLockTestThread(ReadWriteLock* lock) : lock_(lock) {}
+
+  virtual void ThreadMain() OVERRIDE {
+    AutoReadLock auto_lock(*lock_);
+  }
+
+ private:
+  ReadWriteLock* lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadLockTestThread);
+};
+
+TEST(ReadWriteLockTest, ReadersShareTheLock) {
+  ReadWriteLock lock;
+  AutoReadLock auto_lock(lock);
+  lock.AssertAcquired();
+
+  // This thread would never finish if it couldn't get the lock.
+  ReadLockTestThread thread(&lock);
+  PlatformThreadHandle handle;
+  ASSERT_TRUE(PlatformThread::Create(0, &thread, &handle));
+  PlatformThread::Join(handle);
+}
+
+// Test that writers exclude readers and other writers -------------------------
+
+// Writers keep |first| and |second| equal, so readers that see them differ
+// ran at the same time as a writer.
+struct SharedPair {
+  SharedPair() : first(0), second(0) {}
+
+  int first;
+  int second;
+};
+
+class ReadWriteTestThread : public PlatformThread::Delegate {
+ public:
+  ReadWriteTestThread(ReadWriteLock* lock, SharedPair* pair, bool writer)
+      : lock_(lock),
+        pair_(pair),
+        writer_(writer),
+        mismatches_(0) {}
+
+  virtual void ThreadMain() OVERRIDE {
+    for (int i = 0; i < 40; i++) {
+      if (writer_) {
+        AutoWriteLock auto_lock(*lock_);
+        lock_->AssertWriteAcquired();
+        pair_->first++;
+        PlatformThread::Sleep(TimeDelta::FromMilliseconds(rand() % 2));
+        pair_->second++;
+      } else {
+        AutoReadLock auto_lock(*lock_);
+        int first = pair_->first;
+        PlatformThread::Sleep(TimeDelta::FromMilliseconds(rand() % 2));
+        if (first != pair_->second)
+          mismatches_++;
+      }
+    }
+  }
+
+  int mismatches() const { return mismatches_; }
+
+ private:
+  ReadWriteLock* lock_;
+  SharedPair* pair_;
+  const bool writer_;
+  int mismatches_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadWriteTestThread);
+};
+
+TEST(ReadWriteLockTest, WritersAreExclusive) {
+  const int kThreadCount = 8;
+  ReadWriteLock lock;
+  SharedPair pair;
+  ReadWriteTestThread* threads[kThreadCount];
+  PlatformThreadHandle handles[kThreadCount];
+
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads[i] = new ReadWriteTestThread(&lock, &pair, i % 2 == 0);
+    ASSERT_TRUE(PlatformThread::Create(0, threads[i], &handles[i]));
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < kThreadCount; ++i) {
+    PlatformThread::Join(handles[i]);
+    mismatches += threads[i]->mismatches();
+    delete threads[i];
+  }
+
+  EXPECT_EQ(0, mismatches);
+  EXPECT_EQ(kThreadCount / 2 * 40, pair.first);
+  EXPECT_EQ(kThreadCount / 2 * 40, pair.second);
+}
+
+}  // namespace base
@@ -13,6 +13,7 @@
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/move.h"
+#include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
 
@@ -20,6 +21,44 @@ namespace base {
 
 namespace {
 
+// The number of entries a DictionaryValue keeps in its sorted vector before
+// moving them to a map.
+const size_t kMaxFlatDictionarySize = 32;
+
+// Orders the entries of a DictionaryValue against keys. All the overloads are
+// needed by the debug checks of some STL implementations.
+struct EntryKeyLess {
+  bool operator()(const FlatValueMap::value_type& entry,
+                  const std::string& key) const {
+    return entry.first->string() < key;
+  }
+  bool operator()(const std::string& key,
+                  const FlatValueMap::value_type& entry) const {
+    return key < entry.first->string();
+  }
+  bool operator()(const FlatValueMap::value_type& lhs,
+                  const FlatValueMap::value_type& rhs) const {
+    return lhs.first->string() < rhs.first->string();
+  }
+};
+
+// Returns the entry of |key| in |dictionary|, or the position where it should
+// be inserted.
+FlatValueMap::iterator LowerBound(FlatValueMap* dictionary,
+                                  const std::string& key) {
+  return std::lower_bound(dictionary->begin(), dictionary->end(), key,
+                          EntryKeyLess());
+}
+
+FlatValueMap::const_iterator FindEntry(const FlatValueMap& dictionary,
+                                       const std::string& key) {
+  FlatValueMap::const_iterator it = std::lower_bound(
+      dictionary.begin(), dictionary.end(), key, EntryKeyLess());
+  if (it == dictionary.end() || it->first->string() != key)
+    return dictionary.end();
+  return it;
+}
+
 // Make a deep copy of |node|, but don't include empty lists or dictionaries
 // in the copy. It's possible for this function to return NULL and it
 // expects |node| to always be non-NULL.
@@ -381,19 +420,43 @@ bool DictionaryValue::GetAsDictionary(const DictionaryValue** out_value) const {
 
 bool DictionaryValue::HasKey(const std::string& key) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator current_entry = dictionary_.find(key);
+  if (large_dictionary_) {
+    ValueMap::const_iterator current_entry = large_dictionary_->find(key);
+    DCHECK((current_entry == large_dictionary_->end()) ||
+           current_entry->second);
+    return current_entry != large_dictionary_->end();
+  }
+  FlatValueMap::const_iterator current_entry = FindEntry(dictionary_, key);
   DCHECK((current_entry == dictionary_.end()) || current_entry->second);
   return current_entry != dictionary_.end();
 }
 
 void DictionaryValue::Clear() {
-  ValueMap::iterator dict_iterator = dictionary_.begin();
+  FlatValueMap::iterator dict_iterator = dictionary_.begin();
   while (dict_iterator != dictionary_.end()) {
+    dict_iterator->first->Release();
     delete dict_iterator->second;
     ++dict_iterator;
   }
-
   dictionary_.clear();
+
+  if (large_dictionary_) {
+    STLDeleteValues(large_dictionary_.get());
+    large_dictionary_.reset();
+  }
+}
+
+void DictionaryValue::ConvertToLargeDictionary() {
+  DCHECK(!large_dictionary_);
+  large_dictionary_.reset(new ValueMap);
+  // The entries are sorted, so each one goes at the end of the map.
+  for (FlatValueMap::const_iterator it = dictionary_.begin();
+       it != dictionary_.end(); ++it) {
+    large_dictionary_->insert(large_dictionary_->end(),
+                              std::make_pair(it->first->string(), it->second));
+    it->first->Release();
+  }
+  FlatValueMap().swap(dictionary_);
 }
 
 void DictionaryValue::Set(const std::string& path, Value* in_value) {
@@ -446,13 +509,33 @@ void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
   // If there's an existing value here, we need to delete it, because
   // we own all our children.
-  std::pair<ValueMap::iterator, bool> ins_res =
-      dictionary_.insert(std::make_pair(key, in_value));
-  if (!ins_res.second) {
-    DCHECK_NE(ins_res.first->second, in_value);  // This would be bogus
-    delete ins_res.first->second;
-    ins_res.first->second = in_value;
+  if (large_dictionary_) {
+    std::pair<ValueMap::iterator, bool> ins_res =
+        large_dictionary_->insert(std::make_pair(key, in_value));
+    if (!ins_res.second) {
+      DCHECK_NE(ins_res.first->second, in_value);  // This would be bogus
+      delete ins_res.first->second;
+      ins_res.first->second = in_value;
+    }
+    return;
+  }
+  FlatValueMap::iterator entry_iterator = LowerBound(&dictionary_, key);
+  if (entry_iterator != dictionary_.end() &&
+      entry_iterator->first->string() == key) {
+    DCHECK_NE(entry_iterator->second, in_value);  // This would be bogus
+    delete entry_iterator->second;
+    entry_iterator->second = in_value;
+    return;
+  }
+  if (dictionary_.size() >= kMaxFlatDictionarySize) {
+    ConvertToLargeDictionary();
+    large_dictionary_->insert(std::make_pair(key, in_value));
+    return;
   }
+  // Dictionaries are mostly built in key order, e.g. when parsing JSON
+  // written by JSONWriter, so this usually appends.
+  dictionary_.insert(entry_iterator,
+                     std::make_pair(StringAtom::Intern(key), in_value));
 }
 
 void DictionaryValue::SetBooleanWithoutPathExpansion(
@@ -628,11 +711,19 @@ bool DictionaryValue::GetList(const std::string& path, ListValue** out_value) {
 bool DictionaryValue::GetWithoutPathExpansion(const std::string& key,
                                               const Value** out_value) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
-    return false;
+  const Value* entry = NULL;
+  if (large_dictionary_) {
+    ValueMap::const_iterator entry_iterator = large_dictionary_->find(key);
+    if (entry_iterator == large_dictionary_->end())
+      return false;
+    entry = entry_iterator->second;
+  } else {
+    FlatValueMap::const_iterator entry_iterator = FindEntry(dictionary_, key);
+    if (entry_iterator == dictionary_.end())
+      return false;
+    entry = entry_iterator->second;
+  }
 
-  const Value* entry = entry_iterator->second;
   if (out_value)
     *out_value = entry;
   return true;
@@ -757,15 +848,30 @@ bool DictionaryValue::Remove(const std::string& path,
 bool DictionaryValue::RemoveWithoutPathExpansion(const std::string& key,
                                                  scoped_ptr<Value>* out_value) {
   DCHECK(IsStringUTF8(key));
-  ValueMap::iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
+  if (large_dictionary_) {
+    ValueMap::iterator entry_iterator = large_dictionary_->find(key);
+    if (entry_iterator == large_dictionary_->end())
+      return false;
+    Value* entry = entry_iterator->second;
+    if (out_value)
+      out_value->reset(entry);
+    else
+      delete entry;
+    large_dictionary_->erase(entry_iterator);
+    return true;
+  }
+  FlatValueMap::iterator entry_iterator = LowerBound(&dictionary_, key);
+  if (entry_iterator == dictionary_.end() ||
+      entry_iterator->first->string() != key) {
     return false;
+  }
 
   Value* entry = entry_iterator->second;
   if (out_value)
     out_value->reset(entry);
   else
     delete entry;
+  entry_iterator->first->Release();
   dictionary_.erase(entry_iterator);
   return true;
 }
@@ -814,21 +920,41 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
 
 void DictionaryValue::Swap(DictionaryValue* other) {
   dictionary_.swap(other->dictionary_);
+  large_dictionary_.swap(other->large_dictionary_);
 }
 
 DictionaryValue::Iterator::Iterator(const DictionaryValue& target)
     : target_(target),
-      it_(target.dictionary_.begin()) {}
+      it_(target.dictionary_.begin()) {
+  if (target.large_dictionary_)
+    large_it_ = target.large_dictionary_->begin();
+}
 
 DictionaryValue::Iterator::~Iterator() {}
 
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
 
-  for (ValueMap::const_iterator current_entry(dictionary_.begin());
+  if (large_dictionary_) {
+    result->large_dictionary_.reset(new ValueMap);
+    for (ValueMap::const_iterator current_entry(large_dictionary_->begin());
+         current_entry != large_dictionary_->end(); ++current_entry) {
+      result->large_dictionary_->insert(
+          result->large_dictionary_->end(),
+          std::make_pair(current_entry->first,
+                         current_entry->second->DeepCopy()));
+    }
+    return result;
+  }
+
+  // The entries are already sorted, and the copy shares the keys.
+  result->dictionary_.reserve(dictionary_.size());
+  for (FlatValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
-    result->SetWithoutPathExpansion(current_entry->first,
-                                    current_entry->second->DeepCopy());
+    current_entry->first->AddRef();
+    result->dictionary_.push_back(
+        std::make_pair(current_entry->first,
+                       current_entry->second->DeepCopy()));
   }
 
   return result;
@@ -840,18 +966,31 @@ bool DictionaryValue::Equals(const Value* other) const {
 
   const DictionaryValue* other_dict =
       static_cast<const DictionaryValue*>(other);
-  Iterator lhs_it(*this);
-  Iterator rhs_it(*other_dict);
-  while (!lhs_it.IsAtEnd() && !rhs_it.IsAtEnd()) {
-    if (lhs_it.key() != rhs_it.key() ||
-        !lhs_it.value().Equals(&rhs_it.value())) {
+  if (size() != other_dict->size())
+    return false;
+
+  if (large_dictionary_ || other_dict->large_dictionary_) {
+    // Both representations iterate in key order.
+    Iterator lhs_it(*this);
+    Iterator rhs_it(*other_dict);
+    for (; !lhs_it.IsAtEnd(); lhs_it.Advance(), rhs_it.Advance()) {
+      if (lhs_it.key() != rhs_it.key() ||
+          !lhs_it.value().Equals(&rhs_it.value())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Keys are interned, so equal keys are the same atom.
+  for (FlatValueMap::const_iterator lhs_it(dictionary_.begin()),
+           rhs_it(other_dict->dictionary_.begin());
+       lhs_it != dictionary_.end(); ++lhs_it, ++rhs_it) {
+    if (lhs_it->first != rhs_it->first ||
+        !lhs_it->second->Equals(rhs_it->second)) {
       return false;
     }
-    lhs_it.Advance();
-    rhs_it.Advance();
   }
-  if (!lhs_it.IsAtEnd() || !rhs_it.IsAtEnd())
-    return false;
 
   return true;
 }
@@ -30,6 +30,7 @@
 #include "base/compiler_specific.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string16.h"
+#include "base/strings/string_atom.h"
 
 namespace base {
 
@@ -41,6 +42,9 @@ class Value;
 
 typedef std::vector<Value*> ValueVector;
 typedef std::map<std::string, Value*> ValueMap;
+// The entries of a small DictionaryValue, sorted by key. The keys are
+// interned, since the same keys are used by many dictionaries.
+typedef std::vector<std::pair<const StringAtom*, Value*> > FlatValueMap;
 
 // The Value class is the base class for Values. A Value can be instantiated
 // via the Create*Value() factory methods, or by directly creating instances of
@@ -220,10 +224,12 @@ class BASE_EXPORT DictionaryValue : public Value {
   bool HasKey(const std::string& key) const;
 
   // Returns the number of Values in this dictionary.
-  size_t size() const { return dictionary_.size(); }
+  size_t size() const {
+    return large_dictionary_ ? large_dictionary_->size() : dictionary_.size();
+  }
 
   // Returns whether the dictionary is empty.
-  bool empty() const { return dictionary_.empty(); }
+  bool empty() const { return size() == 0; }
 
   // Clears any current contents of this dictionary.
   void Clear();
@@ -351,15 +357,30 @@ class BASE_EXPORT DictionaryValue : public Value {
     explicit Iterator(const DictionaryValue& target);
     ~Iterator();
 
-    bool IsAtEnd() const { return it_ == target_.dictionary_.end(); }
-    void Advance() { ++it_; }
-
-    const std::string& key() const { return it_->first; }
-    const Value& value() const { return *it_->second; }
+    bool IsAtEnd() const {
+      return target_.large_dictionary_ ?
+          large_it_ == target_.large_dictionary_->end() :
+          it_ == target_.dictionary_.end();
+    }
+    void Advance() {
+      if (target_.large_dictionary_)
+        ++large_it_;
+      else
+        ++it_;
+    }
+
+    const std::string& key() const {
+      return target_.large_dictionary_ ? large_it_->first :
+                                         it_->first->string();
+    }
+    const Value& value() const {
+      return target_.large_dictionary_ ? *large_it_->second : *it_->second;
+    }
 
    private:
     const DictionaryValue& target_;
-    ValueMap::const_iterator it_;
+    FlatValueMap::const_iterator it_;
+    ValueMap::const_iterator large_it_;
   };
 
   // Overridden from Value:
@@ -367,7 +388,15 @@ class BASE_EXPORT DictionaryValue : public Value {
   virtual bool Equals(const Value* other) const OVERRIDE;
 
  private:
-  ValueMap dictionary_;
+  // Moves the entries of |dictionary_| to a new |large_dictionary_|.
+  void ConvertToLargeDictionary();
+
+  // Dictionaries are mostly small, and keep their entries in |dictionary_|,
+  // which is compact and shares keys with other dictionaries. Inserting into
+  // or removing from it is linear though, so once a dictionary grows past a
+  // few dozen entries they are moved to |large_dictionary_| for good.
+  FlatValueMap dictionary_;
+  scoped_ptr<ValueMap> large_dictionary_;
 
   DISALLOW_COPY_AND_ASSIGN(DictionaryValue);
 };
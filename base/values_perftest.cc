@@ -0,0 +1,221 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the cost of DictionaryValue on the kind of documents Chrome keeps
+// in memory: the time to parse and to deep copy them, the time to look up
+// their keys, and the memory used by their copies.
+//
+// The documents are the files listed by --json-files, e.g.
+//   base_perftests --gtest_filter=ValuesPerfTest.* \
+//       --json-files=Default/Preferences,Extensions/foo/1.0/manifest.json
+// or, without it, generated documents shaped like a Preferences file and an
+// extension manifest.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/file_util.h"
+#include "base/files/file_path.h"
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/process/process_handle.h"
+#include "base/process/process_metrics.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const char kJsonFilesSwitch[] = "json-files";
+
+// Number of copies kept alive to measure the memory of a document.
+const int kCopies = 200;
+const int kLookupRounds = 100;
+
+struct Document {
+  Document(const std::string& name, const std::string& json)
+      : name(name), json(json) {}
+
+  std::string name;
+  std::string json;
+};
+
+std::string MakeManifest(int index) {
+  return StringPrintf(
+      "{\"manifest_version\": 2,"
+      " \"name\": \"Extension %d\","
+      " \"version\": \"1.%d.0\","
+      " \"description\": \"Generated extension number %d\","
+      " \"icons\": {\"16\": \"icon16.png\", \"48\": \"icon48.png\","
+      "             \"128\": \"icon128.png\"},"
+      " \"browser_action\": {\"default_icon\": \"icon19.png\","
+      "                      \"default_popup\": \"popup.html\","
+      "                      \"default_title\": \"Extension %d\"},"
+      " \"background\": {\"scripts\": [\"background.js\"],"
+      "                  \"persistent\": false},"
+      " \"content_scripts\": [{\"matches\": [\"http://*/*\", \"https://*/*\"],"
+      "                        \"js\": [\"content.js\"],"
+      "                        \"run_at\": \"document_idle\","
+      "                        \"all_frames\": false}],"
+      " \"permissions\": [\"tabs\", \"storage\", \"contextMenus\","
+      "                   \"http://*/*\", \"https://*/*\"],"
+      " \"web_accessible_resources\": [\"images/*.png\", \"style.css\"],"
+      " \"update_url\": \"https://clients2.google.com/service/update2/crx\"}",
+      index, index, index, index);
+}
+
+// Returns a document with the structure of a Preferences file: many content
+// settings exceptions and installed extensions, which repeat the same keys.
+std::string MakePreferences() {
+  std::string json = "{\"browser\": {\"window_placement\": {\"bottom\": 1000,"
+                     " \"left\": 10, \"maximized\": false, \"right\": 1500,"
+                     " \"top\": 10}, \"show_home_button\": true},"
+                     " \"profile\": {\"content_settings\": {\"pattern_pairs\":"
+                     " {";
+  for (int i = 0; i < 500; ++i) {
+    if (i)
+      json += ", ";
+    json += StringPrintf(
+        "\"[*.]site%d.example.com,*\": {\"cookies\": %d, \"images\": 1,"
+        " \"javascript\": 1, \"plugins\": %d, \"popups\": 2,"
+        " \"geolocation\": {\"https://site%d.example.com\": 1},"
+        " \"last_used\": {\"cookies\": 1400000000.%d}}",
+        i, i % 3, i % 2, i, i);
+  }
+  json += "}}}, \"extensions\": {\"settings\": {";
+  for (int i = 0; i < 50; ++i) {
+    if (i)
+      json += ", ";
+    json += StringPrintf(
+        "\"%032d\": {\"active_permissions\": {\"api\": [\"tabs\","
+        " \"storage\"], \"explicit_host\": [\"http://*/*\"],"
+        " \"scriptable_host\": [\"http://*/*\"]},"
+        " \"creation_flags\": 9, \"from_bookmark\": false,"
+        " \"from_webstore\": true, \"incognito\": false,"
+        " \"install_time\": \"1306%09d\", \"location\": 1,"
+        " \"manifest\": %s,"
+        " \"path\": \"%032d/1.%d.0_0\", \"state\": 1,"
+        " \"was_installed_by_default\": false}",
+        i, i, MakeManifest(i).c_str(), i, i);
+  }
+  json += "}}}";
+  return json;
+}
+
+// Returns the documents to measure.
+std::vector<Document> GetDocuments() {
+  std::vector<Document> documents;
+  const CommandLine* command_line = CommandLine::ForCurrentProcess();
+  if (!command_line->HasSwitch(kJsonFilesSwitch)) {
+    documents.push_back(Document("preferences", MakePreferences()));
+    documents.push_back(Document("manifest", MakeManifest(0)));
+    return documents;
+  }
+
+  std::vector<CommandLine::StringType> paths;
+  SplitString(command_line->GetSwitchValueNative(kJsonFilesSwitch),
+              FILE_PATH_LITERAL(','), &paths);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    FilePath path(paths[i]);
+    std::string json;
+    if (!ReadFileToString(path, &json)) {
+      ADD_FAILURE() << "Can't read " << path.value();
+      continue;
+    }
+    documents.push_back(Document(path.BaseName().AsUTF8Unsafe(), json));
+  }
+  return documents;
+}
+
+// Appends the keys of |dictionary| and of the dictionaries it contains to
+// |keys|, with the dictionaries to look them up in.
+void CollectKeys(
+    const DictionaryValue& dictionary,
+    std::vector<std::pair<const DictionaryValue*, std::string> >* keys) {
+  for (DictionaryValue::Iterator it(dictionary); !it.IsAtEnd(); it.Advance()) {
+    keys->push_back(std::make_pair(&dictionary, it.key()));
+    const DictionaryValue* child;
+    if (it.value().GetAsDictionary(&child))
+      CollectKeys(*child, keys);
+  }
+}
+
+size_t GetWorkingSetSize() {
+#if !defined(OS_MACOSX)
+  scoped_ptr<ProcessMetrics> metrics(
+      ProcessMetrics::CreateProcessMetrics(GetCurrentProcessHandle()));
+#else
+  scoped_ptr<ProcessMetrics> metrics(
+      ProcessMetrics::CreateProcessMetrics(GetCurrentProcessHandle(), NULL));
+#endif
+  return metrics->GetWorkingSetSize();
+}
+
+void RunDocumentBenchmark(const Document& document) {
+  TimeTicks start = TimeTicks::HighResNow();
+  scoped_ptr<Value> value(JSONReader::Read(document.json));
+  TimeDelta parse_time = TimeTicks::HighResNow() - start;
+  const DictionaryValue* dictionary;
+  if (!value || !value->GetAsDictionary(&dictionary)) {
+    ADD_FAILURE() << document.name << " isn't a JSON dictionary";
+    return;
+  }
+  perf_test::PrintResult("values_parse", "", document.name,
+                         parse_time.InMillisecondsF(), "ms", true);
+
+  // The copies share their keys with |dictionary|, so their memory is what
+  // each additional document costs.
+  ScopedVector<DictionaryValue> copies;
+  size_t working_set_before = GetWorkingSetSize();
+  start = TimeTicks::HighResNow();
+  for (int i = 0; i < kCopies; ++i)
+    copies.push_back(dictionary->DeepCopy());
+  TimeDelta copy_time = TimeTicks::HighResNow() - start;
+  size_t working_set_after = GetWorkingSetSize();
+  perf_test::PrintResult("values_deep_copy", "", document.name,
+                         copy_time.InMillisecondsF() / kCopies, "ms", true);
+  if (working_set_after > working_set_before) {
+    perf_test::PrintResult(
+        "values_memory", "", document.name,
+        (working_set_after - working_set_before) / kCopies, "bytes", true);
+  }
+
+  std::vector<std::pair<const DictionaryValue*, std::string> > keys;
+  CollectKeys(*dictionary, &keys);
+  int found = 0;
+  start = TimeTicks::HighResNow();
+  for (int round = 0; round < kLookupRounds; ++round) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const Value* child;
+      if (keys[i].first->GetWithoutPathExpansion(keys[i].second, &child))
+        ++found;
+    }
+  }
+  TimeDelta lookup_time = TimeTicks::HighResNow() - start;
+  EXPECT_EQ(static_cast<int>(keys.size()) * kLookupRounds, found);
+  if (found) {
+    perf_test::PrintResult("values_lookup", "", document.name,
+                           lookup_time.InMicroseconds() * 1000.0 / found,
+                           "ns", true);
+  }
+}
+
+}  // namespace
+
+TEST(ValuesPerfTest, Documents) {
+  std::vector<Document> documents = GetDocuments();
+  for (size_t i = 0; i < documents.size(); ++i)
+    RunDocumentBenchmark(documents[i]);
+}
+
+}  // namespace base
@@ -6,6 +6,7 @@
 
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string16.h"
+#include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -809,4 +810,89 @@ TEST(ValuesTest, DictionaryIterator) {
   EXPECT_TRUE(seen2);
 }
 
+// Keys are iterated in order whatever the order of insertion.
+TEST(ValuesTest, DictionaryIteratorOrder) {
+  const char* kKeys[] = { "b", "", "ab", "a", "c", "ba" };
+  DictionaryValue dict;
+  for (size_t i = 0; i < arraysize(kKeys); ++i)
+    dict.SetIntegerWithoutPathExpansion(kKeys[i], static_cast<int>(i));
+  dict.SetIntegerWithoutPathExpansion("ab", 10);
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("c", NULL));
+  EXPECT_FALSE(dict.RemoveWithoutPathExpansion("c", NULL));
+
+  const char* kExpectedKeys[] = { "", "a", "ab", "b", "ba" };
+  const int kExpectedValues[] = { 1, 3, 10, 0, 5 };
+  size_t i = 0;
+  for (DictionaryValue::Iterator it(dict); !it.IsAtEnd(); it.Advance(), ++i) {
+    ASSERT_LT(i, arraysize(kExpectedKeys));
+    EXPECT_EQ(kExpectedKeys[i], it.key());
+    int value = 0;
+    EXPECT_TRUE(it.value().GetAsInteger(&value));
+    EXPECT_EQ(kExpectedValues[i], value);
+  }
+  EXPECT_EQ(arraysize(kExpectedKeys), i);
+  EXPECT_EQ(arraysize(kExpectedKeys), dict.size());
+
+  // Copies share the keys, and compare equal.
+  scoped_ptr<DictionaryValue> copy(dict.DeepCopy());
+  EXPECT_TRUE(dict.Equals(copy.get()));
+  copy->SetIntegerWithoutPathExpansion("ba", 6);
+  EXPECT_FALSE(dict.Equals(copy.get()));
+}
+
+
+// Large dictionaries built in random order stay sorted, and compare equal to
+// small ones holding the same entries.
+TEST(ValuesTest, LargeDictionaryRandomOrder) {
+  const int kSize = 1000;
+  DictionaryValue dict;
+  // 7919 is prime, so this visits every key once, in scrambled order.
+  for (int i = 0; i < kSize; ++i) {
+    int n = (i * 7919) % kSize;
+    dict.SetIntegerWithoutPathExpansion(StringPrintf("key%04d", n), n);
+  }
+  EXPECT_EQ(static_cast<size_t>(kSize), dict.size());
+  dict.SetIntegerWithoutPathExpansion("key0500", -500);
+
+  int expected = 0;
+  for (DictionaryValue::Iterator it(dict); !it.IsAtEnd(); it.Advance()) {
+    EXPECT_EQ(StringPrintf("key%04d", expected), it.key());
+    int value = 0;
+    EXPECT_TRUE(it.value().GetAsInteger(&value));
+    EXPECT_EQ(expected == 500 ? -500 : expected, value);
+    ++expected;
+  }
+  EXPECT_EQ(kSize, expected);
+
+  scoped_ptr<DictionaryValue> copy(dict.DeepCopy());
+  EXPECT_TRUE(dict.Equals(copy.get()));
+  copy->SetIntegerWithoutPathExpansion("key0999", 0);
+  EXPECT_FALSE(dict.Equals(copy.get()));
+
+  // Keep only the first few keys, and compare against a dictionary that was
+  // never large.
+  for (int i = kSize - 1; i >= 3; --i) {
+    scoped_ptr<Value> removed;
+    EXPECT_TRUE(dict.RemoveWithoutPathExpansion(StringPrintf("key%04d", i),
+                                                &removed));
+    EXPECT_TRUE(removed);
+  }
+  EXPECT_FALSE(dict.HasKey("key0003"));
+  EXPECT_TRUE(dict.HasKey("key0002"));
+  DictionaryValue small;
+  small.SetIntegerWithoutPathExpansion("key0002", 2);
+  small.SetIntegerWithoutPathExpansion("key0000", 0);
+  small.SetIntegerWithoutPathExpansion("key0001", 1);
+  EXPECT_TRUE(dict.Equals(&small));
+  EXPECT_TRUE(small.Equals(&dict));
+  small.SetIntegerWithoutPathExpansion("key0001", 2);
+  EXPECT_FALSE(dict.Equals(&small));
+
+  dict.Clear();
+  EXPECT_TRUE(dict.empty());
+  dict.SetIntegerWithoutPathExpansion("key", 1);
+  EXPECT_TRUE(dict.HasKey("key"));
+  EXPECT_EQ(1U, dict.size());
+}
+
 }  // namespace base
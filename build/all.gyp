@@ -477,11 +477,13 @@
           'target_name': 'chromium_builder_perf',
           'type': 'none',
           'dependencies': [
+            '../base/base.gyp:base_perftests',
             '../cc/cc_tests.gyp:cc_perftests',
             '../chrome/chrome.gyp:chrome',
             '../chrome/chrome.gyp:performance_browser_tests',
             '../chrome/chrome.gyp:performance_ui_tests',
             '../chrome/chrome.gyp:sync_performance_tests',
+            '../gpu/gpu.gyp:gpu_perftests',
             '../media/media.gyp:media_perftests',
             '../tools/perf/clear_system_cache/clear_system_cache.gyp:*',
             '../tools/telemetry/telemetry.gyp:*',
@@ -13,6 +13,9 @@
 #include <vector>
 
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
 #include "skia/ext/convolver.h"
 #include "skia/ext/recursive_gaussian_convolution.h"
 #include "third_party/skia/include/core/SkBitmap.h"
@@ -24,6 +27,158 @@ namespace {
 const float kSigmaThresholdForRecursive = 1.5f;
 const float kAspectRatioToleranceFactor = 1.02f;
 
+// Filter passes over images smaller than this run on the calling thread only,
+// since starting threads would cost more than it saves.
+const int kMinPixelsForParallelFiltering = 512 * 512;
+// The filter passes are largely memory bound, so more threads help little.
+const int kMaxFilterThreads = 4;
+
+// Overloads applying a single pass of either kind of filter used below to a
+// single channel image, along the X axis if |along_x| and the Y axis
+// otherwise. Return the largest output value, when the filter computes it.
+unsigned char ApplyFilterPass(const skia::ConvolutionFilter1D& filter,
+                              bool along_x,
+                              const unsigned char* source,
+                              int source_row_stride,
+                              const SkISize& size,
+                              unsigned char* output,
+                              int output_row_stride,
+                              bool absolute_values) {
+  if (along_x) {
+    skia::SingleChannelConvolveX1D(source, source_row_stride, 0, 1, filter,
+                                   size, output, output_row_stride, 0, 1,
+                                   absolute_values);
+  } else {
+    skia::SingleChannelConvolveY1D(source, source_row_stride, 0, 1, filter,
+                                   size, output, output_row_stride, 0, 1,
+                                   absolute_values);
+  }
+  return 0;
+}
+
+unsigned char ApplyFilterPass(const skia::RecursiveFilter& filter,
+                              bool along_x,
+                              const unsigned char* source,
+                              int source_row_stride,
+                              const SkISize& size,
+                              unsigned char* output,
+                              int output_row_stride,
+                              bool absolute_values) {
+  if (along_x) {
+    return skia::SingleChannelRecursiveGaussianX(
+        source, source_row_stride, 0, 1, filter, size, output,
+        output_row_stride, 0, 1, absolute_values);
+  }
+  return skia::SingleChannelRecursiveGaussianY(
+      source, source_row_stride, 0, 1, filter, size, output,
+      output_row_stride, 0, 1, absolute_values);
+}
+
+// Applies a filter pass to a band of a kA8_Config image: a range of rows for
+// a pass along X, or a range of columns for a pass along Y. Bands of the same
+// pass read and write disjoint parts of the images.
+template<typename Filter>
+class FilterBandDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  FilterBandDelegate(const Filter& filter,
+                     bool along_x,
+                     const SkBitmap& source,
+                     SkBitmap* output,
+                     bool absolute_values,
+                     int band_start,
+                     int band_end)
+      : filter_(filter),
+        along_x_(along_x),
+        source_(source),
+        output_(output),
+        absolute_values_(absolute_values),
+        band_start_(band_start),
+        band_end_(band_end),
+        max_output_(0) {
+  }
+  virtual ~FilterBandDelegate() {}
+
+  virtual void Run() OVERRIDE {
+    const int x = along_x_ ? 0 : band_start_;
+    const int y = along_x_ ? band_start_ : 0;
+    const SkISize size = along_x_ ?
+        SkISize::Make(source_.width(), band_end_ - band_start_) :
+        SkISize::Make(band_end_ - band_start_, source_.height());
+    max_output_ = ApplyFilterPass(filter_,
+                                  along_x_,
+                                  source_.getAddr8(x, y),
+                                  static_cast<int>(source_.rowBytes()),
+                                  size,
+                                  output_->getAddr8(x, y),
+                                  static_cast<int>(output_->rowBytes()),
+                                  absolute_values_);
+  }
+
+  unsigned char max_output() const { return max_output_; }
+
+ private:
+  const Filter& filter_;
+  const bool along_x_;
+  const SkBitmap& source_;
+  SkBitmap* output_;
+  const bool absolute_values_;
+  const int band_start_;
+  const int band_end_;
+  unsigned char max_output_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilterBandDelegate);
+};
+
+// Applies a single pass of |filter| to all of |source| and writes the result
+// to |output|. Large images are split into bands which are filtered in
+// parallel; since no output pixel depends on another band the result is the
+// same either way. Returns the largest output value, if |filter| computes it.
+template<typename Filter>
+unsigned char ApplyFilterPassInBands(const Filter& filter,
+                                     bool along_x,
+                                     const SkBitmap& source,
+                                     SkBitmap* output,
+                                     bool absolute_values) {
+  const int extent = along_x ? source.height() : source.width();
+  int num_bands = 1;
+  if (source.width() * source.height() >= kMinPixelsForParallelFiltering) {
+    num_bands = std::min(base::SysInfo::NumberOfProcessors(),
+                         kMaxFilterThreads);
+  }
+
+  // Band boundaries are kept at multiples of 16 so that only the last band
+  // can end with a partial group of lines for the SIMD filters.
+  ScopedVector<FilterBandDelegate<Filter> > delegates;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  int band_start = 0;
+  for (int band = 0; band < num_bands; ++band) {
+    int band_end = band + 1 == num_bands ?
+        extent : ((band + 1) * extent / num_bands) & ~15;
+    if (band_end <= band_start)
+      continue;
+    delegates.push_back(new FilterBandDelegate<Filter>(
+        filter, along_x, source, output, absolute_values,
+        band_start, band_end));
+    band_start = band_end;
+    if (delegates.size() > 1) {
+      threads.push_back(new base::DelegateSimpleThread(
+          delegates.back(), "ContentAnalysisFilter"));
+      threads.back()->Start();
+    }
+  }
+
+  // The first band is processed on this thread.
+  if (!delegates.empty())
+    delegates[0]->Run();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+
+  unsigned char max_output = 0;
+  for (size_t i = 0; i < delegates.size(); ++i)
+    max_output = std::max(max_output, delegates[i]->max_output());
+  return max_output;
+}
+
 template<class InputIterator, class OutputIterator, class Compare>
 void SlidingWindowMinMax(InputIterator first,
                          InputIterator last,
@@ -255,67 +410,25 @@ void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
     skia::ConvolutionFilter1D smoothing_filter;
     skia::SetUpGaussianConvolutionKernel(
         &smoothing_filter, kernel_sigma, false);
-    skia::SingleChannelConvolveX1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), false);
-    skia::SingleChannelConvolveY1D(
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(), false);
+    ApplyFilterPassInBands(
+        smoothing_filter, true, *input_bitmap, &intermediate, false);
+    ApplyFilterPassInBands(
+        smoothing_filter, false, intermediate, input_bitmap, false);
 
     skia::ConvolutionFilter1D gradient_filter;
     skia::SetUpGaussianConvolutionKernel(&gradient_filter, kernel_sigma, true);
-    skia::SingleChannelConvolveX1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), true);
-    skia::SingleChannelConvolveY1D(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate2.getAddr8(0, 0),
-        static_cast<int>(intermediate2.rowBytes()),
-        0, intermediate2.bytesPerPixel(), true);
+    ApplyFilterPassInBands(
+        gradient_filter, true, *input_bitmap, &intermediate, true);
+    ApplyFilterPassInBands(
+        gradient_filter, false, *input_bitmap, &intermediate2, true);
   } else {
     // For larger sigma values use the recursive filter.
     skia::RecursiveFilter smoothing_filter(kernel_sigma,
                                            skia::RecursiveFilter::FUNCTION);
-    skia::SingleChannelRecursiveGaussianX(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), false);
-    unsigned char smoothed_max = skia::SingleChannelRecursiveGaussianY(
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(),
-        smoothing_filter,
-        image_size,
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(), false);
+    ApplyFilterPassInBands(
+        smoothing_filter, true, *input_bitmap, &intermediate, false);
+    unsigned char smoothed_max = ApplyFilterPassInBands(
+        smoothing_filter, false, intermediate, input_bitmap, false);
     if (smoothed_max < 127) {
       int bit_shift = 8 - static_cast<int>(
           std::log10(static_cast<float>(smoothed_max)) / std::log10(2.0f));
@@ -329,24 +442,10 @@ void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
 
     skia::RecursiveFilter gradient_filter(
         kernel_sigma, skia::RecursiveFilter::FIRST_DERIVATIVE);
-    skia::SingleChannelRecursiveGaussianX(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate.getAddr8(0, 0),
-        static_cast<int>(intermediate.rowBytes()),
-        0, intermediate.bytesPerPixel(), true);
-    skia::SingleChannelRecursiveGaussianY(
-        input_bitmap->getAddr8(0, 0),
-        static_cast<int>(input_bitmap->rowBytes()),
-        0, input_bitmap->bytesPerPixel(),
-        gradient_filter,
-        image_size,
-        intermediate2.getAddr8(0, 0),
-        static_cast<int>(intermediate2.rowBytes()),
-        0, intermediate2.bytesPerPixel(), true);
+    ApplyFilterPassInBands(
+        gradient_filter, true, *input_bitmap, &intermediate, true);
+    ApplyFilterPassInBands(
+        gradient_filter, false, *input_bitmap, &intermediate2, true);
   }
 
   unsigned grad_max = 0;
@@ -396,18 +495,21 @@ void ExtractImageProfileInformation(const SkBitmap& input_bitmap,
   rows->clear();
   columns->clear();
   rows->resize(area.height(), 0);
-  columns->resize(area.width(), 0);
 
+  // Column sums are accumulated as integers, which keeps the inner loop free
+  // of conversions so that it can be vectorized.
+  std::vector<unsigned> column_sums(area.width(), 0);
   for (int r = 0; r < area.height(); ++r) {
     // Points to the first byte of the row in the rectangle.
     const uint8* image_row = input_bitmap.getAddr8(area.x(), r + area.y());
     unsigned row_sum = 0;
-    for (int c = 0; c < area.width(); ++c, ++image_row) {
-      row_sum += *image_row;
-      (*columns)[c] += *image_row;
+    for (int c = 0; c < area.width(); ++c) {
+      row_sum += image_row[c];
+      column_sums[c] += image_row[c];
     }
     (*rows)[r] = row_sum;
   }
+  columns->assign(column_sums.begin(), column_sums.end());
 
   if (apply_log) {
     // Generally for processing we will need to take logarithm of this data.
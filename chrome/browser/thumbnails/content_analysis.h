@@ -20,7 +20,8 @@ namespace thumbnailing_utils {
 // |kernel_sigma|. |input_bitmap| is requried to be of SkBitmap::kA8_Config
 // type. The routine computes first-order gaussian derivative on a
 // gaussian-smoothed image. Beware, this is fairly slow since kernel size is
-// 4 * kernel_sigma + 1.
+// 4 * kernel_sigma + 1. Large images are filtered on several threads, which
+// this blocks on; don't call it where blocking isn't allowed.
 void ApplyGaussianGradientMagnitudeFilter(SkBitmap* input_bitmap,
                                           float kernel_sigma);
 
@@ -13,7 +13,10 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColor.h"
 #include "ui/gfx/canvas.h"
@@ -65,6 +68,24 @@ bool CompareImageFragments(const SkBitmap& bitmap_left,
   return true;
 }
 
+// Creates a monochrome image of the given size with a dotted grid pattern and
+// some noise, roughly like the text of a web page reduced to luma.
+void MakeTextLikeImage(int width, int height, SkBitmap* bitmap) {
+  bitmap->setConfig(SkBitmap::kA8_Config, width, height);
+  bitmap->allocPixels();
+  SkAutoLockPixels lock(*bitmap);
+  srand(width * height);
+  for (int r = 0; r < height; ++r) {
+    uint8* row_data = bitmap->getAddr8(0, r);
+    for (int c = 0; c < width; ++c) {
+      if (r % 40 < 12 && c % 9 < 5)
+        row_data[c] = 220;
+      else
+        row_data[c] = 100 + rand() % 8;
+    }
+  }
+}
+
 float AspectDifference(const gfx::Size& reference, const gfx::Size& candidate) {
   return std::abs(static_cast<float>(candidate.width()) / candidate.height() -
                   static_cast<float>(reference.width()) / reference.height());
@@ -160,6 +181,43 @@ TEST_F(ThumbnailContentAnalysisTest, ApplyGradientMagnitudeOnFrame) {
   EXPECT_EQ(ImagePixelSum(reduced_color, inner_rect), 0U);
 }
 
+TEST_F(ThumbnailContentAnalysisTest, ApplyGradientMagnitudeOnLargeImage) {
+  // Images this large are filtered in bands, possibly on several threads.
+  // Filter a grid of identical spikes; no matter where the band boundaries
+  // fall, every spike must produce the same response.
+  const int kWidth = 1280;
+  const int kHeight = 720;
+  const int kSpacing = 64;
+  const float kSigmas[] = { 1.2f, 2.5f };
+  for (size_t i = 0; i < arraysize(kSigmas); ++i) {
+    SkBitmap reduced_color;
+    reduced_color.setConfig(SkBitmap::kA8_Config, kWidth, kHeight);
+    reduced_color.allocPixels();
+    reduced_color.eraseARGB(10, 0, 0, 0);
+    for (int r = kSpacing / 2; r < kHeight; r += kSpacing) {
+      for (int c = kSpacing / 2; c < kWidth; c += kSpacing)
+        *reduced_color.getAddr8(c, r) = 255;
+    }
+
+    ApplyGaussianGradientMagnitudeFilter(&reduced_color, kSigmas[i]);
+
+    int tail_length = static_cast<int>(8.0f * kSigmas[i] + 0.5f);
+    gfx::Size echo_size(2 * tail_length + 1, 2 * tail_length + 1);
+    gfx::Point first_echo(kSpacing / 2 - tail_length,
+                          kSpacing / 2 - tail_length);
+    EXPECT_GT(ImagePixelSum(reduced_color, gfx::Rect(first_echo, echo_size)),
+              0U);
+    for (int r = kSpacing / 2; r < kHeight; r += kSpacing) {
+      for (int c = kSpacing / 2; c < kWidth; c += kSpacing) {
+        EXPECT_TRUE(CompareImageFragments(
+            reduced_color, reduced_color, echo_size, first_echo,
+            gfx::Point(c - tail_length, r - tail_length)))
+            << "sigma " << kSigmas[i] << " at " << c << "," << r;
+      }
+    }
+  }
+}
+
 TEST_F(ThumbnailContentAnalysisTest, ExtractImageProfileInformation) {
   gfx::Canvas canvas(gfx::Size(800, 600), 1.0f, true);
 
@@ -711,4 +769,55 @@ TEST_F(ThumbnailContentAnalysisTest, CreateRetargetedThumbnailImage) {
 
 }
 
+// Timings of the analysis steps which dominate thumbnailing a page capture,
+// at 1080p and 4K. Disabled by default as they are slow on debug builds; run
+// with --gtest_also_run_disabled_tests.
+class ThumbnailContentAnalysisPerfTest
+    : public ThumbnailContentAnalysisTest,
+      public testing::WithParamInterface<gfx::Size> {
+};
+
+TEST_P(ThumbnailContentAnalysisPerfTest, DISABLED_GradientAndProfile) {
+  const gfx::Size image_size = GetParam();
+  const std::string trace = base::StringPrintf(
+      "%dx%d", image_size.width(), image_size.height());
+  const float kSigmas[] = { 1.2f, 5.0f };
+  for (size_t i = 0; i < arraysize(kSigmas); ++i) {
+    SkBitmap reduced_color;
+    MakeTextLikeImage(image_size.width(), image_size.height(),
+                      &reduced_color);
+
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    ApplyGaussianGradientMagnitudeFilter(&reduced_color, kSigmas[i]);
+    base::TimeDelta gradient_time = base::TimeTicks::HighResNow() - start;
+
+    std::vector<float> rows;
+    std::vector<float> columns;
+    start = base::TimeTicks::HighResNow();
+    ExtractImageProfileInformation(reduced_color,
+                                   gfx::Rect(image_size),
+                                   gfx::Size(212, 132),
+                                   true,
+                                   &rows,
+                                   &columns);
+    base::TimeDelta profile_time = base::TimeTicks::HighResNow() - start;
+    EXPECT_EQ(static_cast<size_t>(image_size.height()), rows.size());
+    EXPECT_EQ(static_cast<size_t>(image_size.width()), columns.size());
+
+    perf_test::PrintResult("gradient_magnitude",
+                           base::StringPrintf("_sigma_%.1f", kSigmas[i]),
+                           trace, gradient_time.InMillisecondsF(), "ms",
+                           true);
+    perf_test::PrintResult("image_profile",
+                           base::StringPrintf("_sigma_%.1f", kSigmas[i]),
+                           trace, profile_time.InMillisecondsF(), "ms",
+                           true);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(FullHDAnd4K,
+                        ThumbnailContentAnalysisPerfTest,
+                        testing::Values(gfx::Size(1920, 1080),
+                                        gfx::Size(3840, 2160)));
+
 }  // namespace thumbnailing_utils
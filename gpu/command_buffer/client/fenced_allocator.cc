@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "base/bits.h"
 #include "gpu/command_buffer/client/cmd_buffer_helper.h"
 
 namespace gpu {
@@ -27,37 +28,48 @@ unsigned int RoundUp(unsigned int size) {
   return (size + (kAllocAlignment - 1)) & ~(kAllocAlignment - 1);
 }
 
+// Size class of a block of |size| bytes, a non-zero multiple of
+// kAllocAlignment: the class n holds the sizes in [2^n, 2^(n+1)) units of
+// kAllocAlignment.
+int SizeClass(unsigned int size) {
+  DCHECK_GE(size, kAllocAlignment);
+  return base::bits::Log2Floor(size / kAllocAlignment);
+}
+
 }  // namespace
 
 #ifndef _MSC_VER
 const FencedAllocator::Offset FencedAllocator::kInvalidOffset;
+const FencedAllocator::BlockIndex FencedAllocator::kInvalidIndex;
 #endif
 
 FencedAllocator::FencedAllocator(unsigned int size,
                                  CommandBufferHelper *helper)
     : helper_(helper),
+      first_block_(0),
+      free_list_mask_(0),
       bytes_in_use_(0) {
-  Block block = { FREE, 0, RoundDown(size), kUnusedToken };
+  for (int i = 0; i < kNumSizeClasses; ++i)
+    free_lists_[i] = kInvalidIndex;
+  Block block = { FREE, 0, RoundDown(size), kUnusedToken,
+                  kInvalidIndex, kInvalidIndex, kInvalidIndex, kInvalidIndex };
   blocks_.push_back(block);
+  if (block.size)
+    LinkFreeBlock(first_block_);
 }
 
 FencedAllocator::~FencedAllocator() {
   // Free blocks pending tokens.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state == FREE_PENDING_TOKEN) {
-      i = WaitForTokenAndFreeBlock(i);
-    }
+  while (WaitForOldestPendingBlock() != kInvalidIndex) {
   }
   // These checks are not valid if the service has crashed or lost the context.
-  // DCHECK_EQ(blocks_.size(), 1u);
-  // DCHECK_EQ(blocks_[0].state, FREE);
+  // DCHECK(!InUse());
 }
 
-// Looks for a non-allocated block that is big enough. Search in the FREE
-// blocks first (for direct usage), first-fit, then in the FREE_PENDING_TOKEN
-// blocks, waiting for them. The current implementation isn't smart about
-// optimizing what to wait for, just looks inside the block in order (first-fit
-// as well).
+// Looks for a free block that is big enough in the size class lists. If there
+// is none, releases the blocks whose token has already passed, then waits for
+// the blocks pending tokens, oldest first, until the collapsed block is big
+// enough.
 FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
   // size of 0 is not allowed because it would be inconsistent to only sometimes
   // have it succeed. Example: Alloc(SizeOfBuffer), Alloc(0).
@@ -69,21 +81,21 @@ FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
   size = RoundUp(size);
 
   // Try first to allocate in a free block.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE && block.size >= size) {
-      return AllocInBlock(i, size);
-    }
-  }
+  BlockIndex index = FindFreeBlock(size);
+  if (index != kInvalidIndex)
+    return AllocInBlock(index, size);
 
-  // No free block is available. Look for blocks pending tokens, and wait for
-  // them to be re-usable.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state != FREE_PENDING_TOKEN)
-      continue;
-    i = WaitForTokenAndFreeBlock(i);
-    if (blocks_[i].size >= size)
-      return AllocInBlock(i, size);
+  // Then in the blocks that can be reused without waiting.
+  FreeUnused();
+  index = FindFreeBlock(size);
+  if (index != kInvalidIndex)
+    return AllocInBlock(index, size);
+
+  // No free block is available. Wait for blocks pending tokens to be
+  // re-usable.
+  while ((index = WaitForOldestPendingBlock()) != kInvalidIndex) {
+    if (blocks_[index].size >= size)
+      return AllocInBlock(index, size);
   }
   return kInvalidOffset;
 }
@@ -92,17 +104,16 @@ FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
 // necessary.
 void FencedAllocator::Free(FencedAllocator::Offset offset) {
   BlockIndex index = GetBlockByOffset(offset);
-  DCHECK_NE(blocks_[index].state, FREE);
   Block &block = blocks_[index];
+  DCHECK_NE(block.state, FREE);
 
   if (block.state == IN_USE)
     bytes_in_use_ -= block.size;
 
-  block.state = FREE;
-  CollapseFreeBlock(index);
+  FreeBlock(index);
 }
 
-// Looks for the corresponding block, mark it FREE_PENDING_TOKEN.
+// Looks for the corresponding block, mark it FREE_PENDING_TOKEN and queue it.
 void FencedAllocator::FreePendingToken(
     FencedAllocator::Offset offset, int32 token) {
   BlockIndex index = GetBlockByOffset(offset);
@@ -111,16 +122,21 @@ void FencedAllocator::FreePendingToken(
     bytes_in_use_ -= block.size;
   block.state = FREE_PENDING_TOKEN;
   block.token = token;
+  PendingFree pending = { offset, token };
+  pending_frees_.push_back(pending);
 }
 
-// Gets the max of the size of the blocks marked as free.
+// Gets the max of the size of the blocks marked as free. Only the non-empty
+// size class with the largest sizes needs to be searched.
 unsigned int FencedAllocator::GetLargestFreeSize() {
   FreeUnused();
+  if (!free_list_mask_)
+    return 0;
   unsigned int max_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE)
-      max_size = std::max(max_size, block.size);
+  int size_class = base::bits::Log2Floor(free_list_mask_);
+  for (BlockIndex i = free_lists_[size_class]; i != kInvalidIndex;
+       i = blocks_[i].next_free) {
+    max_size = std::max(max_size, blocks_[i].size);
   }
   return max_size;
 }
@@ -130,7 +146,7 @@ unsigned int FencedAllocator::GetLargestFreeSize() {
 unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
   unsigned int max_size = 0;
   unsigned int current_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
+  for (BlockIndex i = first_block_; i != kInvalidIndex; i = blocks_[i].next) {
     Block &block = blocks_[i];
     if (block.state == IN_USE) {
       max_size = std::max(max_size, current_size);
@@ -144,14 +160,33 @@ unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
 }
 
 // Makes sure that:
-// - there is at least one block.
+// - the first block is at offset 0.
 // - there are no contiguous FREE blocks (they should have been collapsed).
 // - the successive offsets match the block sizes, and they are in order.
+// - the FREE blocks are all in the free list of their size class, and the
+//   other ones are all in the offset map.
 bool FencedAllocator::CheckConsistency() {
-  if (blocks_.size() < 1) return false;
-  for (unsigned int i = 0; i < blocks_.size() - 1; ++i) {
+  if (blocks_[first_block_].offset != 0 ||
+      blocks_[first_block_].prev != kInvalidIndex)
+    return false;
+  size_t free_count = 0;
+  size_t allocated_count = 0;
+  for (BlockIndex i = first_block_; i != kInvalidIndex; i = blocks_[i].next) {
     Block &current = blocks_[i];
-    Block &next = blocks_[i + 1];
+    if (current.state == FREE) {
+      if (current.size)
+        ++free_count;
+    } else {
+      OffsetMap::const_iterator it = allocated_blocks_.find(current.offset);
+      if (it == allocated_blocks_.end() || it->second != i)
+        return false;
+      ++allocated_count;
+    }
+    if (current.next == kInvalidIndex)
+      break;
+    Block &next = blocks_[current.next];
+    if (next.prev != i)
+      return false;
     // This test is NOT included in the next one, because offset is unsigned.
     if (next.offset <= current.offset)
       return false;
@@ -160,89 +195,204 @@ bool FencedAllocator::CheckConsistency() {
     if (current.state == FREE && next.state == FREE)
       return false;
   }
-  return true;
+  if (allocated_count != allocated_blocks_.size())
+    return false;
+  for (int size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+    bool empty = free_lists_[size_class] == kInvalidIndex;
+    if (empty != !(free_list_mask_ & (1u << size_class)))
+      return false;
+    for (BlockIndex i = free_lists_[size_class]; i != kInvalidIndex;
+         i = blocks_[i].next_free) {
+      if (blocks_[i].state != FREE || SizeClass(blocks_[i].size) != size_class)
+        return false;
+      if (free_count-- == 0)
+        return false;
+    }
+  }
+  return free_count == 0;
 }
 
 // Returns false if all blocks are actually FREE, in which
 // case they would be coalesced into one block, true otherwise.
 bool FencedAllocator::InUse() {
-  return blocks_.size() != 1 || blocks_[0].state != FREE;
-}
-
-// Collapse the block to the next one, then to the previous one. Provided the
-// structure is consistent, those are the only blocks eligible for collapse.
-FencedAllocator::BlockIndex FencedAllocator::CollapseFreeBlock(
-    BlockIndex index) {
-  if (index + 1 < blocks_.size()) {
-    Block &next = blocks_[index + 1];
-    if (next.state == FREE) {
-      blocks_[index].size += next.size;
-      blocks_.erase(blocks_.begin() + index + 1);
-    }
+  const Block& first = blocks_[first_block_];
+  return first.next != kInvalidIndex || first.state != FREE;
+}
+
+// A block in the size class of |size| is big enough only if |size| is a power
+// of two, otherwise the first block of any larger class is. Failing that, the
+// size class of |size| is searched, so that the allocation never fails while a
+// big enough block is free.
+FencedAllocator::BlockIndex FencedAllocator::FindFreeBlock(unsigned int size) {
+  int size_class = SizeClass(size);
+  bool power_of_two = (size & (size - 1)) == 0;
+  int first_class = power_of_two ? size_class : size_class + 1;
+  if (first_class < kNumSizeClasses) {
+    uint32 mask = free_list_mask_ & (~0u << first_class);
+    if (mask)
+      return free_lists_[base::bits::Log2Floor(mask & (0u - mask))];
   }
-  if (index > 0) {
-    Block &prev = blocks_[index - 1];
-    if (prev.state == FREE) {
-      prev.size += blocks_[index].size;
-      blocks_.erase(blocks_.begin() + index);
-      --index;
-    }
+  if (power_of_two)
+    return kInvalidIndex;
+  for (BlockIndex i = free_lists_[size_class]; i != kInvalidIndex;
+       i = blocks_[i].next_free) {
+    if (blocks_[i].size >= size)
+      return i;
   }
-  return index;
+  return kInvalidIndex;
 }
 
-// Waits for the block's token, then mark the block as free, then collapse it.
-FencedAllocator::BlockIndex FencedAllocator::WaitForTokenAndFreeBlock(
-    BlockIndex index) {
+// Collapse the block to the next one, then the previous one to it. Provided
+// the structure is consistent, those are the only blocks eligible for
+// collapse. The block with the lower offset is the one that is kept.
+FencedAllocator::BlockIndex FencedAllocator::FreeBlock(BlockIndex index) {
   Block &block = blocks_[index];
-  DCHECK_EQ(block.state, FREE_PENDING_TOKEN);
-  helper_->WaitForToken(block.token);
+  DCHECK_NE(block.state, FREE);
+  allocated_blocks_.erase(block.offset);
   block.state = FREE;
-  return CollapseFreeBlock(index);
+  block.token = kUnusedToken;
+
+  BlockIndex next_index = block.next;
+  if (next_index != kInvalidIndex && blocks_[next_index].state == FREE) {
+    Block &next = blocks_[next_index];
+    UnlinkFreeBlock(next_index);
+    block.size += next.size;
+    block.next = next.next;
+    if (block.next != kInvalidIndex)
+      blocks_[block.next].prev = index;
+    DeleteBlock(next_index);
+  }
+  BlockIndex prev_index = block.prev;
+  if (prev_index != kInvalidIndex && blocks_[prev_index].state == FREE) {
+    Block &prev = blocks_[prev_index];
+    UnlinkFreeBlock(prev_index);
+    prev.size += block.size;
+    prev.next = block.next;
+    if (prev.next != kInvalidIndex)
+      blocks_[prev.next].prev = prev_index;
+    DeleteBlock(index);
+    index = prev_index;
+  }
+  LinkFreeBlock(index);
+  return index;
+}
+
+// Pops stale entries until a block is still pending, waits for its token, then
+// marks it free and collapses it.
+FencedAllocator::BlockIndex FencedAllocator::WaitForOldestPendingBlock() {
+  while (!pending_frees_.empty()) {
+    PendingFree pending = pending_frees_.front();
+    pending_frees_.pop_front();
+    BlockIndex index = GetPendingBlock(pending);
+    if (index == kInvalidIndex)
+      continue;
+    helper_->WaitForToken(pending.token);
+    return FreeBlock(index);
+  }
+  return kInvalidIndex;
+}
+
+FencedAllocator::BlockIndex FencedAllocator::GetPendingBlock(
+    const PendingFree& pending) {
+  OffsetMap::const_iterator it = allocated_blocks_.find(pending.offset);
+  if (it == allocated_blocks_.end())
+    return kInvalidIndex;
+  const Block& block = blocks_[it->second];
+  if (block.state != FREE_PENDING_TOKEN || block.token != pending.token)
+    return kInvalidIndex;
+  return it->second;
 }
 
-// Frees any blocks pending a token for which the token has been read.
+// Frees the blocks pending a token for which the token has been read. Callers
+// may free a block pending an older token after one pending a newer token, so
+// the whole queue is scanned. The entries still pending keep their order, and
+// stale ones are dropped.
 void FencedAllocator::FreeUnused() {
   int32 last_token_read = helper_->last_token_read();
-  for (unsigned int i = 0; i < blocks_.size();) {
-    Block& block = blocks_[i];
-    if (block.state == FREE_PENDING_TOKEN && block.token <= last_token_read) {
-      block.state = FREE;
-      i = CollapseFreeBlock(i);
-    } else {
-      ++i;
-    }
+  std::deque<PendingFree>::iterator kept = pending_frees_.begin();
+  for (std::deque<PendingFree>::iterator it = pending_frees_.begin();
+       it != pending_frees_.end(); ++it) {
+    BlockIndex index = GetPendingBlock(*it);
+    if (index == kInvalidIndex)
+      continue;
+    if (it->token <= last_token_read)
+      FreeBlock(index);
+    else
+      *kept++ = *it;
   }
+  pending_frees_.erase(kept, pending_frees_.end());
 }
 
 // If the block is exactly the requested size, simply mark it IN_USE, otherwise
 // split it and mark the first one (of the requested size) IN_USE.
 FencedAllocator::Offset FencedAllocator::AllocInBlock(BlockIndex index,
                                                       unsigned int size) {
-  Block &block = blocks_[index];
-  DCHECK_GE(block.size, size);
-  DCHECK_EQ(block.state, FREE);
-  Offset offset = block.offset;
+  DCHECK_GE(blocks_[index].size, size);
+  DCHECK_EQ(blocks_[index].state, FREE);
+  UnlinkFreeBlock(index);
+  Offset offset = blocks_[index].offset;
   bytes_in_use_ += size;
-  if (block.size == size) {
-    block.state = IN_USE;
-    return offset;
+  if (blocks_[index].size != size) {
+    // NewBlock() may invalidate references to blocks.
+    BlockIndex new_index = NewBlock();
+    Block &block = blocks_[index];
+    Block newblock = { FREE, offset + size, block.size - size, kUnusedToken,
+                       index, block.next, kInvalidIndex, kInvalidIndex };
+    blocks_[new_index] = newblock;
+    if (block.next != kInvalidIndex)
+      blocks_[block.next].prev = new_index;
+    block.next = new_index;
+    block.size = size;
+    LinkFreeBlock(new_index);
   }
-  Block newblock = { FREE, offset + size, block.size - size, kUnusedToken};
-  block.state = IN_USE;
-  block.size = size;
-  // this is the last thing being done because it may invalidate block;
-  blocks_.insert(blocks_.begin() + index + 1, newblock);
+  blocks_[index].state = IN_USE;
+  allocated_blocks_[offset] = index;
   return offset;
 }
 
-// The blocks are in offset order, so we can do a binary search.
+void FencedAllocator::LinkFreeBlock(BlockIndex index) {
+  Block &block = blocks_[index];
+  int size_class = SizeClass(block.size);
+  block.prev_free = kInvalidIndex;
+  block.next_free = free_lists_[size_class];
+  if (block.next_free != kInvalidIndex)
+    blocks_[block.next_free].prev_free = index;
+  free_lists_[size_class] = index;
+  free_list_mask_ |= 1u << size_class;
+}
+
+void FencedAllocator::UnlinkFreeBlock(BlockIndex index) {
+  Block &block = blocks_[index];
+  int size_class = SizeClass(block.size);
+  if (block.prev_free != kInvalidIndex)
+    blocks_[block.prev_free].next_free = block.next_free;
+  else
+    free_lists_[size_class] = block.next_free;
+  if (block.next_free != kInvalidIndex)
+    blocks_[block.next_free].prev_free = block.prev_free;
+  if (free_lists_[size_class] == kInvalidIndex)
+    free_list_mask_ &= ~(1u << size_class);
+}
+
+FencedAllocator::BlockIndex FencedAllocator::NewBlock() {
+  if (!unused_blocks_.empty()) {
+    BlockIndex index = unused_blocks_.back();
+    unused_blocks_.pop_back();
+    return index;
+  }
+  blocks_.push_back(Block());
+  return static_cast<BlockIndex>(blocks_.size() - 1);
+}
+
+void FencedAllocator::DeleteBlock(BlockIndex index) {
+  unused_blocks_.push_back(index);
+}
+
+// The IN_USE and FREE_PENDING_TOKEN blocks are indexed by offset.
 FencedAllocator::BlockIndex FencedAllocator::GetBlockByOffset(Offset offset) {
-  Block templ = { IN_USE, offset, 0, kUnusedToken };
-  Container::iterator it = std::lower_bound(blocks_.begin(), blocks_.end(),
-                                            templ, OffsetCmp());
-  DCHECK(it != blocks_.end() && it->offset == offset);
-  return it-blocks_.begin();
+  OffsetMap::const_iterator it = allocated_blocks_.find(offset);
+  DCHECK(it != allocated_blocks_.end());
+  return it->second;
 }
 
 }  // namespace gpu
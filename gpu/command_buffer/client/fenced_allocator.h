@@ -7,8 +7,10 @@
 #ifndef GPU_COMMAND_BUFFER_CLIENT_FENCED_ALLOCATOR_H_
 #define GPU_COMMAND_BUFFER_CLIENT_FENCED_ALLOCATOR_H_
 
+#include <deque>
 #include <vector>
 
+#include "base/containers/hash_tables.h"
 #include "base/logging.h"
 #include "gpu/command_buffer/common/types.h"
 #include "gpu/gpu_export.h"
@@ -22,6 +24,11 @@ class CommandBufferHelper;
 // that is, the memory won't be reused until the command buffer has processed
 // that token.
 //
+// Free blocks are kept in segregated free lists, one per power-of-two size
+// class, so that allocating and freeing don't depend on the number of blocks.
+// Blocks freed pending a token are queued in the order they are freed, and
+// released in batches as the tokens pass.
+//
 // NOTE: Although this class is intended to be used in the command buffer
 // environment which is multi-process, this class isn't "thread safe", because
 // it isn't meant to be shared across modules. It is thread-compatible though
@@ -94,49 +101,89 @@ class GPU_EXPORT FencedAllocator {
     FREE_PENDING_TOKEN
   };
 
-  // Book-keeping sturcture that describes a block of memory.
+  typedef unsigned int BlockIndex;
+
+  // Book-keeping sturcture that describes a block of memory. Blocks are kept
+  // in a doubly linked list in offset order, and FREE blocks are additionally
+  // linked into the free list of their size class.
   struct Block {
     State state;
     Offset offset;
     unsigned int size;
     int32 token;  // token to wait for in the FREE_PENDING_TOKEN case.
+    BlockIndex prev;
+    BlockIndex next;
+    BlockIndex prev_free;
+    BlockIndex next_free;
   };
 
-  // Comparison functor for memory block sorting.
-  class OffsetCmp {
-   public:
-    bool operator() (const Block &left, const Block &right) {
-      return left.offset < right.offset;
-    }
+  // A block freed pending a token, in the order of the calls to
+  // FreePendingToken().
+  struct PendingFree {
+    Offset offset;
+    int32 token;
   };
 
   typedef std::vector<Block> Container;
-  typedef unsigned int BlockIndex;
+  typedef base::hash_map<Offset, BlockIndex> OffsetMap;
 
   static const int32 kUnusedToken = 0;
+  static const BlockIndex kInvalidIndex = 0xffffffffU;
+  // Size classes are powers of two in units of the allocation alignment, so
+  // 32 of them cover any 32-bit size.
+  static const int kNumSizeClasses = 32;
 
-  // Gets the index of a memory block, given its offset.
+  // Gets the index of a memory block that is IN_USE or FREE_PENDING_TOKEN,
+  // given its offset.
   BlockIndex GetBlockByOffset(Offset offset);
 
-  // Collapse a free block with its neighbours if they are free. Returns the
-  // index of the collapsed block.
-  // NOTE: this will invalidate block indices.
-  BlockIndex CollapseFreeBlock(BlockIndex index);
+  // Returns the index of a FREE block of at least |size| bytes, or
+  // kInvalidIndex if there is none.
+  BlockIndex FindFreeBlock(unsigned int size);
 
-  // Waits for a FREE_PENDING_TOKEN block to be usable, and free it. Returns
-  // the new index of that block (since it may have been collapsed).
-  // NOTE: this will invalidate block indices.
-  BlockIndex WaitForTokenAndFreeBlock(BlockIndex index);
+  // Marks a block FREE and collapses it with its neighbours if they are free.
+  // Returns the index of the collapsed block.
+  BlockIndex FreeBlock(BlockIndex index);
 
-  // Allocates a block of memory inside a given block, splitting it in two
-  // (unless that block is of the exact requested size).
-  // NOTE: this will invalidate block indices.
+  // Waits for the oldest block still pending a token and frees it. Returns the
+  // index of the collapsed free block, or kInvalidIndex if no block is pending.
+  BlockIndex WaitForOldestPendingBlock();
+
+  // Returns the index of the block described by |pending| if it is still
+  // pending that token, or kInvalidIndex if the entry is stale.
+  BlockIndex GetPendingBlock(const PendingFree& pending);
+
+  // Allocates a block of memory inside a given FREE block, splitting it in
+  // two (unless that block is of the exact requested size).
   // Returns the offset of the allocated block (NOTE: this is different from
   // the other functions that return a block index).
   Offset AllocInBlock(BlockIndex index, unsigned int size);
 
+  // Adds and removes a FREE block to or from the free list of its size
+  // class.
+  void LinkFreeBlock(BlockIndex index);
+  void UnlinkFreeBlock(BlockIndex index);
+
+  // Gets a block from the pool of unused book-keeping entries, or returns one
+  // to it.
+  BlockIndex NewBlock();
+  void DeleteBlock(BlockIndex index);
+
   CommandBufferHelper *helper_;
+  // All the book-keeping entries, in no particular order. Entries that don't
+  // describe a block are listed in |unused_blocks_|.
   Container blocks_;
+  std::vector<BlockIndex> unused_blocks_;
+  // The first block, at offset 0. It is never collapsed into another one.
+  BlockIndex first_block_;
+  // The blocks that are IN_USE or FREE_PENDING_TOKEN, by offset.
+  OffsetMap allocated_blocks_;
+  // The heads of the free lists, and a bit mask of the non-empty ones.
+  BlockIndex free_lists_[kNumSizeClasses];
+  uint32 free_list_mask_;
+  // Blocks freed pending a token. Entries for blocks that have since been
+  // freed or reused are dropped when they are next looked at.
+  std::deque<PendingFree> pending_frees_;
   size_t bytes_in_use_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FencedAllocator);
@@ -0,0 +1,169 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the cost of FencedAllocator book-keeping under the mixed-size
+// alloc/free workload of texture uploads and readbacks through mapped memory:
+// blocks of 16 bytes to 64 kB, freed either directly or pending a token, with
+// the pending ones reclaimed once per flush.
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "gpu/command_buffer/client/cmd_buffer_helper.h"
+#include "gpu/command_buffer/client/fenced_allocator.h"
+#include "gpu/command_buffer/common/cmd_buffer_common.h"
+#include "gpu/command_buffer/service/cmd_parser.h"
+#include "gpu/command_buffer/service/command_buffer_service.h"
+#include "gpu/command_buffer/service/gpu_scheduler.h"
+#include "gpu/command_buffer/service/transfer_buffer_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace gpu {
+
+namespace {
+
+const unsigned int kAllocatorSize = 32 * 1024 * 1024;
+const int kCommandBufferSize = 64 * 1024;
+// Operations between flushes.
+const int kOperationsPerFlush = 64;
+const int kFlushes = 5000;
+
+// Minimal service side handler: forwards the SetToken commands to the engine
+// and ignores the other ones. It avoids the cost of a gmock mock, which would
+// otherwise dominate the measurement.
+class TokenForwardingHandler : public AsyncAPIInterface {
+ public:
+  TokenForwardingHandler() : engine_(NULL) {}
+  virtual ~TokenForwardingHandler() {}
+
+  void set_engine(CommandBufferEngine* engine) { engine_ = engine; }
+
+  // AsyncAPIInterface implementation.
+  virtual error::Error DoCommand(unsigned int command,
+                                 unsigned int arg_count,
+                                 const void* cmd_data) OVERRIDE {
+    if (command == cmd::kSetToken) {
+      engine_->set_token(static_cast<const cmd::SetToken*>(cmd_data)->token);
+    }
+    return error::kNoError;
+  }
+
+  virtual const char* GetCommandName(unsigned int command_id) const OVERRIDE {
+    return "";
+  }
+
+ private:
+  CommandBufferEngine* engine_;
+
+  DISALLOW_COPY_AND_ASSIGN(TokenForwardingHandler);
+};
+
+// Deterministic pseudo random numbers, so that all runs do the same work.
+class RandomSequence {
+ public:
+  RandomSequence() : state_(1) {}
+
+  uint32 Next() {
+    state_ = state_ * 1103515245 + 12345;
+    return state_ >> 8;
+  }
+
+ private:
+  uint32 state_;
+};
+
+}  // namespace
+
+class FencedAllocatorPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    TransferBufferManager* manager = new TransferBufferManager();
+    transfer_buffer_manager_.reset(manager);
+    ASSERT_TRUE(manager->Initialize());
+    command_buffer_.reset(
+        new CommandBufferService(transfer_buffer_manager_.get()));
+    ASSERT_TRUE(command_buffer_->Initialize());
+
+    gpu_scheduler_.reset(new GpuScheduler(
+        command_buffer_.get(), &handler_, NULL));
+    command_buffer_->SetPutOffsetChangeCallback(base::Bind(
+        &GpuScheduler::PutChanged, base::Unretained(gpu_scheduler_.get())));
+    command_buffer_->SetGetBufferChangeCallback(base::Bind(
+        &GpuScheduler::SetGetBuffer, base::Unretained(gpu_scheduler_.get())));
+    handler_.set_engine(gpu_scheduler_.get());
+
+    helper_.reset(new CommandBufferHelper(command_buffer_.get()));
+    helper_->Initialize(kCommandBufferSize);
+  }
+
+  virtual void TearDown() {
+    // If the GpuScheduler posts any tasks, this forces them to run.
+    base::MessageLoop::current()->RunUntilIdle();
+  }
+
+  // Keeps about |live_blocks| blocks allocated while allocating and freeing,
+  // and reports the number of operations per second.
+  void RunMixedSizeBenchmark(int live_blocks) {
+    FencedAllocator allocator(kAllocatorSize, helper_.get());
+    RandomSequence random;
+    std::vector<FencedAllocator::Offset> live;
+    int operations = 0;
+
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    for (int flush = 0; flush < kFlushes; ++flush) {
+      for (int i = 0; i < kOperationsPerFlush; ++i, ++operations) {
+        if (static_cast<int>(live.size()) < live_blocks || random.Next() % 2) {
+          // Sizes are spread evenly over the powers of two.
+          unsigned int size = 16u << (random.Next() % 12);
+          size += random.Next() % size;
+          FencedAllocator::Offset offset = allocator.Alloc(size);
+          if (offset != FencedAllocator::kInvalidOffset)
+            live.push_back(offset);
+          continue;
+        }
+        size_t index = random.Next() % live.size();
+        if (random.Next() % 2)
+          allocator.Free(live[index]);
+        else
+          allocator.FreePendingToken(live[index], helper_->InsertToken());
+        live[index] = live.back();
+        live.pop_back();
+      }
+      helper_->Flush();
+      allocator.FreeUnused();
+    }
+    base::TimeDelta elapsed = base::TimeTicks::HighResNow() - start;
+    EXPECT_TRUE(allocator.CheckConsistency());
+
+    for (size_t i = 0; i < live.size(); ++i)
+      allocator.Free(live[i]);
+    helper_->Finish();
+    allocator.FreeUnused();
+    EXPECT_FALSE(allocator.InUse());
+
+    perf_test::PrintResult("fenced_allocator", "_mixed_sizes",
+                           base::StringPrintf("%d_live", live_blocks),
+                           operations / elapsed.InSecondsF(), "ops/s", true);
+  }
+
+  base::MessageLoop message_loop_;
+  TokenForwardingHandler handler_;
+  scoped_ptr<TransferBufferManagerInterface> transfer_buffer_manager_;
+  scoped_ptr<CommandBufferService> command_buffer_;
+  scoped_ptr<GpuScheduler> gpu_scheduler_;
+  scoped_ptr<CommandBufferHelper> helper_;
+};
+
+TEST_F(FencedAllocatorPerfTest, MixedSizes) {
+  const int kLiveBlocks[] = { 16, 128, 1024 };
+  for (size_t i = 0; i < arraysize(kLiveBlocks); ++i)
+    RunMixedSizeBenchmark(kLiveBlocks[i]);
+}
+
+}  // namespace gpu
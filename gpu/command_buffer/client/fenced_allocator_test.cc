@@ -391,6 +391,99 @@ TEST_F(FencedAllocatorTest, TestGetLargestFreeOrPendingSize) {
   EXPECT_EQ(kBufferSize, allocator_->GetLargestFreeSize());
 }
 
+// Checks that allocations of sizes that aren't powers of two succeed when the
+// only big enough free block is in their own size class.
+TEST_F(FencedAllocatorTest, TestAllocInSameSizeClass) {
+  const unsigned int kSize = 16;
+  // 48 bytes blocks are in the same size class as 32 bytes ones.
+  FencedAllocator::Offset offset1 = allocator_->Alloc(3 * kSize);
+  ASSERT_NE(FencedAllocator::kInvalidOffset, offset1);
+  FencedAllocator::Offset offset2 = allocator_->Alloc(kSize);
+  ASSERT_NE(FencedAllocator::kInvalidOffset, offset2);
+  FencedAllocator::Offset offset3 =
+      allocator_->Alloc(kBufferSize - 4 * kSize);
+  ASSERT_NE(FencedAllocator::kInvalidOffset, offset3);
+  EXPECT_EQ(0u, allocator_->GetLargestFreeSize());
+
+  allocator_->Free(offset1);
+  EXPECT_EQ(3 * kSize, allocator_->GetLargestFreeSize());
+  offset1 = allocator_->Alloc(3 * kSize - 1);
+  EXPECT_NE(FencedAllocator::kInvalidOffset, offset1);
+  EXPECT_TRUE(allocator_->CheckConsistency());
+
+  allocator_->Free(offset1);
+  allocator_->Free(offset2);
+  allocator_->Free(offset3);
+  EXPECT_FALSE(allocator_->InUse());
+}
+
+// Checks that FreeUnused only releases the blocks whose token has passed, and
+// that Alloc waits for the oldest pending block first.
+TEST_F(FencedAllocatorTest, TestFreePendingTokenOrder) {
+  const unsigned int kSize = 16;
+  const unsigned int kAllocCount = kBufferSize / kSize;
+  FencedAllocator::Offset offsets[kAllocCount];
+  for (unsigned int i = 0; i < kAllocCount; ++i) {
+    offsets[i] = allocator_->Alloc(kSize);
+    ASSERT_NE(FencedAllocator::kInvalidOffset, offsets[i]);
+  }
+
+  // Free the blocks pending tokens, last block first.
+  int32 tokens[kAllocCount];
+  for (unsigned int i = kAllocCount; i > 0; --i) {
+    tokens[i - 1] = helper_.get()->InsertToken();
+    allocator_->FreePendingToken(offsets[i - 1], tokens[i - 1]);
+  }
+  EXPECT_EQ(kBufferSize, allocator_->GetLargestFreeOrPendingSize());
+  EXPECT_GT(tokens[0], GetToken());
+
+  // Reclaiming a block waits for the oldest token only.
+  FencedAllocator::Offset offset = allocator_->Alloc(kSize);
+  EXPECT_EQ(offsets[kAllocCount - 1], offset);
+  EXPECT_LE(tokens[kAllocCount - 1], GetToken());
+  EXPECT_TRUE(allocator_->CheckConsistency());
+
+  helper_->Finish();
+  allocator_->FreeUnused();
+  EXPECT_EQ(kBufferSize - kSize, allocator_->GetLargestFreeSize());
+  allocator_->Free(offset);
+  EXPECT_FALSE(allocator_->InUse());
+}
+
+// Checks that FreeUnused releases a block pending a token that has passed even
+// when it was queued behind a block pending a newer token.
+TEST_F(FencedAllocatorTest, TestFreeUnusedOutOfOrder) {
+  const unsigned int kSize = 16;
+  const unsigned int kAllocCount = kBufferSize / kSize;
+  FencedAllocator::Offset offsets[kAllocCount];
+  for (unsigned int i = 0; i < kAllocCount; ++i) {
+    offsets[i] = allocator_->Alloc(kSize);
+    ASSERT_NE(FencedAllocator::kInvalidOffset, offsets[i]);
+  }
+
+  int32 old_token = helper_.get()->InsertToken();
+  helper_->Finish();
+  int32 new_token = helper_.get()->InsertToken();
+  EXPECT_GT(new_token, GetToken());
+
+  // Queue the newer token first, as BufferTracker may do.
+  allocator_->FreePendingToken(offsets[0], new_token);
+  allocator_->FreePendingToken(offsets[2], old_token);
+  allocator_->FreeUnused();
+  EXPECT_EQ(kSize, allocator_->GetLargestFreeSize());
+  EXPECT_TRUE(allocator_->CheckConsistency());
+
+  helper_->Finish();
+  allocator_->FreeUnused();
+  EXPECT_EQ(kSize, allocator_->GetLargestFreeSize());
+  allocator_->Free(offsets[1]);
+  EXPECT_EQ(3 * kSize, allocator_->GetLargestFreeSize());
+
+  for (unsigned int i = 3; i < kAllocCount; ++i)
+    allocator_->Free(offsets[i]);
+  EXPECT_FALSE(allocator_->InUse());
+}
+
 // Test fixture for FencedAllocatorWrapper test - Creates a
 // FencedAllocatorWrapper, using a CommandBufferHelper with a mock
 // AsyncAPIInterface for its interface (calling it directly, not through the
@@ -80,6 +80,22 @@ error::Error CommandParser::ProcessCommand() {
   return result;
 }
 
+error::Error CommandParser::ProcessCommands(int num_commands) {
+  // Commands never wrap around the end of the buffer, so process up to either
+  // the put pointer or the end of the buffer, whichever comes first.
+  int num_entries = put_ < get_ ? entry_count_ - get_ : put_ - get_;
+  int entries_processed = 0;
+
+  error::Error result = handler_->DoCommands(
+      num_commands, buffer_ + get_, num_entries, &entries_processed);
+
+  get_ += entries_processed;
+  if (get_ == entry_count_)
+    get_ = 0;
+
+  return result;
+}
+
 void CommandParser::ReportError(unsigned int command_id,
                                 error::Error result) {
   DVLOG(1) << "Error: " << result << " for Command "
@@ -97,4 +113,49 @@ error::Error CommandParser::ProcessAllCommands() {
   return error::kNoError;
 }
 
+error::Error AsyncAPIInterface::DoCommands(unsigned int num_commands,
+                                           const void* buffer,
+                                           int num_entries,
+                                           int* entries_processed) {
+  const CommandBufferEntry* cmd_data =
+      static_cast<const CommandBufferEntry*>(buffer);
+  int process_pos = 0;
+  error::Error result = error::kNoError;
+
+  for (unsigned int i = 0; i < num_commands && process_pos < num_entries; ++i) {
+    CommandHeader header = cmd_data[process_pos].value_header;
+    if (header.size == 0) {
+      DVLOG(1) << "Error: zero sized command in command buffer";
+      result = error::kInvalidSize;
+      break;
+    }
+
+    if (static_cast<int>(header.size) + process_pos > num_entries) {
+      DVLOG(1) << "Error: get offset out of bounds";
+      result = error::kOutOfBounds;
+      break;
+    }
+
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("cb_command"),
+                 GetCommandName(header.command));
+
+    result = DoCommand(header.command, header.size - 1,
+                       cmd_data + process_pos);
+    if (result == error::kDeferCommandUntilLater)
+      break;
+
+    process_pos += header.size;
+    if (error::IsError(result)) {
+      DVLOG(1) << "Error: " << result << " for Command "
+               << GetCommandName(header.command);
+      break;
+    }
+  }
+
+  if (entries_processed)
+    *entries_processed = process_pos;
+
+  return result;
+}
+
 }  // namespace gpu
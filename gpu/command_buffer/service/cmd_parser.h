@@ -19,6 +19,10 @@ class AsyncAPIInterface;
 // buffer, to implement some asynchronous RPC mechanism.
 class GPU_EXPORT CommandParser {
  public:
+  // The number of commands ProcessCommands() is asked to process at once by
+  // the scheduler, between checks for preemption.
+  static const int kParseCommandsSlice = 20;
+
   explicit CommandParser(AsyncAPIInterface* handler);
 
   // Sets the buffer to read commands from.
@@ -57,6 +61,11 @@ class GPU_EXPORT CommandParser {
   // if there are no commands in the buffer.
   error::Error ProcessCommand();
 
+  // Processes up to |num_commands| commands, stopping early at the put pointer,
+  // the end of the buffer or the first error. Unlike ProcessCommand() this
+  // lets the handler validate and dispatch the commands in one go.
+  error::Error ProcessCommands(int num_commands);
+
   // Processes all commands until get == put.
   error::Error ProcessAllCommands();
 
@@ -91,6 +100,22 @@ class AsyncAPIInterface {
       unsigned int arg_count,
       const void* cmd_data) = 0;
 
+  // Executes multiple commands.
+  // Parameters:
+  //    num_commands: maximum number of commands to execute from |buffer|.
+  //    buffer: pointer to the first command entry to process.
+  //    num_entries: number of sequential command buffer entries in |buffer|.
+  //    entries_processed: if not NULL, set to the number of entries processed.
+  // Returns:
+  //   error::kNoError if no error was found, the error of the command that
+  //   stopped processing otherwise. A command returning
+  //   error::kDeferCommandUntilLater is not counted as processed.
+  // The default implementation validates each header and calls DoCommand().
+  virtual error::Error DoCommands(unsigned int num_commands,
+                                  const void* buffer,
+                                  int num_entries,
+                                  int* entries_processed);
+
   // Returns a name for a command. Useful for logging / debuging.
   virtual const char* GetCommandName(unsigned int command_id) const = 0;
 };
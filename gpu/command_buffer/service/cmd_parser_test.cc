@@ -169,6 +169,80 @@ TEST_F(CommandParserTest, TestMultipleCommands) {
   Mock::VerifyAndClearExpectations(api_mock());
 }
 
+// Tests processing several commands at once.
+TEST_F(CommandParserTest, TestProcessCommands) {
+  scoped_ptr<CommandParser> parser(MakeParser(10));
+  CommandBufferOffset put = parser->put();
+  CommandHeader header;
+
+  // add 3 commands with 1 arg (2 words each)
+  CommandBufferEntry param_array[3];
+  for (unsigned int i = 0; i < 3; ++i) {
+    header.size = 2;
+    header.command = 100 + i;
+    buffer()[put++].value_header = header;
+    buffer()[put++].value_int32 = 10 + i;
+    param_array[i].value_int32 = 10 + i;
+  }
+  parser->set_put(put);
+
+  // Only as many commands as asked for are processed.
+  AddDoCommandExpect(error::kNoError, 100, 1, param_array);
+  AddDoCommandExpect(error::kNoError, 101, 1, param_array + 1);
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(2));
+  EXPECT_EQ(4, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // A deferred command stays in the buffer.
+  AddDoCommandExpect(error::kDeferCommandUntilLater, 102, 1, param_array + 2);
+  EXPECT_EQ(error::kDeferCommandUntilLater,
+            parser->ProcessCommands(CommandParser::kParseCommandsSlice));
+  EXPECT_EQ(4, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // Processing stops at the put pointer.
+  AddDoCommandExpect(error::kNoError, 102, 1, param_array + 2);
+  EXPECT_EQ(error::kNoError,
+            parser->ProcessCommands(CommandParser::kParseCommandsSlice));
+  EXPECT_EQ(put, parser->get());
+  EXPECT_TRUE(parser->IsEmpty());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // add 2 commands with 1 arg up to the end of the buffer and 1 more at its
+  // start; processing stops at the end of the buffer and continues from the
+  // start on the next call.
+  header.size = 2;
+  header.command = 200;
+  buffer()[put++].value_header = header;
+  buffer()[put++].value_int32 = 20;
+  DCHECK_EQ(8, put);
+  header.size = 2;
+  header.command = 201;
+  buffer()[put++].value_header = header;
+  buffer()[put++].value_int32 = 21;
+  DCHECK_EQ(10, put);
+  put = 0;
+  header.size = 2;
+  header.command = 202;
+  buffer()[put++].value_header = header;
+  buffer()[put++].value_int32 = 22;
+  parser->set_put(put);
+
+  param_array[0].value_int32 = 20;
+  param_array[1].value_int32 = 21;
+  param_array[2].value_int32 = 22;
+  AddDoCommandExpect(error::kNoError, 200, 1, param_array);
+  AddDoCommandExpect(error::kNoError, 201, 1, param_array + 1);
+  EXPECT_EQ(error::kNoError,
+            parser->ProcessCommands(CommandParser::kParseCommandsSlice));
+  EXPECT_EQ(0, parser->get());
+  AddDoCommandExpect(error::kNoError, 202, 1, param_array + 2);
+  EXPECT_EQ(error::kNoError,
+            parser->ProcessCommands(CommandParser::kParseCommandsSlice));
+  EXPECT_EQ(put, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+}
+
 // Tests that the parser will wrap correctly at the end of the buffer.
 TEST_F(CommandParserTest, TestWrap) {
   scoped_ptr<CommandParser> parser(MakeParser(5));
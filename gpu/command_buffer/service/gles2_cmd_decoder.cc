@@ -246,6 +246,14 @@ const CommandInfo g_command_info[] = {
   #undef GLES2_CMD_OP
 };
 
+// Returns true if |arg_count| is valid for the command described by |info|.
+static bool IsValidArgCount(const CommandInfo& info,
+                            unsigned int arg_count) {
+  unsigned int info_arg_count = static_cast<unsigned int>(info.arg_count);
+  return (info.arg_flags == cmd::kFixed && arg_count == info_arg_count) ||
+         (info.arg_flags == cmd::kAtLeastN && arg_count >= info_arg_count);
+}
+
 // Return true if a character belongs to the ASCII subset as defined in
 // GLSL ES 1.0 spec section 3.1.
 static bool CharacterIsValidForGLES(unsigned char c) {
@@ -499,6 +507,8 @@ void GLES2Decoder::BeginDecoding() {}
 
 void GLES2Decoder::EndDecoding() {}
 
+void GLES2Decoder::ExitCommandProcessingEarly() {}
+
 // This class implements GLES2Decoder so we don't have to expose all the GLES2
 // cmd stuff to outside this class.
 class GLES2DecoderImpl : public GLES2Decoder,
@@ -518,6 +528,12 @@ class GLES2DecoderImpl : public GLES2Decoder,
                           unsigned int arg_count,
                           const void* args) OVERRIDE;
 
+  // Overridden from AsyncAPIInterface.
+  virtual Error DoCommands(unsigned int num_commands,
+                           const void* buffer,
+                           int num_entries,
+                           int* entries_processed) OVERRIDE;
+
   // Overridden from AsyncAPIInterface.
   virtual const char* GetCommandName(unsigned int command_id) const OVERRIDE;
 
@@ -588,6 +604,7 @@ class GLES2DecoderImpl : public GLES2Decoder,
 
   virtual void BeginDecoding() OVERRIDE;
   virtual void EndDecoding() OVERRIDE;
+  virtual void ExitCommandProcessingEarly() OVERRIDE;
 
   virtual ErrorState* GetErrorState() OVERRIDE;
   virtual const ContextState* GetContextState() OVERRIDE { return &state_; }
@@ -657,6 +674,21 @@ class GLES2DecoderImpl : public GLES2Decoder,
   friend class ScopedResolvedFrameBufferBinder;
   friend class BackFramebuffer;
 
+  // Implements DoCommands(); DebugImpl adds the tracing, logging and
+  // debugging hooks which are off in normal use.
+  template <bool DebugImpl>
+  Error DoCommandsImpl(unsigned int num_commands,
+                       const void* buffer,
+                       int num_entries,
+                       int* entries_processed);
+
+  // Runs the handler of a single, already validated, GLES2 command.
+  template <bool DebugImpl>
+  Error DoGLES2Command(unsigned int command,
+                       const CommandInfo& info,
+                       unsigned int arg_count,
+                       const void* cmd_data);
+
   // Initialize or re-initialize the shader translator.
   bool InitializeShaderTranslator();
 
@@ -1647,6 +1679,9 @@ class GLES2DecoderImpl : public GLES2Decoder,
   // The current decoder error.
   error::Error current_decoder_error_;
 
+  // The number of commands DoCommands() may still process before returning.
+  unsigned int commands_to_process_;
+
   bool use_shader_translator_;
   scoped_refptr<ShaderTranslator> vertex_translator_;
   scoped_refptr<ShaderTranslator> fragment_translator_;
@@ -2160,6 +2195,7 @@ GLES2DecoderImpl::GLES2DecoderImpl(ContextGroup* group)
       back_buffer_has_stencil_(false),
       backbuffer_needs_clear_bits_(0),
       current_decoder_error_(error::kNoError),
+      commands_to_process_(0),
       use_shader_translator_(true),
       validators_(group_->feature_info()->validators()),
       feature_info_(group_->feature_info()),
@@ -3524,6 +3560,51 @@ const char* GLES2DecoderImpl::GetCommandName(unsigned int command_id) const {
 // Note: args is a pointer to the command buffer. As such, it could be changed
 // by a (malicious) client at any time, so if validation has to happen, it
 // should operate on a copy of them.
+template <bool DebugImpl>
+error::Error GLES2DecoderImpl::DoGLES2Command(unsigned int command,
+                                              const CommandInfo& info,
+                                              unsigned int arg_count,
+                                              const void* cmd_data) {
+  error::Error result = error::kNoError;
+  bool doing_gpu_trace = false;
+  if (DebugImpl && gpu_trace_commands_) {
+    if (CMD_FLAG_GET_TRACE_LEVEL(info.cmd_flags) <= gpu_trace_level_) {
+      doing_gpu_trace = true;
+      gpu_tracer_->Begin(GetCommandName(command), kTraceDecoder);
+    }
+  }
+
+  uint32 immediate_data_size =
+      (arg_count - info.arg_count) * sizeof(CommandBufferEntry);  // NOLINT
+  switch (command) {
+    #define GLES2_CMD_OP(name)                                 \
+      case cmds::name::kCmdId:                                 \
+        result = Handle ## name(                               \
+            immediate_data_size,                               \
+            *static_cast<const gles2::cmds::name*>(cmd_data)); \
+        break;                                                 \
+
+    GLES2_COMMAND_LIST(GLES2_CMD_OP)
+    #undef GLES2_CMD_OP
+  }
+
+  if (DebugImpl) {
+    if (doing_gpu_trace)
+      gpu_tracer_->End(kTraceDecoder);
+
+    if (debug()) {
+      GLenum error;
+      while ((error = glGetError()) != GL_NO_ERROR) {
+        LOG(ERROR) << "[" << logger_.GetLogPrefix() << "] "
+                   << "GL ERROR: " << GLES2Util::GetStringEnum(error) << " : "
+                   << GetCommandName(command);
+        LOCAL_SET_GL_ERROR(error, "DoCommand", "GL error from driver");
+      }
+    }
+  }
+  return result;
+}
+
 error::Error GLES2DecoderImpl::DoCommand(
     unsigned int command,
     unsigned int arg_count,
@@ -3538,56 +3619,131 @@ error::Error GLES2DecoderImpl::DoCommand(
   unsigned int command_index = command - kStartPoint - 1;
   if (command_index < arraysize(g_command_info)) {
     const CommandInfo& info = g_command_info[command_index];
-    unsigned int info_arg_count = static_cast<unsigned int>(info.arg_count);
-    if ((info.arg_flags == cmd::kFixed && arg_count == info_arg_count) ||
-        (info.arg_flags == cmd::kAtLeastN && arg_count >= info_arg_count)) {
-      bool doing_gpu_trace = false;
-      if (gpu_trace_commands_) {
-        if (CMD_FLAG_GET_TRACE_LEVEL(info.cmd_flags) <= gpu_trace_level_) {
-          doing_gpu_trace = true;
-          gpu_tracer_->Begin(GetCommandName(command), kTraceDecoder);
-        }
-      }
+    if (IsValidArgCount(info, arg_count))
+      result = DoGLES2Command<true>(command, info, arg_count, cmd_data);
+    else
+      result = error::kInvalidArguments;
+  } else {
+    result = DoCommonCommand(command, arg_count, cmd_data);
+  }
+  if (result == error::kNoError && current_decoder_error_ != error::kNoError) {
+      result = current_decoder_error_;
+      current_decoder_error_ = error::kNoError;
+  }
+  return result;
+}
 
-      uint32 immediate_data_size =
-          (arg_count - info_arg_count) * sizeof(CommandBufferEntry);  // NOLINT
-      switch (command) {
-        #define GLES2_CMD_OP(name)                                 \
-          case cmds::name::kCmdId:                                 \
-            result = Handle ## name(                               \
-                immediate_data_size,                               \
-                *static_cast<const gles2::cmds::name*>(cmd_data)); \
-            break;                                                 \
-
-        GLES2_COMMAND_LIST(GLES2_CMD_OP)
-        #undef GLES2_CMD_OP
-      }
+// Same as calling DoCommand() for each command, but the header of each command
+// is read here, and the tracing, logging and debugging hooks are only checked
+// for once. Consecutive commands with the same header (the same command with
+// the same size) are very common, e.g. a run of uniform or draw calls, and are
+// validated only once.
+template <bool DebugImpl>
+error::Error GLES2DecoderImpl::DoCommandsImpl(unsigned int num_commands,
+                                              const void* buffer,
+                                              int num_entries,
+                                              int* entries_processed) {
+  commands_to_process_ = num_commands;
+  error::Error result = error::kNoError;
+  const CommandBufferEntry* cmd_data =
+      static_cast<const CommandBufferEntry*>(buffer);
+  int process_pos = 0;
+  // No command has a size of 0, so this doesn't match any valid header.
+  uint32 validated_header = 0;
+  const CommandInfo* info = NULL;
+  unsigned int command = 0;
+
+  while (process_pos < num_entries &&
+         result == error::kNoError &&
+         commands_to_process_--) {
+    // The client can change the buffer at any time, so read the header once.
+    const CommandBufferEntry header_entry = cmd_data[process_pos];
+    const CommandHeader header = header_entry.value_header;
+    command = header.command;
+
+    if (header.size == 0) {
+      result = error::kInvalidSize;
+      break;
+    }
 
-      if (doing_gpu_trace)
-        gpu_tracer_->End(kTraceDecoder);
+    if (static_cast<int>(header.size) + process_pos > num_entries) {
+      result = error::kOutOfBounds;
+      break;
+    }
 
-      if (debug()) {
-        GLenum error;
-        while ((error = glGetError()) != GL_NO_ERROR) {
-          LOG(ERROR) << "[" << logger_.GetLogPrefix() << "] "
-                     << "GL ERROR: " << GLES2Util::GetStringEnum(error) << " : "
-                     << GetCommandName(command);
-          LOCAL_SET_GL_ERROR(error, "DoCommand", "GL error from driver");
-        }
+    if (DebugImpl) {
+      TRACE_EVENT_BEGIN0(TRACE_DISABLED_BY_DEFAULT("cb_command"),
+                         GetCommandName(command));
+
+      if (log_commands()) {
+        LOG(ERROR) << "[" << logger_.GetLogPrefix() << "]"
+                   << "cmd: " << GetCommandName(command);
+      }
+    }
+
+    const unsigned int arg_count = header.size - 1;
+    unsigned int command_index = command - kStartPoint - 1;
+    if (command_index < arraysize(g_command_info)) {
+      if (header_entry.value_uint32 != validated_header) {
+        info = &g_command_info[command_index];
+        if (IsValidArgCount(*info, arg_count))
+          validated_header = header_entry.value_uint32;
+        else
+          result = error::kInvalidArguments;
+      }
+      if (result == error::kNoError) {
+        result = DoGLES2Command<DebugImpl>(
+            command, *info, arg_count, cmd_data + process_pos);
       }
     } else {
-      result = error::kInvalidArguments;
+      result = DoCommonCommand(command, arg_count, cmd_data + process_pos);
     }
-  } else {
-    result = DoCommonCommand(command, arg_count, cmd_data);
-  }
-  if (result == error::kNoError && current_decoder_error_ != error::kNoError) {
+
+    if (DebugImpl) {
+      TRACE_EVENT_END0(TRACE_DISABLED_BY_DEFAULT("cb_command"),
+                       GetCommandName(command));
+    }
+
+    if (result == error::kNoError &&
+        current_decoder_error_ != error::kNoError) {
       result = current_decoder_error_;
       current_decoder_error_ = error::kNoError;
+    }
+
+    if (result != error::kDeferCommandUntilLater)
+      process_pos += header.size;
+  }
+
+  if (entries_processed)
+    *entries_processed = process_pos;
+
+  if (error::IsError(result)) {
+    DVLOG(1) << "Error: " << result << " for Command "
+             << GetCommandName(command);
   }
+
   return result;
 }
 
+error::Error GLES2DecoderImpl::DoCommands(unsigned int num_commands,
+                                          const void* buffer,
+                                          int num_entries,
+                                          int* entries_processed) {
+  bool tracing_commands = false;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(TRACE_DISABLED_BY_DEFAULT("cb_command"),
+                                     &tracing_commands);
+  if (tracing_commands || gpu_trace_commands_ || log_commands() || debug()) {
+    return DoCommandsImpl<true>(
+        num_commands, buffer, num_entries, entries_processed);
+  }
+  return DoCommandsImpl<false>(
+      num_commands, buffer, num_entries, entries_processed);
+}
+
+void GLES2DecoderImpl::ExitCommandProcessingEarly() {
+  commands_to_process_ = 0;
+}
+
 void GLES2DecoderImpl::RemoveBuffer(GLuint client_id) {
   buffer_manager()->RemoveBuffer(client_id);
 }
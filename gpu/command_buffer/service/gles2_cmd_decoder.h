@@ -230,6 +230,10 @@ class GPU_EXPORT GLES2Decoder : public base::SupportsWeakPtr<GLES2Decoder>,
   virtual void BeginDecoding();
   virtual void EndDecoding();
 
+  // Makes a DoCommands() call in progress return after the current command,
+  // e.g. because the command unscheduled the decoder.
+  virtual void ExitCommandProcessingEarly();
+
   virtual const ContextState* GetContextState() = 0;
 
  protected:
@@ -0,0 +1,166 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the overhead of parsing, validating and dispatching GLES2 commands,
+// independently of any real GL driver. Command streams are replayed through a
+// CommandParser into a GLES2Decoder running on the mock GL bindings. The
+// streams only contain commands which are handled without calling into GL
+// (redundant state changes, state which is applied lazily and tokens),
+// so that the time measured is spent in the command buffer code alone.
+
+#include <vector>
+
+#include "base/time/time.h"
+#include "gpu/command_buffer/common/cmd_buffer_common.h"
+#include "gpu/command_buffer/common/gles2_cmd_format.h"
+#include "gpu/command_buffer/service/cmd_parser.h"
+#include "gpu/command_buffer/service/gles2_cmd_decoder_unittest_base.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace gpu {
+namespace gles2 {
+
+namespace {
+
+const int kIterations = 20;
+// Number of entries in the command buffer; large enough that the time spent
+// outside the parser is negligible.
+const int kBufferEntries = 256 * 1024;
+
+// Records commands into a buffer of CommandBufferEntry, like
+// CommandBufferHelper does on the client side.
+class CommandStreamRecorder {
+ public:
+  CommandStreamRecorder() : num_commands_(0) {}
+
+  // Appends a command with no immediate data, which the caller should then
+  // Init().
+  template <typename T>
+  T* Append() {
+    COMPILE_ASSERT(T::kArgFlags == cmd::kFixed, Cmd_kArgFlags_not_kFixed);
+    size_t offset = entries_.size();
+    entries_.resize(offset + ComputeNumEntries(sizeof(T)));
+    ++num_commands_;
+    return reinterpret_cast<T*>(&entries_[offset]);
+  }
+
+  const std::vector<CommandBufferEntry>& entries() const { return entries_; }
+  int num_commands() const { return num_commands_; }
+
+ private:
+  std::vector<CommandBufferEntry> entries_;
+  int num_commands_;
+
+  DISALLOW_COPY_AND_ASSIGN(CommandStreamRecorder);
+};
+
+// State setting as issued by a compositor between draws: most of it repeats
+// the current state, so the decoder filters it out.
+void RecordRedundantStateStream(CommandStreamRecorder* recorder) {
+  recorder->Append<cmds::BlendColor>()->Init(0.0f, 0.0f, 0.0f, 0.0f);
+  recorder->Append<cmds::BlendEquation>()->Init(GL_FUNC_ADD);
+  recorder->Append<cmds::ClearColor>()->Init(0.0f, 0.0f, 0.0f, 0.0f);
+  recorder->Append<cmds::ColorMask>()->Init(true, true, true, false);
+  recorder->Append<cmds::CullFace>()->Init(GL_BACK);
+  recorder->Append<cmds::DepthFunc>()->Init(GL_LESS);
+  recorder->Append<cmds::DepthMask>()->Init(false);
+  recorder->Append<cmds::FrontFace>()->Init(GL_CCW);
+  recorder->Append<cmds::LineWidth>()->Init(1.0f);
+  recorder->Append<cmds::PolygonOffset>()->Init(0.0f, 0.0f);
+  recorder->Append<cmds::ColorMask>()->Init(true, true, true, true);
+  recorder->Append<cmds::DepthMask>()->Init(true);
+  recorder->Append<cmd::SetToken>()->Init(1);
+}
+
+// Long runs of the same command, e.g. a batch of state toggles.
+void RecordSameTypeRunsStream(CommandStreamRecorder* recorder) {
+  for (int i = 0; i < 16; ++i)
+    recorder->Append<cmds::ColorMask>()->Init(true, true, true, i % 2 != 0);
+  for (int i = 0; i < 16; ++i)
+    recorder->Append<cmds::DepthMask>()->Init(i % 2 != 0);
+  for (int i = 0; i < 16; ++i)
+    recorder->Append<cmd::SetToken>()->Init(i);
+}
+
+}  // namespace
+
+class GLES2DecoderPerfTest : public GLES2DecoderTestBase {
+ protected:
+  typedef void (*RecordFunction)(CommandStreamRecorder* recorder);
+
+  // Fills the command buffer with repetitions of the stream produced by
+  // |record|. Returns the number of commands and sets |num_entries| to the
+  // number of entries used.
+  int FillBuffer(RecordFunction record, int* num_entries) {
+    CommandStreamRecorder recorder;
+    record(&recorder);
+    const std::vector<CommandBufferEntry>& stream = recorder.entries();
+    // The put offset must stay below the end of the buffer.
+    int repetitions = (kBufferEntries - 1) / stream.size();
+    buffer_.clear();
+    for (int i = 0; i < repetitions; ++i)
+      buffer_.insert(buffer_.end(), stream.begin(), stream.end());
+    *num_entries = static_cast<int>(buffer_.size());
+    buffer_.resize(kBufferEntries);
+    return repetitions * recorder.num_commands();
+  }
+
+  // Replays the command buffer |kIterations| times, processing up to
+  // |commands_per_call| commands per call into the parser. Returns the time
+  // taken.
+  base::TimeDelta Replay(int num_entries, int commands_per_call) {
+    CommandParser parser(GetDecoder());
+    base::TimeDelta elapsed;
+    for (int i = 0; i < kIterations; ++i) {
+      parser.SetBuffer(&buffer_[0], buffer_.size() * sizeof(buffer_[0]), 0,
+                       buffer_.size() * sizeof(buffer_[0]));
+      parser.set_put(num_entries);
+      base::TimeTicks start = base::TimeTicks::HighResNow();
+      while (!parser.IsEmpty()) {
+        error::Error error = commands_per_call == 1 ?
+            parser.ProcessCommand() :
+            parser.ProcessCommands(commands_per_call);
+        if (error != error::kNoError) {
+          ADD_FAILURE() << "Decoding failed: " << error;
+          return elapsed;
+        }
+      }
+      elapsed += base::TimeTicks::HighResNow() - start;
+      EXPECT_EQ(num_entries, parser.get());
+    }
+    return elapsed;
+  }
+
+  void RunReplayBenchmark(const char* trace, RecordFunction record) {
+    int num_entries = 0;
+    int num_commands = FillBuffer(record, &num_entries);
+
+    base::TimeDelta single_time = Replay(num_entries, 1);
+    base::TimeDelta batched_time =
+        Replay(num_entries, CommandParser::kParseCommandsSlice);
+
+    double total_commands = static_cast<double>(num_commands) * kIterations;
+    perf_test::PrintResult("gles2_decode", "_single", trace,
+                           total_commands / single_time.InSecondsF(),
+                           "commands/s", true);
+    perf_test::PrintResult("gles2_decode", "_batched", trace,
+                           total_commands / batched_time.InSecondsF(),
+                           "commands/s", true);
+  }
+
+ private:
+  std::vector<CommandBufferEntry> buffer_;
+};
+
+TEST_F(GLES2DecoderPerfTest, RedundantState) {
+  RunReplayBenchmark("redundant_state", &RecordRedundantStateStream);
+}
+
+TEST_F(GLES2DecoderPerfTest, SameTypeRuns) {
+  RunReplayBenchmark("same_type_runs", &RecordSameTypeRunsStream);
+}
+
+}  // namespace gles2
+}  // namespace gpu
@@ -78,18 +78,19 @@ void GpuScheduler::PutChanged() {
     DCHECK(IsScheduled());
     DCHECK(unschedule_fences_.empty());
 
-    error = parser_->ProcessCommand();
-
-    if (error == error::kDeferCommandUntilLater) {
-      DCHECK_GT(unscheduled_count_, 0);
-      break;
-    }
+    error = parser_->ProcessCommands(CommandParser::kParseCommandsSlice);
 
     // TODO(piman): various classes duplicate various pieces of state, leading
     // to needlessly complex update logic. It should be possible to simply
     // share the state across all of them.
     command_buffer_->SetGetOffset(static_cast<int32>(parser_->get()));
 
+    // The commands of the slice before the deferred one have been processed.
+    if (error == error::kDeferCommandUntilLater) {
+      DCHECK_GT(unscheduled_count_, 0);
+      break;
+    }
+
     if (error::IsError(error)) {
       LOG(ERROR) << "[" << decoder_ << "] "
                  << "GPU PARSE ERROR: " << error;
@@ -145,6 +146,9 @@ void GpuScheduler::SetScheduled(bool scheduled) {
     }
   } else {
     ++unscheduled_count_;
+    // Don't run any more commands of the slice being processed, if any.
+    if (decoder_)
+      decoder_->ExitCommandProcessingEarly();
     if (unscheduled_count_ == 1) {
       TRACE_EVENT_ASYNC_BEGIN1("gpu", "ProcessingSwap", this,
                                "GpuScheduler", this);
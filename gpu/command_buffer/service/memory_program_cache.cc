@@ -9,6 +9,8 @@
 #include "base/metrics/histogram.h"
 #include "base/sha1.h"
 #include "base/strings/string_number_conversions.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "gpu/command_buffer/common/constants.h"
 #include "gpu/command_buffer/service/disk_cache_proto.pb.h"
 #include "gpu/command_buffer/service/gl_utils.h"
@@ -99,6 +101,29 @@ void RunShaderCallback(const ShaderCacheCallback& callback,
   callback.Run(key, shader);
 }
 
+// Reads the program hash of a serialized GpuProgramProto without parsing the
+// rest of it. The hash is the first field written, so this doesn't normally
+// skip anything.
+bool ReadProgramHash(const std::string& program, std::string* sha) {
+  using google::protobuf::internal::WireFormatLite;
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8*>(program.data()), program.size());
+  while (uint32 tag = input.ReadTag()) {
+    if (WireFormatLite::GetTagFieldNumber(tag) ==
+            GpuProgramProto::kShaFieldNumber &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      uint32 length;
+      return input.ReadVarint32(&length) &&
+             length == ProgramCache::kHashLength &&
+             input.ReadString(sha, length);
+    }
+    if (!WireFormatLite::SkipField(&input, tag, NULL))
+      return false;
+  }
+  return false;
+}
+
 }  // namespace
 
 MemoryProgramCache::MemoryProgramCache()
@@ -148,6 +173,11 @@ ProgramCache::ProgramLoadResult MemoryProgramCache::LoadLinkedProgram(
   if (found == store_.end()) {
     return PROGRAM_LOAD_FAILURE;
   }
+  if (found->second->is_serialized()) {
+    found = DecodeLoadedProgram(found);
+    if (found == store_.end())
+      return PROGRAM_LOAD_FAILURE;
+  }
   const scoped_refptr<ProgramCacheValue> value = found->second;
   glProgramBinary(program,
                   value->format(),
@@ -229,10 +259,11 @@ void MemoryProgramCache::SaveLinkedProgram(
   if(existing != store_.end())
     store_.Erase(existing);
 
-  while (curr_size_bytes_ + length > max_size_bytes_) {
-    DCHECK(!store_.empty());
-    store_.Erase(store_.rbegin());
-  }
+  // The binary is accounted for as soon as it is created, unless it is shared
+  // with a program already in the cache.
+  scoped_refptr<ProgramBinary> program_binary =
+      GetProgramBinary(binary.release(), length);
+  EvictToFit(0);
 
   if (!shader_callback.is_null() &&
       !CommandLine::ForCurrentProcess()->HasSwitch(
@@ -241,7 +272,7 @@ void MemoryProgramCache::SaveLinkedProgram(
         GpuProgramProto::default_instance().New());
     proto->set_sha(sha, kHashLength);
     proto->set_format(format);
-    proto->set_program(binary.get(), length);
+    proto->set_program(program_binary->data(), length);
 
     FillShaderProto(proto->mutable_vertex_shader(), a_sha, shader_a);
     FillShaderProto(proto->mutable_fragment_shader(), b_sha, shader_b);
@@ -249,9 +280,8 @@ void MemoryProgramCache::SaveLinkedProgram(
   }
 
   store_.Put(sha_string,
-             new ProgramCacheValue(length,
-                                   format,
-                                   binary.release(),
+             new ProgramCacheValue(format,
+                                   program_binary.get(),
                                    sha_string,
                                    a_sha,
                                    shader_a->attrib_map(),
@@ -267,73 +297,139 @@ void MemoryProgramCache::SaveLinkedProgram(
                        curr_size_bytes_ / 1024);
 }
 
+// Only the program hash is read here, the program is decoded when it is first
+// used. The disk cache sends all its programs at startup, most of which won't
+// be used before they are sent again at the next startup.
 void MemoryProgramCache::LoadProgram(const std::string& program) {
+  std::string sha;
+  if (!ReadProgramHash(program, &sha)) {
+    LOG(ERROR) << "Failed to parse proto file.";
+    return;
+  }
+
+  ProgramMRUCache::iterator existing = store_.Peek(sha);
+  if (existing != store_.end())
+    store_.Erase(existing);
+  EvictToFit(program.size());
+
+  store_.Put(sha, new ProgramCacheValue(sha, program, this));
+
+  UMA_HISTOGRAM_COUNTS("GPU.ProgramCache.MemorySizeAfterKb",
+                       curr_size_bytes_ / 1024);
+}
+
+MemoryProgramCache::ProgramMRUCache::iterator
+MemoryProgramCache::DecodeLoadedProgram(ProgramMRUCache::iterator found) {
   scoped_ptr<GpuProgramProto> proto(GpuProgramProto::default_instance().New());
-  if (proto->ParseFromString(program)) {
-    ShaderTranslator::VariableMap vertex_attribs;
-    ShaderTranslator::VariableMap vertex_uniforms;
-    ShaderTranslator::VariableMap vertex_varyings;
+  bool parsed = proto->ParseFromString(found->second->serialized_program()) &&
+                proto->sha() == found->first &&
+                proto->vertex_shader().sha().length() == kHashLength &&
+                proto->fragment_shader().sha().length() == kHashLength;
+  // Drop the serialized program before adding the decoded one, so that the
+  // link status is only evicted for the former.
+  store_.Erase(found);
+  if (!parsed) {
+    LOG(ERROR) << "Failed to parse proto file.";
+    return store_.end();
+  }
 
-    for (int i = 0; i < proto->vertex_shader().attribs_size(); i++) {
-      RetrieveShaderInfo(proto->vertex_shader().attribs(i), &vertex_attribs);
-    }
+  ShaderTranslator::VariableMap vertex_attribs;
+  ShaderTranslator::VariableMap vertex_uniforms;
+  ShaderTranslator::VariableMap vertex_varyings;
 
-    for (int i = 0; i < proto->vertex_shader().uniforms_size(); i++) {
-      RetrieveShaderInfo(proto->vertex_shader().uniforms(i), &vertex_uniforms);
-    }
+  for (int i = 0; i < proto->vertex_shader().attribs_size(); i++) {
+    RetrieveShaderInfo(proto->vertex_shader().attribs(i), &vertex_attribs);
+  }
 
-    for (int i = 0; i < proto->vertex_shader().varyings_size(); i++) {
-      RetrieveShaderInfo(proto->vertex_shader().varyings(i), &vertex_varyings);
-    }
+  for (int i = 0; i < proto->vertex_shader().uniforms_size(); i++) {
+    RetrieveShaderInfo(proto->vertex_shader().uniforms(i), &vertex_uniforms);
+  }
 
-    ShaderTranslator::VariableMap fragment_attribs;
-    ShaderTranslator::VariableMap fragment_uniforms;
-    ShaderTranslator::VariableMap fragment_varyings;
+  for (int i = 0; i < proto->vertex_shader().varyings_size(); i++) {
+    RetrieveShaderInfo(proto->vertex_shader().varyings(i), &vertex_varyings);
+  }
 
-    for (int i = 0; i < proto->fragment_shader().attribs_size(); i++) {
-      RetrieveShaderInfo(proto->fragment_shader().attribs(i),
-                         &fragment_attribs);
-    }
+  ShaderTranslator::VariableMap fragment_attribs;
+  ShaderTranslator::VariableMap fragment_uniforms;
+  ShaderTranslator::VariableMap fragment_varyings;
 
-    for (int i = 0; i < proto->fragment_shader().uniforms_size(); i++) {
-      RetrieveShaderInfo(proto->fragment_shader().uniforms(i),
-                         &fragment_uniforms);
-    }
+  for (int i = 0; i < proto->fragment_shader().attribs_size(); i++) {
+    RetrieveShaderInfo(proto->fragment_shader().attribs(i),
+                       &fragment_attribs);
+  }
 
-    for (int i = 0; i < proto->fragment_shader().varyings_size(); i++) {
-      RetrieveShaderInfo(proto->fragment_shader().varyings(i),
-                         &fragment_varyings);
-    }
+  for (int i = 0; i < proto->fragment_shader().uniforms_size(); i++) {
+    RetrieveShaderInfo(proto->fragment_shader().uniforms(i),
+                       &fragment_uniforms);
+  }
 
-    scoped_ptr<char[]> binary(new char[proto->program().length()]);
-    memcpy(binary.get(), proto->program().c_str(), proto->program().length());
-
-    store_.Put(proto->sha(),
-               new ProgramCacheValue(proto->program().length(),
-                                     proto->format(),
-                                     binary.release(),
-                                     proto->sha(),
-                                     proto->vertex_shader().sha().c_str(),
-                                     vertex_attribs,
-                                     vertex_uniforms,
-                                     vertex_varyings,
-                                     proto->fragment_shader().sha().c_str(),
-                                     fragment_attribs,
-                                     fragment_uniforms,
-                                     fragment_varyings,
-                                     this));
-
-    UMA_HISTOGRAM_COUNTS("GPU.ProgramCache.MemorySizeAfterKb",
-                         curr_size_bytes_ / 1024);
-  } else {
-    LOG(ERROR) << "Failed to parse proto file.";
+  for (int i = 0; i < proto->fragment_shader().varyings_size(); i++) {
+    RetrieveShaderInfo(proto->fragment_shader().varyings(i),
+                       &fragment_varyings);
   }
+
+  scoped_ptr<char[]> binary(new char[proto->program().length()]);
+  memcpy(binary.get(), proto->program().c_str(), proto->program().length());
+  scoped_refptr<ProgramBinary> program_binary =
+      GetProgramBinary(binary.release(), proto->program().length());
+
+  return store_.Put(
+      proto->sha(),
+      new ProgramCacheValue(proto->format(),
+                            program_binary.get(),
+                            proto->sha(),
+                            proto->vertex_shader().sha().c_str(),
+                            vertex_attribs,
+                            vertex_uniforms,
+                            vertex_varyings,
+                            proto->fragment_shader().sha().c_str(),
+                            fragment_attribs,
+                            fragment_uniforms,
+                            fragment_varyings,
+                            this));
 }
 
-MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
+scoped_refptr<MemoryProgramCache::ProgramBinary>
+MemoryProgramCache::GetProgramBinary(const char* data, GLsizei length) {
+  scoped_ptr<const char[]> owned_data(data);
+  unsigned char hash[kHashLength];
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(data), length,
+                      hash);
+  const std::string binary_hash(reinterpret_cast<char*>(hash), kHashLength);
+  ProgramBinaryMap::iterator it = binaries_.find(binary_hash);
+  if (it != binaries_.end())
+    return it->second;
+  return new ProgramBinary(binary_hash, owned_data.release(), length, this);
+}
+
+void MemoryProgramCache::EvictToFit(size_t additional_bytes) {
+  while (!store_.empty() &&
+         curr_size_bytes_ + additional_bytes > max_size_bytes_) {
+    store_.Erase(store_.rbegin());
+  }
+}
+
+MemoryProgramCache::ProgramBinary::ProgramBinary(
+    const std::string& binary_hash,
+    const char* data,
     GLsizei length,
+    MemoryProgramCache* program_cache)
+    : binary_hash_(binary_hash),
+      data_(data),
+      length_(length),
+      program_cache_(program_cache) {
+  program_cache_->curr_size_bytes_ += length_;
+  program_cache_->binaries_[binary_hash_] = this;
+}
+
+MemoryProgramCache::ProgramBinary::~ProgramBinary() {
+  program_cache_->curr_size_bytes_ -= length_;
+  program_cache_->binaries_.erase(binary_hash_);
+}
+
+MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
     GLenum format,
-    const char* data,
+    ProgramBinary* binary,
     const std::string& program_hash,
     const char* shader_0_hash,
     const ShaderTranslator::VariableMap& attrib_map_0,
@@ -344,9 +440,8 @@ MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
     const ShaderTranslator::VariableMap& uniform_map_1,
     const ShaderTranslator::VariableMap& varying_map_1,
     MemoryProgramCache* program_cache)
-    : length_(length),
-      format_(format),
-      data_(data),
+    : format_(format),
+      binary_(binary),
       program_hash_(program_hash),
       shader_0_hash_(shader_0_hash, kHashLength),
       attrib_map_0_(attrib_map_0),
@@ -357,12 +452,24 @@ MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
       uniform_map_1_(uniform_map_1),
       varying_map_1_(varying_map_1),
       program_cache_(program_cache) {
-  program_cache_->curr_size_bytes_ += length_;
+  DCHECK(binary_.get());
+  program_cache_->LinkedProgramCacheSuccess(program_hash);
+}
+
+MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
+    const std::string& program_hash,
+    const std::string& serialized_program,
+    MemoryProgramCache* program_cache)
+    : format_(0),
+      serialized_program_(serialized_program),
+      program_hash_(program_hash),
+      program_cache_(program_cache) {
+  program_cache_->curr_size_bytes_ += serialized_program_.size();
   program_cache_->LinkedProgramCacheSuccess(program_hash);
 }
 
 MemoryProgramCache::ProgramCacheValue::~ProgramCacheValue() {
-  program_cache_->curr_size_bytes_ -= length_;
+  program_cache_->curr_size_bytes_ -= serialized_program_.size();
   program_cache_->Evict(program_hash_);
 }
 
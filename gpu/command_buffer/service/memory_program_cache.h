@@ -19,7 +19,9 @@
 namespace gpu {
 namespace gles2 {
 
-// Program cache that stores binaries completely in-memory
+// Program cache that stores binaries completely in-memory. Programs received
+// from the disk cache through LoadProgram() are only decoded the first time
+// they are used, and binaries with identical contents are stored once.
 class GPU_EXPORT MemoryProgramCache : public ProgramCache {
  public:
   MemoryProgramCache();
@@ -46,13 +48,64 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
   virtual void LoadProgram(const std::string& program) OVERRIDE;
 
  private:
+  class ProgramBinary;
+  class ProgramCacheValue;
+
+  typedef base::MRUCache<std::string,
+                         scoped_refptr<ProgramCacheValue> > ProgramMRUCache;
+  typedef base::hash_map<std::string, ProgramBinary*> ProgramBinaryMap;
+
   virtual void ClearBackend() OVERRIDE;
 
+  // Returns the binary with the contents of |data|, sharing it with the
+  // programs already cached with the same binary. Takes ownership of |data|.
+  scoped_refptr<ProgramBinary> GetProgramBinary(const char* data,
+                                                GLsizei length);
+
+  // Replaces a program received through LoadProgram() by its decoded value.
+  // Returns the iterator to the decoded value, or store_.end() if the program
+  // could not be decoded, in which case it is dropped.
+  ProgramMRUCache::iterator DecodeLoadedProgram(
+      ProgramMRUCache::iterator found);
+
+  // Evicts the least recently used programs until |additional_bytes| fit in
+  // the cache, or the cache is empty.
+  void EvictToFit(size_t additional_bytes);
+
+  // Linked program binary, stored once for all the cached programs which have
+  // the same binary contents.
+  class ProgramBinary : public base::RefCounted<ProgramBinary> {
+   public:
+    ProgramBinary(const std::string& binary_hash,
+                  const char* data,
+                  GLsizei length,
+                  MemoryProgramCache* program_cache);
+
+    GLsizei length() const {
+      return length_;
+    }
+
+    const char* data() const {
+      return data_.get();
+    }
+
+   private:
+    friend class base::RefCounted<ProgramBinary>;
+
+    ~ProgramBinary();
+
+    const std::string binary_hash_;
+    const scoped_ptr<const char[]> data_;
+    const GLsizei length_;
+    MemoryProgramCache* const program_cache_;
+
+    DISALLOW_COPY_AND_ASSIGN(ProgramBinary);
+  };
+
   class ProgramCacheValue : public base::RefCounted<ProgramCacheValue> {
    public:
-    ProgramCacheValue(GLsizei length,
-                      GLenum format,
-                      const char* data,
+    ProgramCacheValue(GLenum format,
+                      ProgramBinary* binary,
                       const std::string& program_hash,
                       const char* shader_0_hash,
                       const ShaderTranslator::VariableMap& attrib_map_0,
@@ -64,8 +117,22 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
                       const ShaderTranslator::VariableMap& varying_map_1,
                       MemoryProgramCache* program_cache);
 
+    // Program received through LoadProgram(), kept serialized until it is
+    // first used.
+    ProgramCacheValue(const std::string& program_hash,
+                      const std::string& serialized_program,
+                      MemoryProgramCache* program_cache);
+
+    bool is_serialized() const {
+      return !binary_.get();
+    }
+
+    const std::string& serialized_program() const {
+      return serialized_program_;
+    }
+
     GLsizei length() const {
-      return length_;
+      return binary_->length();
     }
 
     GLenum format() const {
@@ -73,7 +140,7 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
     }
 
     const char* data() const {
-      return data_.get();
+      return binary_->data();
     }
 
     const std::string& shader_0_hash() const {
@@ -113,9 +180,9 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
 
     ~ProgramCacheValue();
 
-    const GLsizei length_;
     const GLenum format_;
-    const scoped_ptr<const char[]> data_;
+    const scoped_refptr<ProgramBinary> binary_;
+    const std::string serialized_program_;
     const std::string program_hash_;
     const std::string shader_0_hash_;
     const ShaderTranslator::VariableMap attrib_map_0_;
@@ -130,13 +197,15 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
     DISALLOW_COPY_AND_ASSIGN(ProgramCacheValue);
   };
 
+  friend class ProgramBinary;
   friend class ProgramCacheValue;
 
-  typedef base::MRUCache<std::string,
-                         scoped_refptr<ProgramCacheValue> > ProgramMRUCache;
-
   const size_t max_size_bytes_;
+  // Size of the unique binaries plus the serialized programs.
   size_t curr_size_bytes_;
+  // The binaries of the cached programs, by SHA1 of their contents. Must
+  // outlive |store_|.
+  ProgramBinaryMap binaries_;
   ProgramMRUCache store_;
 
   DISALLOW_COPY_AND_ASSIGN(MemoryProgramCache);
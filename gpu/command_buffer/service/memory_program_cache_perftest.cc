@@ -0,0 +1,175 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the GPU process startup cost of the program cache: the disk cache
+// sends all its programs through MemoryProgramCache::LoadProgram() before the
+// first frame, which then only uses a few of them. Program binaries are
+// opaque to the cache, so the mock GL bindings return a stub binary.
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "gpu/command_buffer/service/gl_utils.h"
+#include "gpu/command_buffer/service/memory_program_cache.h"
+#include "gpu/command_buffer/service/shader_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gl/gl_bindings.h"
+#include "ui/gl/gl_mock.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::SetArgPointee;
+
+namespace gpu {
+namespace gles2 {
+
+namespace {
+
+const size_t kCacheSizeBytes = 256 * 1024 * 1024;
+const GLsizei kBinaryLength = 8 * 1024;
+const GLenum kBinaryFormat = 1;
+const GLuint kProgramId = 10;
+// Number of programs used to draw the first frame.
+const int kProgramsPerFrame = 50;
+
+}  // namespace
+
+class MemoryProgramCachePerfTest : public testing::Test {
+ public:
+  MemoryProgramCachePerfTest()
+      : vertex_shader_(NULL),
+        fragment_shader_(NULL),
+        binary_(kBinaryLength) {
+  }
+  virtual ~MemoryProgramCachePerfTest() {
+    shader_manager_.Destroy(false);
+  }
+
+  void GetProgramBinary(GLuint program,
+                        GLsizei buffer_size,
+                        GLsizei* length,
+                        GLenum* format,
+                        GLvoid* binary) {
+    if (length)
+      *length = kBinaryLength;
+    *format = kBinaryFormat;
+    memcpy(binary, &binary_[0], kBinaryLength);
+  }
+
+  void SaveProgram(const std::string& key, const std::string& program) {
+    programs_.push_back(program);
+  }
+
+ protected:
+  virtual void SetUp() {
+    gl_.reset(new NiceMock<gfx::MockGLInterface>());
+    ::gfx::MockGLInterface::SetGLInterface(gl_.get());
+    ON_CALL(*gl_.get(), GetProgramiv(_, GL_PROGRAM_BINARY_LENGTH_OES, _))
+        .WillByDefault(SetArgPointee<2>(kBinaryLength));
+    ON_CALL(*gl_.get(), GetProgramiv(_, GL_LINK_STATUS, _))
+        .WillByDefault(SetArgPointee<2>(GL_TRUE));
+    ON_CALL(*gl_.get(), GetProgramBinary(_, _, _, _, _))
+        .WillByDefault(
+            Invoke(this, &MemoryProgramCachePerfTest::GetProgramBinary));
+
+    vertex_shader_ = shader_manager_.CreateShader(1, 100, GL_VERTEX_SHADER);
+    fragment_shader_ = shader_manager_.CreateShader(2, 101, GL_FRAGMENT_SHADER);
+    ASSERT_TRUE(vertex_shader_ != NULL);
+    ASSERT_TRUE(fragment_shader_ != NULL);
+  }
+
+  virtual void TearDown() {
+    ::gfx::MockGLInterface::SetGLInterface(NULL);
+    gl_.reset();
+  }
+
+  // Sets the sources of the shaders of the program |index|.
+  void SetProgramSources(int index) {
+    vertex_shader_->UpdateSource(
+        base::StringPrintf("void main() { gl_Position = vec4(%d); }",
+                           index).c_str());
+    fragment_shader_->UpdateSource(
+        base::StringPrintf("void main() { gl_FragColor = vec4(%d); }",
+                           index).c_str());
+    vertex_shader_->SetStatus(true, NULL, NULL);
+    fragment_shader_->SetStatus(true, NULL, NULL);
+  }
+
+  // Links |count| programs with distinct binaries, and records them as the
+  // disk cache would.
+  void CreatePrograms(int count) {
+    MemoryProgramCache cache(kCacheSizeBytes);
+    programs_.clear();
+    for (int i = 0; i < count; ++i) {
+      SetProgramSources(i);
+      for (GLsizei j = 0; j < kBinaryLength; ++j)
+        binary_[j] = static_cast<char>((i * 31 + j) % 251);
+      cache.SaveLinkedProgram(
+          kProgramId, vertex_shader_, NULL, fragment_shader_, NULL, NULL,
+          base::Bind(&MemoryProgramCachePerfTest::SaveProgram,
+                     base::Unretained(this)));
+    }
+    ASSERT_EQ(static_cast<size_t>(count), programs_.size());
+  }
+
+  // Loads the programs of the first |count| programs from |cache|, and
+  // returns the time spent in the cache.
+  base::TimeDelta UsePrograms(MemoryProgramCache* cache, int count) {
+    base::TimeDelta elapsed;
+    for (int i = 0; i < count; ++i) {
+      SetProgramSources(i);
+      base::TimeTicks start = base::TimeTicks::HighResNow();
+      ProgramCache::ProgramLoadResult result = cache->LoadLinkedProgram(
+          kProgramId, vertex_shader_, NULL, fragment_shader_, NULL, NULL,
+          ShaderCacheCallback());
+      elapsed += base::TimeTicks::HighResNow() - start;
+      EXPECT_EQ(ProgramCache::PROGRAM_LOAD_SUCCESS, result);
+    }
+    return elapsed;
+  }
+
+  void RunStartupBenchmark(int program_count) {
+    CreatePrograms(program_count);
+    const std::string trace =
+        base::StringPrintf("%d_programs", program_count);
+
+    MemoryProgramCache cache(kCacheSizeBytes);
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    for (size_t i = 0; i < programs_.size(); ++i)
+      cache.LoadProgram(programs_[i]);
+    base::TimeDelta load_time = base::TimeTicks::HighResNow() - start;
+    base::TimeDelta first_frame_time =
+        load_time + UsePrograms(&cache, kProgramsPerFrame);
+    // The remaining programs pay for their decoding when first used.
+    base::TimeDelta all_programs_time =
+        first_frame_time + UsePrograms(&cache, program_count);
+
+    perf_test::PrintResult("program_cache_startup", "_load", trace,
+                           load_time.InMillisecondsF(), "ms", true);
+    perf_test::PrintResult("program_cache_startup", "_first_frame", trace,
+                           first_frame_time.InMillisecondsF(), "ms", true);
+    perf_test::PrintResult("program_cache_startup", "_all_programs", trace,
+                           all_programs_time.InMillisecondsF(), "ms", true);
+  }
+
+  scoped_ptr<NiceMock<gfx::MockGLInterface> > gl_;
+  ShaderManager shader_manager_;
+  Shader* vertex_shader_;
+  Shader* fragment_shader_;
+  std::vector<char> binary_;
+  std::vector<std::string> programs_;
+};
+
+TEST_F(MemoryProgramCachePerfTest, Startup) {
+  RunStartupBenchmark(1000);
+  RunStartupBenchmark(5000);
+}
+
+}  // namespace gles2
+}  // namespace gpu
@@ -642,5 +642,104 @@ TEST_F(MemoryProgramCacheTest, OverwriteOnNewSave) {
                  base::Unretained(this))));
 }
 
+TEST_F(MemoryProgramCacheTest, LoadFailOnCorruptLoadedProgram) {
+  const GLenum kFormat = 1;
+  const int kProgramId = 10;
+  const int kBinaryLength = 20;
+  char test_binary[kBinaryLength];
+  for (int i = 0; i < kBinaryLength; ++i) {
+    test_binary[i] = i;
+  }
+  ProgramBinaryEmulator emulator(kBinaryLength, kFormat, test_binary);
+
+  SetExpectationsForSaveLinkedProgram(kProgramId, &emulator);
+  cache_->SaveLinkedProgram(kProgramId, vertex_shader_, NULL,
+                            fragment_shader_, NULL, NULL,
+                            base::Bind(&MemoryProgramCacheTest::ShaderCacheCb,
+                                       base::Unretained(this)));
+  EXPECT_EQ(1, shader_cache_count());
+
+  // The program hash comes first, so the truncated program is only found to be
+  // corrupt when it is used.
+  const std::string program = shader_cache_shader();
+  cache_->Clear();
+  cache_->LoadProgram(program.substr(0, program.size() / 2));
+  EXPECT_EQ(ProgramCache::LINK_SUCCEEDED, cache_->GetLinkedProgramStatus(
+      *vertex_shader_->signature_source(),
+      NULL,
+      *fragment_shader_->signature_source(),
+      NULL,
+      NULL));
+
+  EXPECT_EQ(ProgramCache::PROGRAM_LOAD_FAILURE, cache_->LoadLinkedProgram(
+      kProgramId,
+      vertex_shader_,
+      NULL,
+      fragment_shader_,
+      NULL,
+      NULL,
+      base::Bind(&MemoryProgramCacheTest::ShaderCacheCb,
+                 base::Unretained(this))));
+  EXPECT_EQ(ProgramCache::LINK_UNKNOWN, cache_->GetLinkedProgramStatus(
+      *vertex_shader_->signature_source(),
+      NULL,
+      *fragment_shader_->signature_source(),
+      NULL,
+      NULL));
+}
+
+TEST_F(MemoryProgramCacheTest, IdenticalBinariesStoredOnce) {
+  const GLenum kFormat = 1;
+  const int kProgramId = 10;
+  const int kOtherProgramId = 11;
+  // Two copies of the binary wouldn't fit in the cache.
+  const GLsizei kBinaryLength = kCacheSizeBytes / 2 + 1;
+  scoped_ptr<char[]> test_binary(new char[kBinaryLength]);
+  for (GLsizei i = 0; i < kBinaryLength; ++i) {
+    test_binary[i] = i % 250;
+  }
+  ProgramBinaryEmulator emulator(kBinaryLength, kFormat, test_binary.get());
+
+  SetExpectationsForSaveLinkedProgram(kProgramId, &emulator);
+  cache_->SaveLinkedProgram(kProgramId, vertex_shader_, NULL,
+                            fragment_shader_, NULL, NULL,
+                            base::Bind(&MemoryProgramCacheTest::ShaderCacheCb,
+                                       base::Unretained(this)));
+
+  const std::string old_source = *fragment_shader_->signature_source();
+  fragment_shader_->UpdateSource("al sdfkjdk");
+  fragment_shader_->SetStatus(true, NULL, NULL);
+
+  SetExpectationsForSaveLinkedProgram(kOtherProgramId, &emulator);
+  cache_->SaveLinkedProgram(kOtherProgramId, vertex_shader_, NULL,
+                            fragment_shader_, NULL, NULL,
+                            base::Bind(&MemoryProgramCacheTest::ShaderCacheCb,
+                                       base::Unretained(this)));
+
+  EXPECT_EQ(ProgramCache::LINK_SUCCEEDED, cache_->GetLinkedProgramStatus(
+      *vertex_shader_->signature_source(),
+      NULL,
+      *fragment_shader_->signature_source(),
+      NULL,
+      NULL));
+  EXPECT_EQ(ProgramCache::LINK_SUCCEEDED, cache_->GetLinkedProgramStatus(
+      *vertex_shader_->signature_source(),
+      NULL,
+      old_source,
+      NULL,
+      NULL));
+
+  SetExpectationsForLoadLinkedProgram(kOtherProgramId, &emulator);
+  EXPECT_EQ(ProgramCache::PROGRAM_LOAD_SUCCESS, cache_->LoadLinkedProgram(
+      kOtherProgramId,
+      vertex_shader_,
+      NULL,
+      fragment_shader_,
+      NULL,
+      NULL,
+      base::Bind(&MemoryProgramCacheTest::ShaderCacheCb,
+                 base::Unretained(this))));
+}
+
 }  // namespace gles2
 }  // namespace gpu
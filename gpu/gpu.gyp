@@ -273,6 +273,39 @@
       # TODO(jschuh): crbug.com/167187 fix size_t to int truncations.
       'msvs_disabled_warnings': [ 4267, ],
     },
+    {
+      'target_name': 'gpu_perftests',
+      'type': '<(gtest_target_type)',
+      'dependencies': [
+        '../base/base.gyp:base',
+        '../base/base.gyp:test_support_base',
+        '../testing/gmock.gyp:gmock',
+        '../testing/gtest.gyp:gtest',
+        '../testing/perf/perf_test.gyp:perf_test',
+        '<(angle_path)/src/build_angle.gyp:translator',
+        '../ui/gl/gl.gyp:gl',
+        '../ui/gfx/gfx.gyp:gfx',
+        '../ui/gfx/gfx.gyp:gfx_geometry',
+        'command_buffer/command_buffer.gyp:gles2_utils',
+        'command_buffer_client',
+        'command_buffer_common',
+        'command_buffer_service',
+        'gpu',
+        'gpu_unittest_utils',
+      ],
+      'sources': [
+        'command_buffer/client/fenced_allocator_perftest.cc',
+        'command_buffer/common/unittest_main.cc',
+        'command_buffer/service/gles2_cmd_decoder_perftest.cc',
+        'command_buffer/service/gles2_cmd_decoder_unittest_base.cc',
+        'command_buffer/service/gles2_cmd_decoder_unittest_base.h',
+        'command_buffer/service/memory_program_cache_perftest.cc',
+        'command_buffer/service/test_helper.cc',
+        'command_buffer/service/test_helper.h',
+      ],
+      # TODO(jschuh): crbug.com/167187 fix size_t to int truncations.
+      'msvs_disabled_warnings': [ 4267, ],
+    },
     {
       'target_name': 'gl_tests',
       'type': '<(gtest_target_type)',
@@ -0,0 +1,126 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/lock_free_audio_fifo.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+using base::subtle::Acquire_Load;
+using base::subtle::NoBarrier_Load;
+using base::subtle::Release_Store;
+
+namespace media {
+
+// Read and write indices run over [0, 2 * |max_frames|) rather than
+// [0, |max_frames|) so that a full FIFO can be told apart from an empty one
+// without sharing a separate frame counter between the two threads.
+
+// Returns the number of frames between |read_index| and |write_index|.
+static int FillLevel(int write_index, int read_index, int max_frames) {
+  int fill = write_index - read_index;
+  return fill < 0 ? fill + 2 * max_frames : fill;
+}
+
+// Returns the position in the ring buffer referenced by |index|.
+static int BufferPos(int index, int max_frames) {
+  return index < max_frames ? index : index - max_frames;
+}
+
+static int AdvanceIndex(int index, int frames, int max_frames) {
+  index += frames;
+  return index < 2 * max_frames ? index : index - 2 * max_frames;
+}
+
+LockFreeAudioFifo::LockFreeAudioFifo(int channels, int frames)
+    : audio_bus_(AudioBus::Create(channels, frames)),
+      max_frames_(frames),
+      write_index_(0),
+      read_index_(0) {
+  DCHECK_GT(frames, 0);
+}
+
+LockFreeAudioFifo::~LockFreeAudioFifo() {}
+
+bool LockFreeAudioFifo::Push(const AudioBus* source, int frames_to_push) {
+  DCHECK(source);
+  DCHECK_EQ(source->channels(), audio_bus_->channels());
+  DCHECK_GE(frames_to_push, 0);
+  DCHECK_LE(frames_to_push, source->frames());
+
+  // Only the producer writes |write_index_|, so a plain load is sufficient.
+  const int write_index = NoBarrier_Load(&write_index_);
+  const int read_index = Acquire_Load(&read_index_);
+  if (frames_to_push >
+      max_frames_ - FillLevel(write_index, read_index, max_frames_)) {
+    return false;
+  }
+
+  const int write_pos = BufferPos(write_index, max_frames_);
+  const int size = std::min(frames_to_push, max_frames_ - write_pos);
+  const int wrap_size = frames_to_push - size;
+  for (int ch = 0; ch < source->channels(); ++ch) {
+    float* dest = audio_bus_->channel(ch);
+    const float* src = source->channel(ch);
+    memcpy(&dest[write_pos], src, size * sizeof(*src));
+    if (wrap_size > 0)
+      memcpy(dest, &src[size], wrap_size * sizeof(*src));
+  }
+
+  // Publish the frames only after they have been written.
+  Release_Store(&write_index_,
+                AdvanceIndex(write_index, frames_to_push, max_frames_));
+  return true;
+}
+
+bool LockFreeAudioFifo::Consume(AudioBus* destination,
+                                int start_frame,
+                                int frames_to_consume) {
+  DCHECK(destination);
+  DCHECK_EQ(destination->channels(), audio_bus_->channels());
+  DCHECK_GE(frames_to_consume, 0);
+  DCHECK_LE(start_frame + frames_to_consume, destination->frames());
+
+  // Only the consumer writes |read_index_|, so a plain load is sufficient.
+  const int read_index = NoBarrier_Load(&read_index_);
+  const int write_index = Acquire_Load(&write_index_);
+  if (frames_to_consume > FillLevel(write_index, read_index, max_frames_))
+    return false;
+
+  const int read_pos = BufferPos(read_index, max_frames_);
+  const int size = std::min(frames_to_consume, max_frames_ - read_pos);
+  const int wrap_size = frames_to_consume - size;
+  for (int ch = 0; ch < destination->channels(); ++ch) {
+    float* dest = destination->channel(ch) + start_frame;
+    const float* src = audio_bus_->channel(ch);
+    memcpy(dest, &src[read_pos], size * sizeof(*src));
+    if (wrap_size > 0)
+      memcpy(&dest[size], src, wrap_size * sizeof(*src));
+  }
+
+  // Release the space only after the frames have been copied out.
+  Release_Store(&read_index_,
+                AdvanceIndex(read_index, frames_to_consume, max_frames_));
+  return true;
+}
+
+void LockFreeAudioFifo::Flush() {
+  Release_Store(&read_index_, Acquire_Load(&write_index_));
+}
+
+int LockFreeAudioFifo::readable_frames() const {
+  const int read_index = Acquire_Load(&read_index_);
+  return FillLevel(Acquire_Load(&write_index_), read_index, max_frames_);
+}
+
+int LockFreeAudioFifo::writable_frames() const {
+  const int write_index = Acquire_Load(&write_index_);
+  return max_frames_ -
+         FillLevel(write_index, Acquire_Load(&read_index_), max_frames_);
+}
+
+}  // namespace media
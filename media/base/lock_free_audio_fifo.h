@@ -0,0 +1,75 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
+#define MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
+
+#include "base/atomicops.h"
+#include "base/memory/scoped_ptr.h"
+#include "media/base/audio_bus.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+// Wait-free single-producer/single-consumer FIFO for planar float audio.
+// Exactly one thread may call the producer methods (Push(), writable_frames())
+// while exactly one other thread calls the consumer methods (Consume(),
+// Flush(), readable_frames()). Neither side ever blocks or takes a lock, which
+// makes the class suitable for exchanging audio with a real-time audio device
+// thread without risking priority inversion.
+//
+// Unlike AudioFifo, running out of space or data is not fatal: Push() and
+// Consume() report failure and leave the FIFO untouched, so callers on a
+// real-time thread can output silence or drop data instead of crashing.
+class MEDIA_EXPORT LockFreeAudioFifo {
+ public:
+  // Creates a FIFO holding at most |frames| frames of |channels| channels.
+  LockFreeAudioFifo(int channels, int frames);
+  ~LockFreeAudioFifo();
+
+  // Producer side. Pushes the first |frames_to_push| frames of |source|.
+  // Returns false, without pushing anything, if fewer than |frames_to_push|
+  // frames of space are available.
+  bool Push(const AudioBus* source, int frames_to_push);
+  bool Push(const AudioBus* source) { return Push(source, source->frames()); }
+
+  // Consumer side. Copies |frames_to_consume| frames to |destination|
+  // starting at |start_frame| and removes them from the FIFO. Returns false,
+  // without consuming anything, if fewer than |frames_to_consume| frames are
+  // available.
+  bool Consume(AudioBus* destination, int start_frame, int frames_to_consume);
+
+  // Consumer side. Discards all frames currently in the FIFO.
+  void Flush();
+
+  // Number of frames that can be consumed. Exact on the consumer thread, a
+  // lower bound elsewhere.
+  int readable_frames() const;
+
+  // Number of frames that can be pushed. Exact on the producer thread, a
+  // lower bound elsewhere.
+  int writable_frames() const;
+
+  int channels() const { return audio_bus_->channels(); }
+  int max_frames() const { return max_frames_; }
+
+ private:
+  // Storage for the ring buffer.
+  scoped_ptr<AudioBus> audio_bus_;
+
+  const int max_frames_;
+
+  // Write and read indices in [0, 2 * |max_frames_|). |write_index_| is only
+  // written by the producer and |read_index_| only by the consumer; each side
+  // publishes its index with release semantics after touching the audio data
+  // and reads the other's with acquire semantics.
+  volatile base::subtle::Atomic32 write_index_;
+  volatile base::subtle::Atomic32 read_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockFreeAudioFifo);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
@@ -0,0 +1,128 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "base/synchronization/cancellation_flag.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "media/base/audio_fifo.h"
+#include "media/base/lock_free_audio_fifo.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kChannels = 2;
+static const int kSampleRate = 48000;
+static const int kBufferFrames = 128;
+static const int kFifoFrames = 4 * kBufferFrames;
+static const int kBenchmarkSeconds = 2;
+
+// Adapts AudioFifo guarded by a base::Lock, the pattern used by existing
+// cross-thread users, to the interface used by the benchmark.
+class LockedAudioFifo {
+ public:
+  LockedAudioFifo() : fifo_(kChannels, kFifoFrames) {}
+
+  bool Push(const AudioBus* source) {
+    base::AutoLock auto_lock(lock_);
+    if (fifo_.frames() + source->frames() > fifo_.max_frames())
+      return false;
+    fifo_.Push(source);
+    return true;
+  }
+
+  bool Consume(AudioBus* destination, int start_frame, int frames) {
+    base::AutoLock auto_lock(lock_);
+    if (fifo_.frames() < frames)
+      return false;
+    fifo_.Consume(destination, start_frame, frames);
+    return true;
+  }
+
+ private:
+  base::Lock lock_;
+  AudioFifo fifo_;
+};
+
+// Pushes |kBufferFrames| blocks into the FIFO as fast as space allows until
+// stopped, simulating a capture or decode thread.
+template <typename Fifo>
+class Producer : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit Producer(Fifo* fifo) : fifo_(fifo) {}
+  virtual ~Producer() {}
+
+  virtual void Run() OVERRIDE {
+    scoped_ptr<AudioBus> bus = AudioBus::Create(kChannels, kBufferFrames);
+    bus->Zero();
+    while (!stop_.IsSet()) {
+      if (!fifo_->Push(bus.get()))
+        base::PlatformThread::YieldCurrentThread();
+    }
+  }
+
+  void Stop() { stop_.Set(); }
+
+ private:
+  Fifo* fifo_;
+  base::CancellationFlag stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(Producer);
+};
+
+// Simulates an audio device thread which must consume |kBufferFrames| frames
+// every buffer period. A deadline is missed when the FIFO cannot deliver a
+// full buffer or when the Consume() call itself takes longer than the period.
+template <typename Fifo>
+static void RunFifoBenchmark(Fifo* fifo, const std::string& trace_name) {
+  Producer<Fifo> producer(fifo);
+  base::DelegateSimpleThread producer_thread(&producer, "Producer");
+  producer_thread.Start();
+
+  const base::TimeDelta period = base::TimeDelta::FromMicroseconds(
+      base::Time::kMicrosecondsPerSecond * kBufferFrames / kSampleRate);
+  const int periods = kBenchmarkSeconds * kSampleRate / kBufferFrames;
+
+  scoped_ptr<AudioBus> bus = AudioBus::Create(kChannels, kBufferFrames);
+  int missed_deadlines = 0;
+  base::TimeDelta max_consume_time;
+  base::TimeTicks next_deadline = base::TimeTicks::HighResNow();
+  for (int i = 0; i < periods; ++i) {
+    next_deadline += period;
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    bool success = fifo->Consume(bus.get(), 0, kBufferFrames);
+    base::TimeDelta consume_time = base::TimeTicks::HighResNow() - start;
+    max_consume_time = std::max(max_consume_time, consume_time);
+    if (!success || consume_time > period)
+      ++missed_deadlines;
+
+    base::TimeDelta sleep_time =
+        next_deadline - base::TimeTicks::HighResNow();
+    if (sleep_time > base::TimeDelta())
+      base::PlatformThread::Sleep(sleep_time);
+  }
+
+  producer.Stop();
+  producer_thread.Join();
+
+  perf_test::PrintResult("audio_fifo_missed_deadlines", "", trace_name,
+                         static_cast<size_t>(missed_deadlines), "count", true);
+  perf_test::PrintResult("audio_fifo_max_consume_time", "", trace_name,
+                         max_consume_time.InMillisecondsF() * 1000, "us",
+                         true);
+}
+
+TEST(LockFreeAudioFifoPerfTest, MissedDeadlines) {
+  LockedAudioFifo locked_fifo;
+  RunFifoBenchmark(&locked_fifo, "locked_audio_fifo");
+
+  LockFreeAudioFifo lock_free_fifo(kChannels, kFifoFrames);
+  RunFifoBenchmark(&lock_free_fifo, "lock_free_audio_fifo");
+}
+
+}  // namespace media
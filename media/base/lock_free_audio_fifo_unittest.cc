@@ -0,0 +1,140 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "media/base/lock_free_audio_fifo.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static const int kChannels = 2;
+static const int kMaxFrameCount = 128;
+
+// Fills every channel of |bus| with consecutive values starting at |value|.
+static void FillBus(AudioBus* bus, float value) {
+  for (int ch = 0; ch < bus->channels(); ++ch) {
+    for (int i = 0; i < bus->frames(); ++i)
+      bus->channel(ch)[i] = value + i;
+  }
+}
+
+TEST(LockFreeAudioFifoTest, Construct) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  EXPECT_EQ(0, fifo.readable_frames());
+  EXPECT_EQ(kMaxFrameCount, fifo.writable_frames());
+  EXPECT_EQ(kChannels, fifo.channels());
+  EXPECT_EQ(kMaxFrameCount, fifo.max_frames());
+}
+
+// Verify that pushing into a full FIFO or consuming from an empty one fails
+// without changing the FIFO.
+TEST(LockFreeAudioFifoTest, OverflowAndUnderflow) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  scoped_ptr<AudioBus> bus = AudioBus::Create(kChannels, kMaxFrameCount);
+
+  EXPECT_FALSE(fifo.Consume(bus.get(), 0, 1));
+
+  EXPECT_TRUE(fifo.Push(bus.get()));
+  EXPECT_EQ(kMaxFrameCount, fifo.readable_frames());
+  EXPECT_EQ(0, fifo.writable_frames());
+  EXPECT_FALSE(fifo.Push(bus.get(), 1));
+  EXPECT_EQ(kMaxFrameCount, fifo.readable_frames());
+
+  EXPECT_TRUE(fifo.Consume(bus.get(), 0, kMaxFrameCount));
+  EXPECT_EQ(0, fifo.readable_frames());
+  EXPECT_FALSE(fifo.Consume(bus.get(), 0, 1));
+}
+
+// Push and consume odd-sized blocks so that the read and write positions wrap
+// around the ring buffer many times, verifying the data on the way out.
+TEST(LockFreeAudioFifoTest, WrapAround) {
+  static const int kBlockSize = 37;
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  scoped_ptr<AudioBus> in = AudioBus::Create(kChannels, kBlockSize);
+  scoped_ptr<AudioBus> out = AudioBus::Create(kChannels, kBlockSize + 3);
+
+  for (int i = 0; i < 100; ++i) {
+    FillBus(in.get(), i * kBlockSize);
+    ASSERT_TRUE(fifo.Push(in.get()));
+    ASSERT_TRUE(fifo.Push(in.get(), kBlockSize - 1));
+    ASSERT_TRUE(fifo.Consume(out.get(), 3, kBlockSize));
+    ASSERT_TRUE(fifo.Consume(out.get(), 0, kBlockSize - 1));
+    for (int ch = 0; ch < kChannels; ++ch) {
+      for (int j = 0; j < kBlockSize - 1; ++j)
+        ASSERT_FLOAT_EQ(i * kBlockSize + j, out->channel(ch)[j]);
+    }
+    EXPECT_EQ(0, fifo.readable_frames());
+  }
+}
+
+TEST(LockFreeAudioFifoTest, Flush) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  scoped_ptr<AudioBus> bus = AudioBus::Create(kChannels, kMaxFrameCount / 2);
+  EXPECT_TRUE(fifo.Push(bus.get()));
+  fifo.Flush();
+  EXPECT_EQ(0, fifo.readable_frames());
+  EXPECT_EQ(kMaxFrameCount, fifo.writable_frames());
+  EXPECT_TRUE(fifo.Push(bus.get()));
+  EXPECT_TRUE(fifo.Push(bus.get()));
+}
+
+// Producer thread that pushes a ramp of |total_frames| frames, spinning
+// whenever the FIFO is full.
+class RampProducer : public base::DelegateSimpleThread::Delegate {
+ public:
+  RampProducer(LockFreeAudioFifo* fifo, int total_frames)
+      : fifo_(fifo), total_frames_(total_frames) {}
+  virtual ~RampProducer() {}
+
+  virtual void Run() OVERRIDE {
+    static const int kBlockSize = 29;
+    scoped_ptr<AudioBus> bus = AudioBus::Create(fifo_->channels(), kBlockSize);
+    for (int pushed = 0; pushed < total_frames_;) {
+      int frames = std::min(kBlockSize, total_frames_ - pushed);
+      FillBus(bus.get(), pushed);
+      while (!fifo_->Push(bus.get(), frames))
+        base::PlatformThread::YieldCurrentThread();
+      pushed += frames;
+    }
+  }
+
+ private:
+  LockFreeAudioFifo* fifo_;
+  const int total_frames_;
+
+  DISALLOW_COPY_AND_ASSIGN(RampProducer);
+};
+
+// Stress the FIFO with a concurrent producer and consumer and verify that the
+// consumer observes every frame exactly once and in order.
+TEST(LockFreeAudioFifoTest, ConcurrentProducerConsumer) {
+  static const int kTotalFrames = 1 << 20;
+  static const int kBlockSize = 31;
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  RampProducer producer(&fifo, kTotalFrames);
+  base::DelegateSimpleThread producer_thread(&producer, "RampProducer");
+  producer_thread.Start();
+
+  scoped_ptr<AudioBus> bus = AudioBus::Create(kChannels, kBlockSize);
+  for (int consumed = 0; consumed < kTotalFrames;) {
+    int frames = std::min(kBlockSize, kTotalFrames - consumed);
+    if (!fifo.Consume(bus.get(), 0, frames)) {
+      base::PlatformThread::YieldCurrentThread();
+      continue;
+    }
+    for (int ch = 0; ch < kChannels; ++ch) {
+      for (int i = 0; i < frames; ++i)
+        ASSERT_FLOAT_EQ(consumed + i, bus->channel(ch)[i]);
+    }
+    consumed += frames;
+  }
+
+  producer_thread.Join();
+  EXPECT_EQ(0, fifo.readable_frames());
+}
+
+}  // namespace media
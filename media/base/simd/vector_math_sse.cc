@@ -114,5 +114,28 @@ std::pair<float, float> EWMAAndMaxPower_SSE(
   return result;
 }
 
+float DotProduct_SSE(const float a[], const float b[], int len) {
+  const int rem = len % 4;
+  const int last_index = len - rem;
+
+  // |a| and |b| are frequently offset into a channel by an arbitrary number of
+  // frames, so unaligned loads are required.
+  __m128 sum_x4 = _mm_setzero_ps();
+  for (int i = 0; i < last_index; i += 4) {
+    sum_x4 = _mm_add_ps(sum_x4,
+                        _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+
+  // Fold the four partial sums together.
+  sum_x4 = _mm_add_ps(sum_x4, _mm_movehl_ps(sum_x4, sum_x4));
+  sum_x4 = _mm_add_ss(sum_x4, _mm_shuffle_ps(sum_x4, sum_x4, 1));
+  float sum = EXTRACT_FLOAT(sum_x4, 0);
+
+  // Handle any remaining values that wouldn't fit in an SSE pass.
+  for (int i = last_index; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
 }  // namespace vector_math
 }  // namespace media
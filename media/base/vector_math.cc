@@ -26,6 +26,7 @@ namespace vector_math {
 #define FMAC_FUNC FMAC_SSE
 #define FMUL_FUNC FMUL_SSE
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
+#define DotProduct_FUNC DotProduct_SSE
 void Initialize() {}
 #else
 // X86 CPU detection required.  Functions will be set by Initialize().
@@ -33,6 +34,7 @@ void Initialize() {}
 #define FMAC_FUNC g_fmac_proc_
 #define FMUL_FUNC g_fmul_proc_
 #define EWMAAndMaxPower_FUNC g_ewma_power_proc_
+#define DotProduct_FUNC g_dot_product_proc_
 
 typedef void (*MathProc)(const float src[], float scale, int len, float dest[]);
 static MathProc g_fmac_proc_ = NULL;
@@ -40,27 +42,33 @@ static MathProc g_fmul_proc_ = NULL;
 typedef std::pair<float, float> (*EWMAAndMaxPowerProc)(
     float initial_value, const float src[], int len, float smoothing_factor);
 static EWMAAndMaxPowerProc g_ewma_power_proc_ = NULL;
+typedef float (*DotProductProc)(const float a[], const float b[], int len);
+static DotProductProc g_dot_product_proc_ = NULL;
 
 void Initialize() {
   CHECK(!g_fmac_proc_);
   CHECK(!g_fmul_proc_);
   CHECK(!g_ewma_power_proc_);
+  CHECK(!g_dot_product_proc_);
   const bool kUseSSE = base::CPU().has_sse();
   g_fmac_proc_ = kUseSSE ? FMAC_SSE : FMAC_C;
   g_fmul_proc_ = kUseSSE ? FMUL_SSE : FMUL_C;
   g_ewma_power_proc_ = kUseSSE ? EWMAAndMaxPower_SSE : EWMAAndMaxPower_C;
+  g_dot_product_proc_ = kUseSSE ? DotProduct_SSE : DotProduct_C;
 }
 #endif
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #define FMAC_FUNC FMAC_NEON
 #define FMUL_FUNC FMUL_NEON
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_NEON
+#define DotProduct_FUNC DotProduct_NEON
 void Initialize() {}
 #else
 // Unknown architecture.
 #define FMAC_FUNC FMAC_C
 #define FMUL_FUNC FMUL_C
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_C
+#define DotProduct_FUNC DotProduct_C
 void Initialize() {}
 #endif
 
@@ -109,6 +117,18 @@ std::pair<float, float> EWMAAndMaxPower_C(
   return result;
 }
 
+float DotProduct(const float a[], const float b[], int len) {
+  DCHECK_GE(len, 0);
+  return DotProduct_FUNC(a, b, len);
+}
+
+float DotProduct_C(const float a[], const float b[], int len) {
+  float sum = 0.0f;
+  for (int i = 0; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 void FMAC_NEON(const float src[], float scale, int len, float dest[]) {
   const int rem = len % 4;
@@ -200,6 +220,24 @@ std::pair<float, float> EWMAAndMaxPower_NEON(
 
   return result;
 }
+
+float DotProduct_NEON(const float a[], const float b[], int len) {
+  const int rem = len % 4;
+  const int last_index = len - rem;
+  float32x4_t sum_x4 = vdupq_n_f32(0.0f);
+  for (int i = 0; i < last_index; i += 4)
+    sum_x4 = vmlaq_f32(sum_x4, vld1q_f32(a + i), vld1q_f32(b + i));
+
+  // Fold the four partial sums together.
+  float32x2_t sum_x2 = vadd_f32(vget_low_f32(sum_x4), vget_high_f32(sum_x4));
+  sum_x2 = vpadd_f32(sum_x2, sum_x2);
+  float sum = vget_lane_f32(sum_x2, 0);
+
+  // Handle any remaining values that wouldn't fit in an NEON pass.
+  for (int i = last_index; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
 #endif
 
 }  // namespace vector_math
@@ -38,6 +38,11 @@ MEDIA_EXPORT void FMUL(const float src[], float scale, int len, float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower(
     float initial_value, const float src[], int len, float smoothing_factor);
 
+// Returns the sum of the element-wise products of |a| and |b| (up to |len|).
+// Unlike the functions above, |a| and |b| need not be aligned, since callers
+// typically pass arbitrary frame offsets into audio channels.
+MEDIA_EXPORT float DotProduct(const float a[], const float b[], int len);
+
 }  // namespace vector_math
 }  // namespace media
 
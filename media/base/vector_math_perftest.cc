@@ -18,6 +18,7 @@ namespace media {
 
 static const int kBenchmarkIterations = 200000;
 static const int kEWMABenchmarkIterations = 50000;
+static const int kDotProductBenchmarkIterations = 50000;
 static const float kScale = 0.5;
 static const int kVectorSize = 8192;
 
@@ -73,6 +74,30 @@ class VectorMathPerfTest : public testing::Test {
                            true);
   }
 
+  void RunBenchmark(float (*fn)(const float[], const float[], int),
+                    bool aligned,
+                    const std::string& test_name,
+                    const std::string& trace_name) {
+    // WSOLA computes dot products at arbitrary frame offsets, so the
+    // unaligned case offsets the inputs rather than just the length.
+    const int offset = aligned ? 0 : 1;
+    TimeTicks start = TimeTicks::HighResNow();
+    for (int i = 0; i < kDotProductBenchmarkIterations; ++i) {
+      fn(input_vector_.get() + offset,
+         output_vector_.get() + offset,
+         kVectorSize - offset);
+    }
+    double total_time_milliseconds =
+        (TimeTicks::HighResNow() - start).InMillisecondsF();
+    perf_test::PrintResult(
+        test_name,
+        "",
+        trace_name,
+        kDotProductBenchmarkIterations / total_time_milliseconds,
+        "runs/ms",
+        true);
+  }
+
  protected:
   scoped_ptr<float, base::AlignedFreeDeleter> input_vector_;
   scoped_ptr<float, base::AlignedFreeDeleter> output_vector_;
@@ -178,4 +203,35 @@ TEST_F(VectorMathPerfTest, EWMAAndMaxPower) {
 
 #undef EWMAAndMaxPower_FUNC
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#define DotProduct_FUNC DotProduct_SSE
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+#define DotProduct_FUNC DotProduct_NEON
+#endif
+
+// Benchmark for each optimized vector_math::DotProduct() method.
+TEST_F(VectorMathPerfTest, DotProduct) {
+  // Benchmark DotProduct_C().
+  RunBenchmark(
+      vector_math::DotProduct_C, true, "vector_math_dot_product",
+      "unoptimized");
+#if defined(DotProduct_FUNC)
+#if defined(ARCH_CPU_X86_FAMILY)
+  ASSERT_TRUE(base::CPU().has_sse());
+#endif
+  // Benchmark DotProduct_FUNC() with unaligned inputs.
+  RunBenchmark(vector_math::DotProduct_FUNC,
+               false,
+               "vector_math_dot_product",
+               "optimized_unaligned");
+  // Benchmark DotProduct_FUNC() with aligned inputs.
+  RunBenchmark(vector_math::DotProduct_FUNC,
+               true,
+               "vector_math_dot_product",
+               "optimized_aligned");
+#endif
+}
+
+#undef DotProduct_FUNC
+
 } // namespace media
@@ -18,6 +18,7 @@ MEDIA_EXPORT void FMAC_C(const float src[], float scale, int len, float dest[]);
 MEDIA_EXPORT void FMUL_C(const float src[], float scale, int len, float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_C(
     float initial_value, const float src[], int len, float smoothing_factor);
+MEDIA_EXPORT float DotProduct_C(const float a[], const float b[], int len);
 
 #if defined(ARCH_CPU_X86_FAMILY)
 MEDIA_EXPORT void FMAC_SSE(const float src[], float scale, int len,
@@ -26,6 +27,7 @@ MEDIA_EXPORT void FMUL_SSE(const float src[], float scale, int len,
                            float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_SSE(
     float initial_value, const float src[], int len, float smoothing_factor);
+MEDIA_EXPORT float DotProduct_SSE(const float a[], const float b[], int len);
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -35,6 +37,7 @@ MEDIA_EXPORT void FMUL_NEON(const float src[], float scale, int len,
                             float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_NEON(
     float initial_value, const float src[], int len, float smoothing_factor);
+MEDIA_EXPORT float DotProduct_NEON(const float a[], const float b[], int len);
 #endif
 
 }  // namespace vector_math
@@ -11,6 +11,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringize_macros.h"
+#include "base/strings/stringprintf.h"
 #include "media/base/vector_math.h"
 #include "media/base/vector_math_testing.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -138,6 +139,42 @@ TEST_F(VectorMathTest, FMUL) {
 #endif
 }
 
+// Ensure each optimized vector_math::DotProduct() method returns the same value
+// for both aligned and unaligned inputs and lengths.
+TEST_F(VectorMathTest, DotProduct) {
+  for (int i = 0; i < kVectorSize; ++i) {
+    input_vector_.get()[i] = (i % 7) * 0.25f - 0.5f;
+    output_vector_.get()[i] = (i % 5) * 0.5f - 1.0f;
+  }
+
+  // Offsets and lengths which exercise both the vectorized loop and the
+  // scalar remainder.
+  const int kOffsets[] = {0, 1, 3};
+  const int kLengths[] = {0, 1, 3, 4, 7, 64, kVectorSize - 3};
+  for (size_t i = 0; i < arraysize(kOffsets); ++i) {
+    for (size_t j = 0; j < arraysize(kLengths); ++j) {
+      const float* a = input_vector_.get() + kOffsets[i];
+      const float* b = output_vector_.get() + kOffsets[i];
+      const int len = kLengths[j];
+      SCOPED_TRACE(base::StringPrintf("offset=%d len=%d", kOffsets[i], len));
+
+      float expected = 0;
+      for (int n = 0; n < len; ++n)
+        expected += a[n] * b[n];
+
+      EXPECT_FLOAT_EQ(expected, vector_math::DotProduct(a, b, len));
+      EXPECT_FLOAT_EQ(expected, vector_math::DotProduct_C(a, b, len));
+#if defined(ARCH_CPU_X86_FAMILY)
+      ASSERT_TRUE(base::CPU().has_sse());
+      EXPECT_FLOAT_EQ(expected, vector_math::DotProduct_SSE(a, b, len));
+#endif
+#if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+      EXPECT_FLOAT_EQ(expected, vector_math::DotProduct_NEON(a, b, len));
+#endif
+    }
+  }
+}
+
 namespace {
 
 class EWMATestScenario {
@@ -147,6 +147,24 @@
             'video_sender/video_sender_unittest.cc',
           ], # source
         },
+        {
+          'target_name': 'cast_perftests',
+          'type': '<(gtest_target_type)',
+          'dependencies': [
+            'transport/cast_transport.gyp:cast_transport',
+            '<(DEPTH)/base/base.gyp:run_all_unittests',
+            '<(DEPTH)/base/base.gyp:test_support_base',
+            '<(DEPTH)/net/net.gyp:net',
+            '<(DEPTH)/testing/gtest.gyp:gtest',
+            '<(DEPTH)/testing/perf/perf_test.gyp:perf_test',
+          ],
+          'include_dirs': [
+            '<(DEPTH)/',
+          ],
+          'sources': [
+            'transport/transport/udp_transport_perftest.cc',
+          ], # source
+        },
         {
           'target_name': 'cast_sender_app',
           'type': 'executable',
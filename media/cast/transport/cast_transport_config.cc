@@ -74,6 +74,13 @@ SendRtcpFromRtpSenderData::SendRtcpFromRtpSenderData()
       sending_ssrc(0) {}
 SendRtcpFromRtpSenderData::~SendRtcpFromRtpSenderData() {}
 
+bool PacketSender::SendPackets(const PacketList& packets) {
+  bool ret = true;
+  for (size_t i = 0; i < packets.size(); ++i)
+    ret &= SendPacket(packets[i]);
+  return ret;
+}
+
 }  // namespace transport
 }  // namespace cast
 }  // namespace media
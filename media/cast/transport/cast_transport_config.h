@@ -103,6 +103,11 @@ class PacketSender {
   // functions.
   virtual bool SendPacket(const transport::Packet& packet) = 0;
 
+  // Sends a burst of packets in one call. Transports that can write several
+  // datagrams at once should override this; the default implementation calls
+  // SendPacket() for each packet. Returns false if any packet failed.
+  virtual bool SendPackets(const transport::PacketList& packets);
+
   virtual ~PacketSender() {}
 };
 
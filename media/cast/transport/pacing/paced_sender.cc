@@ -28,9 +28,8 @@ PacedSender::PacedSender(
       transport_task_runner_(transport_task_runner),
       burst_size_(1),
       packets_sent_in_burst_(0),
-      weak_factory_(this) {
-  ScheduleNextSend();
-}
+      send_task_pending_(false),
+      weak_factory_(this) {}
 
 PacedSender::~PacedSender() {}
 
@@ -68,6 +67,13 @@ bool PacedSender::SendPacketsToTransport(const PacketList& packets,
   packets_not_sent->insert(
       packets_not_sent->end(), first_to_store_it, packets.end());
   packets_sent_in_burst_ = packets_to_send.size();
+
+  // If the sender was idle, the burst sent now starts a new pacing interval.
+  if (!send_task_pending_ && !packets_not_sent->empty()) {
+    time_last_process_ = clock_->NowTicks();
+    ScheduleNextSend();
+  }
+
   if (packets_to_send.empty())
     return true;
 
@@ -80,6 +86,11 @@ bool PacedSender::SendRtcpPacket(const Packet& packet) {
 }
 
 void PacedSender::ScheduleNextSend() {
+  if (send_task_pending_ ||
+      (packet_list_.empty() && resend_packet_list_.empty())) {
+    return;
+  }
+
   base::TimeDelta time_to_next =
       time_last_process_ - clock_->NowTicks() +
       base::TimeDelta::FromMilliseconds(kPacingIntervalMs);
@@ -90,9 +101,11 @@ void PacedSender::ScheduleNextSend() {
       FROM_HERE,
       base::Bind(&PacedSender::SendNextPacketBurst, weak_factory_.GetWeakPtr()),
       time_to_next);
+  send_task_pending_ = true;
 }
 
 void PacedSender::SendNextPacketBurst() {
+  send_task_pending_ = false;
   SendStoredPackets();
   time_last_process_ = clock_->NowTicks();
   ScheduleNextSend();
@@ -135,11 +148,7 @@ void PacedSender::SendStoredPackets() {
 }
 
 bool PacedSender::TransmitPackets(const PacketList& packets) {
-  bool ret = true;
-  for (size_t i = 0; i < packets.size(); i++) {
-    ret &= transport_->SendPacket(packets[i]);
-  }
-  return ret;
+  return transport_->SendPackets(packets);
 }
 
 void PacedSender::UpdateBurstSize(size_t packets_to_send) {
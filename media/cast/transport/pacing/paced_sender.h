@@ -58,7 +58,8 @@ class PacedSender : public PacedPacketSender,
 
  protected:
   // Schedule a delayed task on the main cast thread when it's time to send the
-  // next packet burst.
+  // next packet burst. Does nothing if a task is already pending or if there
+  // are no stored packets, so an idle sender does not wake up periodically.
   void ScheduleNextSend();
 
   // Process any pending packets in the queue(s).
@@ -68,7 +69,7 @@ class PacedSender : public PacedPacketSender,
   bool SendPacketsToTransport(const PacketList& packets,
                               PacketList* packets_not_sent);
 
-  // Actually sends the packets to the transport.
+  // Actually sends the packets to the transport, as a single batch.
   bool TransmitPackets(const PacketList& packets);
   void SendStoredPackets();
   void UpdateBurstSize(size_t num_of_packets);
@@ -80,6 +81,8 @@ class PacedSender : public PacedPacketSender,
   size_t burst_size_;
   size_t packets_sent_in_burst_;
   base::TimeTicks time_last_process_;
+  // True while a SendNextPacketBurst() task is posted.
+  bool send_task_pending_;
   // Note: We can't combine the |packet_list_| and the |resend_packet_list_|
   // since then we might get reordering of the retransmitted packets.
   PacketList packet_list_;
@@ -23,7 +23,13 @@ static const int64 kStartMillisecond = GG_INT64_C(12345678900000);
 
 class TestPacketSender : public PacketSender {
  public:
-  TestPacketSender() {}
+  TestPacketSender() : num_batches_(0) {}
+
+  virtual bool SendPackets(const PacketList& packets) OVERRIDE {
+    if (!packets.empty())
+      ++num_batches_;
+    return PacketSender::SendPackets(packets);
+  }
 
   virtual bool SendPacket(const Packet& packet) OVERRIDE {
     EXPECT_FALSE(expected_packet_size_.empty());
@@ -39,8 +45,11 @@ class TestPacketSender : public PacketSender {
     }
   }
 
+  int num_batches() const { return num_batches_; }
+
  private:
   std::list<int> expected_packet_size_;
+  int num_batches_;
 
   DISALLOW_COPY_AND_ASSIGN(TestPacketSender);
 };
@@ -117,6 +126,43 @@ TEST_F(PacedSenderTest, BasicPace) {
   task_runner_->RunTasks();
 }
 
+TEST_F(PacedSenderTest, BurstsAreSentAsBatches) {
+  int num_of_packets = 9;
+  PacketList packets = CreatePacketList(kSize1, num_of_packets);
+
+  // Each burst of three packets must reach the transport in a single call.
+  mock_transport_.AddExpectedSize(kSize1, 3);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+  EXPECT_EQ(1, mock_transport_.num_batches());
+
+  base::TimeDelta timeout = base::TimeDelta::FromMilliseconds(10);
+  mock_transport_.AddExpectedSize(kSize1, 3);
+  testing_clock_.Advance(timeout);
+  task_runner_->RunTasks();
+  EXPECT_EQ(2, mock_transport_.num_batches());
+
+  mock_transport_.AddExpectedSize(kSize1, 3);
+  testing_clock_.Advance(timeout);
+  task_runner_->RunTasks();
+  EXPECT_EQ(3, mock_transport_.num_batches());
+
+  // Once idle, the sender does not wake up again until new packets arrive,
+  // and then starts pacing from the time of the new frame.
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(100));
+  task_runner_->RunTasks();
+  EXPECT_EQ(3, mock_transport_.num_batches());
+
+  mock_transport_.AddExpectedSize(kSize2, 3);
+  EXPECT_TRUE(paced_sender_->SendPackets(CreatePacketList(kSize2, 9)));
+  task_runner_->RunTasks();
+  EXPECT_EQ(4, mock_transport_.num_batches());
+
+  mock_transport_.AddExpectedSize(kSize2, 3);
+  testing_clock_.Advance(timeout);
+  task_runner_->RunTasks();
+  EXPECT_EQ(5, mock_transport_.num_batches());
+}
+
 TEST_F(PacedSenderTest, PaceWithNack) {
   // Testing what happen when we get multiple NACK requests for a fully lost
   // frames just as we sent the first packets in a frame.
@@ -24,6 +24,11 @@ namespace transport {
 namespace {
 const int kMaxPacketSize = 1500;
 
+// Upper bound on packets queued behind a pending write, so that a stalled
+// socket cannot grow memory without bound. At 1500 bytes per packet this is
+// about 100 ms of video at 100 Mbps.
+const size_t kMaxQueuedPackets = 1000;
+
 bool IsEmpty(const net::IPEndPoint& addr) {
   net::IPAddressNumber empty_addr(addr.address().size());
   return std::equal(
@@ -133,6 +138,37 @@ bool UdpTransport::SendPacket(const Packet& packet) {
     return false;
   }
 
+  // When ok, will return a positive value equal the number of bytes sent.
+  return WritePacket(packet) >= net::OK;
+}
+
+bool UdpTransport::SendPackets(const PacketList& packets) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+
+  if (queued_packets_.size() + packets.size() > kMaxQueuedPackets) {
+    VLOG(1) << "Dropping " << packets.size() << " packets; "
+            << queued_packets_.size() << " packets already queued.";
+    return false;
+  }
+
+  queued_packets_.insert(queued_packets_.end(), packets.begin(), packets.end());
+  if (send_pending_)
+    return true;
+  return SendQueuedPackets();
+}
+
+bool UdpTransport::SendQueuedPackets() {
+  bool ret = true;
+  while (!queued_packets_.empty() && !send_pending_) {
+    int result = WritePacket(queued_packets_.front());
+    queued_packets_.pop_front();
+    if (result < net::OK && result != net::ERR_IO_PENDING)
+      ret = false;
+  }
+  return ret;
+}
+
+int UdpTransport::WritePacket(const Packet& packet) {
   // TODO(hclam): This interface should take a net::IOBuffer to minimize
   // memcpy.
   scoped_refptr<net::IOBuffer> buf =
@@ -145,8 +181,7 @@ bool UdpTransport::SendPacket(const Packet& packet) {
       base::Bind(&UdpTransport::OnSent, weak_factory_.GetWeakPtr(), buf));
   if (ret == net::ERR_IO_PENDING)
     send_pending_ = true;
-  // When ok, will return a positive value equal the number of bytes sent.
-  return ret >= net::OK;
+  return ret;
 }
 
 void UdpTransport::OnSent(const scoped_refptr<net::IOBuffer>& buf, int result) {
@@ -157,6 +192,7 @@ void UdpTransport::OnSent(const scoped_refptr<net::IOBuffer>& buf, int result) {
     LOG(ERROR) << "Failed to send packet: " << result << ".";
     status_callback_.Run(TRANSPORT_SOCKET_ERROR);
   }
+  SendQueuedPackets();
 }
 
 }  // namespace transport
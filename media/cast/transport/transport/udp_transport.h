@@ -5,6 +5,8 @@
 #ifndef MEDIA_CAST_TRANSPORT_TRANSPORT_UDP_TRANSPORT_H_
 #define MEDIA_CAST_TRANSPORT_TRANSPORT_UDP_TRANSPORT_H_
 
+#include <deque>
+
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
@@ -47,16 +49,31 @@ class UdpTransport : public PacketSender {
   // PacketSender implementations.
   virtual bool SendPacket(const Packet& packet) OVERRIDE;
 
+  // Writes the packets back to back. If the socket would block, the rest of
+  // the batch is queued and written as soon as the pending write completes
+  // instead of being dropped.
+  virtual bool SendPackets(const PacketList& packets) OVERRIDE;
+
  private:
   void ReceiveOnePacket();
   void OnReceived(int result);
   void OnSent(const scoped_refptr<net::IOBuffer>& buf, int result);
 
+  // Starts an asynchronous write of |packet|. Returns the result of
+  // net::UDPSocket::SendTo().
+  int WritePacket(const Packet& packet);
+
+  // Writes packets from |queued_packets_| until the queue is empty or a write
+  // is pending. Returns false if a write failed.
+  bool SendQueuedPackets();
+
   scoped_refptr<base::SingleThreadTaskRunner> io_thread_proxy_;
   net::IPEndPoint local_addr_;
   net::IPEndPoint remote_addr_;
   scoped_ptr<net::UDPSocket> udp_socket_;
   bool send_pending_;
+  // Packets of a batch that could not be written because of pending IO.
+  std::deque<Packet> queued_packets_;
   scoped_refptr<net::IOBuffer> recv_buf_;
   net::IPEndPoint recv_addr_;
   PacketReceiverCallback packet_receiver_;
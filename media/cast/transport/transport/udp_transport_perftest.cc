@@ -0,0 +1,219 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Loopback benchmark of the Cast sender transport: frames are paced by
+// PacedSender, written by a sending UdpTransport and received by a second
+// UdpTransport in the same process. Reports the CPU cost per Mbps of the IO
+// thread and the jitter of frame delivery latency.
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "media/cast/transport/cast_transport_config.h"
+#include "media/cast/transport/pacing/paced_sender.h"
+#include "media/cast/transport/transport/udp_transport.h"
+#include "net/base/net_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+namespace cast {
+namespace transport {
+
+namespace {
+
+const int kFramesPerSecond = 30;
+const size_t kPacketSize = 1400;
+const size_t kHeaderSize = 8;
+const int kBenchmarkSeconds = 3;
+
+void IgnoreStatus(CastTransportStatus status) {}
+
+void WriteUint32(uint8* dest, uint32 value) {
+  dest[0] = value >> 24;
+  dest[1] = value >> 16;
+  dest[2] = value >> 8;
+  dest[3] = value;
+}
+
+uint32 ReadUint32(const uint8* src) {
+  return (src[0] << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+}
+
+// Generates frames at a constant bit rate and hands them to the pacer, and
+// measures when each frame has been completely received.
+class LoopbackBenchmark {
+ public:
+  explicit LoopbackBenchmark(int bitrate_mbps)
+      : frame_size_(bitrate_mbps * 1000 * 1000 / 8 / kFramesPerSecond),
+        next_frame_id_(0),
+        frames_completed_(0),
+        packets_received_(0) {}
+
+  void Run(base::MessageLoop* message_loop,
+           base::TimeDelta* thread_time,
+           base::TimeDelta* wall_time) {
+    net::IPAddressNumber local_addr_number;
+    net::ParseIPLiteralToNumber("127.0.0.1", &local_addr_number);
+    net::IPEndPoint send_end_point(local_addr_number, 2346);
+    net::IPEndPoint recv_end_point(local_addr_number, 2347);
+
+    UdpTransport send_transport(message_loop->message_loop_proxy(),
+                                send_end_point,
+                                recv_end_point,
+                                base::Bind(&IgnoreStatus));
+    UdpTransport recv_transport(message_loop->message_loop_proxy(),
+                                recv_end_point,
+                                send_end_point,
+                                base::Bind(&IgnoreStatus));
+    send_transport.StartReceiving(base::Bind(&DropPacket));
+    recv_transport.StartReceiving(base::Bind(
+        &LoopbackBenchmark::ReceivedPacket, base::Unretained(this)));
+
+    base::DefaultTickClock clock;
+    paced_sender_.reset(new PacedSender(
+        &clock, &send_transport, message_loop->message_loop_proxy()));
+
+    base::RepeatingTimer<LoopbackBenchmark> frame_timer;
+    frame_timer.Start(FROM_HERE,
+                      base::TimeDelta::FromSeconds(1) / kFramesPerSecond,
+                      this,
+                      &LoopbackBenchmark::SendFrame);
+
+    base::RunLoop run_loop;
+    message_loop->PostDelayedTask(FROM_HERE,
+                                  run_loop.QuitClosure(),
+                                  base::TimeDelta::FromSeconds(
+                                      kBenchmarkSeconds));
+
+    const bool measure_thread_time = base::TimeTicks::IsThreadNowSupported();
+    base::TimeTicks thread_start;
+    if (measure_thread_time)
+      thread_start = base::TimeTicks::ThreadNow();
+    base::TimeTicks wall_start = base::TimeTicks::HighResNow();
+    run_loop.Run();
+    *wall_time = base::TimeTicks::HighResNow() - wall_start;
+    if (measure_thread_time)
+      *thread_time = base::TimeTicks::ThreadNow() - thread_start;
+
+    frame_timer.Stop();
+    paced_sender_.reset();
+  }
+
+  // Standard deviation of the frame delivery latency.
+  double JitterMs() const {
+    if (latencies_ms_.empty())
+      return 0;
+    double sum = 0;
+    for (size_t i = 0; i < latencies_ms_.size(); ++i)
+      sum += latencies_ms_[i];
+    double mean = sum / latencies_ms_.size();
+    double variance = 0;
+    for (size_t i = 0; i < latencies_ms_.size(); ++i)
+      variance += (latencies_ms_[i] - mean) * (latencies_ms_[i] - mean);
+    return std::sqrt(variance / latencies_ms_.size());
+  }
+
+  int frames_completed() const { return frames_completed_; }
+  int frames_sent() const { return next_frame_id_; }
+  size_t packets_received() const { return packets_received_; }
+
+ private:
+  struct FrameState {
+    base::TimeTicks send_time;
+    uint32 packets_left;
+  };
+
+  static void DropPacket(scoped_ptr<Packet> packet) {}
+
+  void SendFrame() {
+    const uint32 frame_id = next_frame_id_++;
+    const size_t payload_size = kPacketSize - kHeaderSize;
+    const uint32 num_packets = (frame_size_ + payload_size - 1) / payload_size;
+
+    PacketList packets(num_packets, Packet(kPacketSize));
+    for (uint32 i = 0; i < num_packets; ++i) {
+      WriteUint32(&packets[i][0], frame_id);
+      WriteUint32(&packets[i][4], i);
+    }
+
+    FrameState& state = frames_[frame_id];
+    state.send_time = base::TimeTicks::HighResNow();
+    state.packets_left = num_packets;
+    paced_sender_->SendPackets(packets);
+  }
+
+  void ReceivedPacket(scoped_ptr<Packet> packet) {
+    ++packets_received_;
+    if (packet->size() < kHeaderSize)
+      return;
+
+    std::map<uint32, FrameState>::iterator it =
+        frames_.find(ReadUint32(&(*packet)[0]));
+    if (it == frames_.end())
+      return;
+
+    if (--it->second.packets_left == 0) {
+      latencies_ms_.push_back(
+          (base::TimeTicks::HighResNow() - it->second.send_time)
+              .InMillisecondsF());
+      ++frames_completed_;
+      frames_.erase(it);
+    }
+  }
+
+  const size_t frame_size_;
+  scoped_ptr<PacedSender> paced_sender_;
+  uint32 next_frame_id_;
+  std::map<uint32, FrameState> frames_;
+  std::vector<double> latencies_ms_;
+  int frames_completed_;
+  size_t packets_received_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopbackBenchmark);
+};
+
+}  // namespace
+
+TEST(UdpTransportPerfTest, PacedLoopback) {
+  const int kBitratesMbps[] = {20, 35, 50};
+  for (size_t i = 0; i < arraysize(kBitratesMbps); ++i) {
+    base::MessageLoopForIO message_loop;
+    const int bitrate_mbps = kBitratesMbps[i];
+    const std::string trace = base::IntToString(bitrate_mbps) + "Mbps";
+
+    LoopbackBenchmark benchmark(bitrate_mbps);
+    base::TimeDelta thread_time;
+    base::TimeDelta wall_time;
+    benchmark.Run(&message_loop, &thread_time, &wall_time);
+
+    EXPECT_GT(benchmark.frames_completed(), 0);
+    if (base::TimeTicks::IsThreadNowSupported()) {
+      perf_test::PrintResult(
+          "cast_transport_cpu_per_mbps", "", trace,
+          thread_time.InMillisecondsF() / wall_time.InSecondsF() /
+              bitrate_mbps,
+          "ms/s/Mbps", true);
+    }
+    perf_test::PrintResult("cast_transport_frame_jitter", "", trace,
+                           benchmark.JitterMs(), "ms", true);
+    perf_test::PrintResult(
+        "cast_transport_frames_lost", "", trace,
+        static_cast<size_t>(benchmark.frames_sent() -
+                            benchmark.frames_completed()),
+        "frames", false);
+  }
+}
+
+}  // namespace transport
+}  // namespace cast
+}  // namespace media
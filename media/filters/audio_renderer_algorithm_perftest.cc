@@ -0,0 +1,88 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "media/audio/audio_parameters.h"
+#include "media/base/audio_buffer.h"
+#include "media/base/audio_bus.h"
+#include "media/base/buffers.h"
+#include "media/base/channel_layout.h"
+#include "media/base/test_helpers.h"
+#include "media/filters/audio_renderer_algorithm.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kSampleRate = 48000;
+static const int kFramesPerBuffer = 480;
+static const int kOutputDurationInSec = 20;
+
+// Renders |kOutputDurationInSec| seconds of output at |playback_rate| and
+// reports how long WSOLA took to produce each second of audio.
+static void RunPlaybackBenchmark(ChannelLayout channel_layout,
+                                 float playback_rate) {
+  const int channels = ChannelLayoutToChannelCount(channel_layout);
+  AudioParameters params(AudioParameters::AUDIO_PCM_LINEAR,
+                         channel_layout,
+                         kSampleRate,
+                         32,
+                         kFramesPerBuffer);
+
+  AudioRendererAlgorithm algorithm;
+  algorithm.Initialize(playback_rate, params);
+
+  scoped_ptr<AudioBus> bus = AudioBus::Create(channels, kFramesPerBuffer);
+  const int total_frames = kSampleRate * kOutputDurationInSec;
+  float sample = 0.0f;
+  base::TimeDelta elapsed;
+
+  for (int frames_rendered = 0; frames_rendered < total_frames;) {
+    // Keep the input filled outside of the timed region; a slowly varying
+    // ramp keeps the similarity search from degenerating.
+    while (!algorithm.IsQueueFull()) {
+      algorithm.EnqueueBuffer(
+          MakeInterleavedAudioBuffer<float>(kSampleFormatF32,
+                                            channels,
+                                            sample,
+                                            0.00001f,
+                                            kFramesPerBuffer,
+                                            kNoTimestamp(),
+                                            kNoTimestamp()));
+      sample += 0.00001f * channels * kFramesPerBuffer;
+      if (sample > 1.0f)
+        sample = -1.0f;
+    }
+
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    const int frames = algorithm.FillBuffer(bus.get(), kFramesPerBuffer);
+    elapsed += base::TimeTicks::HighResNow() - start;
+    ASSERT_GT(frames, 0);
+    frames_rendered += frames;
+  }
+
+  perf_test::PrintResult(
+      "audio_renderer_algorithm",
+      base::StringPrintf("_%dch", channels),
+      base::StringPrintf("rate_%.2f", playback_rate),
+      elapsed.InMillisecondsF() / kOutputDurationInSec,
+      "ms/s",
+      true);
+}
+
+TEST(AudioRendererAlgorithmPerfTest, FillBuffer) {
+  const ChannelLayout kLayouts[] = {
+      CHANNEL_LAYOUT_MONO, CHANNEL_LAYOUT_STEREO, CHANNEL_LAYOUT_5_1};
+  const float kPlaybackRates[] = {0.5f, 0.9f, 1.25f, 1.5f, 2.0f};
+  for (size_t i = 0; i < arraysize(kLayouts); ++i) {
+    for (size_t j = 0; j < arraysize(kPlaybackRates); ++j)
+      RunPlaybackBenchmark(kLayouts[i], kPlaybackRates[j]);
+  }
+}
+
+}  // namespace media
@@ -1206,6 +1206,7 @@ ChunkDemuxer::ChunkDemuxer(const base::Closure& open_cb,
       open_cb_(open_cb),
       need_key_cb_(need_key_cb),
       enable_text_(false),
+      append_slice_size_(0),
       log_cb_(log_cb),
       duration_(kNoTimestamp()),
       user_specified_duration_(-1) {
@@ -1415,62 +1416,42 @@ void ChunkDemuxer::AppendData(const std::string& id,
   DCHECK(!id.empty());
 
   Ranges<TimeDelta> ranges;
+  size_t slice_size = length;
 
   {
     base::AutoLock auto_lock(lock_);
     DCHECK_NE(state_, ENDED);
 
-    // Capture if any of the SourceBuffers are waiting for data before we start
-    // parsing.
-    bool old_waiting_for_data = IsSeekWaitingForData_Locked();
-
     if (length == 0u)
       return;
 
     DCHECK(data);
 
-    switch (state_) {
-      case INITIALIZING:
-        DCHECK(IsValidId(id));
-        if (!source_state_map_[id]->Append(data, length)) {
-          ReportError_Locked(DEMUXER_ERROR_COULD_NOT_OPEN);
-          return;
-        }
-        break;
-
-      case INITIALIZED: {
-        DCHECK(IsValidId(id));
-        if (!source_state_map_[id]->Append(data, length)) {
-          ReportError_Locked(PIPELINE_ERROR_DECODE);
-          return;
-        }
-      } break;
-
-      case PARSE_ERROR:
-        DVLOG(1) << "AppendData(): Ignoring data after a parse error.";
-        return;
-
-      case WAITING_FOR_INIT:
-      case ENDED:
-      case SHUTDOWN:
-        DVLOG(1) << "AppendData(): called in unexpected state " << state_;
-        return;
-    }
+    if (append_slice_size_ > 0u)
+      slice_size = std::min(length, append_slice_size_);
+  }
 
-    // Check to see if data was appended at the pending seek point. This
-    // indicates we have parsed enough data to complete the seek.
-    if (old_waiting_for_data && !IsSeekWaitingForData_Locked() &&
-        !seek_cb_.is_null()) {
-      base::ResetAndReturn(&seek_cb_).Run(PIPELINE_OK);
-    }
+  // Parse one slice per acquisition of |lock_| so that the media thread can
+  // interleave reads and seeks with a large append.
+  for (size_t offset = 0; offset < length; offset += slice_size) {
+    base::AutoLock auto_lock(lock_);
+    size_t slice_length = std::min(slice_size, length - offset);
+    if (!AppendSlice_Locked(id, data + offset, slice_length))
+      return;
 
-    ranges = GetBufferedRanges_Locked();
+    if (offset + slice_length == length)
+      ranges = GetBufferedRanges_Locked();
   }
 
   for (size_t i = 0; i < ranges.size(); ++i)
     host_->AddBufferedTimeRange(ranges.start(i), ranges.end(i));
 }
 
+void ChunkDemuxer::SetAppendSliceSize(size_t slice_size) {
+  base::AutoLock auto_lock(lock_);
+  append_slice_size_ = slice_size;
+}
+
 void ChunkDemuxer::Abort(const std::string& id) {
   DVLOG(1) << "Abort(" << id << ")";
   base::AutoLock auto_lock(lock_);
@@ -1664,6 +1645,53 @@ void ChunkDemuxer::ChangeState_Locked(State new_state) {
   state_ = new_state;
 }
 
+bool ChunkDemuxer::AppendSlice_Locked(const std::string& id,
+                                      const uint8* data,
+                                      size_t length) {
+  lock_.AssertAcquired();
+
+  // Capture if any of the SourceBuffers are waiting for data before we start
+  // parsing.
+  bool old_waiting_for_data = IsSeekWaitingForData_Locked();
+
+  switch (state_) {
+    case INITIALIZING:
+      DCHECK(IsValidId(id));
+      if (!source_state_map_[id]->Append(data, length)) {
+        ReportError_Locked(DEMUXER_ERROR_COULD_NOT_OPEN);
+        return false;
+      }
+      break;
+
+    case INITIALIZED: {
+      DCHECK(IsValidId(id));
+      if (!source_state_map_[id]->Append(data, length)) {
+        ReportError_Locked(PIPELINE_ERROR_DECODE);
+        return false;
+      }
+    } break;
+
+    case PARSE_ERROR:
+      DVLOG(1) << "AppendData(): Ignoring data after a parse error.";
+      return false;
+
+    case WAITING_FOR_INIT:
+    case ENDED:
+    case SHUTDOWN:
+      DVLOG(1) << "AppendData(): called in unexpected state " << state_;
+      return false;
+  }
+
+  // Check to see if data was appended at the pending seek point. This
+  // indicates we have parsed enough data to complete the seek.
+  if (old_waiting_for_data && !IsSeekWaitingForData_Locked() &&
+      !seek_cb_.is_null()) {
+    base::ResetAndReturn(&seek_cb_).Run(PIPELINE_OK);
+  }
+
+  return true;
+}
+
 ChunkDemuxer::~ChunkDemuxer() {
   DCHECK_NE(state_, INITIALIZED);
 
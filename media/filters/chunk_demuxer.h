@@ -101,6 +101,15 @@ class MEDIA_EXPORT ChunkDemuxer : public Demuxer {
   // Appends media data to the source buffer associated with |id|.
   void AppendData(const std::string& id, const uint8* data, size_t length);
 
+  // Enables incremental parsing of appended data. When |slice_size| is
+  // non-zero, AppendData() parses its input in slices of at most |slice_size|
+  // bytes and releases |lock_| between slices, so Read() and Seek() calls from
+  // the media thread are not blocked for the duration of a large append.
+  // Parsed buffers become readable, and a pending seek can complete, as soon
+  // as the slice containing them has been parsed. A |slice_size| of 0 (the
+  // default) parses each append in a single pass.
+  void SetAppendSliceSize(size_t slice_size);
+
   // Aborts parsing the current segment and reset the parser to a state where
   // it can accept a new segment.
   void Abort(const std::string& id);
@@ -170,6 +179,14 @@ class MEDIA_EXPORT ChunkDemuxer : public Demuxer {
 
   void ChangeState_Locked(State new_state);
 
+  // Parses |length| bytes of |data| for the source buffer associated with
+  // |id|. Returns false if parsing failed or the demuxer is in a state where
+  // it does not accept data, in which case the rest of the append must be
+  // dropped.
+  bool AppendSlice_Locked(const std::string& id,
+                          const uint8* data,
+                          size_t length);
+
   // Reports an error and puts the demuxer in a state where it won't accept more
   // data.
   void ReportError_Locked(PipelineStatus error);
@@ -243,6 +260,11 @@ class MEDIA_EXPORT ChunkDemuxer : public Demuxer {
   base::Closure open_cb_;
   NeedKeyCB need_key_cb_;
   bool enable_text_;
+
+  // Maximum number of bytes parsed per acquisition of |lock_| in
+  // AppendData(). 0 means appends are not split.
+  size_t append_slice_size_;
+
   // Callback used to report error strings that can help the web developer
   // figure out what is wrong with the content.
   LogCB log_cb_;
@@ -0,0 +1,133 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/mock_demuxer_host.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/chunk_demuxer.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using ::testing::NiceMock;
+
+namespace media {
+
+static const char kSourceId[] = "SourceId";
+static const size_t kAppendSize = 100 * 1024 * 1024;
+
+static void OnOpen() {}
+
+static void OnNeedKey(const std::string& type,
+                      const std::vector<uint8>& init_data) {}
+
+static void OnLog(const std::string& str) {}
+
+static void OnInitDone(PipelineStatus status) {
+  EXPECT_EQ(PIPELINE_OK, status);
+}
+
+// Simulates the media thread by repeatedly calling into the demuxer while an
+// append is in progress on another thread, and records the longest time a
+// single call had to wait for the demuxer's lock.
+class MediaThreadSimulator : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit MediaThreadSimulator(ChunkDemuxer* demuxer)
+      : demuxer_(demuxer), calls_(0) {}
+  virtual ~MediaThreadSimulator() {}
+
+  virtual void Run() OVERRIDE {
+    while (!stop_.IsSet()) {
+      base::TimeTicks start = base::TimeTicks::HighResNow();
+      demuxer_->GetBufferedRanges(kSourceId);
+      max_blocking_time_ = std::max(max_blocking_time_,
+                                    base::TimeTicks::HighResNow() - start);
+      ++calls_;
+    }
+  }
+
+  void Stop() { stop_.Set(); }
+
+  base::TimeDelta max_blocking_time() const { return max_blocking_time_; }
+  int calls() const { return calls_; }
+
+ private:
+  ChunkDemuxer* demuxer_;
+  base::CancellationFlag stop_;
+  base::TimeDelta max_blocking_time_;
+  int calls_;
+
+  DISALLOW_COPY_AND_ASSIGN(MediaThreadSimulator);
+};
+
+// Appends |kAppendSize| bytes made of repeated copies of a WebM file in a
+// single AppendData() call, reporting append throughput and the longest time
+// a concurrent media thread was blocked on the demuxer.
+static void RunAppendBenchmark(const std::string& filename,
+                               size_t slice_size,
+                               const std::string& trace_name) {
+  base::MessageLoop message_loop;
+  NiceMock<MockDemuxerHost> host;
+
+  scoped_refptr<DecoderBuffer> file_data = ReadTestDataFile(filename);
+  ASSERT_GT(file_data->data_size(), 0);
+
+  std::vector<uint8> data;
+  data.reserve(kAppendSize + file_data->data_size());
+  while (data.size() < kAppendSize) {
+    data.insert(data.end(), file_data->data(),
+                file_data->data() + file_data->data_size());
+  }
+
+  ChunkDemuxer demuxer(base::Bind(&OnOpen), base::Bind(&OnNeedKey),
+                       base::Bind(&OnLog));
+  demuxer.Initialize(&host, base::Bind(&OnInitDone), true);
+
+  std::vector<std::string> codecs;
+  codecs.push_back("vorbis");
+  codecs.push_back("vp8");
+  ASSERT_EQ(ChunkDemuxer::kOk, demuxer.AddId(kSourceId, "video/webm", codecs));
+  demuxer.SetAppendSliceSize(slice_size);
+
+  MediaThreadSimulator simulator(&demuxer);
+  base::DelegateSimpleThread media_thread(&simulator, "MediaThread");
+  media_thread.Start();
+
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  demuxer.AppendData(kSourceId, &data[0], data.size());
+  base::TimeDelta append_time = base::TimeTicks::HighResNow() - start;
+
+  simulator.Stop();
+  media_thread.Join();
+  message_loop.RunUntilIdle();
+
+  perf_test::PrintResult("chunk_demuxer_append_throughput", "", trace_name,
+                         data.size() / (1024.0 * 1024.0) /
+                             append_time.InSecondsF(),
+                         "MB/s", true);
+  perf_test::PrintResult("chunk_demuxer_media_thread_max_blocking", "",
+                         trace_name,
+                         simulator.max_blocking_time().InMillisecondsF(),
+                         "ms", true);
+
+  demuxer.Shutdown();
+  message_loop.RunUntilIdle();
+}
+
+TEST(ChunkDemuxerPerfTest, AppendWebM) {
+  RunAppendBenchmark("bear-320x240.webm", 0, "unsliced");
+  RunAppendBenchmark("bear-320x240.webm", 1024 * 1024, "slice_1MB");
+  RunAppendBenchmark("bear-320x240.webm", 64 * 1024, "slice_64KB");
+}
+
+}  // namespace media
@@ -1606,6 +1606,62 @@ TEST_F(ChunkDemuxerTest, AppendingInPieces) {
   GenerateExpectedReads(0, 9);
 }
 
+// Verify that a single append parsed in slices produces the same buffers as
+// an append parsed in one pass.
+TEST_F(ChunkDemuxerTest, AppendingWithSliceSize) {
+  demuxer_->SetAppendSliceSize(7);
+
+  EXPECT_CALL(*this, DemuxerOpened());
+  demuxer_->Initialize(
+      &host_, CreateInitDoneCB(kDefaultDuration(), PIPELINE_OK), true);
+
+  ASSERT_EQ(AddId(), ChunkDemuxer::kOk);
+
+  scoped_ptr<uint8[]> info_tracks;
+  int info_tracks_size = 0;
+  CreateInitSegment(HAS_AUDIO | HAS_VIDEO,
+                    false, false, &info_tracks, &info_tracks_size);
+
+  scoped_ptr<Cluster> cluster_a(kDefaultFirstCluster());
+  scoped_ptr<Cluster> cluster_b(kDefaultSecondCluster());
+
+  size_t buffer_size = info_tracks_size + cluster_a->size() + cluster_b->size();
+  scoped_ptr<uint8[]> buffer(new uint8[buffer_size]);
+  uint8* dst = buffer.get();
+  memcpy(dst, info_tracks.get(), info_tracks_size);
+  dst += info_tracks_size;
+
+  memcpy(dst, cluster_a->data(), cluster_a->size());
+  dst += cluster_a->size();
+
+  memcpy(dst, cluster_b->data(), cluster_b->size());
+  dst += cluster_b->size();
+
+  AppendData(buffer.get(), buffer_size);
+
+  GenerateExpectedReads(0, 9);
+}
+
+// Verify that a parse error in a later slice drops the remainder of the
+// append but keeps the buffers parsed from earlier slices.
+TEST_F(ChunkDemuxerTest, AppendingWithSliceSize_ErrorInLaterSlice) {
+  ASSERT_TRUE(InitDemuxer(HAS_AUDIO | HAS_VIDEO));
+
+  scoped_ptr<Cluster> cluster(kDefaultFirstCluster());
+  demuxer_->SetAppendSliceSize(cluster->size());
+
+  int garbage_size = 10;
+  size_t buffer_size = cluster->size() + garbage_size;
+  scoped_ptr<uint8[]> buffer(new uint8[buffer_size]);
+  memcpy(buffer.get(), cluster->data(), cluster->size());
+  for (int i = 0; i < garbage_size; ++i)
+    buffer[cluster->size() + i] = i;
+
+  EXPECT_CALL(host_, OnDemuxerError(PIPELINE_ERROR_DECODE));
+  AppendData(buffer.get(), buffer_size);
+  CheckExpectedRanges(kDefaultFirstClusterRange);
+}
+
 TEST_F(ChunkDemuxerTest, WebMFile_AudioAndVideo) {
   struct BufferTimestamps buffer_timestamps[] = {
     {0, 0},
@@ -2,16 +2,26 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 #include "media/filters/h264_bit_reader.h"
 
 namespace media {
 
+// |curr_word_| is refilled until it holds more than this many bits, which
+// guarantees that any ReadBits() call of up to 31 bits can be satisfied from
+// the cache without a second refill.
+static const int kRefillThreshold = 56;
+
 H264BitReader::H264BitReader()
     : data_(NULL),
       bytes_left_(0),
-      curr_byte_(0),
-      num_remaining_bits_in_curr_byte_(0),
+      curr_word_(0),
+      num_bits_in_curr_word_(0),
+      epb_mask_(0),
       prev_two_bytes_(0),
       emulation_prevention_bytes_(0) {}
 
@@ -25,7 +35,9 @@ bool H264BitReader::Initialize(const uint8* data, off_t size) {
 
   data_ = data;
   bytes_left_ = size;
-  num_remaining_bits_in_curr_byte_ = 0;
+  curr_word_ = 0;
+  num_bits_in_curr_word_ = 0;
+  epb_mask_ = 0;
   // Initially set to 0xffff to accept all initial two-byte sequences.
   prev_two_bytes_ = 0xffff;
   emulation_prevention_bytes_ = 0;
@@ -33,81 +45,129 @@ bool H264BitReader::Initialize(const uint8* data, off_t size) {
   return true;
 }
 
-bool H264BitReader::UpdateCurrByte() {
+bool H264BitReader::LoadByte() {
   if (bytes_left_ < 1)
     return false;
 
   // Emulation prevention three-byte detection.
   // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
+  bool skipped_epb = false;
   if (*data_ == 0x03 && (prev_two_bytes_ & 0xffff) == 0) {
+    // An emulation prevention byte at the very end of the stream is left
+    // unconsumed, as there is no byte after it to load.
+    if (bytes_left_ < 2)
+      return false;
+
     // Detected 0x000003, skip last byte.
     ++data_;
     --bytes_left_;
     ++emulation_prevention_bytes_;
+    skipped_epb = true;
     // Need another full three bytes before we can detect the sequence again.
     prev_two_bytes_ = 0xffff;
-
-    if (bytes_left_ < 1)
-      return false;
   }
 
   // Load a new byte and advance pointers.
-  curr_byte_ = *data_++ & 0xff;
+  int byte = *data_++ & 0xff;
   --bytes_left_;
-  num_remaining_bits_in_curr_byte_ = 8;
+  curr_word_ = (curr_word_ << 8) | byte;
+  epb_mask_ = (epb_mask_ << 8) | (skipped_epb ? 0x80 : 0);
+  num_bits_in_curr_word_ += 8;
 
-  prev_two_bytes_ = (prev_two_bytes_ << 8) | curr_byte_;
+  prev_two_bytes_ = ((prev_two_bytes_ & 0xff) << 8) | byte;
 
   return true;
 }
 
+void H264BitReader::Refill() {
+  while (num_bits_in_curr_word_ <= kRefillThreshold) {
+    off_t bytes_to_load = std::min<off_t>(
+        (64 - num_bits_in_curr_word_) / 8, bytes_left_);
+    if (bytes_to_load <= 0)
+      return;
+
+    // An emulation prevention byte is always 0x03, so if none of the next
+    // bytes is 0x03 they can be loaded as a block.
+    if (bytes_to_load > 1 && !memchr(data_, 0x03, bytes_to_load)) {
+      for (off_t i = 0; i < bytes_to_load; ++i)
+        curr_word_ = (curr_word_ << 8) | data_[i];
+      epb_mask_ = bytes_to_load < 8 ? epb_mask_ << (8 * bytes_to_load) : 0;
+      num_bits_in_curr_word_ += 8 * bytes_to_load;
+      prev_two_bytes_ = (data_[bytes_to_load - 2] << 8) |
+                        data_[bytes_to_load - 1];
+      data_ += bytes_to_load;
+      bytes_left_ -= bytes_to_load;
+      continue;
+    }
+
+    if (!LoadByte())
+      return;
+  }
+}
+
+int H264BitReader::NumUnreadEmulationPreventionBytes() const {
+  uint64 unread_mask = epb_mask_;
+  if (num_bits_in_curr_word_ < 64)
+    unread_mask &= (GG_UINT64_C(1) << num_bits_in_curr_word_) - 1;
+
+  int count = 0;
+  for (; unread_mask; unread_mask &= unread_mask - 1)
+    ++count;
+  return count;
+}
+
 // Read |num_bits| (1 to 31 inclusive) from the stream and return them
 // in |out|, with first bit in the stream as MSB in |out| at position
 // (|num_bits| - 1).
 bool H264BitReader::ReadBits(int num_bits, int* out) {
-  int bits_left = num_bits;
+  DCHECK_GE(num_bits, 0);
+  DCHECK_LE(num_bits, 31);
   *out = 0;
-  DCHECK(num_bits <= 31);
 
-  while (num_remaining_bits_in_curr_byte_ < bits_left) {
-    // Take all that's left in current byte, shift to make space for the rest.
-    *out |= (curr_byte_ << (bits_left - num_remaining_bits_in_curr_byte_));
-    bits_left -= num_remaining_bits_in_curr_byte_;
-
-    if (!UpdateCurrByte())
+  if (num_bits_in_curr_word_ < num_bits) {
+    Refill();
+    if (num_bits_in_curr_word_ < num_bits)
       return false;
   }
 
-  *out |= (curr_byte_ >> (num_remaining_bits_in_curr_byte_ - bits_left));
-  *out &= ((1 << num_bits) - 1);
-  num_remaining_bits_in_curr_byte_ -= bits_left;
+  num_bits_in_curr_word_ -= num_bits;
+  *out = static_cast<int>((curr_word_ >> num_bits_in_curr_word_) &
+                          ((GG_UINT64_C(1) << num_bits) - 1));
 
   return true;
 }
 
 off_t H264BitReader::NumBitsLeft() {
-  return (num_remaining_bits_in_curr_byte_ + bytes_left_ * 8);
+  // Emulation prevention bytes ahead of the read position still count towards
+  // the bits left in the stream, as if they had not been loaded yet.
+  return num_bits_in_curr_word_ + bytes_left_ * 8 +
+         NumUnreadEmulationPreventionBytes() * 8;
 }
 
 bool H264BitReader::HasMoreRBSPData() {
   // Make sure we have more bits, if we are at 0 bits in current byte
   // and updating current byte fails, we don't have more data anyway.
-  if (num_remaining_bits_in_curr_byte_ == 0 && !UpdateCurrByte())
-    return false;
+  if (num_bits_in_curr_word_ == 0) {
+    Refill();
+    if (num_bits_in_curr_word_ == 0)
+      return false;
+  }
 
   // On last byte?
-  if (bytes_left_)
+  int bits_in_curr_byte = num_bits_in_curr_word_ % 8;
+  if (bits_in_curr_byte == 0)
+    bits_in_curr_byte = 8;
+  if (bytes_left_ || num_bits_in_curr_word_ > bits_in_curr_byte)
     return true;
 
   // Last byte, look for stop bit;
   // We have more RBSP data if the last non-zero bit we find is not the
   // first available bit.
-  return (curr_byte_ &
-          ((1 << (num_remaining_bits_in_curr_byte_ - 1)) - 1)) != 0;
+  return (curr_word_ & ((1 << (bits_in_curr_byte - 1)) - 1)) != 0;
 }
 
 size_t H264BitReader::NumEmulationPreventionBytesRead() {
-  return emulation_prevention_bytes_;
+  return emulation_prevention_bytes_ - NumUnreadEmulationPreventionBytes();
 }
 
 }  // namespace media
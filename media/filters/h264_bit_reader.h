@@ -47,28 +47,48 @@ class MEDIA_EXPORT H264BitReader {
   size_t NumEmulationPreventionBytesRead();
 
  private:
-  // Advance to the next byte, loading it into curr_byte_.
+  // Load whole bytes from the stream into |curr_word_| until it holds more
+  // than 56 bits or the stream is exhausted, skipping emulation prevention
+  // bytes on the way. Runs of bytes that cannot contain an emulation
+  // prevention byte are loaded without per-byte checks.
+  void Refill();
+
+  // Load the next byte of the stream into |curr_word_|, skipping a preceding
+  // emulation prevention byte if present.
   // Return false on end of stream.
-  bool UpdateCurrByte();
+  bool LoadByte();
 
-  // Pointer to the next unread (not in curr_byte_) byte in the stream.
+  // Return the number of emulation prevention bytes that were skipped while
+  // filling |curr_word_| but that precede bits which have not been read yet.
+  int NumUnreadEmulationPreventionBytes() const;
+
+  // Pointer to the next byte of the stream not yet loaded into |curr_word_|.
   const uint8* data_;
 
-  // Bytes left in the stream (without the curr_byte_).
+  // Bytes left in the stream that have not been loaded into |curr_word_|.
   off_t bytes_left_;
 
-  // Contents of the current byte; first unread bit starting at position
-  // 8 - num_remaining_bits_in_curr_byte_ from MSB.
-  int curr_byte_;
+  // Cache of the next unread bits in the stream, with emulation prevention
+  // bytes removed. The next bit to be read is at position
+  // |num_bits_in_curr_word_| - 1, counting from the LSB.
+  uint64 curr_word_;
+
+  // Number of valid bits in |curr_word_|. Bytes are always loaded whole, so
+  // |num_bits_in_curr_word_| % 8 is the number of bits left in the current
+  // byte (a value of 0 meaning the current byte has 8 bits left, unless the
+  // cache is empty).
+  int num_bits_in_curr_word_;
 
-  // Number of bits remaining in curr_byte_
-  int num_remaining_bits_in_curr_byte_;
+  // Bit i is set if an emulation prevention byte was skipped right before the
+  // byte whose most significant bit is bit i of |curr_word_|.
+  uint64 epb_mask_;
 
   // Used in emulation prevention three byte detection (see spec).
   // Initially set to 0xffff to accept all initial two-byte sequences.
   int prev_two_bytes_;
 
-  // Number of emulation preventation bytes (0x000003) we met.
+  // Number of emulation preventation bytes (0x000003) skipped while loading
+  // |curr_word_|, including those not read yet.
   size_t emulation_prevention_bytes_;
 
   DISALLOW_COPY_AND_ASSIGN(H264BitReader);
@@ -70,4 +70,36 @@ TEST(H264BitReaderTest, StopBitOccupyFullByte) {
   EXPECT_FALSE(reader.HasMoreRBSPData());
 }
 
+TEST(H264BitReaderTest, ReadStreamWithEmulationPreventionBytes) {
+  H264BitReader reader;
+  const unsigned char rbsp[] = {
+      0x01, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x00, 0xff, 0x80};
+  int dummy = 0;
+
+  EXPECT_TRUE(reader.Initialize(rbsp, sizeof(rbsp)));
+  EXPECT_EQ(reader.NumBitsLeft(), 88);
+
+  EXPECT_TRUE(reader.ReadBits(24, &dummy));
+  EXPECT_EQ(dummy, 0x010000);
+  EXPECT_EQ(reader.NumBitsLeft(), 64);
+  EXPECT_EQ(reader.NumEmulationPreventionBytesRead(), 0u);
+
+  // The first emulation prevention byte is skipped once the byte following it
+  // is read.
+  EXPECT_TRUE(reader.ReadBits(8, &dummy));
+  EXPECT_EQ(dummy, 0x01);
+  EXPECT_EQ(reader.NumBitsLeft(), 48);
+  EXPECT_EQ(reader.NumEmulationPreventionBytesRead(), 1u);
+
+  EXPECT_TRUE(reader.ReadBits(24, &dummy));
+  EXPECT_EQ(dummy, 0x000000);
+  EXPECT_EQ(reader.NumBitsLeft(), 16);
+  EXPECT_EQ(reader.NumEmulationPreventionBytesRead(), 2u);
+
+  EXPECT_TRUE(reader.ReadBits(8, &dummy));
+  EXPECT_EQ(dummy, 0xff);
+  EXPECT_FALSE(reader.HasMoreRBSPData());
+  EXPECT_FALSE(reader.ReadBits(9, &dummy));
+}
+
 }  // namespace media
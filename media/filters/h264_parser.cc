@@ -2,11 +2,18 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "media/filters/h264_parser.h"
+
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
+#include "build/build_config.h"
 
-#include "media/filters/h264_parser.h"
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace media {
 
@@ -162,6 +169,29 @@ bool H264Parser::FindStartCode(const uint8* data, off_t data_size,
   off_t bytes_left = data_size;
 
   while (bytes_left >= 3) {
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+    // Every start code begins with a zero byte, so skip whole 16-byte blocks
+    // without one.
+    const __m128i zero = _mm_setzero_si128();
+    while (bytes_left >= 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)))
+        break;
+      data += 16;
+      bytes_left -= 16;
+    }
+    if (bytes_left < 3)
+      break;
+#endif
+
+    // If the third byte is neither 0x00 nor 0x01, no start code can begin at
+    // any of the first three bytes.
+    if (data[2] > 0x01) {
+      data += 3;
+      bytes_left -= 3;
+      continue;
+    }
+
     if (IsStartCode(data)) {
       // Found three-byte start code, set pointer at its beginning.
       *offset = data_size - bytes_left;
@@ -182,11 +212,12 @@ bool H264Parser::FindStartCode(const uint8* data, off_t data_size,
   }
 
   // End of data: offset is pointing to the first byte that was not considered
-  // as a possible start of a start code.
+  // as a possible start of a start code, i.e. the last two bytes are left
+  // unconsumed since they may be the beginning of a start code split across
+  // buffers.
   // Note: there is no security issue when receiving a negative |data_size|
-  // since in this case, |bytes_left| is equal to |data_size| and thus
-  // |*offset| is equal to 0 (valid offset).
-  *offset = data_size - bytes_left;
+  // since in this case |*offset| is equal to 0 (valid offset).
+  *offset = std::max<off_t>(data_size - 2, 0);
   *start_code_size = 0;
   return false;
 }
@@ -0,0 +1,92 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/files/memory_mapped_file.h"
+#include "base/time/time.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/h264_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkIterations = 200;
+
+static void ReportThroughput(const std::string& measurement,
+                             size_t bytes_per_iteration,
+                             base::TimeDelta total_time) {
+  perf_test::PrintResult(
+      measurement, "", "test-25fps.h264",
+      kBenchmarkIterations * bytes_per_iteration / (1024.0 * 1024.0) /
+          total_time.InSecondsF(),
+      "MB/s", true);
+}
+
+// Benchmark scanning a stream for start codes only.
+TEST(H264ParserPerfTest, FindStartCode) {
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(GetTestDataFilePath("test-25fps.h264")));
+
+  int num_start_codes = 0;
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    const uint8* data = stream.data();
+    off_t bytes_left = stream.length();
+    off_t offset = 0;
+    off_t start_code_size = 0;
+    while (H264Parser::FindStartCode(data, bytes_left,
+                                     &offset, &start_code_size)) {
+      data += offset + start_code_size;
+      bytes_left -= offset + start_code_size;
+      ++num_start_codes;
+    }
+  }
+  base::TimeDelta total_time = base::TimeTicks::HighResNow() - start;
+
+  EXPECT_GT(num_start_codes, 0);
+  ReportThroughput("h264_find_start_code", stream.length(), total_time);
+}
+
+// Benchmark locating every NALU and parsing all SPS, PPS and slice headers,
+// which exercises H264BitReader.
+TEST(H264ParserPerfTest, ParseStream) {
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(GetTestDataFilePath("test-25fps.h264")));
+
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    H264Parser parser;
+    parser.SetStream(stream.data(), stream.length());
+
+    while (true) {
+      H264NALU nalu;
+      H264Parser::Result res = parser.AdvanceToNextNALU(&nalu);
+      if (res == H264Parser::kEOStream)
+        break;
+      ASSERT_EQ(H264Parser::kOk, res);
+
+      int id;
+      H264SliceHeader shdr;
+      switch (nalu.nal_unit_type) {
+        case H264NALU::kIDRSlice:
+        case H264NALU::kNonIDRSlice:
+          ASSERT_EQ(H264Parser::kOk, parser.ParseSliceHeader(nalu, &shdr));
+          break;
+        case H264NALU::kSPS:
+          ASSERT_EQ(H264Parser::kOk, parser.ParseSPS(&id));
+          break;
+        case H264NALU::kPPS:
+          ASSERT_EQ(H264Parser::kOk, parser.ParsePPS(&id));
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  base::TimeDelta total_time = base::TimeTicks::HighResNow() - start;
+
+  ReportThroughput("h264_parse_stream", stream.length(), total_time);
+}
+
+}  // namespace media
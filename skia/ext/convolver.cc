@@ -5,7 +5,10 @@
 #include <algorithm>
 
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
 #include "skia/ext/convolver.h"
+#include "skia/ext/convolver_AVX2.h"
 #include "skia/ext/convolver_SSE2.h"
 #include "skia/ext/convolver_mips_dspr2.h"
 #include "third_party/skia/include/core/SkSize.h"
@@ -369,6 +372,16 @@ void SetupSIMD(ConvolveProcs *procs) {
     procs->convolve_4rows_horizontally = &Convolve4RowsHorizontally_SSE2;
     procs->convolve_horizontally = &ConvolveHorizontally_SSE2;
   }
+#ifdef SIMD_AVX2
+  if (cpu.has_avx2()) {
+    // The AVX2 horizontal pass applies eight taps at a time, which already
+    // amortizes the coefficient loads the 4-row SSE2 version shares.
+    procs->extra_horizontal_reads = 7;
+    procs->convolve_vertically = &ConvolveVertically_AVX2;
+    procs->convolve_4rows_horizontally = NULL;
+    procs->convolve_horizontally = &ConvolveHorizontally_AVX2;
+  }
+#endif
 #elif defined SIMD_MIPS_DSPR2
   procs->extra_horizontal_reads = 3;
   procs->convolve_vertically = &ConvolveVertically_mips_dspr2;
@@ -376,22 +389,32 @@ void SetupSIMD(ConvolveProcs *procs) {
 #endif
 }
 
-void BGRAConvolve2D(const unsigned char* source_data,
-                    int source_byte_row_stride,
-                    bool source_has_alpha,
-                    const ConvolutionFilter1D& filter_x,
-                    const ConvolutionFilter1D& filter_y,
-                    int output_byte_row_stride,
-                    unsigned char* output,
-                    bool use_simd_if_possible) {
+namespace {
+
+// Everything needed to convolve a range of output rows, shared by all bands.
+struct ConvolveParams {
+  const unsigned char* source_data;
+  int source_byte_row_stride;
+  bool source_has_alpha;
+  const ConvolutionFilter1D* filter_x;
+  const ConvolutionFilter1D* filter_y;
+  int output_byte_row_stride;
+  unsigned char* output;
   ConvolveProcs simd;
-  simd.extra_horizontal_reads = 0;
-  simd.convolve_vertically = NULL;
-  simd.convolve_4rows_horizontally = NULL;
-  simd.convolve_horizontally = NULL;
-  if (use_simd_if_possible) {
-    SetupSIMD(&simd);
-  }
+};
+
+// Produces the output rows [|first_out_y|, |last_out_y|). Each call keeps its
+// own circular buffer of horizontally convolved rows, so calls for disjoint
+// ranges may run concurrently.
+void BGRAConvolve2DRows(const ConvolveParams& params,
+                        int first_out_y,
+                        int last_out_y) {
+  const unsigned char* source_data = params.source_data;
+  const int source_byte_row_stride = params.source_byte_row_stride;
+  const bool source_has_alpha = params.source_has_alpha;
+  const ConvolutionFilter1D& filter_x = *params.filter_x;
+  const ConvolutionFilter1D& filter_y = *params.filter_y;
+  const ConvolveProcs& simd = params.simd;
 
   int max_y_filter_size = filter_y.max_filter();
 
@@ -402,7 +425,7 @@ void BGRAConvolve2D(const unsigned char* source_data,
   // row for convolution as the first pixel for the first vertical filter.
   int filter_offset, filter_length;
   const ConvolutionFilter1D::Fixed* filter_values =
-      filter_y.FilterForValue(0, &filter_offset, &filter_length);
+      filter_y.FilterForValue(first_out_y, &filter_offset, &filter_length);
   int next_x_row = filter_offset;
 
   // We loop over each row in the input doing a horizontal convolution. This
@@ -424,7 +447,7 @@ void BGRAConvolve2D(const unsigned char* source_data,
 
   // Loop over every possible output row, processing just enough horizontal
   // convolutions to run each subsequent vertical convolution.
-  SkASSERT(output_byte_row_stride >= filter_x.num_values() * 4);
+  SkASSERT(params.output_byte_row_stride >= filter_x.num_values() * 4);
   int num_output_rows = filter_y.num_values();
 
   // We need to check which is the last line to convolve before we advance 4
@@ -446,7 +469,7 @@ void BGRAConvolve2D(const unsigned char* source_data,
   filter_y.FilterForValue(num_output_rows - 1, &last_filter_offset,
                           &last_filter_length);
 
-  for (int out_y = 0; out_y < num_output_rows; out_y++) {
+  for (int out_y = first_out_y; out_y < last_out_y; out_y++) {
     filter_values = filter_y.FilterForValue(out_y,
                                             &filter_offset, &filter_length);
 
@@ -487,7 +510,8 @@ void BGRAConvolve2D(const unsigned char* source_data,
     }
 
     // Compute where in the output image this row of final data will go.
-    unsigned char* cur_output_row = &output[out_y * output_byte_row_stride];
+    unsigned char* cur_output_row =
+        &params.output[out_y * params.output_byte_row_stride];
 
     // Get the list of rows that the circular buffer has, in order.
     int first_row_in_circular_buffer;
@@ -513,6 +537,108 @@ void BGRAConvolve2D(const unsigned char* source_data,
   }
 }
 
+// Runs BGRAConvolve2DRows() for one band on a separate thread.
+class ConvolveBandDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  ConvolveBandDelegate(const ConvolveParams& params,
+                       int first_out_y,
+                       int last_out_y)
+      : params_(params),
+        first_out_y_(first_out_y),
+        last_out_y_(last_out_y) {
+  }
+  virtual ~ConvolveBandDelegate() {}
+
+  virtual void Run() OVERRIDE {
+    BGRAConvolve2DRows(params_, first_out_y_, last_out_y_);
+  }
+
+ private:
+  const ConvolveParams& params_;
+  const int first_out_y_;
+  const int last_out_y_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConvolveBandDelegate);
+};
+
+void InitConvolveParams(const unsigned char* source_data,
+                        int source_byte_row_stride,
+                        bool source_has_alpha,
+                        const ConvolutionFilter1D& filter_x,
+                        const ConvolutionFilter1D& filter_y,
+                        int output_byte_row_stride,
+                        unsigned char* output,
+                        bool use_simd_if_possible,
+                        ConvolveParams* params) {
+  params->source_data = source_data;
+  params->source_byte_row_stride = source_byte_row_stride;
+  params->source_has_alpha = source_has_alpha;
+  params->filter_x = &filter_x;
+  params->filter_y = &filter_y;
+  params->output_byte_row_stride = output_byte_row_stride;
+  params->output = output;
+  params->simd.extra_horizontal_reads = 0;
+  params->simd.convolve_vertically = NULL;
+  params->simd.convolve_4rows_horizontally = NULL;
+  params->simd.convolve_horizontally = NULL;
+  if (use_simd_if_possible) {
+    SetupSIMD(&params->simd);
+  }
+}
+
+}  // namespace
+
+void BGRAConvolve2D(const unsigned char* source_data,
+                    int source_byte_row_stride,
+                    bool source_has_alpha,
+                    const ConvolutionFilter1D& filter_x,
+                    const ConvolutionFilter1D& filter_y,
+                    int output_byte_row_stride,
+                    unsigned char* output,
+                    bool use_simd_if_possible) {
+  ConvolveParams params;
+  InitConvolveParams(source_data, source_byte_row_stride, source_has_alpha,
+                     filter_x, filter_y, output_byte_row_stride, output,
+                     use_simd_if_possible, &params);
+  BGRAConvolve2DRows(params, 0, filter_y.num_values());
+}
+
+void BGRAConvolve2DInBands(const unsigned char* source_data,
+                           int source_byte_row_stride,
+                           bool source_has_alpha,
+                           const ConvolutionFilter1D& filter_x,
+                           const ConvolutionFilter1D& filter_y,
+                           int output_byte_row_stride,
+                           unsigned char* output,
+                           bool use_simd_if_possible,
+                           int num_bands) {
+  ConvolveParams params;
+  InitConvolveParams(source_data, source_byte_row_stride, source_has_alpha,
+                     filter_x, filter_y, output_byte_row_stride, output,
+                     use_simd_if_possible, &params);
+
+  int num_output_rows = filter_y.num_values();
+  num_bands = std::max(1, std::min(num_bands, num_output_rows));
+
+  // Band |i| covers output rows [i * rows / bands, (i + 1) * rows / bands).
+  ScopedVector<ConvolveBandDelegate> delegates;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int band = 1; band < num_bands; ++band) {
+    delegates.push_back(new ConvolveBandDelegate(
+        params,
+        band * num_output_rows / num_bands,
+        (band + 1) * num_output_rows / num_bands));
+    threads.push_back(new base::DelegateSimpleThread(
+        delegates.back(), "ConvolveBand"));
+    threads.back()->Start();
+  }
+
+  BGRAConvolve2DRows(params, 0, num_output_rows / num_bands);
+
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+}
+
 void SingleChannelConvolveX1D(const unsigned char* source_data,
                               int source_byte_row_stride,
                               int input_channel_index,
@@ -20,6 +20,11 @@
 #define SIMD_PADDING 8  // 8 * int16
 #endif
 
+// The AVX2 versions are selected at runtime when the CPU supports them.
+#if defined(SIMD_SSE2) && !defined(OS_NACL)
+#define SIMD_AVX2 1
+#endif
+
 #if defined (ARCH_CPU_MIPS_FAMILY) && \
     defined(__mips_dsp) && (__mips_dsp_rev >= 2)
 #define SIMD_MIPS_DSPR2 1
@@ -191,6 +196,24 @@ SK_API void BGRAConvolve2D(const unsigned char* source_data,
                            unsigned char* output,
                            bool use_simd_if_possible);
 
+// Same as BGRAConvolve2D(), but splits the output rows into |num_bands|
+// horizontal bands which are convolved concurrently, the first one on the
+// calling thread and each of the others on a thread of its own.
+//
+// Source rows under a band boundary are convolved horizontally by both bands
+// that need them, so this only pays off for images large enough to amortize
+// that and the thread startup. This blocks until all bands are done, and so
+// must not be called on threads which may not block (e.g. the UI thread).
+SK_API void BGRAConvolve2DInBands(const unsigned char* source_data,
+                                  int source_byte_row_stride,
+                                  bool source_has_alpha,
+                                  const ConvolutionFilter1D& xfilter,
+                                  const ConvolutionFilter1D& yfilter,
+                                  int output_byte_row_stride,
+                                  unsigned char* output,
+                                  bool use_simd_if_possible,
+                                  int num_bands);
+
 // Does a 1D convolution of the given source image along the X dimension on
 // a single channel of the bitmap.
 //
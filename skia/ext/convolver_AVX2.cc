@@ -0,0 +1,248 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "skia/ext/convolver.h"
+#include "skia/ext/convolver_AVX2.h"
+#include "third_party/skia/include/core/SkTypes.h"
+
+// This is the only file in skia/ext built with -mavx2; callers must check
+// base::CPU::has_avx2() before using anything defined here.
+#include <immintrin.h>
+
+namespace skia {
+
+namespace {
+
+// Broadcasts the coefficient pair (|lo|, |hi|) to every 32-bit lane, so that
+// _mm256_madd_epi16() applies |lo| to the even and |hi| to the odd 16-bit
+// elements of its other operand and sums the two products.
+inline __m256i BroadcastCoefficientPair(ConvolutionFilter1D::Fixed lo,
+                                        ConvolutionFilter1D::Fixed hi) {
+  unsigned pair = static_cast<unsigned short>(lo) |
+      (static_cast<unsigned>(static_cast<unsigned short>(hi)) << 16);
+  return _mm256_set1_epi32(static_cast<int>(pair));
+}
+
+}  // namespace
+
+// Convolves horizontally along a single row. The row data is given in
+// |src_data| and continues for the num_values() of the filter.
+//
+// Eight filter taps are applied per iteration. Like the SSE2 version this may
+// read past the last pixel the filter touches (up to 7 pixels here) and past
+// the last coefficient, which PaddingForSIMD() accounts for.
+void ConvolveHorizontally_AVX2(const unsigned char* src_data,
+                               const ConvolutionFilter1D& filter,
+                               unsigned char* out_row,
+                               bool /*has_alpha*/) {
+  const __m256i zero = _mm256_setzero_si256();
+  // Interleaves the channels of neighbouring pixels within each group of four
+  // so that each channel of pixels 2k and 2k+1 ends up side by side.
+  // [8] a3 a2 r3 r2 g3 g2 b3 b2 a1 a0 r1 r0 g1 g0 b1 b0 (per 128-bit lane)
+  const __m256i pair_shuffle = _mm256_setr_epi8(
+      0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15,
+      0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+  // Selects coefficient pairs (c0, c1) and (c4, c5), resp. (c2, c3) and
+  // (c6, c7), for the low and high 128-bit lanes.
+  const __m256i even_pairs = _mm256_setr_epi32(0, 0, 0, 0, 2, 2, 2, 2);
+  const __m256i odd_pairs = _mm256_setr_epi32(1, 1, 1, 1, 3, 3, 3, 3);
+  const __m128i tap_index = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+
+  int num_values = filter.num_values();
+  int filter_offset, filter_length;
+
+  // Output one pixel each iteration, calculating all channels (RGBA) together.
+  for (int out_x = 0; out_x < num_values; out_x++) {
+    const ConvolutionFilter1D::Fixed* filter_values =
+        filter.FilterForValue(out_x, &filter_offset, &filter_length);
+
+    // Compute the first pixel in this row that the filter affects. It will
+    // touch |filter_length| pixels (4 bytes each) after this.
+    const unsigned char* row_to_filter = &src_data[filter_offset << 2];
+
+    __m256i accum = _mm256_setzero_si256();
+    for (int filter_x = 0; filter_x < filter_length; filter_x += 8) {
+      // [16] c7 c6 c5 c4 c3 c2 c1 c0
+      __m128i coeff = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(filter_values + filter_x));
+      // Zero the coefficients loaded past the end of this filter so that the
+      // extra pixels read don't contribute.
+      int remaining = filter_length - filter_x;
+      if (remaining < 8) {
+        coeff = _mm_and_si128(
+            coeff, _mm_cmpgt_epi16(_mm_set1_epi16(remaining), tap_index));
+      }
+      __m256i coeff256 = _mm256_castsi128_si256(coeff);
+      // [16] c5 c4 c5 c4 c5 c4 c5 c4 c1 c0 c1 c0 c1 c0 c1 c0
+      __m256i coeff_even = _mm256_permutevar8x32_epi32(coeff256, even_pairs);
+      // [16] c7 c6 c7 c6 c7 c6 c7 c6 c3 c2 c3 c2 c3 c2 c3 c2
+      __m256i coeff_odd = _mm256_permutevar8x32_epi32(coeff256, odd_pairs);
+
+      // Load eight pixels and pair up the channels of neighbouring pixels.
+      __m256i src8 = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(row_to_filter + (filter_x << 2)));
+      src8 = _mm256_shuffle_epi8(src8, pair_shuffle);
+
+      // Pixels 0, 1 (low lane) and 4, 5 (high lane) => two taps per channel.
+      __m256i src16 = _mm256_unpacklo_epi8(src8, zero);
+      accum = _mm256_add_epi32(accum, _mm256_madd_epi16(src16, coeff_even));
+      // Pixels 2, 3 (low lane) and 6, 7 (high lane).
+      src16 = _mm256_unpackhi_epi8(src8, zero);
+      accum = _mm256_add_epi32(accum, _mm256_madd_epi16(src16, coeff_odd));
+    }
+
+    // Sum the two lanes => [32] a b g r.
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(accum),
+                                _mm256_extracti128_si256(accum, 1));
+
+    // Shift right for fixed point implementation and pack with saturation.
+    sum = _mm_srai_epi32(sum, ConvolutionFilter1D::kShiftBits);
+    sum = _mm_packs_epi32(sum, sum);
+    sum = _mm_packus_epi16(sum, sum);
+
+    // Store the pixel value of 32 bits.
+    *(reinterpret_cast<int*>(out_row)) = _mm_cvtsi128_si32(sum);
+    out_row += 4;
+  }
+}
+
+// Loads |pixels| (at most eight) pixels from |src|, without reading past
+// them. Missing pixels are zero.
+inline __m256i LoadPixels(const unsigned char* src, int pixels) {
+  if (pixels == 8)
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  unsigned char tail[32] = { 0 };
+  memcpy(tail, src, pixels * 4);
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+}
+
+// Does vertical convolution to produce one output row. The filter values and
+// length are given in the first two parameters. These are applied to each
+// of the rows pointed to in the |source_data_rows| array, with each row
+// being |pixel_width| wide.
+//
+// Eight pixels are produced per iteration, with two filter taps (rows)
+// applied at a time. Nothing is read or written past |pixel_width| pixels of
+// any row: the last partial group of eight pixels is copied out of each row
+// before being loaded, and its store is trimmed.
+template<bool has_alpha>
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row) {
+  const __m256i zero = _mm256_setzero_si256();
+
+  for (int out_x = 0; out_x < pixel_width; out_x += 8) {
+    const int pixels = std::min(pixel_width - out_x, 8);
+
+    // Accumulated result for each pixel. 32 bits per RGBA channel; the low
+    // lane holds pixels 0-3 and the high lane pixels 4-7.
+    __m256i accum0 = _mm256_setzero_si256();
+    __m256i accum1 = _mm256_setzero_si256();
+    __m256i accum2 = _mm256_setzero_si256();
+    __m256i accum3 = _mm256_setzero_si256();
+
+    for (int filter_y = 0; filter_y < filter_length; filter_y += 2) {
+      // Load eight pixels (32 bytes) from each of the two rows. An odd last
+      // tap is paired with a zero row and coefficient.
+      __m256i src_a =
+          LoadPixels(&source_data_rows[filter_y][out_x << 2], pixels);
+      __m256i src_b;
+      __m256i coeff;
+      if (filter_y + 1 < filter_length) {
+        src_b =
+            LoadPixels(&source_data_rows[filter_y + 1][out_x << 2], pixels);
+        coeff = BroadcastCoefficientPair(filter_values[filter_y],
+                                         filter_values[filter_y + 1]);
+      } else {
+        src_b = zero;
+        coeff = BroadcastCoefficientPair(filter_values[filter_y], 0);
+      }
+
+      // Unpack pixels 0, 1 (and 4, 5) of both rows to 16 bits and interleave
+      // them => multiply-add with the coefficient pair => accumulate.
+      __m256i a16 = _mm256_unpacklo_epi8(src_a, zero);
+      __m256i b16 = _mm256_unpacklo_epi8(src_b, zero);
+      accum0 = _mm256_add_epi32(
+          accum0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a16, b16), coeff));
+      accum1 = _mm256_add_epi32(
+          accum1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a16, b16), coeff));
+
+      // Same for pixels 2, 3 (and 6, 7).
+      a16 = _mm256_unpackhi_epi8(src_a, zero);
+      b16 = _mm256_unpackhi_epi8(src_b, zero);
+      accum2 = _mm256_add_epi32(
+          accum2, _mm256_madd_epi16(_mm256_unpacklo_epi16(a16, b16), coeff));
+      accum3 = _mm256_add_epi32(
+          accum3, _mm256_madd_epi16(_mm256_unpackhi_epi16(a16, b16), coeff));
+    }
+
+    // Shift right for fixed point implementation.
+    accum0 = _mm256_srai_epi32(accum0, ConvolutionFilter1D::kShiftBits);
+    accum1 = _mm256_srai_epi32(accum1, ConvolutionFilter1D::kShiftBits);
+    accum2 = _mm256_srai_epi32(accum2, ConvolutionFilter1D::kShiftBits);
+    accum3 = _mm256_srai_epi32(accum3, ConvolutionFilter1D::kShiftBits);
+
+    // Packing 32 bits |accum| to 16 bits per channel (signed saturation).
+    // [16] pixels 5 4 | 1 0
+    accum0 = _mm256_packs_epi32(accum0, accum1);
+    // [16] pixels 7 6 | 3 2
+    accum2 = _mm256_packs_epi32(accum2, accum3);
+
+    // Packing 16 bits |accum| to 8 bits per channel (unsigned saturation).
+    // [8] pixels 7 6 5 4 | 3 2 1 0
+    accum0 = _mm256_packus_epi16(accum0, accum2);
+
+    if (has_alpha) {
+      // Make sure the value of alpha channel is always larger than maximum
+      // value of color channels. See ConvolveVertically_SSE2().
+      __m256i a = _mm256_srli_epi32(accum0, 8);
+      __m256i b = _mm256_max_epu8(a, accum0);
+      a = _mm256_srli_epi32(accum0, 16);
+      b = _mm256_max_epu8(a, b);
+      b = _mm256_slli_epi32(b, 24);
+      accum0 = _mm256_max_epu8(b, accum0);
+    } else {
+      // Set value of alpha channels to 0xFF.
+      accum0 = _mm256_or_si256(accum0, _mm256_set1_epi32(0xff000000));
+    }
+
+    if (pixels == 8) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_row), accum0);
+      out_row += 32;
+    } else {
+      unsigned char tail[32];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tail), accum0);
+      memcpy(out_row, tail, pixels * 4);
+    }
+  }
+}
+
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha) {
+  if (has_alpha) {
+    ConvolveVertically_AVX2<true>(filter_values,
+                                  filter_length,
+                                  source_data_rows,
+                                  pixel_width,
+                                  out_row);
+  } else {
+    ConvolveVertically_AVX2<false>(filter_values,
+                                   filter_length,
+                                   source_data_rows,
+                                   pixel_width,
+                                   out_row);
+  }
+}
+
+}  // namespace skia
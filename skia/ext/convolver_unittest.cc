@@ -339,6 +339,52 @@ TEST(Convolver, MAYBE_SIMDVerification) {
   }
 }
 
+// Verifies that convolving in concurrent bands gives the same result as doing
+// the whole image at once, including when there are more bands than rows.
+TEST(Convolver, BandedConvolution) {
+  const int kSourceWidth = 517;
+  const int kSourceHeight = 389;
+  const int kDestWidth = 131;
+  const int kDestHeight = 97;
+  float filter[] = { 0.05f, -0.15f, 0.6f, 0.6f, -0.15f, 0.05f };
+
+  ConvolutionFilter1D x_filter, y_filter;
+  for (int p = 0; p < kDestWidth; ++p) {
+    int offset = kSourceWidth * p / kDestWidth;
+    x_filter.AddFilter(offset, filter,
+                       std::min<int>(arraysize(filter),
+                                     kSourceWidth - offset));
+  }
+  x_filter.PaddingForSIMD();
+  for (int p = 0; p < kDestHeight; ++p) {
+    int offset = kSourceHeight * p / kDestHeight;
+    y_filter.AddFilter(offset, filter,
+                       std::min<int>(arraysize(filter),
+                                     kSourceHeight - offset));
+  }
+  y_filter.PaddingForSIMD();
+
+  std::vector<unsigned char> source(kSourceWidth * kSourceHeight * 4);
+  for (size_t i = 0; i < source.size(); ++i)
+    source[i] = (i * 7 + i / 13) % 255;
+
+  const int kNumBands[] = { 1, 2, 3, 8, kDestHeight + 5 };
+  for (int alpha = 0; alpha < 2; alpha++) {
+    std::vector<unsigned char> expected(kDestWidth * kDestHeight * 4);
+    BGRAConvolve2D(&source[0], kSourceWidth * 4, (alpha != 0),
+                   x_filter, y_filter, kDestWidth * 4, &expected[0], true);
+
+    for (size_t i = 0; i < arraysize(kNumBands); ++i) {
+      std::vector<unsigned char> output(expected.size());
+      BGRAConvolve2DInBands(&source[0], kSourceWidth * 4, (alpha != 0),
+                            x_filter, y_filter, kDestWidth * 4, &output[0],
+                            true, kNumBands[i]);
+      EXPECT_TRUE(expected == output) << "bands: " << kNumBands[i]
+                                      << " alpha: " << alpha;
+    }
+  }
+}
+
 TEST(Convolver, SeparableSingleConvolution) {
   static const int kImgWidth = 1024;
   static const int kImgHeight = 1024;
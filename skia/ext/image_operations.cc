@@ -347,7 +347,7 @@ SkBitmap ImageOperations::Resize(const SkBitmap& source,
                           dest_subset, allocator);
   } else {
     return ResizeBasic(source, method, dest_width, dest_height, dest_subset,
-                       allocator);
+                       1, allocator);
   }
 }
 
@@ -386,7 +386,7 @@ SkBitmap ImageOperations::ResizeSubpixel(const SkBitmap& source,
                      dest_subset.fLeft + dest_subset.width() * w,
                      dest_subset.fTop + dest_subset.height() * h };
   SkBitmap img = ResizeBasic(source, ImageOperations::RESIZE_LANCZOS3, width,
-                             height, subset, allocator);
+                             height, subset, 1, allocator);
   const int row_words = img.rowBytes() / 4;
   if (w == 1 && h == 1)
     return img;
@@ -466,6 +466,7 @@ SkBitmap ImageOperations::ResizeBasic(const SkBitmap& source,
                                       ResizeMethod method,
                                       int dest_width, int dest_height,
                                       const SkIRect& dest_subset,
+                                      int num_bands,
                                       SkBitmap::Allocator* allocator) {
   TRACE_EVENT2("skia", "ImageOperations::ResizeBasic",
                "src_pixels", source.width()*source.height(),
@@ -515,11 +516,20 @@ SkBitmap ImageOperations::ResizeBasic(const SkBitmap& source,
   if (!result.readyToDraw())
     return SkBitmap();
 
-  BGRAConvolve2D(source_subset, static_cast<int>(source.rowBytes()),
-                 !source.isOpaque(), filter.x_filter(), filter.y_filter(),
-                 static_cast<int>(result.rowBytes()),
-                 static_cast<unsigned char*>(result.getPixels()),
-                 true);
+  if (num_bands > 1) {
+    BGRAConvolve2DInBands(source_subset, static_cast<int>(source.rowBytes()),
+                          !source.isOpaque(), filter.x_filter(),
+                          filter.y_filter(),
+                          static_cast<int>(result.rowBytes()),
+                          static_cast<unsigned char*>(result.getPixels()),
+                          true, num_bands);
+  } else {
+    BGRAConvolve2D(source_subset, static_cast<int>(source.rowBytes()),
+                   !source.isOpaque(), filter.x_filter(), filter.y_filter(),
+                   static_cast<int>(result.rowBytes()),
+                   static_cast<unsigned char*>(result.getPixels()),
+                   true);
+  }
 
   base::TimeDelta delta = base::TimeTicks::Now() - resize_start;
   UMA_HISTOGRAM_TIMES("Image.ResampleMS", delta);
@@ -537,4 +547,19 @@ SkBitmap ImageOperations::Resize(const SkBitmap& source,
                 allocator);
 }
 
+// static
+SkBitmap ImageOperations::ResizeInParallel(const SkBitmap& source,
+                                           ResizeMethod method,
+                                           int dest_width, int dest_height,
+                                           int num_threads,
+                                           SkBitmap::Allocator* allocator) {
+  SkIRect dest_subset = { 0, 0, dest_width, dest_height };
+  if (method == ImageOperations::RESIZE_SUBPIXEL) {
+    return ResizeSubpixel(source, dest_width, dest_height,
+                          dest_subset, allocator);
+  }
+  return ResizeBasic(source, method, dest_width, dest_height, dest_subset,
+                     num_threads, allocator);
+}
+
 }  // namespace skia
@@ -111,14 +111,27 @@ class SK_API ImageOperations {
                          int dest_width, int dest_height,
                          SkBitmap::Allocator* allocator = NULL);
 
+  // Same as the version above, but splits the result into |num_threads|
+  // horizontal bands which are resized concurrently. This blocks until all
+  // bands are done, so it is meant for worker threads downscaling large
+  // images (e.g. thumbnailing); see BGRAConvolve2DInBands(). RESIZE_SUBPIXEL
+  // is always resized on the calling thread only.
+  static SkBitmap ResizeInParallel(const SkBitmap& source,
+                                   ResizeMethod method,
+                                   int dest_width, int dest_height,
+                                   int num_threads,
+                                   SkBitmap::Allocator* allocator = NULL);
+
  private:
   ImageOperations();  // Class for scoping only.
 
-  // Supports all methods except RESIZE_SUBPIXEL.
+  // Supports all methods except RESIZE_SUBPIXEL. The result is convolved in
+  // |num_bands| concurrent bands.
   static SkBitmap ResizeBasic(const SkBitmap& source,
                               ResizeMethod method,
                               int dest_width, int dest_height,
                               const SkIRect& dest_subset,
+                              int num_bands,
                               SkBitmap::Allocator* allocator = NULL);
 
   // Subpixel renderer.
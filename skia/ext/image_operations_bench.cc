@@ -141,6 +141,8 @@ class Benchmark {
 
   Benchmark()
       : num_iterations_(kDefaultNumberIterations),
+        num_threads_(1),
+        run_suite_(false),
         method_(kDefaultResizeMethod) {}
 
   // Returns true if command line parsing was successful, false otherwise.
@@ -151,7 +153,21 @@ class Benchmark {
 
   static void Usage();
  private:
+  // Resizes a |source| sized bitmap to |dest| |num_iterations| times using
+  // |num_threads| bands, and prints the throughput.
+  void RunResize(const Dimensions& source,
+                 const Dimensions& dest,
+                 skia::ImageOperations::ResizeMethod method,
+                 int num_iterations,
+                 int num_threads) const;
+
+  // Runs the 4K to thumbnail resizes for Lanczos3 and box filters, single
+  // threaded and with |num_threads_| bands.
+  void RunSuite() const;
+
   int num_iterations_;
+  int num_threads_;
+  bool run_suite_;
   skia::ImageOperations::ResizeMethod method_;
   Dimensions source_;
   Dimensions dest_;
@@ -165,10 +181,13 @@ const skia::ImageOperations::ResizeMethod Benchmark::kDefaultResizeMethod =
 // argument management
 void Benchmark::Usage() {
   printf("image_operations_bench -source wxh -destination wxh "
-         "[-iterations i] [-method m] [-help]\n"
+         "[-iterations i] [-method m] [-threads t] [-help]\n"
+         "image_operations_bench -suite [-threads t]\n"
          "  -source wxh: specify source width and height\n"
          "  -destination wxh: specify destination width and height\n"
          "  -iter i: perform i iterations (default:%d)\n"
+         "  -threads t: resize in t concurrent bands (default:1)\n"
+         "  -suite: run the 4K to thumbnail Lanczos3 and box resizes\n"
          "  -method m: use method m (default:%s), which can be:",
          Benchmark::kDefaultNumberIterations,
          MethodToString(Benchmark::kDefaultResizeMethod));
@@ -198,6 +217,12 @@ bool Benchmark::ParseArgs(const CommandLine* command_line) {
       if (base::StringToInt(value, &num_iterations_) == false) {
         fNeedHelp = true;
       }
+    } else if (s == "threads") {
+      if (base::StringToInt(value, &num_threads_) == false) {
+        fNeedHelp = true;
+      }
+    } else if (s == "suite") {
+      run_suite_ = true;
     } else if (s == "method") {
       if (!StringToMethod(value, &method_)) {
         printf("Invalid method '%s' specified\n", value.c_str());
@@ -212,11 +237,15 @@ bool Benchmark::ParseArgs(const CommandLine* command_line) {
     printf("Invalid number of iterations: %d\n", num_iterations_);
     fNeedHelp = true;
   }
-  if (!source_.IsValid()) {
+  if (num_threads_ <= 0) {
+    printf("Invalid number of threads: %d\n", num_threads_);
+    fNeedHelp = true;
+  }
+  if (!run_suite_ && !source_.IsValid()) {
     printf("Invalid source dimensions specified\n");
     fNeedHelp = true;
   }
-  if (!dest_.IsValid()) {
+  if (!run_suite_ && !dest_.IsValid()) {
     printf("Invalid dest dimensions specified\n");
     fNeedHelp = true;
   }
@@ -228,9 +257,21 @@ bool Benchmark::ParseArgs(const CommandLine* command_line) {
 
 // actual benchmark.
 bool Benchmark::Run() const {
+  if (run_suite_)
+    RunSuite();
+  else
+    RunResize(source_, dest_, method_, num_iterations_, num_threads_);
+  return true;
+}
+
+void Benchmark::RunResize(const Dimensions& source_size,
+                          const Dimensions& dest_size,
+                          skia::ImageOperations::ResizeMethod method,
+                          int num_iterations,
+                          int num_threads) const {
   SkBitmap source;
   source.setConfig(SkBitmap::kARGB_8888_Config,
-                   source_.width(), source_.height());
+                   source_size.width(), source_size.height());
   source.allocPixels();
   source.eraseARGB(0, 0, 0, 0);
 
@@ -238,23 +279,54 @@ bool Benchmark::Run() const {
 
   const base::TimeTicks start = base::TimeTicks::Now();
 
-  for (int i = 0; i < num_iterations_; ++i) {
-    dest = skia::ImageOperations::Resize(source,
-                                         method_,
-                                         dest_.width(), dest_.height());
+  for (int i = 0; i < num_iterations; ++i) {
+    if (num_threads > 1) {
+      dest = skia::ImageOperations::ResizeInParallel(source,
+                                                     method,
+                                                     dest_size.width(),
+                                                     dest_size.height(),
+                                                     num_threads);
+    } else {
+      dest = skia::ImageOperations::Resize(source,
+                                           method,
+                                           dest_size.width(),
+                                           dest_size.height());
+    }
   }
 
   const int64 elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
 
-  const uint64 num_bytes = static_cast<uint64>(num_iterations_) *
+  const uint64 num_bytes = static_cast<uint64>(num_iterations) *
       (GetBitmapSize(&source) + GetBitmapSize(&dest));
 
-  printf("%" PRIu64 " MB/s,\telapsed = %" PRIu64 " source=%d dest=%d\n",
+  printf("%" PRIu64 " MB/s,\telapsed = %" PRIu64 " source=%d dest=%d "
+         "method=%s threads=%d\n",
          static_cast<uint64>(elapsed_us == 0 ? 0 : num_bytes / elapsed_us),
          static_cast<uint64>(elapsed_us),
-         GetBitmapSize(&source), GetBitmapSize(&dest));
+         GetBitmapSize(&source), GetBitmapSize(&dest),
+         MethodToString(method), num_threads);
+}
 
-  return true;
+void Benchmark::RunSuite() const {
+  // Typical thumbnail and favicon-sized targets for a 4K source.
+  const int kDestSizes[][2] = { {512, 288}, {212, 119}, {64, 64}, {16, 16} };
+  const skia::ImageOperations::ResizeMethod kMethods[] = {
+    skia::ImageOperations::RESIZE_LANCZOS3,
+    skia::ImageOperations::RESIZE_BOX,
+  };
+  const int kSuiteIterations = 8;
+
+  Dimensions source;
+  source.set(3840, 2160);
+  for (size_t i = 0; i < arraysize(kMethods); ++i) {
+    for (size_t j = 0; j < arraysize(kDestSizes); ++j) {
+      Dimensions dest;
+      dest.set(kDestSizes[j][0], kDestSizes[j][1]);
+      RunResize(source, dest, kMethods[i], kSuiteIterations, 1);
+      if (num_threads_ > 1)
+        RunResize(source, dest, kMethods[i], kSuiteIterations, num_threads_);
+    }
+  }
 }
 
 // A small class to automatically call Reset on the global command line to
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
 #include <numeric>
 #include <vector>
@@ -392,4 +394,68 @@ TEST(RecursiveGaussian, SecondDerivative) {
   EXPECT_EQ(image_total, box_inflated);
 }
 
+TEST(RecursiveGaussian, BatchedMatchesSingleLine) {
+  // Lines are filtered several at a time where possible; the leftover lines
+  // and single line images take a separate path. Both must agree exactly.
+  static const int kImgWidth = 37;
+  static const int kImgHeight = 23;
+  static const int kChannelIndex = 1;
+  static const int kChannelCount = 3;
+  static const int kStrideSlack = 5;
+
+  const int src_row_stride = ComputeRowStride(
+      kImgWidth, kChannelCount, kStrideSlack);
+  std::vector<unsigned char> input(src_row_stride * kImgHeight);
+  srand(kImgWidth * kImgHeight);
+  for (size_t i = 0; i < input.size(); ++i)
+    input[i] = rand() % 256;
+
+  const SkISize image_size = SkISize::Make(kImgWidth, kImgHeight);
+  std::vector<unsigned char> output(kImgWidth * kImgHeight);
+  std::vector<unsigned char> line_output(std::max(kImgWidth, kImgHeight));
+  const RecursiveFilter::Order kOrders[] = {
+    RecursiveFilter::FUNCTION,
+    RecursiveFilter::FIRST_DERIVATIVE,
+    RecursiveFilter::SECOND_DERIVATIVE
+  };
+  for (size_t i = 0; i < arraysize(kOrders); ++i) {
+    RecursiveFilter recursive_filter(3.0f, kOrders[i]);
+    for (int absolute_values = 0; absolute_values < 2; ++absolute_values) {
+      SingleChannelRecursiveGaussianX(&input[0], src_row_stride,
+                                      kChannelIndex, kChannelCount,
+                                      recursive_filter, image_size,
+                                      &output[0], kImgWidth, 0, 1,
+                                      absolute_values != 0);
+      for (int r = 0; r < kImgHeight; ++r) {
+        SingleChannelRecursiveGaussianX(&input[r * src_row_stride],
+                                        src_row_stride,
+                                        kChannelIndex, kChannelCount,
+                                        recursive_filter,
+                                        SkISize::Make(kImgWidth, 1),
+                                        &line_output[0], kImgWidth, 0, 1,
+                                        absolute_values != 0);
+        for (int c = 0; c < kImgWidth; ++c)
+          EXPECT_EQ(line_output[c], output[r * kImgWidth + c]);
+      }
+
+      SingleChannelRecursiveGaussianY(&input[0], src_row_stride,
+                                      kChannelIndex, kChannelCount,
+                                      recursive_filter, image_size,
+                                      &output[0], kImgWidth, 0, 1,
+                                      absolute_values != 0);
+      for (int c = 0; c < kImgWidth; ++c) {
+        SingleChannelRecursiveGaussianY(&input[c * kChannelCount],
+                                        src_row_stride,
+                                        kChannelIndex, kChannelCount,
+                                        recursive_filter,
+                                        SkISize::Make(1, kImgHeight),
+                                        &line_output[0], 1, 0, 1,
+                                        absolute_values != 0);
+        for (int r = 0; r < kImgHeight; ++r)
+          EXPECT_EQ(line_output[r], output[r * kImgWidth + c]);
+      }
+    }
+  }
+}
+
 }  // namespace skia
@@ -351,7 +351,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -429,7 +429,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -502,7 +502,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -581,7 +581,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -663,7 +663,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -743,7 +743,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
@@ -823,7 +823,7 @@ TEST_F(ApplyControlDataUpdatesTest,
   // Apply the update locally so that UpdateFromEncryptedTypes knows what state
   // to use.
   {
-    syncable::ReadTransaction trans(FROM_HERE, directory());
+    syncable::WriteTransaction trans(FROM_HERE, UNITTEST, directory());
     cryptographer = directory()->GetCryptographer(&trans);
     directory()->GetNigoriHandler()->ApplyNigoriUpdate(
         *local_nigori,
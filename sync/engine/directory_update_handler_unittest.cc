@@ -5,8 +5,11 @@
 #include "sync/engine/directory_update_handler.h"
 
 #include "base/compiler_specific.h"
+#include "base/memory/scoped_vector.h"
 #include "base/message_loop/message_loop.h"
 #include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
 #include "sync/engine/syncer_proto_util.h"
 #include "sync/internal_api/public/base/model_type.h"
 #include "sync/internal_api/public/test/test_entry_factory.h"
@@ -232,6 +235,59 @@ TEST_F(DirectoryUpdateHandlerProcessUpdateTest, ProcessNewProgressMarkers) {
   EXPECT_EQ(progress.data_type_id(), saved.data_type_id());
 }
 
+// Measures processing and applying a large initial sync of bookmarks, sent
+// children first so that every folder's contents arrive before the folder.
+TEST_F(DirectoryUpdateHandlerProcessUpdateTest, DISABLED_LargeInitialSync) {
+  const int kChainCount = 100;
+  const int kChainDepth = 20;
+  const int kBookmarksPerFolder = 99;
+  DirectoryUpdateHandler handler(dir(), BOOKMARKS, ui_worker());
+  sessions::StatusController status;
+
+  ScopedVector<sync_pb::SyncEntity> entities;
+  std::string root = syncable::GetNullId().GetServerId();
+  for (int chain = 0; chain < kChainCount; ++chain) {
+    std::string parent = root;
+    for (int depth = 0; depth < kChainDepth; ++depth) {
+      std::string folder = SyncableIdToProto(syncable::Id::CreateFromServerId(
+          base::StringPrintf("f%d_%d", chain, depth)));
+      scoped_ptr<sync_pb::SyncEntity> e =
+          CreateUpdate(folder, parent, BOOKMARKS);
+      e->set_folder(true);
+      e->set_originator_cache_guid(
+          std::string(kCacheGuid, arraysize(kCacheGuid)-1));
+      e->set_originator_client_item_id(folder);
+      e->set_position_in_parent(0);
+      entities.push_back(e.release());
+      for (int i = 0; i < kBookmarksPerFolder; ++i) {
+        std::string bookmark = SyncableIdToProto(
+            syncable::Id::CreateFromServerId(
+                base::StringPrintf("b%d_%d_%d", chain, depth, i)));
+        e = CreateUpdate(bookmark, folder, BOOKMARKS);
+        e->set_originator_cache_guid(
+            std::string(kCacheGuid, arraysize(kCacheGuid)-1));
+        e->set_originator_client_item_id(bookmark);
+        e->set_position_in_parent(i + 1);
+        entities.push_back(e.release());
+      }
+      parent = folder;
+    }
+  }
+  SyncEntityList updates(entities.rbegin(), entities.rend());
+
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  UpdateSyncEntities(&handler, updates, &status);
+  base::TimeTicks processed = base::TimeTicks::HighResNow();
+  handler.ApplyUpdates(&status);
+  base::TimeTicks applied = base::TimeTicks::HighResNow();
+
+  EXPECT_EQ(static_cast<int>(updates.size()), status.num_updates_applied());
+  EXPECT_EQ(0, status.num_hierarchy_conflicts());
+  LOG(INFO) << "Processed " << updates.size() << " updates in "
+            << (processed - start).InMillisecondsF() << " ms, applied them in "
+            << (applied - processed).InMillisecondsF() << " ms";
+}
+
 // A test harness for tests that focus on applying updates.
 //
 // Update application is performed when we want to take updates that were
@@ -407,6 +463,35 @@ TEST_F(DirectoryUpdateHandlerApplyUpdateTest,
   }
 }
 
+// Test that a deep hierarchy sent children first is applied in full.
+TEST_F(DirectoryUpdateHandlerApplyUpdateTest, DeepHierarchyChildrenFirst) {
+  const int kDepth = 10;
+  std::string root_server_id = syncable::GetNullId().GetServerId();
+  std::vector<int64> handles;
+  for (int i = kDepth - 1; i >= 0; --i) {
+    std::string parent =
+        i == 0 ? root_server_id : base::StringPrintf("folder%d", i - 1);
+    handles.push_back(
+        entry_factory()->CreateUnappliedNewBookmarkItemWithParent(
+            base::StringPrintf("folder%d", i), DefaultBookmarkSpecifics(),
+            parent));
+  }
+
+  sessions::StatusController status;
+  ApplyBookmarkUpdates(&status);
+  EXPECT_EQ(kDepth, status.num_updates_applied());
+  EXPECT_EQ(0, status.num_hierarchy_conflicts());
+
+  {
+    syncable::ReadTransaction trans(FROM_HERE, directory());
+    for (size_t i = 0; i < handles.size(); ++i) {
+      syncable::Entry entry(&trans, syncable::GET_BY_HANDLE, handles[i]);
+      ASSERT_TRUE(entry.good());
+      EXPECT_FALSE(entry.GetIsUnappliedUpdate());
+    }
+  }
+}
+
 // Try to apply changes on an item that is both IS_UNSYNCED and
 // IS_UNAPPLIED_UPDATE.  Conflict resolution should be performed.
 TEST_F(DirectoryUpdateHandlerApplyUpdateTest, SimpleBookmarkConflict) {
@@ -6,12 +6,14 @@
 
 #include <string>
 
+#include "sync/engine/get_updates_stream_reader.h"
 #include "sync/engine/syncer_proto_util.h"
 #include "sync/sessions/sync_session.h"
 #include "sync/sessions/sync_session_context.h"
 #include "sync/syncable/directory.h"
 #include "sync/syncable/nigori_handler.h"
 #include "sync/syncable/syncable_read_transaction.h"
+#include "sync/syncable/syncable_write_transaction.h"
 
 namespace syncer {
 
@@ -30,7 +32,8 @@ SyncerError HandleGetEncryptionKeyResponse(
     LOG(ERROR) << "Failed to receive encryption key from server.";
     return SERVER_RESPONSE_VALIDATION_FAILED;
   }
-  syncable::ReadTransaction trans(FROM_HERE, dir);
+  // Setting the keys changes the cryptographer, which readers may be using.
+  syncable::WriteTransaction trans(FROM_HERE, syncable::SYNCER, dir);
   syncable::NigoriHandler* nigori_handler = dir->GetNigoriHandler();
   success = nigori_handler->SetKeystoreKeys(
       update_response.get_updates().encryption_keys(),
@@ -78,6 +81,13 @@ void InitDownloadUpdatesContext(
   bool need_encryption_key = ShouldRequestEncryptionKey(session->context());
   get_updates->set_need_encryption_key(need_encryption_key);
 
+  // A streamed response has no room for encryption keys, so only ask for one
+  // when no key is needed.
+  if (session->context()->streaming_get_updates_enabled() &&
+      !need_encryption_key) {
+    get_updates->set_streaming(true);
+  }
+
   // Set legacy GetUpdatesMessage.GetUpdatesCallerInfo information.
   get_updates->mutable_caller_info()->set_notifications_enabled(
       session->context()->notifications_enabled());
@@ -97,10 +107,13 @@ SyncerError ExecuteDownloadUpdates(
     CopyClientDebugInfo(session->context()->debug_info_getter(), debug_info);
   }
 
-  SyncerError result = SyncerProtoUtil::PostClientToServerMessage(
-      msg,
-      &update_response,
-      session);
+  const bool streaming = msg->get_updates().streaming();
+  GetUpdatesStreamReader stream;
+  SyncerError result = streaming ?
+      SyncerProtoUtil::PostClientToServerMessageForStream(
+          msg, &update_response, &stream, session) :
+      SyncerProtoUtil::PostClientToServerMessage(
+          msg, &update_response, session);
 
   DVLOG(2) << SyncerProtoUtil::ClientToServerResponseDebugString(
       update_response);
@@ -129,6 +142,14 @@ SyncerError ExecuteDownloadUpdates(
         HandleGetEncryptionKeyResponse(update_response, dir));
   }
 
+  if (streaming) {
+    return ProcessResponseStream(update_response.stream_metadata(),
+                                 &stream,
+                                 request_types,
+                                 get_updates_processor,
+                                 status);
+  }
+
   return ProcessResponse(update_response.get_updates(),
                          request_types,
                          get_updates_processor,
@@ -163,6 +184,41 @@ SyncerError ProcessResponse(
   }
 }
 
+SyncerError ProcessResponseStream(
+    const sync_pb::GetUpdatesMetadataResponse& metadata,
+    GetUpdatesStreamReader* stream,
+    ModelTypeSet request_types,
+    GetUpdatesProcessor* get_updates_processor,
+    StatusController* status) {
+  if (!metadata.has_changes_remaining())
+    return SERVER_RESPONSE_VALIDATION_FAILED;
+
+  // Hand each batch to the update handlers as soon as it's decoded.  The
+  // message is reused, so only one batch is held in memory at a time.
+  sync_pb::ClientToServerResponse batch;
+  while (stream->ReadNext(&batch)) {
+    const sync_pb::GetUpdatesStreamingResponse& stream_data =
+        batch.stream_data();
+    status->increment_num_updates_downloaded_by(stream_data.entries_size());
+    get_updates_processor->ProcessStreamedUpdates(request_types,
+                                                  stream_data,
+                                                  status);
+  }
+  if (stream->failed())
+    return SERVER_RESPONSE_VALIDATION_FAILED;
+
+  // The new progress markers can be recorded now that all the entities they
+  // cover have been processed.
+  sync_pb::GetUpdatesResponse gu_response;
+  gu_response.set_changes_remaining(metadata.changes_remaining());
+  gu_response.mutable_new_progress_marker()->CopyFrom(
+      metadata.new_progress_marker());
+  return ProcessResponse(gu_response,
+                         request_types,
+                         get_updates_processor,
+                         status);
+}
+
 void CopyClientDebugInfo(
     sessions::DebugInfoGetter* debug_info_getter,
     sync_pb::DebugInfo* debug_info) {
@@ -17,6 +17,8 @@ class DebugInfo;
 
 namespace syncer {
 
+class GetUpdatesStreamReader;
+
 namespace sessions {
 class DebugInfoGetter;
 class StatusController;
@@ -47,6 +49,16 @@ SYNC_EXPORT_PRIVATE SyncerError ProcessResponse(
     GetUpdatesProcessor* get_updates_processor,
     sessions::StatusController* status);
 
+// Like ProcessResponse(), for a response that was streamed.  |metadata| comes
+// from the first message of the stream, and the entities from the messages
+// left in |stream|.  Defined here for testing.
+SYNC_EXPORT_PRIVATE SyncerError ProcessResponseStream(
+    const sync_pb::GetUpdatesMetadataResponse& metadata,
+    GetUpdatesStreamReader* stream,
+    ModelTypeSet proto_request_types,
+    GetUpdatesProcessor* get_updates_processor,
+    sessions::StatusController* status);
+
 // Helper function to copy client debug info from debug_info_getter to
 // debug_info.  Defined here for testing.
 SYNC_EXPORT_PRIVATE void CopyClientDebugInfo(
@@ -12,6 +12,7 @@
 
 typedef std::vector<const sync_pb::SyncEntity*> SyncEntityList;
 typedef std::map<syncer::ModelType, SyncEntityList> TypeSyncEntityMap;
+typedef google::protobuf::RepeatedPtrField<sync_pb::SyncEntity> SyncEntities;
 
 namespace syncer {
 
@@ -19,21 +20,21 @@ typedef std::map<ModelType, size_t> TypeToIndexMap;
 
 namespace {
 
-// Given a GetUpdates response, iterates over all the returned items and
-// divides them according to their type.  Outputs a map from model types to
-// received SyncEntities.  The output map will have entries (possibly empty)
-// for all types in |requested_types|.
+// Given the items returned by a GetUpdates response, divides them according
+// to their type.  Outputs a map from model types to received SyncEntities.
+// The output map will have entries (possibly empty) for all types in
+// |requested_types|.
 void PartitionUpdatesByType(
-    const sync_pb::GetUpdatesResponse& updates,
+    const SyncEntities& updates,
     ModelTypeSet requested_types,
     TypeSyncEntityMap* updates_by_type) {
-  int update_count = updates.entries().size();
+  int update_count = updates.size();
   for (ModelTypeSet::Iterator it = requested_types.First();
        it.Good(); it.Inc()) {
     updates_by_type->insert(std::make_pair(it.Get(), SyncEntityList()));
   }
   for (int i = 0; i < update_count; ++i) {
-    const sync_pb::SyncEntity& update = updates.entries(i);
+    const sync_pb::SyncEntity& update = updates.Get(i);
     ModelType type = GetModelType(update);
     if (!IsRealDataType(type)) {
       NOTREACHED() << "Received update with invalid type.";
@@ -100,7 +101,7 @@ bool GetUpdatesProcessor::ProcessGetUpdatesResponse(
     const sync_pb::GetUpdatesResponse& gu_response,
     sessions::StatusController* status_controller) {
   TypeSyncEntityMap updates_by_type;
-  PartitionUpdatesByType(gu_response, gu_types, &updates_by_type);
+  PartitionUpdatesByType(gu_response.entries(), gu_types, &updates_by_type);
   DCHECK_EQ(gu_types.Size(), updates_by_type.size());
 
   TypeToIndexMap progress_index_by_type;
@@ -143,6 +144,36 @@ bool GetUpdatesProcessor::ProcessGetUpdatesResponse(
   return true;
 }
 
+void GetUpdatesProcessor::ProcessStreamedUpdates(
+    ModelTypeSet gu_types,
+    const sync_pb::GetUpdatesStreamingResponse& stream_data,
+    sessions::StatusController* status_controller) {
+  TypeSyncEntityMap updates_by_type;
+  PartitionUpdatesByType(stream_data.entries(), gu_types, &updates_by_type);
+
+  for (TypeSyncEntityMap::iterator it = updates_by_type.begin();
+       it != updates_by_type.end(); ++it) {
+    if (it->second.empty())
+      continue;
+
+    UpdateHandlerMap::iterator update_handler_iter =
+        update_handler_map_->find(it->first);
+    if (update_handler_iter == update_handler_map_->end()) {
+      DLOG(WARNING)
+          << "Ignoring received updates of a type we can't handle.  "
+          << "Type is: " << ModelTypeToString(it->first);
+      continue;
+    }
+
+    // The handler keeps its current progress marker until the whole stream
+    // has been processed.
+    sync_pb::DataTypeProgressMarker progress_marker;
+    update_handler_iter->second->GetDownloadProgress(&progress_marker);
+    update_handler_iter->second->ProcessGetUpdatesResponse(
+        progress_marker, it->second, status_controller);
+  }
+}
+
 void GetUpdatesProcessor::ApplyUpdates(
     sessions::StatusController* status_controller) {
   delegate_.ApplyUpdates(status_controller, update_handler_map_);
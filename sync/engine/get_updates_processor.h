@@ -17,6 +17,7 @@
 namespace sync_pb {
 class GetUpdatesMessage;
 class GetUpdatesResponse;
+class GetUpdatesStreamingResponse;
 }  // namespace sync_pb
 
 namespace syncer {
@@ -53,6 +54,14 @@ class SYNC_EXPORT_PRIVATE GetUpdatesProcessor {
       const sync_pb::GetUpdatesResponse& gu_response,
       sessions::StatusController* status_controller);
 
+  // Processes one batch of entities from a streamed GetUpdates response.  The
+  // new progress markers are only known once the whole stream has been read;
+  // they are then passed to ProcessGetUpdatesResponse(), with no entities.
+  void ProcessStreamedUpdates(
+      ModelTypeSet gu_types,
+      const sync_pb::GetUpdatesStreamingResponse& stream_data,
+      sessions::StatusController* status_controller);
+
   // Hands off control to the delegate so it can apply updates.
   void ApplyUpdates(sessions::StatusController* status_controller);
 
@@ -0,0 +1,62 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sync/engine/get_updates_stream_reader.h"
+
+#include "base/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "sync/protocol/sync.pb.h"
+
+namespace syncer {
+
+GetUpdatesStreamReader::GetUpdatesStreamReader()
+    : offset_(0),
+      failed_(false) {
+}
+
+GetUpdatesStreamReader::~GetUpdatesStreamReader() {
+}
+
+void GetUpdatesStreamReader::Reset(std::string* body) {
+  body_.clear();
+  body_.swap(*body);
+  offset_ = 0;
+  failed_ = false;
+}
+
+bool GetUpdatesStreamReader::ReadNext(
+    sync_pb::ClientToServerResponse* response) {
+  if (failed_ || offset_ == body_.size())
+    return false;
+
+  const size_t remaining = body_.size() - offset_;
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8*>(body_.data() + offset_),
+      static_cast<int>(remaining));
+  uint32 size = 0;
+  if (!input.ReadVarint32(&size) ||
+      size > remaining - input.CurrentPosition()) {
+    LOG(WARNING) << "Bad message length in streamed GetUpdates response.";
+    failed_ = true;
+    return false;
+  }
+
+  const int message_start = input.CurrentPosition();
+  google::protobuf::io::CodedInputStream::Limit limit =
+      input.PushLimit(static_cast<int>(size));
+  if (!response->ParseFromCodedStream(&input) ||
+      !input.ConsumedEntireMessage() ||
+      input.CurrentPosition() != message_start + static_cast<int>(size)) {
+    LOG(WARNING) << "Failed to parse streamed GetUpdates response.";
+    failed_ = true;
+    return false;
+  }
+  input.PopLimit(limit);
+
+  offset_ += input.CurrentPosition();
+  DCHECK_LE(offset_, body_.size());
+  return true;
+}
+
+}  // namespace syncer
@@ -0,0 +1,53 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SYNC_ENGINE_GET_UPDATES_STREAM_READER_H_
+#define SYNC_ENGINE_GET_UPDATES_STREAM_READER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "sync/base/sync_export.h"
+
+namespace sync_pb {
+class ClientToServerResponse;
+}
+
+namespace syncer {
+
+// Decodes a GetUpdates response that the server streamed, as requested by
+// GetUpdatesMessage.streaming.  Such a response is a sequence of
+// ClientToServerResponses, each prefixed with its length as a varint: the
+// first carries the metadata and any error, the others carry the entities in
+// batches.
+//
+// The messages are decoded one at a time, so only the encoded body and a
+// single batch of entities need to be held in memory at once.
+class SYNC_EXPORT_PRIVATE GetUpdatesStreamReader {
+ public:
+  GetUpdatesStreamReader();
+  ~GetUpdatesStreamReader();
+
+  // Starts reading a new response body.  Takes the contents of |body|,
+  // leaving it empty.
+  void Reset(std::string* body);
+
+  // Decodes the next message into |response|.  Returns false once the body
+  // has been read in full, or if it is malformed; failed() tells the two
+  // apart.
+  bool ReadNext(sync_pb::ClientToServerResponse* response);
+
+  bool failed() const { return failed_; }
+
+ private:
+  std::string body_;
+  size_t offset_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(GetUpdatesStreamReader);
+};
+
+}  // namespace syncer
+
+#endif  // SYNC_ENGINE_GET_UPDATES_STREAM_READER_H_
@@ -7,6 +7,7 @@
 #include "base/format_macros.h"
 #include "base/strings/stringprintf.h"
 #include "google_apis/google_api_keys.h"
+#include "sync/engine/get_updates_stream_reader.h"
 #include "sync/engine/net/server_connection_manager.h"
 #include "sync/engine/syncer.h"
 #include "sync/engine/syncer_types.h"
@@ -262,7 +263,8 @@ void SyncerProtoUtil::SetProtocolVersion(ClientToServerMessage* msg) {
 bool SyncerProtoUtil::PostAndProcessHeaders(ServerConnectionManager* scm,
                                             sessions::SyncSession* session,
                                             const ClientToServerMessage& msg,
-                                            ClientToServerResponse* response) {
+                                            ClientToServerResponse* response,
+                                            GetUpdatesStreamReader* stream) {
   ServerConnectionManager::PostBufferParams params;
   DCHECK(msg.has_protocol_version());
   DCHECK_EQ(msg.protocol_version(),
@@ -276,7 +278,15 @@ bool SyncerProtoUtil::PostAndProcessHeaders(ServerConnectionManager* scm,
     return false;
   }
 
-  if (response->ParseFromString(params.buffer_out)) {
+  bool parsed = false;
+  if (stream) {
+    stream->Reset(&params.buffer_out);
+    parsed = stream->ReadNext(response);
+  } else {
+    parsed = response->ParseFromString(params.buffer_out);
+  }
+
+  if (parsed) {
     // TODO(tim): This is an egregious layering violation (bug 35060).
     switch (response->error_code()) {
       case sync_pb::SyncEnums::ACCESS_DENIED:
@@ -342,6 +352,26 @@ SyncerError SyncerProtoUtil::PostClientToServerMessage(
     ClientToServerMessage* msg,
     ClientToServerResponse* response,
     SyncSession* session) {
+  return PostMessageAndHandleResponse(msg, response, NULL, session);
+}
+
+// static
+SyncerError SyncerProtoUtil::PostClientToServerMessageForStream(
+    ClientToServerMessage* msg,
+    ClientToServerResponse* response,
+    GetUpdatesStreamReader* stream,
+    SyncSession* session) {
+  DCHECK(stream);
+  DCHECK(msg->get_updates().streaming());
+  return PostMessageAndHandleResponse(msg, response, stream, session);
+}
+
+// static
+SyncerError SyncerProtoUtil::PostMessageAndHandleResponse(
+    ClientToServerMessage* msg,
+    ClientToServerResponse* response,
+    GetUpdatesStreamReader* stream,
+    SyncSession* session) {
   CHECK(response);
   DCHECK(!msg->get_updates().has_from_timestamp());  // Deprecated.
   DCHECK(!msg->get_updates().has_requested_types());  // Deprecated.
@@ -360,7 +390,7 @@ SyncerError SyncerProtoUtil::PostClientToServerMessage(
   LogClientToServerMessage(*msg);
   session->context()->traffic_recorder()->RecordClientToServerMessage(*msg);
   if (!PostAndProcessHeaders(session->context()->connection_manager(), session,
-                             *msg, response)) {
+                             *msg, response, stream)) {
     // There was an error establishing communication with the server.
     // We can not proceed beyond this point.
     const HttpResponse::ServerConnectionCode server_status =
@@ -26,6 +26,7 @@ class SyncEntity;
 
 namespace syncer {
 
+class GetUpdatesStreamReader;
 class ServerConnectionManager;
 
 namespace sessions {
@@ -58,6 +59,16 @@ class SYNC_EXPORT_PRIVATE SyncerProtoUtil {
       sync_pb::ClientToServerResponse* response,
       sessions::SyncSession* session);
 
+  // Like PostClientToServerMessage(), for GetUpdates requests that ask for a
+  // streamed response.  The first message of the stream, which carries the
+  // metadata and any error, is decoded into |response|.  The messages that
+  // carry the entities are left in |stream|, to be decoded one at a time.
+  static SyncerError PostClientToServerMessageForStream(
+      sync_pb::ClientToServerMessage* msg,
+      sync_pb::ClientToServerResponse* response,
+      GetUpdatesStreamReader* stream,
+      sessions::SyncSession* session);
+
   static bool ShouldMaintainPosition(const sync_pb::SyncEntity& sync_entity);
 
   // Utility methods for converting between syncable::Blobs and protobuf byte
@@ -113,6 +124,15 @@ class SYNC_EXPORT_PRIVATE SyncerProtoUtil {
 
   // Helper functions for PostClientToServerMessage.
 
+  // Implements both PostClientToServerMessage() and
+  // PostClientToServerMessageForStream().  |stream| is NULL unless the
+  // response is streamed.
+  static SyncerError PostMessageAndHandleResponse(
+      sync_pb::ClientToServerMessage* msg,
+      sync_pb::ClientToServerResponse* response,
+      GetUpdatesStreamReader* stream,
+      sessions::SyncSession* session);
+
   // Verifies the store birthday, alerting/resetting as appropriate if there's a
   // mismatch. Return false if the syncer should be stuck.
   static bool VerifyResponseBirthday(
@@ -124,11 +144,14 @@ class SYNC_EXPORT_PRIVATE SyncerProtoUtil {
       const sync_pb::ClientToServerResponse& response);
 
   // Post the message using the scm, and do some processing on the returned
-  // headers. Decode the server response.
+  // headers. Decode the server response.  If |stream| is not NULL, the
+  // response is streamed: only its first message is decoded into |response|,
+  // and the rest of it is handed to |stream|.
   static bool PostAndProcessHeaders(ServerConnectionManager* scm,
                                     sessions::SyncSession* session,
                                     const sync_pb::ClientToServerMessage& msg,
-                                    sync_pb::ClientToServerResponse* response);
+                                    sync_pb::ClientToServerResponse* response,
+                                    GetUpdatesStreamReader* stream);
 
   static base::TimeDelta GetThrottleDelay(
       const sync_pb::ClientToServerResponse& response);
@@ -136,6 +159,8 @@ class SYNC_EXPORT_PRIVATE SyncerProtoUtil {
   friend class SyncerProtoUtilTest;
   FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest, AddRequestBirthday);
   FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest, PostAndProcessHeaders);
+  FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest,
+                           PostAndProcessHeadersStreamed);
   FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest, VerifyDisabledByAdmin);
   FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest, VerifyResponseBirthday);
   FRIEND_TEST_ALL_PREFIXES(SyncerProtoUtilTest, HandleThrottlingNoDatatypes);
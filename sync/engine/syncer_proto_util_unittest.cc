@@ -10,6 +10,8 @@
 #include "base/compiler_specific.h"
 #include "base/message_loop/message_loop.h"
 #include "base/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "sync/engine/get_updates_stream_reader.h"
 #include "sync/internal_api/public/base/cancelation_signal.h"
 #include "sync/internal_api/public/base/model_type_test_util.h"
 #include "sync/protocol/bookmark_specifics.pb.h"
@@ -257,7 +259,8 @@ class DummyConnectionManager : public ServerConnectionManager {
   DummyConnectionManager(CancelationSignal* signal)
       : ServerConnectionManager("unused", 0, false, signal),
         send_error_(false),
-        access_denied_(false) {}
+        access_denied_(false),
+        streaming_(false) {}
 
   virtual ~DummyConnectionManager() {}
   virtual bool PostBufferWithCachedAuth(
@@ -271,8 +274,21 @@ class DummyConnectionManager : public ServerConnectionManager {
     if (access_denied_) {
       response.set_error_code(sync_pb::SyncEnums::ACCESS_DENIED);
     }
-    response.SerializeToString(&params->buffer_out);
+    if (!streaming_) {
+      response.SerializeToString(&params->buffer_out);
+      return true;
+    }
 
+    // A streamed response: the metadata, then a batch with one entity.
+    params->buffer_out.clear();
+    response.mutable_stream_metadata()->set_changes_remaining(0);
+    AppendToStream(response, &params->buffer_out);
+    sync_pb::ClientToServerResponse batch;
+    SyncEntity* entity = batch.mutable_stream_data()->add_entries();
+    entity->set_id_string("id");
+    entity->set_version(1);
+    entity->set_name("name");
+    AppendToStream(batch, &params->buffer_out);
     return true;
   }
 
@@ -284,9 +300,24 @@ class DummyConnectionManager : public ServerConnectionManager {
     access_denied_ = denied;
   }
 
+  void set_streaming(bool streaming) {
+    streaming_ = streaming;
+  }
+
  private:
+  static void AppendToStream(const sync_pb::ClientToServerResponse& message,
+                             std::string* body) {
+    uint8 size[5];
+    uint8* size_end =
+        google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+            message.ByteSize(), size);
+    body->append(reinterpret_cast<char*>(size), size_end - size);
+    message.AppendToString(body);
+  }
+
   bool send_error_;
   bool access_denied_;
+  bool streaming_;
 };
 
 TEST_F(SyncerProtoUtilTest, PostAndProcessHeaders) {
@@ -300,15 +331,45 @@ TEST_F(SyncerProtoUtilTest, PostAndProcessHeaders) {
 
   dcm.set_send_error(true);
   EXPECT_FALSE(SyncerProtoUtil::PostAndProcessHeaders(&dcm, NULL,
-      msg, &response));
+      msg, &response, NULL));
 
   dcm.set_send_error(false);
   EXPECT_TRUE(SyncerProtoUtil::PostAndProcessHeaders(&dcm, NULL,
-      msg, &response));
+      msg, &response, NULL));
+
+  dcm.set_access_denied(true);
+  EXPECT_FALSE(SyncerProtoUtil::PostAndProcessHeaders(&dcm, NULL,
+      msg, &response, NULL));
+}
+
+TEST_F(SyncerProtoUtilTest, PostAndProcessHeadersStreamed) {
+  CancelationSignal signal;
+  DummyConnectionManager dcm(&signal);
+  ClientToServerMessage msg;
+  SyncerProtoUtil::SetProtocolVersion(&msg);
+  msg.set_share("required");
+  msg.set_message_contents(ClientToServerMessage::GET_UPDATES);
+  msg.mutable_get_updates()->set_streaming(true);
+  sync_pb::ClientToServerResponse response;
+  GetUpdatesStreamReader stream;
+
+  // Only the first message of the stream is decoded.
+  dcm.set_streaming(true);
+  EXPECT_TRUE(SyncerProtoUtil::PostAndProcessHeaders(&dcm, NULL,
+      msg, &response, &stream));
+  EXPECT_TRUE(response.has_stream_metadata());
+  EXPECT_FALSE(response.has_stream_data());
+
+  sync_pb::ClientToServerResponse batch;
+  ASSERT_TRUE(stream.ReadNext(&batch));
+  EXPECT_EQ(1, batch.stream_data().entries_size());
+  EXPECT_FALSE(stream.ReadNext(&batch));
+  EXPECT_FALSE(stream.failed());
 
+  // Errors in the first message are still detected.
   dcm.set_access_denied(true);
   EXPECT_FALSE(SyncerProtoUtil::PostAndProcessHeaders(&dcm, NULL,
-      msg, &response));
+      msg, &response, &stream));
 }
 
 }  // namespace syncer
@@ -4,6 +4,8 @@
 
 #include "sync/engine/update_applicator.h"
 
+#include <algorithm>
+#include <map>
 #include <vector>
 
 #include "base/logging.h"
@@ -19,6 +21,83 @@ namespace syncer {
 
 using syncable::ID;
 
+namespace {
+
+// An update and its place in the hierarchy formed by the updates being
+// applied.
+struct HierarchyNode {
+  HierarchyNode() : handle(0), is_del(false), depth(-1) {}
+
+  int64 handle;
+  syncable::Id parent_id;
+  bool is_del;
+  int depth;
+};
+
+// Creations and moves go first, parents before children.  Deletions go last,
+// children before parents, because a folder can't be deleted until it is
+// empty.  Items at the same depth keep the order of their metahandles.
+bool HierarchyNodeLess(const HierarchyNode& a, const HierarchyNode& b) {
+  if (a.is_del != b.is_del)
+    return b.is_del;
+  return a.is_del ? a.depth > b.depth : a.depth < b.depth;
+}
+
+// Sorts |handles| so that a single pass over them can apply any consistent
+// hierarchy.  An update's depth counts its ancestors among the updates that
+// are being applied; its server parent is used for creations and moves, its
+// local parent for deletions.  Parent loops are broken arbitrarily, and are
+// left for AttemptApplications() to report as hierarchy conflicts.
+void SortByHierarchy(syncable::BaseTransaction* trans,
+                     std::vector<int64>* handles) {
+  std::vector<HierarchyNode> nodes(handles->size());
+  std::map<syncable::Id, size_t> index_by_id;
+  for (size_t i = 0; i < handles->size(); ++i) {
+    syncable::Entry entry(trans, syncable::GET_BY_HANDLE, (*handles)[i]);
+    DCHECK(entry.good());
+    HierarchyNode& node = nodes[i];
+    node.handle = (*handles)[i];
+    node.is_del = entry.GetServerIsDel();
+    node.parent_id = node.is_del ? entry.GetParentId()
+                                 : entry.GetServerParentId();
+    index_by_id[entry.GetId()] = i;
+  }
+
+  std::vector<size_t> chain;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    // Climb until we reach an ancestor whose depth is known, or one that
+    // isn't part of this set of updates.
+    size_t current = i;
+    int depth = 0;
+    while (nodes[current].depth == -1) {
+      chain.push_back(current);
+      nodes[current].depth = -2;  // On |chain|; seeing it again means a loop.
+      std::map<syncable::Id, size_t>::const_iterator parent =
+          index_by_id.find(nodes[current].parent_id);
+      if (parent == index_by_id.end() ||
+          nodes[parent->second].is_del != nodes[current].is_del) {
+        break;
+      }
+      current = parent->second;
+    }
+    if (nodes[current].depth >= 0)
+      depth = nodes[current].depth + 1;
+
+    // Assign depths on the way back down.
+    for (std::vector<size_t>::reverse_iterator it = chain.rbegin();
+         it != chain.rend(); ++it) {
+      nodes[*it].depth = depth++;
+    }
+    chain.clear();
+  }
+
+  std::stable_sort(nodes.begin(), nodes.end(), HierarchyNodeLess);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    (*handles)[i] = nodes[i].handle;
+}
+
+}  // namespace
+
 UpdateApplicator::UpdateApplicator(Cryptographer* cryptographer)
     : cryptographer_(cryptographer),
       updates_applied_(0),
@@ -32,9 +111,12 @@ UpdateApplicator::~UpdateApplicator() {
 // Attempt to apply all updates, using multiple passes if necessary.
 //
 // Some updates must be applied in order.  For example, children must be created
-// after their parent folder is created.  This function runs an O(n^2) algorithm
-// that will keep trying until there is nothing left to apply, or it stops
-// making progress, which would indicate that the hierarchy is invalid.
+// after their parent folder is created.  The updates are sorted by their place
+// in the hierarchy first, so a consistent set of updates is applied in a single
+// pass no matter what order the server sent it in.  Beyond that, this function
+// runs an O(n^2) algorithm that will keep trying until there is nothing left to
+// apply, or it stops making progress, which would indicate that the hierarchy
+// is invalid.
 //
 // The update applicator also has to deal with simple conflicts, which occur
 // when an item is modified on both the server and the local model.  We remember
@@ -47,6 +129,7 @@ void UpdateApplicator::AttemptApplications(
     syncable::WriteTransaction* trans,
     const std::vector<int64>& handles) {
   std::vector<int64> to_apply = handles;
+  SortByHierarchy(trans, &to_apply);
 
   DVLOG(1) << "UpdateApplicator running over " << to_apply.size() << " items.";
   while (!to_apply.empty()) {
@@ -42,6 +42,10 @@ class SYNC_EXPORT_PRIVATE UpdateHandler {
   // this update handler's type, and the set of SyncEntities must include all
   // entities of this type found in the response message.
   //
+  // A streamed response is processed one batch of entities at a time, with
+  // the handler's current progress marker.  The new marker is passed in a
+  // last call, with no entities, once the whole stream has been processed.
+  //
   // In this context, "applicable_updates" means the set of updates belonging to
   // this type.
   virtual void ProcessGetUpdatesResponse(
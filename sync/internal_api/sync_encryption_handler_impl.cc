@@ -1281,6 +1281,8 @@ void SyncEncryptionHandlerImpl::MergeEncryptedTypes(
 SyncEncryptionHandlerImpl::Vault* SyncEncryptionHandlerImpl::UnlockVaultMutable(
     syncable::BaseTransaction* const trans) {
   DCHECK_EQ(user_share_->directory.get(), trans->directory());
+  // Readers share the transaction lock, and may be reading the vault.
+  trans->AssertWriteLocked();
   return &vault_unsafe_;
 }
 
@@ -124,7 +124,8 @@ class SYNC_EXPORT_PRIVATE SyncEncryptionHandlerImpl
   // Container for members that require thread safety protection.  All members
   // that can be accessed from more than one thread should be held here and
   // accessed via UnlockVault(..) and UnlockVaultMutable(..), which enforce
-  // that a transaction is held.
+  // that a transaction is held.  UnlockVaultMutable(..) requires a write
+  // transaction, since read transactions run concurrently.
   struct Vault {
     Vault(Encryptor* encryptor, ModelTypeSet encrypted_types);
     ~Vault();
@@ -210,7 +211,7 @@ class SYNC_EXPORT_PRIVATE SyncEncryptionHandlerImpl
                            syncable::BaseTransaction* const trans);
 
   // Helper methods for ensuring transactions are held when accessing
-  // |vault_unsafe_|.
+  // |vault_unsafe_|.  Modifying it requires a write transaction.
   Vault* UnlockVaultMutable(syncable::BaseTransaction* const trans);
   const Vault& UnlockVault(syncable::BaseTransaction* const trans) const;
 
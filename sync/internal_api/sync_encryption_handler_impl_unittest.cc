@@ -719,7 +719,7 @@ TEST_F(SyncEncryptionHandlerImplTest, MigrateOnDecryptImplicitPass) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -776,7 +776,7 @@ TEST_F(SyncEncryptionHandlerImplTest, MigrateOnDecryptCustomPass) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -844,7 +844,7 @@ TEST_F(SyncEncryptionHandlerImplTest, MigrateOnKeystoreKeyAvailableImplicit) {
   Mock::VerifyAndClearExpectations(observer());
 
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     // Once we provide a keystore key, we should perform the migration.
     EXPECT_CALL(*observer(),
                 OnCryptographerStateChanged(_)).Times(AnyNumber());
@@ -889,7 +889,7 @@ TEST_F(SyncEncryptionHandlerImplTest,
   encryption_handler()->EnableEncryptEverything();
 
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     // Once we provide a keystore key, we should perform the migration.
     EXPECT_CALL(*observer(),
                 OnCryptographerStateChanged(_)).Times(AnyNumber());
@@ -943,7 +943,7 @@ TEST_F(SyncEncryptionHandlerImplTest,
   Mock::VerifyAndClearExpectations(observer());
 
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     // Once we provide a keystore key, we should perform the migration.
     EXPECT_CALL(*observer(),
                 OnCryptographerStateChanged(_)).Times(AnyNumber());
@@ -988,7 +988,7 @@ TEST_F(SyncEncryptionHandlerImplTest,
   Mock::VerifyAndClearExpectations(observer());
 
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     // Once we provide a keystore key, we should perform the migration.
     EXPECT_CALL(*observer(),
                 OnCryptographerStateChanged(_)).Times(AnyNumber());
@@ -1097,7 +1097,7 @@ TEST_F(SyncEncryptionHandlerImplTest, ReceiveMigratedNigoriFrozenImplicitPass) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1177,7 +1177,7 @@ TEST_F(SyncEncryptionHandlerImplTest, ReceiveMigratedNigoriCustomPass) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1285,7 +1285,7 @@ TEST_F(SyncEncryptionHandlerImplTest, ReceiveUnmigratedNigoriAfterMigration) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1364,7 +1364,7 @@ TEST_F(SyncEncryptionHandlerImplTest, ReceiveOldMigratedNigori) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1462,7 +1462,7 @@ TEST_F(SyncEncryptionHandlerImplTest, SetKeystoreAfterReceivingMigratedNigori) {
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1911,7 +1911,7 @@ TEST_F(SyncEncryptionHandlerImplTest,
   {
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
                                               kRawKeystoreKey),
                                           trans.GetWrappedTrans());
@@ -1971,7 +1971,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysGaiaDefault) {
   std::string old_keystore_key;
   base::Base64Encode(kRawOldKeystoreKey, &old_keystore_key);
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
       encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
@@ -1995,7 +1995,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysGaiaDefault) {
     keys.Add()->assign(kRawKeystoreKey);
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(keys,
                                           trans.GetWrappedTrans());
   }
@@ -2025,7 +2025,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysKeystoreDefault) {
   std::string old_keystore_key;
   base::Base64Encode(kRawOldKeystoreKey, &old_keystore_key);
   {
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
       encryption_handler()->SetKeystoreKeys(BuildEncryptionKeyProto(
@@ -2049,7 +2049,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysKeystoreDefault) {
     keys.Add()->assign(kRawKeystoreKey);
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(keys,
                                           trans.GetWrappedTrans());
   }
@@ -2080,7 +2080,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysAfterPendingGaiaResolved) {
     google::protobuf::RepeatedPtrField<google::protobuf::string> keys;
     keys.Add()->assign(kRawOldKeystoreKey);
     keys.Add()->assign(kRawKeystoreKey);
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
     encryption_handler()->SetKeystoreKeys(keys,
@@ -2128,7 +2128,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysGaiaDefaultOnInit) {
     keys.Add()->assign(kRawKeystoreKey);
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     encryption_handler()->SetKeystoreKeys(keys,
                                           trans.GetWrappedTrans());
   }
@@ -2166,7 +2166,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysWhenMigratedNigoriArrives) {
     google::protobuf::RepeatedPtrField<google::protobuf::string> keys;
     keys.Add()->assign(kRawOldKeystoreKey);
     keys.Add()->assign(kRawKeystoreKey);
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
     encryption_handler()->SetKeystoreKeys(keys,
@@ -2221,7 +2221,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysUnmigratedCustomPassphrase) {
     google::protobuf::RepeatedPtrField<google::protobuf::string> keys;
     keys.Add()->assign(kRawOldKeystoreKey);
     keys.Add()->assign(kRawKeystoreKey);
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
     encryption_handler()->SetKeystoreKeys(keys,
@@ -2265,7 +2265,7 @@ TEST_F(SyncEncryptionHandlerImplTest, RotateKeysMigratedCustomPassphrase) {
     google::protobuf::RepeatedPtrField<google::protobuf::string> keys;
     keys.Add()->assign(kRawOldKeystoreKey);
     keys.Add()->assign(kRawKeystoreKey);
-    ReadTransaction trans(FROM_HERE, user_share());
+    WriteTransaction trans(FROM_HERE, user_share());
     EXPECT_CALL(*observer(),
                 OnBootstrapTokenUpdated(_, KEYSTORE_BOOTSTRAP_TOKEN));
     EXPECT_CALL(*observer(),
@@ -25,6 +25,7 @@ SyncSessionContext::SyncSessionContext(
       directory_(directory),
       extensions_activity_(extensions_activity),
       notifications_enabled_(false),
+      streaming_get_updates_enabled_(false),
       max_commit_batch_size_(kDefaultMaxCommitBatchSize),
       debug_info_getter_(debug_info_getter),
       traffic_recorder_(traffic_recorder),
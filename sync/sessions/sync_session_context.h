@@ -89,6 +89,15 @@ class SYNC_EXPORT_PRIVATE SyncSessionContext {
   }
   const std::string& account_name() const { return account_name_; }
 
+  // Whether GetUpdates requests ask the server to stream its response, so
+  // that the entities can be processed one batch at a time.
+  void set_streaming_get_updates_enabled(bool enabled) {
+    streaming_get_updates_enabled_ = enabled;
+  }
+  bool streaming_get_updates_enabled() const {
+    return streaming_get_updates_enabled_;
+  }
+
   void set_max_commit_batch_size(int batch_size) {
     max_commit_batch_size_ = batch_size;
   }
@@ -157,6 +166,9 @@ class SYNC_EXPORT_PRIVATE SyncSessionContext {
   // The name of the account being synced.
   std::string account_name_;
 
+  // True if GetUpdates responses should be streamed.  Off by default.
+  bool streaming_get_updates_enabled_;
+
   // The server limits the number of items a client can commit in one batch.
   int max_commit_batch_size_;
 
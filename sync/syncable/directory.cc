@@ -199,7 +199,11 @@ void Directory::OnUnrecoverableError(const BaseTransaction* trans,
                                      const tracked_objects::Location& location,
                                      const std::string & message) {
   DCHECK(trans != NULL);
-  unrecoverable_error_set_ = true;
+  base::AutoLock handler_lock(unrecoverable_error_handler_lock_);
+  {
+    base::AutoLock lock(unrecoverable_error_lock_);
+    unrecoverable_error_set_ = true;
+  }
   unrecoverable_error_handler_->OnUnrecoverableError(location,
                                                      message);
 }
@@ -411,11 +415,12 @@ bool Directory::ReindexParentId(BaseWriteTransaction* trans,
 
 bool Directory::unrecoverable_error_set(const BaseTransaction* trans) const {
   DCHECK(trans != NULL);
+  base::AutoLock lock(unrecoverable_error_lock_);
   return unrecoverable_error_set_;
 }
 
 void Directory::ClearDirtyMetahandles() {
-  kernel_->transaction_mutex.AssertAcquired();
+  kernel_->transaction_mutex.AssertWriteAcquired();
   kernel_->dirty_metahandles.clear();
 }
 
@@ -449,15 +454,19 @@ bool Directory::SafeToPurgeFromMemory(WriteTransaction* trans,
 }
 
 void Directory::TakeSnapshotForSaveChanges(SaveChangesSnapshot* snapshot) {
-  ReadTransaction trans(FROM_HERE, this);
+  // Clearing the dirty bits modifies the entries, which read transactions
+  // must not see.
+  WriteTransaction trans(FROM_HERE, SAVE_CHANGES, this);
   ScopedKernelLock lock(this);
 
   // If there is an unrecoverable error then just bail out.
   if (unrecoverable_error_set(&trans))
     return;
 
-  // Deep copy dirty entries from kernel_->metahandles_index into snapshot and
-  // clear dirty flags.
+  // Copy the dirty fields of dirty entries from kernel_->metahandles_index
+  // into snapshot and clear dirty flags.  Copying only what changed keeps the
+  // lock short when many entries are dirty, and lets the backing store update
+  // only the columns that changed.
   for (MetahandleSet::const_iterator i = kernel_->dirty_metahandles.begin();
        i != kernel_->dirty_metahandles.end(); ++i) {
     EntryKernel* entry = GetEntryByHandle(*i, &lock);
@@ -467,11 +476,12 @@ void Directory::TakeSnapshotForSaveChanges(SaveChangesSnapshot* snapshot) {
     if (!entry->is_dirty())
       continue;
     snapshot->dirty_metas.insert(snapshot->dirty_metas.end(),
-                                 new EntryKernel(*entry));
+                                 entry->CopyDirtyFields());
     DCHECK_EQ(1U, kernel_->dirty_metahandles.count(*i));
     // We don't bother removing from the index here as we blow the entire thing
     // in a moment, and it unnecessarily complicates iteration.
     entry->clear_dirty(NULL);
+    entry->clear_dirty_fields();
   }
   ClearDirtyMetahandles();
 
@@ -559,8 +569,7 @@ bool Directory::VacuumAfterSaveChanges(const SaveChangesSnapshot& snapshot) {
 
 void Directory::UnapplyEntry(EntryKernel* entry) {
   int64 handle = entry->ref(META_HANDLE);
-  ModelType server_type = GetModelTypeFromSpecifics(
-      entry->ref(SERVER_SPECIFICS));
+  ModelType server_type = entry->GetSpecificsModelType(SERVER_SPECIFICS);
 
   // Clear enough so that on the next sync cycle all local data will
   // be overwritten.
@@ -610,8 +619,7 @@ void Directory::DeleteEntry(bool save_to_journal,
                             EntryKernel* entry,
                             EntryKernelSet* entries_to_journal) {
   int64 handle = entry->ref(META_HANDLE);
-  ModelType server_type = GetModelTypeFromSpecifics(
-      entry->ref(SERVER_SPECIFICS));
+  ModelType server_type = entry->GetSpecificsModelType(SERVER_SPECIFICS);
 
   kernel_->metahandles_to_purge.insert(handle);
 
@@ -672,12 +680,9 @@ bool Directory::PurgeEntriesWithTypeIn(ModelTypeSet disabled_types,
       std::set<EntryKernel*> to_purge;
       for (MetahandlesMap::iterator it = kernel_->metahandles_map.begin();
            it != kernel_->metahandles_map.end(); ++it) {
-        const sync_pb::EntitySpecifics& local_specifics =
-            it->second->ref(SPECIFICS);
-        const sync_pb::EntitySpecifics& server_specifics =
-            it->second->ref(SERVER_SPECIFICS);
-        ModelType local_type = GetModelTypeFromSpecifics(local_specifics);
-        ModelType server_type = GetModelTypeFromSpecifics(server_specifics);
+        ModelType local_type = it->second->GetSpecificsModelType(SPECIFICS);
+        ModelType server_type =
+            it->second->GetSpecificsModelType(SERVER_SPECIFICS);
 
         if ((IsRealDataType(local_type) && disabled_types.Has(local_type)) ||
             (IsRealDataType(server_type) && disabled_types.Has(server_type))) {
@@ -689,12 +694,8 @@ bool Directory::PurgeEntriesWithTypeIn(ModelTypeSet disabled_types,
            it != to_purge.end(); ++it) {
         EntryKernel* entry = *it;
 
-        const sync_pb::EntitySpecifics& local_specifics =
-            (*it)->ref(SPECIFICS);
-        const sync_pb::EntitySpecifics& server_specifics =
-            (*it)->ref(SERVER_SPECIFICS);
-        ModelType local_type = GetModelTypeFromSpecifics(local_specifics);
-        ModelType server_type = GetModelTypeFromSpecifics(server_specifics);
+        ModelType local_type = entry->GetSpecificsModelType(SPECIFICS);
+        ModelType server_type = entry->GetSpecificsModelType(SERVER_SPECIFICS);
 
         if (types_to_unapply.Has(local_type) ||
             types_to_unapply.Has(server_type)) {
@@ -734,13 +735,15 @@ void Directory::HandleSaveChangesFailure(const SaveChangesSnapshot& snapshot) {
   // taking the snapshot, we must restore it on failure.  Not doing this could
   // cause lost data, if no other changes are made to the in-memory entries
   // that would cause the dirty bit to get set again. Setting the bit ensures
-  // that SaveChanges will at least try again later.
+  // that SaveChanges will at least try again later.  The fields that weren't
+  // saved are marked dirty again too, so that the retry writes them.
   for (EntryKernelSet::const_iterator i = snapshot.dirty_metas.begin();
        i != snapshot.dirty_metas.end(); ++i) {
     MetahandlesMap::iterator found =
         kernel_->metahandles_map.find((*i)->ref(META_HANDLE));
     if (found != kernel_->metahandles_map.end()) {
       found->second->mark_dirty(&kernel_->dirty_metahandles);
+      found->second->mark_fields_dirty((*i)->dirty_fields());
     }
   }
 
@@ -788,7 +791,7 @@ int64 Directory::GetTransactionVersion(ModelType type) const {
 }
 
 void Directory::IncrementTransactionVersion(ModelType type) {
-  kernel_->transaction_mutex.AssertAcquired();
+  kernel_->transaction_mutex.AssertWriteAcquired();
   kernel_->persisted_info.transaction_version[type]++;
 }
 
@@ -912,7 +915,7 @@ void Directory::CollectMetaHandleCounts(
   for (MetahandlesMap::iterator it = kernel_->metahandles_map.begin();
        it != kernel_->metahandles_map.end(); ++it) {
     EntryKernel* entry = it->second;
-    const ModelType type = GetModelTypeFromSpecifics(entry->ref(SPECIFICS));
+    const ModelType type = entry->GetSpecificsModelType(SPECIFICS);
     (*num_entries_by_type)[type]++;
     if (entry->ref(IS_DEL))
       (*num_to_delete_entries_by_type)[type]++;
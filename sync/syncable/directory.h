@@ -14,6 +14,7 @@
 #include "base/containers/hash_tables.h"
 #include "base/file_util.h"
 #include "base/gtest_prod_util.h"
+#include "base/synchronization/read_write_lock.h"
 #include "base/values.h"
 #include "sync/base/sync_export.h"
 #include "sync/internal_api/public/util/report_unrecoverable_error_function.h"
@@ -233,6 +234,7 @@ class SYNC_EXPORT Directory {
   // propagate it up).
   void ReportUnrecoverableError() {
     if (report_unrecoverable_error_function_) {
+      base::AutoLock lock(unrecoverable_error_handler_lock_);
       report_unrecoverable_error_function_();
     }
   }
@@ -389,8 +391,11 @@ class SYNC_EXPORT Directory {
 
     ~Kernel();
 
-    // Implements ReadTransaction / WriteTransaction using a simple lock.
-    base::Lock transaction_mutex;
+    // Implements ReadTransaction / WriteTransaction: any number of read
+    // transactions can run at the same time, but write transactions are
+    // exclusive.  So code holding a read transaction must not modify entries
+    // or anything else the transaction lock protects.
+    base::ReadWriteLock transaction_mutex;
 
     // Protected by transaction_mutex.  Used by WriteTransactions.
     int64 next_write_transaction_id;
@@ -529,6 +534,13 @@ class SYNC_EXPORT Directory {
 
   UnrecoverableErrorHandler* const unrecoverable_error_handler_;
   const ReportUnrecoverableErrorFunction report_unrecoverable_error_function_;
+  // The handler and report function above expect to be called by one thread
+  // at a time, which the transaction lock no longer guarantees now that read
+  // transactions share it.  Held around every call to them.
+  base::Lock unrecoverable_error_handler_lock_;
+  // Read transactions can report errors concurrently, so the flag has its own
+  // lock.
+  mutable base::Lock unrecoverable_error_lock_;
   bool unrecoverable_error_set_;
 
   // Not owned.
@@ -12,6 +12,7 @@
 #include "base/debug/trace_event.h"
 #include "base/logging.h"
 #include "base/rand_util.h"
+#include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "sql/connection.h"
@@ -37,41 +38,46 @@ static const string::size_type kUpdateStatementBufferSize = 2048;
 // Increment this version whenever updating DB tables.
 const int32 kCurrentDBVersion = 86;
 
-// Iterate over the fields of |entry| and bind each to |statement| for
-// updating.  Returns the number of args bound.
-void BindFields(const EntryKernel& entry,
-                sql::Statement* statement) {
-  int index = 0;
-  int i = 0;
-  for (i = BEGIN_FIELDS; i < INT64_FIELDS_END; ++i) {
-    statement->BindInt64(index++, entry.ref(static_cast<Int64Field>(i)));
-  }
-  for ( ; i < TIME_FIELDS_END; ++i) {
-    statement->BindInt64(index++,
+// The dirty fields of an entry are used as keys of the update statements.
+COMPILE_ASSERT(FIELD_COUNT <= 32, too_many_fields_for_update_statement_keys);
+
+// Binds |field| of |entry| to the argument |index| of |statement|.
+void BindField(const EntryKernel& entry,
+               int field,
+               int index,
+               sql::Statement* statement) {
+  if (field < INT64_FIELDS_END) {
+    statement->BindInt64(index, entry.ref(static_cast<Int64Field>(field)));
+  } else if (field < TIME_FIELDS_END) {
+    statement->BindInt64(index,
                          TimeToProtoTime(
-                             entry.ref(static_cast<TimeField>(i))));
-  }
-  for ( ; i < ID_FIELDS_END; ++i) {
-    statement->BindString(index++, entry.ref(static_cast<IdField>(i)).s_);
-  }
-  for ( ; i < BIT_FIELDS_END; ++i) {
-    statement->BindInt(index++, entry.ref(static_cast<BitField>(i)));
-  }
-  for ( ; i < STRING_FIELDS_END; ++i) {
-    statement->BindString(index++, entry.ref(static_cast<StringField>(i)));
-  }
-  for ( ; i < PROTO_FIELDS_END; ++i) {
+                             entry.ref(static_cast<TimeField>(field))));
+  } else if (field < ID_FIELDS_END) {
+    statement->BindString(index, entry.ref(static_cast<IdField>(field)).s_);
+  } else if (field < BIT_FIELDS_END) {
+    statement->BindInt(index, entry.ref(static_cast<BitField>(field)));
+  } else if (field < STRING_FIELDS_END) {
+    statement->BindString(index, entry.ref(static_cast<StringField>(field)));
+  } else if (field < PROTO_FIELDS_END) {
     std::string temp;
-    entry.ref(static_cast<ProtoField>(i)).SerializeToString(&temp);
-    statement->BindBlob(index++, temp.data(), temp.length());
-  }
-  for ( ; i < UNIQUE_POSITION_FIELDS_END; ++i) {
+    entry.SerializeSpecifics(static_cast<ProtoField>(field), &temp);
+    statement->BindBlob(index, temp.data(), temp.length());
+  } else {
     std::string temp;
-    entry.ref(static_cast<UniquePositionField>(i)).SerializeToString(&temp);
-    statement->BindBlob(index++, temp.data(), temp.length());
+    entry.ref(static_cast<UniquePositionField>(field)).SerializeToString(
+        &temp);
+    statement->BindBlob(index, temp.data(), temp.length());
   }
 }
 
+// Iterate over the fields of |entry| and bind each to |statement| for
+// updating.
+void BindFields(const EntryKernel& entry,
+                sql::Statement* statement) {
+  for (int i = BEGIN_FIELDS; i < FIELD_COUNT; ++i)
+    BindField(entry, i, i - BEGIN_FIELDS, statement);
+}
+
 // The caller owns the returned EntryKernel*.  Assumes the statement currently
 // points to a valid row in the metas table. Returns NULL to indicate that
 // it detected a corruption in the data on unpacking.
@@ -98,8 +104,9 @@ scoped_ptr<EntryKernel> UnpackEntry(sql::Statement* statement) {
                 statement->ColumnString(i));
   }
   for ( ; i < PROTO_FIELDS_END; ++i) {
-    kernel->mutable_ref(static_cast<ProtoField>(i)).ParseFromArray(
-        statement->ColumnBlob(i), statement->ColumnByteLength(i));
+    kernel->PutSerialized(static_cast<ProtoField>(i),
+                          statement->ColumnBlob(i),
+                          statement->ColumnByteLength(i));
   }
   for ( ; i < UNIQUE_POSITION_FIELDS_END; ++i) {
     std::string temp;
@@ -114,6 +121,8 @@ scoped_ptr<EntryKernel> UnpackEntry(sql::Statement* statement) {
     kernel->mutable_ref(static_cast<UniquePositionField>(i)) =
         UniquePosition::FromProto(proto);
   }
+  // The entry matches its row until it is modified.
+  kernel->clear_dirty_fields();
   return kernel.Pass();
 }
 
@@ -168,6 +177,7 @@ DirectoryBackingStore::DirectoryBackingStore(const string& dir_name,
 }
 
 DirectoryBackingStore::~DirectoryBackingStore() {
+  STLDeleteValues(&update_meta_statements_);
 }
 
 bool DirectoryBackingStore::DeleteEntries(EntryTable from,
@@ -221,7 +231,11 @@ bool DirectoryBackingStore::SaveChanges(
   for (EntryKernelSet::const_iterator i = snapshot.dirty_metas.begin();
        i != snapshot.dirty_metas.end(); ++i) {
     DCHECK((*i)->is_dirty());
-    if (!SaveEntryToDB(&save_meta_statment_, **i))
+    // New entries are inserted whole, the others only get their dirty
+    // columns updated.
+    bool saved = (*i)->are_all_fields_dirty() ?
+        SaveEntryToDB(&save_meta_statment_, **i) : UpdateEntryToDB(**i);
+    if (!saved)
       return false;
   }
 
@@ -598,6 +612,31 @@ bool DirectoryBackingStore::SaveEntryToDB(sql::Statement* save_statement,
   return save_statement->Run();
 }
 
+bool DirectoryBackingStore::UpdateEntryToDB(const EntryKernel& entry) {
+  const EntryKernel::FieldSet& fields = entry.dirty_fields();
+  if (fields.none())
+    return true;
+
+  sql::Statement*& update_statement =
+      update_meta_statements_[static_cast<uint32>(fields.to_ulong())];
+  if (!update_statement)
+    update_statement = new sql::Statement();
+  PrepareUpdateEntryStatement(fields, update_statement);
+
+  update_statement->Reset(true);
+  int index = 0;
+  for (int i = BEGIN_FIELDS; i < FIELD_COUNT; ++i) {
+    if (fields[i])
+      BindField(entry, i, index++, update_statement);
+  }
+  update_statement->BindInt64(index, entry.ref(META_HANDLE));
+  if (!update_statement->Run())
+    return false;
+  DCHECK_EQ(1, db_->GetLastChangeCount())
+      << "No row to update for metahandle " << entry.ref(META_HANDLE);
+  return true;
+}
+
 bool DirectoryBackingStore::DropDeletedEntries() {
   if (!db_->Execute("DELETE FROM metas "
                     "WHERE is_del > 0 "
@@ -1500,5 +1539,26 @@ void DirectoryBackingStore::PrepareSaveEntryStatement(
       base::StringPrintf(query.c_str(), "metas").c_str()));
 }
 
+void DirectoryBackingStore::PrepareUpdateEntryStatement(
+    const EntryKernel::FieldSet& fields, sql::Statement* update_statement) {
+  if (update_statement->is_valid())
+    return;
+
+  string query;
+  query.reserve(kUpdateStatementBufferSize);
+  query.append("UPDATE metas SET ");
+  const char* separator = "";
+  for (int i = BEGIN_FIELDS; i < FIELD_COUNT; ++i) {
+    if (!fields[i])
+      continue;
+    query.append(separator);
+    separator = ", ";
+    query.append(ColumnName(i));
+    query.append(" = ?");
+  }
+  query.append(" WHERE metahandle = ?");
+  update_statement->Assign(db_->GetUniqueStatement(query.c_str()));
+}
+
 }  // namespace syncable
 }  // namespace syncer
@@ -5,6 +5,7 @@
 #ifndef SYNC_SYNCABLE_DIRECTORY_BACKING_STORE_H_
 #define SYNC_SYNCABLE_DIRECTORY_BACKING_STORE_H_
 
+#include <map>
 #include <string>
 
 #include "base/memory/scoped_ptr.h"
@@ -49,7 +50,8 @@ class SYNC_EXPORT_PRIVATE DirectoryBackingStore : public base::NonThreadSafe {
   virtual ~DirectoryBackingStore();
 
   // Loads and drops all currently persisted meta entries into |handles_map|
-  // and loads appropriate persisted kernel info into |info_bucket|.
+  // and loads appropriate persisted kernel info into |info_bucket|.  The
+  // specifics of the entries are kept serialized until they are accessed.
   //
   // This function can perform some cleanup tasks behind the scenes.  It will
   // clean up unused entries from the database and migrate to the latest
@@ -104,6 +106,7 @@ class SYNC_EXPORT_PRIVATE DirectoryBackingStore : public base::NonThreadSafe {
   static bool SaveEntryToDB(sql::Statement* save_statement,
                             const EntryKernel& entry);
   bool SaveNewEntryToDB(const EntryKernel& entry);
+  // Writes only the dirty fields of |entry|, whose row must already exist.
   bool UpdateEntryToDB(const EntryKernel& entry);
 
   // Close save_dbhandle_.  Broken out for testing.
@@ -174,6 +177,8 @@ class SYNC_EXPORT_PRIVATE DirectoryBackingStore : public base::NonThreadSafe {
   scoped_ptr<sql::Connection> db_;
   sql::Statement save_meta_statment_;
   sql::Statement save_delete_journal_statment_;
+  // The statements of UpdateEntryToDB(), by the dirty fields they update.
+  std::map<uint32, sql::Statement*> update_meta_statements_;
   std::string dir_name_;
 
   // Set to true if migration left some old columns around that need to be
@@ -184,6 +189,10 @@ class SYNC_EXPORT_PRIVATE DirectoryBackingStore : public base::NonThreadSafe {
   // Prepares |save_statement| for saving entries in |table|.
   void PrepareSaveEntryStatement(EntryTable table,
                                  sql::Statement* save_statement);
+  // Prepares |update_statement| for updating |fields| of entries in the metas
+  // table.
+  void PrepareUpdateEntryStatement(const EntryKernel::FieldSet& fields,
+                                   sql::Statement* update_statement);
 
   DISALLOW_COPY_AND_ASSIGN(DirectoryBackingStore);
 };
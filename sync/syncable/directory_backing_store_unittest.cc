@@ -9,9 +9,13 @@
 #include "base/file_util.h"
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/process/process_handle.h"
+#include "base/process/process_metrics.h"
 #include "base/stl_util.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
 #include "sql/connection.h"
 #include "sql/statement.h"
 #include "sync/base/sync_export.h"
@@ -3488,6 +3492,143 @@ TEST_F(DirectoryBackingStoreTest, DeleteEntries) {
   EXPECT_EQ(0U, handles_map.size());
 }
 
+namespace {
+
+// Returns a synced bookmark under the root, ready to be saved.
+EntryKernel* CreateBookmarkEntry(int64 metahandle) {
+  EntryKernel* entry = new EntryKernel();
+  std::string number = base::Int64ToString(metahandle);
+  entry->put(META_HANDLE, metahandle);
+  entry->put(BASE_VERSION, 1);
+  entry->put(SERVER_VERSION, 1);
+  entry->put(ID, Id::CreateFromServerId(number));
+  entry->put(PARENT_ID, Id());
+  entry->put(SERVER_PARENT_ID, Id());
+  entry->put(NON_UNIQUE_NAME, "Bookmark " + number);
+  entry->put(SERVER_NON_UNIQUE_NAME, "Bookmark " + number);
+  sync_pb::EntitySpecifics specifics;
+  specifics.mutable_bookmark()->set_url("http://www.example.com/" + number);
+  specifics.mutable_bookmark()->set_title("Bookmark " + number);
+  entry->put(SPECIFICS, specifics);
+  entry->put(SERVER_SPECIFICS, specifics);
+  entry->mark_dirty(NULL);
+  return entry;
+}
+
+size_t GetWorkingSetSize() {
+#if !defined(OS_MACOSX)
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle(), NULL));
+#endif
+  return metrics->GetWorkingSetSize();
+}
+
+}  // namespace
+
+// The specifics are loaded serialized, and parsed when they're accessed.
+TEST_F(DirectoryBackingStoreTest, LoadSerializedSpecifics) {
+  sync_pb::EntitySpecifics encrypted;
+  encrypted.mutable_encrypted()->set_key_name("key");
+  encrypted.mutable_encrypted()->set_blob("blob");
+  encrypted.mutable_bookmark();
+  {
+    scoped_ptr<OnDiskDirectoryBackingStore> dbs(
+        new OnDiskDirectoryBackingStore(GetUsername(), GetDatabasePath()));
+    ASSERT_TRUE(LoadAndIgnoreReturnedData(dbs.get()));
+    Directory::SaveChangesSnapshot snapshot;
+    scoped_ptr<EntryKernel> entry(CreateBookmarkEntry(2));
+    entry->put(SERVER_SPECIFICS, encrypted);
+    snapshot.dirty_metas.insert(entry.get());
+    ASSERT_TRUE(dbs->SaveChanges(snapshot));
+  }
+
+  Directory::MetahandlesMap handles_map;
+  JournalIndex delete_journals;
+  Directory::KernelLoadInfo kernel_load_info;
+  STLValueDeleter<Directory::MetahandlesMap> index_deleter(&handles_map);
+  scoped_ptr<OnDiskDirectoryBackingStore> dbs(
+      new OnDiskDirectoryBackingStore(GetUsername(), GetDatabasePath()));
+  ASSERT_EQ(OPENED,
+            dbs->Load(&handles_map, &delete_journals, &kernel_load_info));
+  ASSERT_EQ(1U, handles_map.count(2));
+  EntryKernel* entry = handles_map[2];
+
+  // The types are known without parsing the specifics, even encrypted ones.
+  EXPECT_EQ(BOOKMARKS, entry->GetModelType());
+  EXPECT_EQ(BOOKMARKS, entry->GetServerModelType());
+  EXPECT_TRUE(entry->ShouldMaintainPosition());
+  std::string serialized;
+  entry->SerializeSpecifics(SERVER_SPECIFICS, &serialized);
+  EXPECT_EQ(encrypted.SerializeAsString(), serialized);
+
+  EXPECT_EQ("http://www.example.com/2", entry->ref(SPECIFICS).bookmark().url());
+  EXPECT_EQ("blob", entry->ref(SERVER_SPECIFICS).encrypted().blob());
+  entry->mutable_ref(SPECIFICS).mutable_bookmark()->set_title("Modified");
+  entry->SerializeSpecifics(SPECIFICS, &serialized);
+  EXPECT_EQ(entry->ref(SPECIFICS).SerializeAsString(), serialized);
+  EXPECT_EQ("Modified", entry->ref(SPECIFICS).bookmark().title());
+  EXPECT_EQ(UNSPECIFIED, entry->GetSpecificsModelType(BASE_SERVER_SPECIFICS));
+}
+
+// Measures the time and the memory it takes to load the database of a large
+// account, and to parse all its specifics.  This is too slow to run by
+// default: use --gtest_also_run_disabled_tests.
+TEST_F(DirectoryBackingStoreTest, DISABLED_LoadLargeDatabase) {
+  const int64 kEntryCount = 500000;
+  const int64 kEntriesPerSave = 10000;
+  {
+    scoped_ptr<OnDiskDirectoryBackingStore> dbs(
+        new OnDiskDirectoryBackingStore(GetUsername(), GetDatabasePath()));
+    ASSERT_TRUE(LoadAndIgnoreReturnedData(dbs.get()));
+    // The root has metahandle 1.
+    for (int64 first = 2; first < kEntryCount + 2; first += kEntriesPerSave) {
+      Directory::SaveChangesSnapshot snapshot;
+      STLElementDeleter<EntryKernelSet> deleter(&snapshot.dirty_metas);
+      for (int64 i = first; i < first + kEntriesPerSave; ++i)
+        snapshot.dirty_metas.insert(CreateBookmarkEntry(i));
+      ASSERT_TRUE(dbs->SaveChanges(snapshot));
+    }
+  }
+
+  size_t working_set_before = GetWorkingSetSize();
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  Directory::MetahandlesMap handles_map;
+  JournalIndex delete_journals;
+  Directory::KernelLoadInfo kernel_load_info;
+  STLValueDeleter<Directory::MetahandlesMap> index_deleter(&handles_map);
+  scoped_ptr<OnDiskDirectoryBackingStore> dbs(
+      new OnDiskDirectoryBackingStore(GetUsername(), GetDatabasePath()));
+  ASSERT_EQ(OPENED,
+            dbs->Load(&handles_map, &delete_journals, &kernel_load_info));
+  base::TimeDelta load_time = base::TimeTicks::HighResNow() - start;
+  size_t working_set_loaded = GetWorkingSetSize();
+  EXPECT_EQ(static_cast<size_t>(kEntryCount + 1), handles_map.size());
+
+  // Parses everything, as loading used to.
+  start = base::TimeTicks::HighResNow();
+  for (Directory::MetahandlesMap::const_iterator it = handles_map.begin();
+       it != handles_map.end(); ++it) {
+    it->second->ref(SPECIFICS);
+    it->second->ref(SERVER_SPECIFICS);
+    it->second->ref(BASE_SERVER_SPECIFICS);
+  }
+  base::TimeDelta parse_time = base::TimeTicks::HighResNow() - start;
+  size_t working_set_parsed = GetWorkingSetSize();
+
+  LOG(INFO) << "Loaded " << handles_map.size() << " entries in "
+            << load_time.InMilliseconds() << " ms, using "
+            << (working_set_loaded - working_set_before) / 1024 << " KB";
+  LOG(INFO) << "Parsed their specifics in " << parse_time.InMilliseconds()
+            << " ms, using "
+            << (working_set_parsed - working_set_loaded) / 1024
+            << " more KB";
+}
+
 TEST_F(DirectoryBackingStoreTest, GenerateCacheGUID) {
   const std::string& guid1 = TestDirectoryBackingStore::GenerateCacheGUID();
   const std::string& guid2 = TestDirectoryBackingStore::GenerateCacheGUID();
@@ -4,7 +4,13 @@
 
 #include "sync/syncable/entry_kernel.h"
 
+#include <algorithm>
+
+#include "base/lazy_instance.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "sync/protocol/proto_value_conversions.h"
 #include "sync/syncable/syncable_enum_conversions.h"
 #include "sync/util/cryptographer.h"
@@ -12,17 +18,188 @@
 namespace syncer {
 namespace syncable {
 
-EntryKernel::EntryKernel() : dirty_(false) {
+COMPILE_ASSERT(PROTO_FIELDS_COUNT <= 32, too_many_proto_fields_for_bitmask);
+
+EntryKernel::EntryKernel() : unparsed_specifics_(0), dirty_(false) {
   // Everything else should already be default-initialized.
   for (int i = INT64_FIELDS_BEGIN; i < INT64_FIELDS_END; ++i) {
     int64_fields[i] = 0;
   }
+  // A new entry has never been saved, so all of its row must be written.
+  dirty_fields_.set();
+}
+
+EntryKernel::EntryKernel(const EntryKernel& other) : unparsed_specifics_(0) {
+  *this = other;
 }
 
 EntryKernel::~EntryKernel() {}
 
+EntryKernel& EntryKernel::operator=(const EntryKernel& other) {
+  if (this == &other)
+    return *this;
+  std::copy(other.string_fields, other.string_fields + STRING_FIELDS_COUNT,
+            string_fields);
+  std::copy(other.int64_fields, other.int64_fields + INT64_FIELDS_COUNT,
+            int64_fields);
+  std::copy(other.time_fields, other.time_fields + TIME_FIELDS_COUNT,
+            time_fields);
+  std::copy(other.id_fields, other.id_fields + ID_FIELDS_COUNT, id_fields);
+  std::copy(other.unique_position_fields,
+            other.unique_position_fields + UNIQUE_POSITION_FIELDS_COUNT,
+            unique_position_fields);
+  bit_fields = other.bit_fields;
+  bit_temps = other.bit_temps;
+
+  // Specifics that |other| has parsed are complete once their bit is clear.
+  // Those that are still serialized may be parsed concurrently, but their
+  // serialized form doesn't change.
+  base::subtle::Atomic32 unparsed =
+      base::subtle::Acquire_Load(&other.unparsed_specifics_);
+  for (int i = 0; i < PROTO_FIELDS_COUNT; ++i) {
+    if (unparsed & (1 << i)) {
+      specifics_fields[i].Clear();
+      serialized_specifics_fields[i] = other.serialized_specifics_fields[i];
+    } else {
+      specifics_fields[i].CopyFrom(other.specifics_fields[i]);
+      std::string().swap(serialized_specifics_fields[i]);
+    }
+  }
+  base::subtle::NoBarrier_Store(&unparsed_specifics_, unparsed);
+
+  dirty_ = other.dirty_;
+  dirty_fields_ = other.dirty_fields_;
+  return *this;
+}
+
+namespace {
+
+// Serializes the parsing of specifics by concurrent read transactions.
+base::LazyInstance<base::Lock>::Leaky g_parse_specifics_lock =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Returns the type of serialized specifics, which is given by the field of
+// the EntitySpecifics that is set.  The other fields, like the encrypted
+// data, are skipped without being parsed.
+ModelType GetModelTypeFromSerializedSpecifics(const std::string& data) {
+  using google::protobuf::internal::WireFormatLite;
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8*>(data.data()), data.size());
+  while (uint32 tag = input.ReadTag()) {
+    ModelType type = GetModelTypeFromSpecificsFieldNumber(
+        WireFormatLite::GetTagFieldNumber(tag));
+    if (type != UNSPECIFIED)
+      return type;
+    if (!WireFormatLite::SkipField(&input, tag, NULL))
+      break;
+  }
+  return UNSPECIFIED;
+}
+
+}  // namespace
+
+void EntryKernel::PutSerialized(ProtoField field,
+                                const void* data,
+                                int length) {
+  int index = field - PROTO_FIELDS_BEGIN;
+  dirty_fields_.set(field);
+  specifics_fields[index].Clear();
+  DiscardSerializedSpecifics(field);
+  if (length > 0) {
+    serialized_specifics_fields[index].assign(static_cast<const char*>(data),
+                                              length);
+    base::subtle::NoBarrier_Store(
+        &unparsed_specifics_,
+        base::subtle::NoBarrier_Load(&unparsed_specifics_) |
+            SpecificsBit(field));
+  }
+}
+
+void EntryKernel::SerializeSpecifics(ProtoField field,
+                                     std::string* data) const {
+  int index = field - PROTO_FIELDS_BEGIN;
+  if (HasUnparsedSpecifics(field))
+    *data = serialized_specifics_fields[index];
+  else
+    specifics_fields[index].SerializeToString(data);
+}
+
+EntryKernel* EntryKernel::CopyDirtyFields() const {
+  EntryKernel* copy = new EntryKernel();
+  copy->put(META_HANDLE, ref(META_HANDLE));
+  for (int i = BEGIN_FIELDS; i < FIELD_COUNT; ++i) {
+    if (!dirty_fields_[i])
+      continue;
+    if (i < INT64_FIELDS_END) {
+      copy->int64_fields[i - INT64_FIELDS_BEGIN] =
+          int64_fields[i - INT64_FIELDS_BEGIN];
+    } else if (i < TIME_FIELDS_END) {
+      copy->time_fields[i - TIME_FIELDS_BEGIN] =
+          time_fields[i - TIME_FIELDS_BEGIN];
+    } else if (i < ID_FIELDS_END) {
+      copy->id_fields[i - ID_FIELDS_BEGIN] = id_fields[i - ID_FIELDS_BEGIN];
+    } else if (i < BIT_FIELDS_END) {
+      copy->bit_fields[i - BIT_FIELDS_BEGIN] =
+          bit_fields[i - BIT_FIELDS_BEGIN];
+    } else if (i < STRING_FIELDS_END) {
+      copy->string_fields[i - STRING_FIELDS_BEGIN] =
+          string_fields[i - STRING_FIELDS_BEGIN];
+    } else if (i < PROTO_FIELDS_END) {
+      // Specifics that were never parsed are copied serialized.
+      ProtoField field = static_cast<ProtoField>(i);
+      int index = i - PROTO_FIELDS_BEGIN;
+      if (HasUnparsedSpecifics(field)) {
+        copy->PutSerialized(field, serialized_specifics_fields[index].data(),
+                            serialized_specifics_fields[index].size());
+      } else {
+        copy->specifics_fields[index].CopyFrom(specifics_fields[index]);
+      }
+    } else {
+      copy->unique_position_fields[i - UNIQUE_POSITION_FIELDS_BEGIN] =
+          unique_position_fields[i - UNIQUE_POSITION_FIELDS_BEGIN];
+    }
+  }
+  copy->dirty_ = dirty_;
+  copy->dirty_fields_ = dirty_fields_;
+  return copy;
+}
+
+ModelType EntryKernel::GetSpecificsModelType(ProtoField field) const {
+  int index = field - PROTO_FIELDS_BEGIN;
+  if (HasUnparsedSpecifics(field)) {
+    return GetModelTypeFromSerializedSpecifics(
+        serialized_specifics_fields[index]);
+  }
+  return GetModelTypeFromSpecifics(specifics_fields[index]);
+}
+
+void EntryKernel::ParseSpecifics(ProtoField field) const {
+  base::AutoLock lock(g_parse_specifics_lock.Get());
+  if (!HasUnparsedSpecifics(field))
+    return;
+  int index = field - PROTO_FIELDS_BEGIN;
+  // Specifics that can't be parsed are left empty, as they always were when
+  // loaded from a corrupt database.
+  if (!specifics_fields[index].ParseFromString(
+          serialized_specifics_fields[index])) {
+    DVLOG(1) << "Dropping specifics that can't be parsed";
+  }
+  base::subtle::Release_Store(
+      &unparsed_specifics_,
+      base::subtle::NoBarrier_Load(&unparsed_specifics_) &
+          ~SpecificsBit(field));
+}
+
+void EntryKernel::DiscardSerializedSpecifics(ProtoField field) {
+  base::subtle::NoBarrier_Store(
+      &unparsed_specifics_,
+      base::subtle::NoBarrier_Load(&unparsed_specifics_) &
+          ~SpecificsBit(field));
+  std::string().swap(serialized_specifics_fields[field - PROTO_FIELDS_BEGIN]);
+}
+
 ModelType EntryKernel::GetModelType() const {
-  ModelType specifics_type = GetModelTypeFromSpecifics(ref(SPECIFICS));
+  ModelType specifics_type = GetSpecificsModelType(SPECIFICS);
   if (specifics_type != UNSPECIFIED)
     return specifics_type;
   if (ref(ID).IsRoot())
@@ -36,7 +213,7 @@ ModelType EntryKernel::GetModelType() const {
 }
 
 ModelType EntryKernel::GetServerModelType() const {
-  ModelType specifics_type = GetModelTypeFromSpecifics(ref(SERVER_SPECIFICS));
+  ModelType specifics_type = GetSpecificsModelType(SERVER_SPECIFICS);
   if (specifics_type != UNSPECIFIED)
     return specifics_type;
   if (ref(ID).IsRoot())
@@ -52,7 +229,7 @@ ModelType EntryKernel::GetServerModelType() const {
 bool EntryKernel::ShouldMaintainPosition() const {
   // We maintain positions for all bookmarks, except those that are
   // server-created top-level folders.
-  return (GetModelTypeFromSpecifics(ref(SPECIFICS)) == syncer::BOOKMARKS)
+  return (GetSpecificsModelType(SPECIFICS) == syncer::BOOKMARKS)
       && !(!ref(UNIQUE_SERVER_TAG).empty() && ref(IS_DIR));
 }
 
@@ -7,6 +7,7 @@
 
 #include <set>
 
+#include "base/atomicops.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "sync/base/sync_export.h"
@@ -178,7 +179,19 @@ enum {
 struct SYNC_EXPORT_PRIVATE EntryKernel {
  private:
   std::string string_fields[STRING_FIELDS_COUNT];
-  sync_pb::EntitySpecifics specifics_fields[PROTO_FIELDS_COUNT];
+  // The specifics are loaded from the database in serialized form, and only
+  // parsed the first time they are accessed: most entries are never looked
+  // at before the next restart.  The specifics of a field are in
+  // |serialized_specifics_fields| while its bit is set in
+  // |unparsed_specifics_|, and in |specifics_fields| otherwise.
+  //
+  // Read transactions run concurrently, so the const getters parse under a
+  // lock, and publish the parsed specifics by clearing the bit.  The
+  // serialized specifics aren't modified by readers, which may be copying
+  // them; they are freed when the field is next written.
+  mutable sync_pb::EntitySpecifics specifics_fields[PROTO_FIELDS_COUNT];
+  std::string serialized_specifics_fields[PROTO_FIELDS_COUNT];
+  mutable base::subtle::Atomic32 unparsed_specifics_;
   int64 int64_fields[INT64_FIELDS_COUNT];
   base::Time time_fields[TIME_FIELDS_COUNT];
   Id id_fields[ID_FIELDS_COUNT];
@@ -188,8 +201,12 @@ struct SYNC_EXPORT_PRIVATE EntryKernel {
 
  public:
   EntryKernel();
+  // Copying is safe while read transactions parse the specifics of |other|.
+  EntryKernel(const EntryKernel& other);
   ~EntryKernel();
 
+  EntryKernel& operator=(const EntryKernel& other);
+
   // Set the dirty bit, and optionally add this entry's metahandle to
   // a provided index on dirty bits in |dirty_index|. Parameter may be null,
   // and will result only in setting the dirty bit of this entry.
@@ -216,42 +233,78 @@ struct SYNC_EXPORT_PRIVATE EntryKernel {
     return dirty_;
   }
 
+  // The fields that changed since the entry was loaded from or last saved to
+  // the database, which are all the fields of a new entry.  Only those are
+  // copied by CopyDirtyFields() and written by the next save.
+  typedef std::bitset<FIELD_COUNT> FieldSet;
+  inline const FieldSet& dirty_fields() const {
+    return dirty_fields_;
+  }
+  inline bool are_all_fields_dirty() const {
+    return dirty_fields_.count() == FIELD_COUNT;
+  }
+  inline void mark_fields_dirty(const FieldSet& fields) {
+    dirty_fields_ |= fields;
+  }
+  inline void clear_dirty_fields() {
+    dirty_fields_.reset();
+  }
+
+  // Returns a copy of this entry with only its metahandle and its dirty
+  // fields set, for saving it to the database.  Caller owns the copy.
+  EntryKernel* CopyDirtyFields() const;
+
   // Setters.
   inline void put(MetahandleField field, int64 value) {
     int64_fields[field - INT64_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(Int64Field field, int64 value) {
     int64_fields[field - INT64_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(TimeField field, const base::Time& value) {
     // Round-trip to proto time format and back so that we have
     // consistent time resolutions (ms).
     time_fields[field - TIME_FIELDS_BEGIN] =
         ProtoTimeToTime(TimeToProtoTime(value));
+    dirty_fields_.set(field);
   }
   inline void put(IdField field, const Id& value) {
     id_fields[field - ID_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(BaseVersion field, int64 value) {
     int64_fields[field - INT64_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(IndexedBitField field, bool value) {
     bit_fields[field - BIT_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(IsDelField field, bool value) {
     bit_fields[field - BIT_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(BitField field, bool value) {
     bit_fields[field - BIT_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(StringField field, const std::string& value) {
     string_fields[field - STRING_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(ProtoField field, const sync_pb::EntitySpecifics& value) {
+    DiscardSerializedSpecifics(field);
     specifics_fields[field - PROTO_FIELDS_BEGIN].CopyFrom(value);
+    dirty_fields_.set(field);
   }
+  // Sets |field| to the specifics serialized in |data|, which are parsed when
+  // they are first accessed.
+  void PutSerialized(ProtoField field, const void* data, int length);
   inline void put(UniquePositionField field, const UniquePosition& value) {
     unique_position_fields[field - UNIQUE_POSITION_FIELDS_BEGIN] = value;
+    dirty_fields_.set(field);
   }
   inline void put(BitTemp field, bool value) {
     bit_temps[field - BIT_TEMPS_BEGIN] = value;
@@ -286,6 +339,8 @@ struct SYNC_EXPORT_PRIVATE EntryKernel {
     return string_fields[field - STRING_FIELDS_BEGIN];
   }
   inline const sync_pb::EntitySpecifics& ref(ProtoField field) const {
+    if (HasUnparsedSpecifics(field))
+      ParseSpecifics(field);
     return specifics_fields[field - PROTO_FIELDS_BEGIN];
   }
   inline const UniquePosition& ref(UniquePositionField field) const {
@@ -297,15 +352,30 @@ struct SYNC_EXPORT_PRIVATE EntryKernel {
 
   // Non-const, mutable ref getters for object types only.
   inline std::string& mutable_ref(StringField field) {
+    dirty_fields_.set(field);
     return string_fields[field - STRING_FIELDS_BEGIN];
   }
   inline sync_pb::EntitySpecifics& mutable_ref(ProtoField field) {
+    dirty_fields_.set(field);
+    if (HasUnparsedSpecifics(field))
+      ParseSpecifics(field);
+    DiscardSerializedSpecifics(field);
     return specifics_fields[field - PROTO_FIELDS_BEGIN];
   }
+
+  // Serializes the specifics of |field| into |data|, without parsing them if
+  // they are still serialized.
+  void SerializeSpecifics(ProtoField field, std::string* data) const;
+
+  // Same as GetModelTypeFromSpecifics(ref(field)), without parsing the
+  // specifics if they are still serialized.
+  ModelType GetSpecificsModelType(ProtoField field) const;
   inline Id& mutable_ref(IdField field) {
+    dirty_fields_.set(field);
     return id_fields[field - ID_FIELDS_BEGIN];
   }
   inline UniquePosition& mutable_ref(UniquePositionField field) {
+    dirty_fields_.set(field);
     return unique_position_fields[field - UNIQUE_POSITION_FIELDS_BEGIN];
   }
 
@@ -321,8 +391,26 @@ struct SYNC_EXPORT_PRIVATE EntryKernel {
   base::DictionaryValue* ToValue(Cryptographer* cryptographer) const;
 
  private:
+  static inline base::subtle::Atomic32 SpecificsBit(ProtoField field) {
+    return 1 << (field - PROTO_FIELDS_BEGIN);
+  }
+
+  inline bool HasUnparsedSpecifics(ProtoField field) const {
+    return (base::subtle::Acquire_Load(&unparsed_specifics_) &
+            SpecificsBit(field)) != 0;
+  }
+
+  // Parses the serialized specifics of |field|, unless another thread did.
+  void ParseSpecifics(ProtoField field) const;
+
+  // Frees the serialized specifics of |field|, once they are parsed or when
+  // they are overwritten.  Only for writers.
+  void DiscardSerializedSpecifics(ProtoField field);
+
   // Tracks whether this entry needs to be saved to the database.
   bool dirty_;
+
+  FieldSet dirty_fields_;
 };
 
 class EntryKernelLessByMetaHandle {
@@ -33,7 +33,7 @@ class SYNC_EXPORT_PRIVATE NigoriHandler {
   virtual ~NigoriHandler();
 
   // Apply a nigori node update, updating the internal encryption state
-  // accordingly.
+  // accordingly.  |trans| must be a write transaction.
   virtual void ApplyNigoriUpdate(
       const sync_pb::NigoriSpecifics& nigori,
       syncable::BaseTransaction* const trans) = 0;
@@ -47,8 +47,8 @@ class SYNC_EXPORT_PRIVATE NigoriHandler {
   virtual bool NeedKeystoreKey(
       syncable::BaseTransaction* const trans) const = 0;
 
-  // Set the keystore keys the server returned for this account.
-  // Returns true on success, false otherwise.
+  // Set the keystore keys the server returned for this account.  |trans| must
+  // be a write transaction.  Returns true on success, false otherwise.
   virtual bool SetKeystoreKeys(
       const google::protobuf::RepeatedPtrField<std::string>& keys,
       syncable::BaseTransaction* const trans) = 0;
@@ -24,11 +24,23 @@ void BaseTransaction::Lock() {
                "src_file", from_here_.file_name(),
                "src_func", from_here_.function_name());
 
-  directory_->kernel_->transaction_mutex.Acquire();
+  directory_->kernel_->transaction_mutex.WriteAcquire();
 }
 
 void BaseTransaction::Unlock() {
-  directory_->kernel_->transaction_mutex.Release();
+  directory_->kernel_->transaction_mutex.WriteRelease();
+}
+
+void BaseTransaction::ReadLock() {
+  TRACE_EVENT2("sync_lock_contention", "AcquireReadLock",
+               "src_file", from_here_.file_name(),
+               "src_func", from_here_.function_name());
+
+  directory_->kernel_->transaction_mutex.ReadAcquire();
+}
+
+void BaseTransaction::ReadUnlock() {
+  directory_->kernel_->transaction_mutex.ReadRelease();
 }
 
 void BaseTransaction::OnUnrecoverableError(
@@ -49,6 +61,10 @@ bool BaseTransaction::unrecoverable_error_set() const {
   return unrecoverable_error_set_;
 }
 
+void BaseTransaction::AssertWriteLocked() const {
+  directory_->kernel_->transaction_mutex.AssertWriteAcquired();
+}
+
 void BaseTransaction::HandleUnrecoverableErrorIfSet() {
   if (unrecoverable_error_set_) {
     directory()->OnUnrecoverableError(this,
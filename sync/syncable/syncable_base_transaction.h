@@ -23,6 +23,7 @@ enum WriterTag {
   AUTHWATCHER,
   UNITTEST,
   VACUUM_AFTER_SAVE,
+  SAVE_CHANGES,
   HANDLE_SAVE_FAILURE,
   PURGE_ENTRIES,
   SYNCAPI,
@@ -49,19 +50,30 @@ class SYNC_EXPORT BaseTransaction {
 
   bool unrecoverable_error_set() const;
 
+  // Checks that this transaction holds the directory's transaction lock
+  // exclusively, as write transactions do.  Read transactions share the
+  // lock, so state they can see must not be modified under one.  Does
+  // nothing in release builds.
+  void AssertWriteLocked() const;
+
  protected:
   BaseTransaction(const tracked_objects::Location& from_here,
                   const char* name,
                   WriterTag writer,
                   Directory* directory);
 
+  // Write transactions hold the directory's transaction lock exclusively,
+  // read transactions share it.
   void Lock();
   void Unlock();
-
-  // This should be called before unlocking because it calls the Direcotry's
-  // OnUnrecoverableError method which is not protected by locks and could
-  // be called from any thread. Holding the transaction lock ensures only one
-  // thread could call the method at a time.
+  void ReadLock();
+  void ReadUnlock();
+
+  // This should be called before unlocking because it calls the Directory's
+  // OnUnrecoverableError method, which must run before any write transaction
+  // can see the entries left behind by the error.  Read transactions run
+  // concurrently, so the Directory serializes the calls to its error handler
+  // with a lock of its own; only one thread handles an error at a time.
   void HandleUnrecoverableErrorIfSet();
 
   const tracked_objects::Location from_here_;
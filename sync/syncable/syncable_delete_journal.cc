@@ -31,8 +31,7 @@ void DeleteJournal::UpdateDeleteJournalForServerDelete(
   // Should be sufficient to check server type only but check for local
   // type too because of incomplete test setup.
   if (!(IsDeleteJournalEnabled(entry.GetServerModelType()) ||
-      IsDeleteJournalEnabled(
-          GetModelTypeFromSpecifics(entry.ref(SPECIFICS))))) {
+      IsDeleteJournalEnabled(entry.GetSpecificsModelType(SPECIFICS)))) {
     return;
   }
 
@@ -71,7 +70,7 @@ void DeleteJournal::GetDeleteJournals(BaseTransaction* trans,
   for (JournalIndex::const_iterator it = delete_journals_.begin();
       it != delete_journals_.end(); ++it) {
     if ((*it)->GetServerModelType() == type ||
-        GetModelTypeFromSpecifics((*it)->ref(SPECIFICS)) == type) {
+        (*it)->GetSpecificsModelType(SPECIFICS) == type) {
       deleted_entries->insert(*it);
     }
   }
@@ -10,12 +10,12 @@ namespace syncable {
 ReadTransaction::ReadTransaction(const tracked_objects::Location& location,
                                  Directory* directory)
     : BaseTransaction(location, "ReadTransaction", INVALID, directory) {
-  Lock();
+  ReadLock();
 }
 
 ReadTransaction::~ReadTransaction() {
   HandleUnrecoverableErrorIfSet();
-  Unlock();
+  ReadUnlock();
 }
 
 }  // namespace syncable
@@ -2,7 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
@@ -16,8 +18,10 @@
 #include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/test/values_test_util.h"
 #include "base/threading/platform_thread.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "sync/protocol/bookmark_specifics.pb.h"
 #include "sync/syncable/directory_backing_store.h"
@@ -460,6 +464,21 @@ class SyncableDirectoryTest : public testing::Test {
     return 1 == dir_->kernel_->metahandles_to_purge.count(metahandle);
   }
 
+  // Saves the changes like Directory::SaveChanges(), and returns in
+  // |snapshot_time| how long taking the snapshot held the kernel lock.
+  bool SaveChangesTimingSnapshot(base::TimeDelta* snapshot_time) {
+    base::AutoLock scoped_lock(dir_->kernel_->save_changes_mutex);
+    Directory::SaveChangesSnapshot snapshot;
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    dir_->TakeSnapshotForSaveChanges(&snapshot);
+    *snapshot_time = base::TimeTicks::HighResNow() - start;
+    if (!dir_->store_->SaveChanges(snapshot)) {
+      dir_->HandleSaveChangesFailure(snapshot);
+      return false;
+    }
+    return dir_->VacuumAfterSaveChanges(snapshot);
+  }
+
   void CheckPurgeEntriesWithTypeInSucceeded(ModelTypeSet types_to_purge,
                                             bool before_reload) {
     SCOPED_TRACE(testing::Message("Before reload: ") << before_reload);
@@ -1904,6 +1923,89 @@ TEST_F(OnDiskSyncableDirectoryTest,
   }
 }
 
+// Entries that were already saved only get their modified columns written,
+// which must leave the others as they were.
+TEST_F(OnDiskSyncableDirectoryTest,
+       TestUpdatedFieldsPreservedDuringSaveChanges) {
+  Id id;
+  sync_pb::EntitySpecifics specifics;
+  specifics.mutable_bookmark()->set_favicon("PNG");
+  specifics.mutable_bookmark()->set_url("http://nowhere");
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, dir_.get());
+    MutableEntry create(&trans, CREATE, BOOKMARKS, trans.root_id(), "Create");
+    create.PutIsUnsynced(true);
+    create.PutSpecifics(specifics);
+    id = create.GetId();
+  }
+  SaveAndReloadDir();
+
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, dir_.get());
+    MutableEntry update(&trans, GET_BY_ID, id);
+    ASSERT_TRUE(update.good());
+    update.PutServerVersion(5);
+    update.PutNonUniqueName("Renamed");
+  }
+  SaveAndReloadDir();
+
+  {
+    ReadTransaction trans(FROM_HERE, dir_.get());
+    Entry entry(&trans, GET_BY_ID, id);
+    ASSERT_TRUE(entry.good());
+    EXPECT_EQ(5, entry.GetServerVersion());
+    EXPECT_EQ("Renamed", entry.GetNonUniqueName());
+    EXPECT_TRUE(entry.GetIsUnsynced());
+    EXPECT_EQ(trans.root_id(), entry.GetParentId());
+    EXPECT_EQ(specifics.SerializeAsString(),
+              entry.GetSpecifics().SerializeAsString());
+  }
+}
+
+// Measures how long SaveChanges() takes, and how long it holds the kernel
+// lock, for 10k dirty entries: first new ones, then ones that only had a few
+// fields changed.  Too slow to run by default.
+TEST_F(OnDiskSyncableDirectoryTest, DISABLED_SaveChangesLatency) {
+  const int kEntryCount = 10000;
+  sync_pb::EntitySpecifics specifics;
+  specifics.mutable_bookmark()->set_favicon(std::string(1024, 'x'));
+  specifics.mutable_bookmark()->set_url("http://www.example.com/");
+  std::vector<int64> handles;
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, dir_.get());
+    for (int i = 0; i < kEntryCount; ++i) {
+      MutableEntry entry(&trans, CREATE, BOOKMARKS, trans.root_id(),
+                         base::StringPrintf("Entry %d", i));
+      entry.PutIsUnsynced(true);
+      entry.PutSpecifics(specifics);
+      handles.push_back(entry.GetMetahandle());
+    }
+  }
+  base::TimeDelta snapshot_time;
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  ASSERT_TRUE(SaveChangesTimingSnapshot(&snapshot_time));
+  base::TimeDelta save_time = base::TimeTicks::HighResNow() - start;
+  LOG(INFO) << "Saved " << kEntryCount << " new entries in "
+            << save_time.InMillisecondsF() << " ms, holding the lock for "
+            << snapshot_time.InMillisecondsF() << " ms";
+
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, dir_.get());
+    for (size_t i = 0; i < handles.size(); ++i) {
+      MutableEntry entry(&trans, GET_BY_HANDLE, handles[i]);
+      ASSERT_TRUE(entry.good());
+      entry.PutIsUnsynced(false);
+      entry.PutBaseVersion(1);
+    }
+  }
+  start = base::TimeTicks::HighResNow();
+  ASSERT_TRUE(SaveChangesTimingSnapshot(&snapshot_time));
+  save_time = base::TimeTicks::HighResNow() - start;
+  LOG(INFO) << "Saved " << kEntryCount << " updated entries in "
+            << save_time.InMillisecondsF() << " ms, holding the lock for "
+            << snapshot_time.InMillisecondsF() << " ms";
+}
+
 TEST_F(OnDiskSyncableDirectoryTest, TestSaveChangesFailure) {
   int64 handle1 = 0;
   // Set up an item using a regular, saveable directory.
@@ -2184,6 +2286,213 @@ TEST(SyncableDirectory, StressTransactions) {
   dir.Close();
 }
 
+// Reads an entry in a read transaction of its own.
+class ReadEntryDelegate : public base::PlatformThread::Delegate {
+ public:
+  ReadEntryDelegate(Directory* dir, int64 handle)
+      : dir_(dir),
+        handle_(handle),
+        read_(false) {}
+
+  bool read() const { return read_; }
+
+ private:
+  Directory* const dir_;
+  const int64 handle_;
+  bool read_;
+
+  // PlatformThread::Delegate methods:
+  virtual void ThreadMain() OVERRIDE {
+    ReadTransaction trans(FROM_HERE, dir_);
+    Entry entry(&trans, GET_BY_HANDLE, handle_);
+    read_ = entry.good() && entry.GetSpecifics().has_bookmark();
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ReadEntryDelegate);
+};
+
+TEST(SyncableDirectory, ConcurrentReadTransactions) {
+  base::MessageLoop message_loop;
+  FakeEncryptor encryptor;
+  TestUnrecoverableErrorHandler handler;
+  NullDirectoryChangeDelegate delegate;
+  std::string dirname = "concurrent";
+  Directory dir(new InMemoryDirectoryBackingStore(dirname),
+                &handler,
+                NULL,
+                NULL,
+                NULL);
+  dir.Open(dirname, &delegate, NullTransactionObserver());
+
+  int64 handle;
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, &dir);
+    MutableEntry entry(&trans, CREATE, BOOKMARKS, trans.root_id(), "entry");
+    ASSERT_TRUE(entry.good());
+    sync_pb::EntitySpecifics specifics;
+    AddDefaultFieldValue(BOOKMARKS, &specifics);
+    entry.PutSpecifics(specifics);
+    handle = entry.GetMetahandle();
+  }
+
+  // The thread would never get its read transaction if they were exclusive.
+  {
+    ReadTransaction trans(FROM_HERE, &dir);
+    ReadEntryDelegate reader(&dir, handle);
+    base::PlatformThreadHandle thread;
+    ASSERT_TRUE(base::PlatformThread::Create(0, &reader, &thread));
+    base::PlatformThread::Join(thread);
+    EXPECT_TRUE(reader.read());
+  }
+
+  dir.Close();
+}
+
+// Modifies entries in batches, each in its own write transaction, like the
+// syncer applying updates.
+class ApplyUpdatesDelegate : public base::PlatformThread::Delegate {
+ public:
+  ApplyUpdatesDelegate(Directory* dir,
+                       const std::vector<int64>& handles,
+                       size_t batch_size)
+      : dir_(dir),
+        handles_(handles),
+        batch_size_(batch_size),
+        done_(true, false) {}
+
+  bool done() { return done_.IsSignaled(); }
+
+ private:
+  Directory* const dir_;
+  const std::vector<int64> handles_;
+  const size_t batch_size_;
+  base::WaitableEvent done_;
+
+  // PlatformThread::Delegate methods:
+  virtual void ThreadMain() OVERRIDE {
+    for (size_t begin = 0; begin < handles_.size(); begin += batch_size_) {
+      WriteTransaction trans(FROM_HERE, SYNCER, dir_);
+      size_t end = std::min(handles_.size(), begin + batch_size_);
+      for (size_t i = begin; i < end; ++i) {
+        MutableEntry entry(&trans, GET_BY_HANDLE, handles_[i]);
+        CHECK(entry.good());
+        entry.PutServerVersion(entry.GetServerVersion() + 1);
+        entry.PutBaseVersion(entry.GetServerVersion());
+      }
+    }
+    done_.Signal();
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ApplyUpdatesDelegate);
+};
+
+// Holds read transactions for a while, like a model associator walking the
+// bookmarks.
+class SlowReaderDelegate : public base::PlatformThread::Delegate {
+ public:
+  explicit SlowReaderDelegate(Directory* dir)
+      : dir_(dir),
+        stop_(true, false) {}
+
+  void Stop() { stop_.Signal(); }
+
+ private:
+  Directory* const dir_;
+  base::WaitableEvent stop_;
+
+  // PlatformThread::Delegate methods:
+  virtual void ThreadMain() OVERRIDE {
+    while (!stop_.IsSignaled()) {
+      ReadTransaction trans(FROM_HERE, dir_);
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+    }
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(SlowReaderDelegate);
+};
+
+// Measures how long short read transactions, like those of the UI thread,
+// wait for the transaction lock while another thread applies updates to 10k
+// entries, and then while another thread holds long read transactions.  Too
+// slow to run by default.
+TEST(SyncableDirectory, DISABLED_ReadLatencyDuringUpdates) {
+  const int kEntryCount = 10000;
+  const size_t kBatchSize = 100;
+  const int kReadCount = 1000;
+  base::MessageLoop message_loop;
+  FakeEncryptor encryptor;
+  TestUnrecoverableErrorHandler handler;
+  NullDirectoryChangeDelegate delegate;
+  std::string dirname = "contention";
+  Directory dir(new InMemoryDirectoryBackingStore(dirname),
+                &handler,
+                NULL,
+                NULL,
+                NULL);
+  dir.Open(dirname, &delegate, NullTransactionObserver());
+
+  std::vector<int64> handles;
+  {
+    WriteTransaction trans(FROM_HERE, UNITTEST, &dir);
+    sync_pb::EntitySpecifics specifics;
+    AddDefaultFieldValue(BOOKMARKS, &specifics);
+    for (int i = 0; i < kEntryCount; ++i) {
+      MutableEntry entry(&trans, CREATE, BOOKMARKS, trans.root_id(),
+                         base::StringPrintf("Entry %d", i));
+      entry.PutSpecifics(specifics);
+      handles.push_back(entry.GetMetahandle());
+    }
+  }
+
+  ApplyUpdatesDelegate writer(&dir, handles, kBatchSize);
+  base::PlatformThreadHandle thread;
+  ASSERT_TRUE(base::PlatformThread::Create(0, &writer, &thread));
+  base::TimeDelta total;
+  base::TimeDelta longest;
+  int reads = 0;
+  while (!writer.done()) {
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    {
+      ReadTransaction trans(FROM_HERE, &dir);
+      Entry entry(&trans, GET_BY_HANDLE, handles[reads % kEntryCount]);
+      CHECK(entry.good());
+    }
+    base::TimeDelta latency = base::TimeTicks::HighResNow() - start;
+    total += latency;
+    longest = std::max(longest, latency);
+    ++reads;
+  }
+  base::PlatformThread::Join(thread);
+  if (reads) {
+    LOG(INFO) << "Read latency during updates: "
+              << total.InMicroseconds() / reads << " us on average, "
+              << longest.InMicroseconds() << " us at most, over " << reads
+              << " reads";
+  }
+
+  SlowReaderDelegate slow_reader(&dir);
+  ASSERT_TRUE(base::PlatformThread::Create(0, &slow_reader, &thread));
+  total = longest = base::TimeDelta();
+  for (int i = 0; i < kReadCount; ++i) {
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    {
+      ReadTransaction trans(FROM_HERE, &dir);
+      Entry entry(&trans, GET_BY_HANDLE, handles[i % kEntryCount]);
+      CHECK(entry.good());
+    }
+    base::TimeDelta latency = base::TimeTicks::HighResNow() - start;
+    total += latency;
+    longest = std::max(longest, latency);
+  }
+  slow_reader.Stop();
+  base::PlatformThread::Join(thread);
+  LOG(INFO) << "Read latency during slow reads: "
+            << total.InMicroseconds() / kReadCount << " us on average, "
+            << longest.InMicroseconds() << " us at most";
+
+  dir.Close();
+}
+
 class SyncableClientTagTest : public SyncableDirectoryTest {
  public:
   static const int kBaseVersion = 1;
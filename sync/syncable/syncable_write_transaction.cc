@@ -45,7 +45,7 @@ void WriteTransaction::TrackChangesTo(const EntryKernel* entry) {
 }
 
 ImmutableEntryKernelMutationMap WriteTransaction::RecordMutations() {
-  directory_->kernel_->transaction_mutex.AssertAcquired();
+  directory_->kernel_->transaction_mutex.AssertWriteAcquired();
   for (syncable::EntryKernelMutationMap::iterator it = mutations_.begin();
        it != mutations_.end();) {
     EntryKernel* kernel = directory()->GetEntryByHandle(it->first);
@@ -83,7 +83,7 @@ void WriteTransaction::UnlockAndNotify(
 
 ModelTypeSet WriteTransaction::NotifyTransactionChangingAndEnding(
     const ImmutableEntryKernelMutationMap& mutations) {
-  directory_->kernel_->transaction_mutex.AssertAcquired();
+  directory_->kernel_->transaction_mutex.AssertWriteAcquired();
   DCHECK(!mutations.Get().empty());
 
   WriteTransactionInfo write_transaction_info(
@@ -174,6 +174,7 @@ std::string WriterTagToString(WriterTag writer_tag) {
     ENUM_CASE(AUTHWATCHER);
     ENUM_CASE(UNITTEST);
     ENUM_CASE(VACUUM_AFTER_SAVE);
+    ENUM_CASE(SAVE_CHANGES);
     ENUM_CASE(HANDLE_SAVE_FAILURE);
     ENUM_CASE(PURGE_ENTRIES);
     ENUM_CASE(SYNCAPI);
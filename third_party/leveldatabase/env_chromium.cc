@@ -30,6 +30,11 @@ const base::FilePath::CharType table_extension[] = FILE_PATH_LITERAL(".ldb");
 static const base::FilePath::CharType kLevelDBTestDirectoryPrefix[]
     = FILE_PATH_LITERAL("leveldb-test-");
 
+// All the databases opened with an env share its background threads, so with
+// a single thread, a large compaction of one database holds up the memtable
+// flushes of every other one.
+const int kDefaultMaxBackgroundThreads = 4;
+
 class ChromiumFileLock : public FileLock {
  public:
   ::base::File file_;
@@ -352,8 +357,10 @@ bool ChromiumEnv::HasTableExtension(const base::FilePath& path)
 ChromiumEnv::ChromiumEnv()
     : name_("LevelDBEnv"),
       make_backup_(false),
+      max_bg_threads_(kDefaultMaxBackgroundThreads),
       bgsignal_(&mu_),
-      started_bgthread_(false),
+      bg_threads_(0),
+      idle_bg_threads_(0),
       kMaxRetryTimeMillis(1000) {
 }
 
@@ -777,23 +784,22 @@ class Thread : public ::base::PlatformThread::Delegate {
 void ChromiumEnv::Schedule(void (*function)(void*), void* arg) {
   mu_.Acquire();
 
-  // Start background thread if necessary
-  if (!started_bgthread_) {
-    started_bgthread_ = true;
-    StartThread(&ChromiumEnv::BGThreadWrapper, this);
-  }
-
-  // If the queue is currently empty, the background thread may currently be
-  // waiting.
-  if (queue_.empty()) {
-    bgsignal_.Signal();
-  }
-
   // Add to priority queue
   queue_.push_back(BGItem());
   queue_.back().function = function;
   queue_.back().arg = arg;
 
+  // Start another background thread if the waiting ones can't take all the
+  // queued work.
+  if (queue_.size() > static_cast<size_t>(idle_bg_threads_) &&
+      bg_threads_ < max_bg_threads_) {
+    ++bg_threads_;
+    StartThread(&ChromiumEnv::BGThreadWrapper, this);
+  }
+
+  // Wake up a waiting background thread, if any.
+  bgsignal_.Signal();
+
   mu_.Release();
 }
 
@@ -803,9 +809,11 @@ void ChromiumEnv::BGThread() {
   while (true) {
     // Wait until there is an item that is ready to run
     mu_.Acquire();
+    ++idle_bg_threads_;
     while (queue_.empty()) {
       bgsignal_.Wait();
     }
+    --idle_bg_threads_;
 
     void (*function)(void*) = queue_.front().function;
     void* arg = queue_.front().arg;
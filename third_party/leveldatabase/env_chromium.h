@@ -145,6 +145,10 @@ class ChromiumEnv : public leveldb::Env,
 
   std::string name_;
   bool make_backup_;
+  // The most threads Schedule() runs background work on. Threads are started
+  // only when work is waiting and every running thread is busy, so an env
+  // with a single database open rarely uses more than one.
+  int max_bg_threads_;
 
  private:
   // File locks may not be exclusive within a process (e.g. on POSIX). Track
@@ -192,7 +196,10 @@ class ChromiumEnv : public leveldb::Env,
 
   ::base::Lock mu_;
   ::base::ConditionVariable bgsignal_;
-  bool started_bgthread_;
+  // Number of background threads started, and how many of them are waiting
+  // for work.
+  int bg_threads_;
+  int idle_bg_threads_;
 
   // Entry per Schedule() call
   struct BGItem {
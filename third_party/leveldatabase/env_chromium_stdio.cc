@@ -4,7 +4,12 @@
 
 #include <errno.h>
 
+#include <algorithm>
+
 #include "base/debug/trace_event.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/strings/utf_string_conversions.h"
@@ -28,6 +33,13 @@ namespace leveldb_env {
 
 namespace {
 
+#if defined(ARCH_CPU_64_BITS)
+const uint64_t kDefaultMaxMmapBytes = 1024 * 1024 * 1024;
+#else
+// Address space is too scarce in 32-bit processes to map tables.
+const uint64_t kDefaultMaxMmapBytes = 0;
+#endif
+
 #if (defined(OS_POSIX) && !defined(OS_LINUX)) || defined(OS_WIN)
 // The following are glibc-specific
 
@@ -131,8 +143,64 @@ class ChromiumRandomAccessFile : public RandomAccessFile {
   }
 };
 
+// Tables are never modified once written, so they can be read through a
+// read-only mapping.
+class ChromiumMmapReadableFile : public RandomAccessFile {
+ private:
+  std::string filename_;
+  scoped_ptr< ::base::MemoryMappedFile> mapped_file_;
+  MmapLimiter* limiter_;
+  uint64_t reserved_bytes_;
+
+ public:
+  ChromiumMmapReadableFile(const std::string& fname,
+                           scoped_ptr< ::base::MemoryMappedFile> mapped_file,
+                           MmapLimiter* limiter,
+                           uint64_t reserved_bytes)
+      : filename_(fname),
+        mapped_file_(mapped_file.Pass()),
+        limiter_(limiter),
+        reserved_bytes_(reserved_bytes) {}
+  virtual ~ChromiumMmapReadableFile() {
+    mapped_file_.reset();
+    limiter_->Release(reserved_bytes_);
+  }
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result, char* scratch)
+      const {
+    // Like a pread(), reading past the end of the file returns what's left.
+    size_t length = mapped_file_->length();
+    if (offset >= length) {
+      *result = Slice();
+    } else {
+      const char* data =
+          reinterpret_cast<const char*>(mapped_file_->data()) + offset;
+      *result = Slice(data, std::min<uint64_t>(n, length - offset));
+    }
+    return Status::OK();
+  }
+};
+
 }  // unnamed namespace
 
+MmapLimiter::MmapLimiter() : bytes_in_use_(0) {}
+
+MmapLimiter::~MmapLimiter() { DCHECK_EQ(0u, bytes_in_use_); }
+
+bool MmapLimiter::Acquire(uint64_t bytes, uint64_t max_bytes) {
+  base::AutoLock auto_lock(lock_);
+  if (bytes > max_bytes || bytes_in_use_ > max_bytes - bytes)
+    return false;
+  bytes_in_use_ += bytes;
+  return true;
+}
+
+void MmapLimiter::Release(uint64_t bytes) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK_LE(bytes, bytes_in_use_);
+  bytes_in_use_ -= bytes;
+}
+
 ChromiumWritableFile::ChromiumWritableFile(const std::string& fname,
                                            FILE* f,
                                            const UMALogger* uma_logger,
@@ -243,7 +311,8 @@ Status ChromiumWritableFile::Sync() {
   return result;
 }
 
-ChromiumEnvStdio::ChromiumEnvStdio() {}
+ChromiumEnvStdio::ChromiumEnvStdio()
+    : max_mmap_bytes_(kDefaultMaxMmapBytes) {}
 
 ChromiumEnvStdio::~ChromiumEnvStdio() {}
 
@@ -274,7 +343,24 @@ void ChromiumEnvStdio::RecordOpenFilesLimit(const std::string& type) {
 Status ChromiumEnvStdio::NewRandomAccessFile(const std::string& fname,
                                              RandomAccessFile** result) {
   int flags = ::base::File::FLAG_READ | ::base::File::FLAG_OPEN;
-  ::base::File file(ChromiumEnv::CreateFilePath(fname), flags);
+  base::FilePath path = ChromiumEnv::CreateFilePath(fname);
+  ::base::File file(path, flags);
+  if (file.IsValid()) {
+    int64 length = file.GetLength();
+    if (length > 0 && mmap_limiter_.Acquire(length, max_mmap_bytes_)) {
+      scoped_ptr< ::base::MemoryMappedFile> mapped_file(
+          new ::base::MemoryMappedFile);
+      if (mapped_file->Initialize(file.Pass())) {
+        *result = new ChromiumMmapReadableFile(
+            fname, mapped_file.Pass(), &mmap_limiter_, length);
+        RecordOpenFilesLimit("Success");
+        return Status::OK();
+      }
+      // The mapping took the file with it; read it the usual way instead.
+      mmap_limiter_.Release(length);
+      file.Initialize(path, flags);
+    }
+  }
   if (file.IsValid()) {
     *result = new ChromiumRandomAccessFile(fname, file.Pass(), this);
     RecordOpenFilesLimit("Success");
@@ -39,6 +39,25 @@ class ChromiumWritableFile : public leveldb::WritableFile {
   bool make_backup_;
 };
 
+// Tracks the number of bytes of files that are memory mapped, so that many
+// open tables can't use up the address space of the process.
+class MmapLimiter {
+ public:
+  MmapLimiter();
+  ~MmapLimiter();
+
+  // Reserves |bytes| if they fit in a budget of |max_bytes|. Returns false if
+  // they don't, and the file should be read without being mapped.
+  bool Acquire(uint64_t bytes, uint64_t max_bytes);
+  void Release(uint64_t bytes);
+
+ private:
+  ::base::Lock lock_;
+  uint64_t bytes_in_use_;
+
+  DISALLOW_COPY_AND_ASSIGN(MmapLimiter);
+};
+
 class ChromiumEnvStdio : public ChromiumEnv {
  public:
   ChromiumEnvStdio();
@@ -59,6 +78,11 @@ class ChromiumEnvStdio : public ChromiumEnv {
       const base::FilePath& dir_param,
       std::vector<base::FilePath>* result) const;
 
+  // The most bytes of random access files, i.e. tables, that are memory
+  // mapped at once. Reads from mapped tables don't copy blocks out of the page
+  // cache. Files that don't fit are read with pread(). Zero disables mapping.
+  uint64_t max_mmap_bytes_;
+
  private:
   // BGThread() is the body of the background thread
   void BGThread();
@@ -66,6 +90,8 @@ class ChromiumEnvStdio : public ChromiumEnv {
     reinterpret_cast<ChromiumEnvStdio*>(arg)->BGThread();
   }
   void RecordOpenFilesLimit(const std::string& type);
+
+  MmapLimiter mmap_limiter_;
 };
 
 }  // namespace leveldb_env
@@ -7,7 +7,13 @@
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/test/test_suite.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
 #include "env_chromium_stdio.h"
 #if defined(OS_WIN)
 #include "env_chromium_win.h"
@@ -255,4 +261,218 @@ TEST(ChromiumEnv, GetChildrenPriorResults) {
   EXPECT_EQ(1, result.size());
 }
 
+class TestEnvStdio : public ChromiumEnvStdio {
+ public:
+  TestEnvStdio(int max_bg_threads, uint64_t max_mmap_bytes) {
+    max_bg_threads_ = max_bg_threads;
+    max_mmap_bytes_ = max_mmap_bytes;
+  }
+};
+
+std::string WriteTestFile(const base::FilePath& dir, size_t size) {
+  base::FilePath path = dir.Append(FPL("000005.ldb"));
+  std::string contents;
+  for (size_t i = 0; i < size; ++i)
+    contents.push_back('a' + i % 26);
+  EXPECT_EQ(static_cast<int>(size),
+            file_util::WriteFile(path, contents.data(), size));
+  return FilePathToString(path);
+}
+
+TEST(ChromiumEnvStdio, MmapReads) {
+  base::ScopedTempDir scoped_temp_dir;
+  ASSERT_TRUE(scoped_temp_dir.CreateUniqueTempDir());
+  std::string fname = WriteTestFile(scoped_temp_dir.path(), 100);
+
+  TestEnvStdio env(1, 1024);
+  RandomAccessFile* file_ptr;
+  Status s = env.NewRandomAccessFile(fname, &file_ptr);
+  ASSERT_TRUE(s.ok()) << s.ToString();
+  scoped_ptr<RandomAccessFile> file(file_ptr);
+
+  char scratch[100];
+  Slice result;
+  EXPECT_TRUE(file->Read(26, 3, &result, scratch).ok());
+  EXPECT_EQ("abc", result.ToString());
+  // A mapped file hands out its own memory instead of copying to |scratch|.
+  EXPECT_NE(scratch, result.data());
+
+  // Reads are cut short at the end of the file.
+  EXPECT_TRUE(file->Read(98, 10, &result, scratch).ok());
+  EXPECT_EQ("uv", result.ToString());
+  EXPECT_TRUE(file->Read(100, 10, &result, scratch).ok());
+  EXPECT_EQ(0u, result.size());
+}
+
+TEST(ChromiumEnvStdio, MmapBudget) {
+  base::ScopedTempDir scoped_temp_dir;
+  ASSERT_TRUE(scoped_temp_dir.CreateUniqueTempDir());
+  std::string fname = WriteTestFile(scoped_temp_dir.path(), 100);
+
+  TestEnvStdio env(1, 150);
+  RandomAccessFile* mapped_ptr;
+  ASSERT_TRUE(env.NewRandomAccessFile(fname, &mapped_ptr).ok());
+  scoped_ptr<RandomAccessFile> mapped(mapped_ptr);
+
+  // The second file doesn't fit in the budget, and is read into |scratch|.
+  RandomAccessFile* unmapped_ptr;
+  ASSERT_TRUE(env.NewRandomAccessFile(fname, &unmapped_ptr).ok());
+  scoped_ptr<RandomAccessFile> unmapped(unmapped_ptr);
+  char scratch[3];
+  Slice result;
+  EXPECT_TRUE(unmapped->Read(26, 3, &result, scratch).ok());
+  EXPECT_EQ("abc", result.ToString());
+  EXPECT_EQ(scratch, result.data());
+
+  // Closing the mapped file gives its bytes back.
+  mapped.reset();
+  ASSERT_TRUE(env.NewRandomAccessFile(fname, &mapped_ptr).ok());
+  mapped.reset(mapped_ptr);
+  EXPECT_TRUE(mapped->Read(26, 3, &result, scratch).ok());
+  EXPECT_NE(scratch, result.data());
+}
+
+struct ScheduleCounter {
+  static void Increment(void* arg) {
+    ScheduleCounter* counter = static_cast<ScheduleCounter*>(arg);
+    base::AutoLock auto_lock(counter->lock);
+    if (++counter->count == counter->expected_count)
+      counter->done.Signal();
+  }
+
+  explicit ScheduleCounter(int expected_count)
+      : count(0), expected_count(expected_count), done(false, false) {}
+
+  base::Lock lock;
+  int count;
+  int expected_count;
+  base::WaitableEvent done;
+};
+
+TEST(ChromiumEnvStdio, ScheduleRunsEverything) {
+  // Leaked, as background threads never exit.
+  TestEnvStdio* env = new TestEnvStdio(4, 0);
+
+  const int kItems = 100;
+  ScheduleCounter counter(kItems);
+  for (int i = 0; i < kItems; ++i)
+    env->Schedule(&ScheduleCounter::Increment, &counter);
+  counter.done.Wait();
+  base::AutoLock auto_lock(counter.lock);
+  EXPECT_EQ(kItems, counter.count);
+}
+
+// db_bench style benchmarks of the env. They're disabled as they take a while;
+// run them with --gtest_also_run_disabled_tests.
+
+std::string BenchmarkKey(int i) {
+  return base::StringPrintf("%016d", i);
+}
+
+// Fills a database with |num_keys| entries, compacts it to tables and times
+// uncached random reads, which go through NewRandomAccessFile().
+void RunReadRandomBenchmark(uint64_t max_mmap_bytes) {
+  const int kNumKeys = 200000;
+  const int kNumReads = 200000;
+  base::ScopedTempDir scoped_temp_dir;
+  ASSERT_TRUE(scoped_temp_dir.CreateUniqueTempDir());
+
+  Options options;
+  options.create_if_missing = true;
+  // Leaked, as background threads never exit.
+  options.env = new TestEnvStdio(1, max_mmap_bytes);
+  DB* db_ptr;
+  Status s = DB::Open(options, scoped_temp_dir.path().AsUTF8Unsafe(), &db_ptr);
+  ASSERT_TRUE(s.ok()) << s.ToString();
+  scoped_ptr<DB> db(db_ptr);
+
+  std::string value(100, 'x');
+  for (int i = 0; i < kNumKeys; ++i)
+    ASSERT_TRUE(db->Put(WriteOptions(), BenchmarkKey(i), value).ok());
+  db->CompactRange(NULL, NULL);
+
+  ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::string read_value;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumReads; ++i) {
+    int key = (i * 7919) % kNumKeys;
+    ASSERT_TRUE(db->Get(read_options, BenchmarkKey(key), &read_value).ok());
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  LOG(INFO) << "readrandom, max_mmap_bytes=" << max_mmap_bytes << ": "
+            << static_cast<double>(elapsed.InMicroseconds()) / kNumReads
+            << " micros/op";
+}
+
+TEST(ChromiumEnvStdio, DISABLED_ReadRandomBenchmark) {
+  RunReadRandomBenchmark(0);
+  RunReadRandomBenchmark(1024 * 1024 * 1024);
+}
+
+class FillDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  FillDelegate(DB* db, int num_keys) : db_(db), num_keys_(num_keys) {}
+
+  virtual void Run() OVERRIDE {
+    std::string value(1000, 'x');
+    for (int i = 0; i < num_keys_; ++i) {
+      // Scatter the keys so that compactions rewrite overlapping tables.
+      int key = (i * 7919) % num_keys_;
+      EXPECT_TRUE(db_->Put(WriteOptions(), BenchmarkKey(key), value).ok());
+    }
+  }
+
+ private:
+  DB* db_;
+  int num_keys_;
+};
+
+// Times filling several databases sharing an env at once. Writers stall when
+// too many memtables wait to be compacted, so this measures how well the
+// background threads keep up.
+void RunFillConcurrentBenchmark(int max_bg_threads) {
+  const int kNumDatabases = 8;
+  const int kNumKeys = 50000;
+  base::ScopedTempDir scoped_temp_dir;
+  ASSERT_TRUE(scoped_temp_dir.CreateUniqueTempDir());
+
+  Options options;
+  options.create_if_missing = true;
+  options.write_buffer_size = 256 * 1024;
+  // Leaked, as background threads never exit.
+  options.env = new TestEnvStdio(max_bg_threads, 0);
+
+  ScopedVector<DB> dbs;
+  ScopedVector<FillDelegate> delegates;
+  for (int i = 0; i < kNumDatabases; ++i) {
+    base::FilePath path =
+        scoped_temp_dir.path().AppendASCII(base::StringPrintf("db%d", i));
+    DB* db;
+    Status s = DB::Open(options, path.AsUTF8Unsafe(), &db);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+    dbs.push_back(db);
+    delegates.push_back(new FillDelegate(db, kNumKeys));
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int i = 0; i < kNumDatabases; ++i) {
+    threads.push_back(new base::DelegateSimpleThread(delegates[i], "Filler"));
+    threads.back()->Start();
+  }
+  for (int i = 0; i < kNumDatabases; ++i)
+    threads[i]->Join();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  LOG(INFO) << "fillconcurrent, max_bg_threads=" << max_bg_threads << ": "
+            << static_cast<double>(elapsed.InMicroseconds()) /
+                   (kNumDatabases * kNumKeys)
+            << " micros/op";
+}
+
+TEST(ChromiumEnvStdio, DISABLED_FillConcurrentBenchmark) {
+  RunFillConcurrentBenchmark(1);
+  RunFillConcurrentBenchmark(4);
+}
+
 int main(int argc, char** argv) { return base::TestSuite(argc, argv).Run(); }
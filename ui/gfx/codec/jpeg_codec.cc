@@ -10,6 +10,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColorPriv.h"
+#include "ui/gfx/rect.h"
 
 extern "C" {
 #if defined(USE_SYSTEM_LIBJPEG)
@@ -455,11 +456,27 @@ class DecompressDestroyer {
   jpeg_decompress_struct* cinfo_;
 };
 
-}  // namespace
+// Returns the largest of 1, 2, 4 and 8 that can divide |full_w| x |full_h| and
+// still leave an image of at least |min_w| x |min_h|. libjpeg rounds scaled
+// dimensions up, so this does too. Only powers of two are used since those are
+// the only scales every libjpeg variant we build against supports.
+int ChooseScaleDenominator(int full_w, int full_h, int min_w, int min_h) {
+  int denom = 1;
+  while (denom < 8 &&
+         (full_w + 2 * denom - 1) / (2 * denom) >= min_w &&
+         (full_h + 2 * denom - 1) / (2 * denom) >= min_h) {
+    denom *= 2;
+  }
+  return denom;
+}
 
-bool JPEGCodec::Decode(const unsigned char* input, size_t input_size,
-                       ColorFormat format, std::vector<unsigned char>* output,
-                       int* w, int* h) {
+// Shared implementation of JPEGCodec::Decode() and JPEGCodec::DecodeScaled().
+// Decodes at 1/|scale_denom| of the full size, and if |crop| is not NULL, only
+// keeps its intersection with the image (|crop| is in full size coordinates).
+bool DecodeImpl(const unsigned char* input, size_t input_size,
+                JPEGCodec::ColorFormat format, int min_w, int min_h,
+                const Rect* crop, std::vector<unsigned char>* output,
+                int* w, int* h) {
   jpeg_decompress_struct cinfo;
   DecompressDestroyer destroyer;
   destroyer.SetManagedObject(&cinfo);
@@ -509,15 +526,17 @@ bool JPEGCodec::Decode(const unsigned char* input, size_t input_size,
       // Same as JPEGCodec::Encode(), libjpeg-turbo supports all input formats
       // used by Chromium (i.e. RGB, RGBA, and BGRA) and we just map the input
       // parameters to a colorspace.
-      if (format == FORMAT_RGB) {
+      if (format == JPEGCodec::FORMAT_RGB) {
         cinfo.out_color_space = JCS_RGB;
         cinfo.output_components = 3;
-      } else if (format == FORMAT_RGBA ||
-                 (format == FORMAT_SkBitmap && SK_R32_SHIFT == 0)) {
+      } else if (format == JPEGCodec::FORMAT_RGBA ||
+                 (format == JPEGCodec::FORMAT_SkBitmap &&
+                  SK_R32_SHIFT == 0)) {
         cinfo.out_color_space = JCS_EXT_RGBX;
         cinfo.output_components = 4;
-      } else if (format == FORMAT_BGRA ||
-                 (format == FORMAT_SkBitmap && SK_B32_SHIFT == 0)) {
+      } else if (format == JPEGCodec::FORMAT_BGRA ||
+                 (format == JPEGCodec::FORMAT_SkBitmap &&
+                  SK_B32_SHIFT == 0)) {
         cinfo.out_color_space = JCS_EXT_BGRX;
         cinfo.output_components = 4;
       } else {
@@ -542,73 +561,123 @@ bool JPEGCodec::Decode(const unsigned char* input, size_t input_size,
   cinfo.output_components = 3;
 #endif
 
+  // Let the DCT produce the reduced size image directly; this skips most of
+  // the IDCT work as well as the full size output buffer.
+  const int scale_denom = ChooseScaleDenominator(
+      cinfo.image_width, cinfo.image_height, min_w, min_h);
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale_denom;
+
   jpeg_calc_output_dimensions(&cinfo);
-  *w = cinfo.output_width;
-  *h = cinfo.output_height;
+  const int output_width = cinfo.output_width;
+  const int output_height = cinfo.output_height;
+
+  // Map the crop rectangle to the scaled image, rounding outwards.
+  Rect region(output_width, output_height);
+  if (crop) {
+    Rect scaled_crop(
+        crop->x() / scale_denom,
+        crop->y() / scale_denom,
+        (crop->right() + scale_denom - 1) / scale_denom -
+            crop->x() / scale_denom,
+        (crop->bottom() + scale_denom - 1) / scale_denom -
+            crop->y() / scale_denom);
+    region.Intersect(scaled_crop);
+    if (region.IsEmpty())
+      return false;
+  }
+  *w = region.width();
+  *h = region.height();
+
+  // Work out how each decoded row becomes a row of |output|.
+  int bytes_per_output_pixel;
+  void (*converter)(const unsigned char* rgb, int w, unsigned char* out) =
+      NULL;
+#ifdef JCS_EXTENSIONS
+  // libjpeg-turbo writes the requested format directly, same as
+  // JPEGCodec::Encode().
+  bytes_per_output_pixel = cinfo.output_components;
+#else
+  if (format == JPEGCodec::FORMAT_RGB) {
+    // easy case, row needs no conversion
+    bytes_per_output_pixel = 3;
+  } else if (format == JPEGCodec::FORMAT_RGBA ||
+             (format == JPEGCodec::FORMAT_SkBitmap && SK_R32_SHIFT == 0)) {
+    bytes_per_output_pixel = 4;
+    converter = AddAlpha;
+  } else if (format == JPEGCodec::FORMAT_BGRA ||
+             (format == JPEGCodec::FORMAT_SkBitmap && SK_B32_SHIFT == 0)) {
+    bytes_per_output_pixel = 4;
+    converter = RGBtoBGRA;
+  } else {
+    NOTREACHED() << "Invalid pixel format";
+    return false;
+  }
+#endif
 
   jpeg_start_decompress(&cinfo);
 
   // FIXME(brettw) we may want to allow the capability for callers to request
   // how to align row lengths as we do for the compressor.
-  int row_read_stride = cinfo.output_width * cinfo.output_components;
-
-#ifdef JCS_EXTENSIONS
-  // Create memory for a decoded image and write decoded lines to the memory
-  // without conversions same as JPEGCodec::Encode().
-  int row_write_stride = row_read_stride;
-  output->resize(row_write_stride * cinfo.output_height);
-
-  for (int row = 0; row < static_cast<int>(cinfo.output_height); row++) {
-    unsigned char* rowptr = &(*output)[row * row_write_stride];
+  int row_read_stride = output_width * cinfo.output_components;
+  int row_write_stride = region.width() * bytes_per_output_pixel;
+  output->resize(row_write_stride * region.height());
+
+  // Rows which need neither conversion nor horizontal cropping are decoded
+  // straight into |output|; all others go through a temporary row.
+  const bool decode_in_place = !converter && region.width() == output_width;
+  scoped_ptr<unsigned char[]> row_data;
+  if (!decode_in_place || region.y() > 0)
+    row_data.reset(new unsigned char[row_read_stride]);
+
+  for (int row = 0; row < region.bottom(); row++) {
+    const bool keep = row >= region.y();
+    unsigned char* dest =
+        keep ? &(*output)[(row - region.y()) * row_write_stride] : NULL;
+    unsigned char* rowptr = keep && decode_in_place ? dest : row_data.get();
     if (!jpeg_read_scanlines(&cinfo, &rowptr, 1))
       return false;
+    if (!keep || decode_in_place)
+      continue;
+
+    const unsigned char* src =
+        rowptr + region.x() * cinfo.output_components;
+    if (converter)
+      converter(src, region.width(), dest);
+    else
+      memcpy(dest, src, row_write_stride);
   }
-#else
-  if (format == FORMAT_RGB) {
-    // easy case, row needs no conversion
-    int row_write_stride = row_read_stride;
-    output->resize(row_write_stride * cinfo.output_height);
 
-    for (int row = 0; row < static_cast<int>(cinfo.output_height); row++) {
-      unsigned char* rowptr = &(*output)[row * row_write_stride];
-      if (!jpeg_read_scanlines(&cinfo, &rowptr, 1))
-        return false;
-    }
+  if (region.bottom() < output_height) {
+    // Don't decode the rows below the crop rectangle.
+    jpeg_abort_decompress(&cinfo);
   } else {
-    // Rows need conversion to output format: read into a temporary buffer and
-    // expand to the final one. Performance: we could avoid the extra
-    // allocation by doing the expansion in-place.
-    int row_write_stride;
-    void (*converter)(const unsigned char* rgb, int w, unsigned char* out);
-    if (format == FORMAT_RGBA ||
-        (format == FORMAT_SkBitmap && SK_R32_SHIFT == 0)) {
-      row_write_stride = cinfo.output_width * 4;
-      converter = AddAlpha;
-    } else if (format == FORMAT_BGRA ||
-               (format == FORMAT_SkBitmap && SK_B32_SHIFT == 0)) {
-      row_write_stride = cinfo.output_width * 4;
-      converter = RGBtoBGRA;
-    } else {
-      NOTREACHED() << "Invalid pixel format";
-      jpeg_destroy_decompress(&cinfo);
-      return false;
-    }
+    jpeg_finish_decompress(&cinfo);
+  }
+  return true;
+}
 
-    output->resize(row_write_stride * cinfo.output_height);
+// Copies |w| x |h| pixels of FORMAT_SkBitmap |data| into a new SkBitmap.
+SkBitmap* CreateBitmap(const std::vector<unsigned char>& data, int w, int h) {
+  // Skia only handles 32 bit images.
+  int data_length = w * h * 4;
 
-    scoped_ptr<unsigned char[]> row_data(new unsigned char[row_read_stride]);
-    unsigned char* rowptr = row_data.get();
-    for (int row = 0; row < static_cast<int>(cinfo.output_height); row++) {
-      if (!jpeg_read_scanlines(&cinfo, &rowptr, 1))
-        return false;
-      converter(rowptr, *w, &(*output)[row * row_write_stride]);
-    }
-  }
-#endif
+  SkBitmap* bitmap = new SkBitmap();
+  bitmap->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+  bitmap->allocPixels();
+  memcpy(bitmap->getAddr32(0, 0), &data[0], data_length);
 
-  jpeg_finish_decompress(&cinfo);
-  jpeg_destroy_decompress(&cinfo);
-  return true;
+  return bitmap;
+}
+
+}  // namespace
+
+bool JPEGCodec::Decode(const unsigned char* input, size_t input_size,
+                       ColorFormat format, std::vector<unsigned char>* output,
+                       int* w, int* h) {
+  // A minimum size larger than any JPEG keeps the image at full scale.
+  return DecodeImpl(input, input_size, format, kint32max, kint32max, NULL,
+                    output, w, h);
 }
 
 // static
@@ -618,15 +687,31 @@ SkBitmap* JPEGCodec::Decode(const unsigned char* input, size_t input_size) {
   if (!Decode(input, input_size, FORMAT_SkBitmap, &data_vector, &w, &h))
     return NULL;
 
-  // Skia only handles 32 bit images.
-  int data_length = w * h * 4;
+  return CreateBitmap(data_vector, w, h);
+}
 
-  SkBitmap* bitmap = new SkBitmap();
-  bitmap->setConfig(SkBitmap::kARGB_8888_Config, w, h);
-  bitmap->allocPixels();
-  memcpy(bitmap->getAddr32(0, 0), &data_vector[0], data_length);
+// static
+bool JPEGCodec::DecodeScaled(const unsigned char* input, size_t input_size,
+                             ColorFormat format, int min_w, int min_h,
+                             const Rect* crop,
+                             std::vector<unsigned char>* output,
+                             int* w, int* h) {
+  return DecodeImpl(input, input_size, format, min_w, min_h, crop, output,
+                    w, h);
+}
 
-  return bitmap;
+// static
+SkBitmap* JPEGCodec::DecodeScaled(const unsigned char* input,
+                                  size_t input_size,
+                                  int min_w, int min_h) {
+  int w, h;
+  std::vector<unsigned char> data_vector;
+  if (!DecodeScaled(input, input_size, FORMAT_SkBitmap, min_w, min_h, NULL,
+                    &data_vector, &w, &h)) {
+    return NULL;
+  }
+
+  return CreateBitmap(data_vector, w, h);
 }
 
 }  // namespace gfx
@@ -14,6 +14,8 @@ class SkBitmap;
 
 namespace gfx {
 
+class Rect;
+
 // Interface for encoding/decoding JPEG data. This is a wrapper around libjpeg,
 // which has an inconvenient interface for callers. This is only used for UI
 // elements, WebKit has its own more complicated JPEG decoder which handles,
@@ -72,6 +74,28 @@ class GFX_EXPORT JPEGCodec {
   // successful, a SkBitmap is created and returned. It is up to the caller
   // to delete the returned bitmap.
   static SkBitmap* Decode(const unsigned char* input, size_t input_size);
+
+  // Like Decode() above, but uses libjpeg's DCT scaling to decode directly at
+  // the smallest of 1/1, 1/2, 1/4 and 1/8 scale whose dimensions are still at
+  // least |min_w| x |min_h|. This is much cheaper in both time and memory than
+  // decoding at full size and downscaling, but callers still need to resize
+  // the result to their exact target size.
+  //
+  // If |crop| is not NULL, only that region of the image (given in full size
+  // image coordinates, and clipped to the image) is written to |output|, and
+  // rows below it are not decoded at all. Fails if the region is empty.
+  //
+  // *w and *h are set to the dimensions of |output|.
+  static bool DecodeScaled(const unsigned char* input, size_t input_size,
+                           ColorFormat format, int min_w, int min_h,
+                           const Rect* crop,
+                           std::vector<unsigned char>* output,
+                           int* w, int* h);
+
+  // SkBitmap version of DecodeScaled(), without cropping. It is up to the
+  // caller to delete the returned bitmap.
+  static SkBitmap* DecodeScaled(const unsigned char* input, size_t input_size,
+                                int min_w, int min_h);
 };
 
 }  // namespace gfx
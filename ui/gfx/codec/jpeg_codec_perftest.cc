@@ -0,0 +1,108 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares decoding a camera sized JPEG at full size and then downscaling it
+// with decoding it directly at a reduced size (JPEGCodec::DecodeScaled()) and
+// downscaling only the remainder. Reports the time taken and the size of the
+// largest decoded image held in memory, which dominates the peak memory use.
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "skia/ext/image_operations.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/codec/jpeg_codec.h"
+
+namespace gfx {
+
+namespace {
+
+// A 12 megapixel image, as produced by a typical phone camera.
+const int kSourceWidth = 4000;
+const int kSourceHeight = 3000;
+const int kJpegQuality = 90;
+const int kIterations = 5;
+
+// Encodes an image with smooth gradients plus some texture, so that the
+// entropy coded data is closer to a photo than a flat image would be.
+void MakeCameraImage(std::vector<unsigned char>* encoded) {
+  std::vector<unsigned char> pixels(kSourceWidth * kSourceHeight * 3);
+  for (int y = 0; y < kSourceHeight; y++) {
+    for (int x = 0; x < kSourceWidth; x++) {
+      unsigned char* px = &pixels[(y * kSourceWidth + x) * 3];
+      px[0] = static_cast<unsigned char>(x * 255 / kSourceWidth);
+      px[1] = static_cast<unsigned char>(y * 255 / kSourceHeight);
+      px[2] = static_cast<unsigned char>((x ^ y) & 0x3f);
+    }
+  }
+  ASSERT_TRUE(JPEGCodec::Encode(&pixels[0], JPEGCodec::FORMAT_RGB,
+                                kSourceWidth, kSourceHeight,
+                                kSourceWidth * 3, kJpegQuality, encoded));
+}
+
+size_t BitmapBytes(const SkBitmap& bitmap) {
+  return bitmap.rowBytes() * bitmap.height();
+}
+
+void RunDecodeBenchmark(const std::vector<unsigned char>& encoded,
+                        int target_width,
+                        int target_height) {
+  const std::string trace =
+      base::StringPrintf("%dx%d", target_width, target_height);
+
+  base::TimeDelta full_time;
+  base::TimeDelta scaled_time;
+  size_t full_bytes = 0;
+  size_t scaled_bytes = 0;
+  for (int i = 0; i < kIterations; ++i) {
+    base::TimeTicks start = base::TimeTicks::HighResNow();
+    scoped_ptr<SkBitmap> full(JPEGCodec::Decode(&encoded[0], encoded.size()));
+    ASSERT_TRUE(full.get());
+    SkBitmap resized = skia::ImageOperations::Resize(
+        *full, skia::ImageOperations::RESIZE_GOOD,
+        target_width, target_height);
+    full_time += base::TimeTicks::HighResNow() - start;
+    full_bytes = BitmapBytes(*full);
+
+    start = base::TimeTicks::HighResNow();
+    scoped_ptr<SkBitmap> scaled(JPEGCodec::DecodeScaled(
+        &encoded[0], encoded.size(), target_width, target_height));
+    ASSERT_TRUE(scaled.get());
+    resized = skia::ImageOperations::Resize(
+        *scaled, skia::ImageOperations::RESIZE_GOOD,
+        target_width, target_height);
+    scaled_time += base::TimeTicks::HighResNow() - start;
+    scaled_bytes = BitmapBytes(*scaled);
+  }
+
+  perf_test::PrintResult("jpeg_decode_resize", "_full", trace,
+                         full_time.InMillisecondsF() / kIterations, "ms",
+                         true);
+  perf_test::PrintResult("jpeg_decode_resize", "_scaled", trace,
+                         scaled_time.InMillisecondsF() / kIterations, "ms",
+                         true);
+  perf_test::PrintResult("jpeg_decode_peak_bytes", "_full", trace,
+                         full_bytes, "bytes", true);
+  perf_test::PrintResult("jpeg_decode_peak_bytes", "_scaled", trace,
+                         scaled_bytes, "bytes", true);
+}
+
+}  // namespace
+
+TEST(JPEGCodecPerfTest, DecodeAndResize) {
+  std::vector<unsigned char> encoded;
+  MakeCameraImage(&encoded);
+  ASSERT_FALSE(encoded.empty());
+
+  // Thumbnail, screen and half resolution targets.
+  const int kTargets[][2] = { { 320, 240 }, { 1280, 960 }, { 2000, 1500 } };
+  for (size_t i = 0; i < arraysize(kTargets); ++i)
+    RunDecodeBenchmark(encoded, kTargets[i][0], kTargets[i][1]);
+}
+
+}  // namespace gfx
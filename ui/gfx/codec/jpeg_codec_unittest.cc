@@ -7,6 +7,7 @@
 #include "base/basictypes.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "ui/gfx/codec/jpeg_codec.h"
+#include "ui/gfx/rect.h"
 
 namespace {
 
@@ -197,6 +198,95 @@ TEST(JPEGCodec, DecodeCorrupted) {
                                  &outw, &outh));
 }
 
+TEST(JPEGCodec, DecodeScaled) {
+  int w = 101, h = 67;
+
+  std::vector<unsigned char> original;
+  MakeRGBImage(w, h, &original);
+  std::vector<unsigned char> encoded;
+  ASSERT_TRUE(JPEGCodec::Encode(&original[0], JPEGCodec::FORMAT_RGB, w, h,
+                                w * 3, jpeg_quality, &encoded));
+
+  // Each case lists the requested minimum size and the expected output size.
+  // Scaled dimensions are rounded up, and the scale never goes below 1/8.
+  const struct {
+    int min_w, min_h;
+    int expected_w, expected_h;
+  } kCases[] = {
+    { 101, 67, 101, 67 },
+    { 200, 200, 101, 67 },
+    { 51, 34, 51, 34 },
+    { 52, 34, 101, 67 },
+    { 26, 17, 26, 17 },
+    { 13, 9, 13, 9 },
+    { 1, 1, 13, 9 },
+  };
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    std::vector<unsigned char> decoded;
+    int outw, outh;
+    ASSERT_TRUE(JPEGCodec::DecodeScaled(&encoded[0], encoded.size(),
+                                        JPEGCodec::FORMAT_RGB,
+                                        kCases[i].min_w, kCases[i].min_h,
+                                        NULL, &decoded, &outw, &outh));
+    EXPECT_EQ(kCases[i].expected_w, outw) << i;
+    EXPECT_EQ(kCases[i].expected_h, outh) << i;
+    EXPECT_EQ(static_cast<size_t>(outw * outh * 3), decoded.size()) << i;
+  }
+}
+
+TEST(JPEGCodec, DecodeScaledAndCropped) {
+  int w = 160, h = 120;
+
+  std::vector<unsigned char> original;
+  MakeRGBImage(w, h, &original);
+  std::vector<unsigned char> encoded;
+  ASSERT_TRUE(JPEGCodec::Encode(&original[0], JPEGCodec::FORMAT_RGB, w, h,
+                                w * 3, jpeg_quality, &encoded));
+
+  // Decode the whole image at half size for reference.
+  std::vector<unsigned char> full;
+  int fullw, fullh;
+  ASSERT_TRUE(JPEGCodec::DecodeScaled(&encoded[0], encoded.size(),
+                                      JPEGCodec::FORMAT_RGBA, 80, 60, NULL,
+                                      &full, &fullw, &fullh));
+  ASSERT_EQ(80, fullw);
+  ASSERT_EQ(60, fullh);
+
+  // The crop rectangle is given in full size coordinates and is rounded
+  // outwards: (21, 11) - (121, 71) becomes (10, 5) - (61, 36) at half size.
+  Rect crop(21, 11, 100, 60);
+  std::vector<unsigned char> cropped;
+  int outw, outh;
+  ASSERT_TRUE(JPEGCodec::DecodeScaled(&encoded[0], encoded.size(),
+                                      JPEGCodec::FORMAT_RGBA, 80, 60, &crop,
+                                      &cropped, &outw, &outh));
+  ASSERT_EQ(51, outw);
+  ASSERT_EQ(31, outh);
+  ASSERT_EQ(static_cast<size_t>(outw * outh * 4), cropped.size());
+  for (int y = 0; y < outh; y++) {
+    std::vector<unsigned char> expected_row(
+        full.begin() + ((y + 5) * fullw + 10) * 4,
+        full.begin() + ((y + 5) * fullw + 10 + outw) * 4);
+    std::vector<unsigned char> row(cropped.begin() + y * outw * 4,
+                                   cropped.begin() + (y + 1) * outw * 4);
+    ASSERT_EQ(expected_row, row) << "row " << y;
+  }
+
+  // A region partly outside the image is clipped to it.
+  Rect overhanging(100, 90, 100, 100);
+  ASSERT_TRUE(JPEGCodec::DecodeScaled(&encoded[0], encoded.size(),
+                                      JPEGCodec::FORMAT_RGBA, w, h,
+                                      &overhanging, &cropped, &outw, &outh));
+  EXPECT_EQ(60, outw);
+  EXPECT_EQ(30, outh);
+
+  // A region completely outside the image can't be decoded.
+  Rect outside(w, 0, 10, 10);
+  EXPECT_FALSE(JPEGCodec::DecodeScaled(&encoded[0], encoded.size(),
+                                       JPEGCodec::FORMAT_RGBA, w, h,
+                                       &outside, &cropped, &outw, &outh));
+}
+
 // Test that we can decode JPEG images without invalid-read errors on valgrind.
 // This test decodes a 1x1 JPEG image and writes the decoded RGB (or RGBA) pixel
 // to the output buffer without OOB reads.
@@ -6,6 +6,7 @@
 
 #include "base/logging.h"
 #include "base/strings/string_util.h"
+#include "build/build_config.h"
 #include "third_party/libpng/png.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColorPriv.h"
@@ -567,6 +568,70 @@ class CommentWriter {
 typedef void (*FormatConverter)(const unsigned char* in, int w,
                                 unsigned char* out, bool* is_opaque);
 
+// zlib and row filter settings for the encoder.
+struct EncoderSettings {
+  int compression_level;
+  int compression_strategy;
+  // One of the PNG_FILTER_* values, or 0 to let libpng pick a filter for each
+  // row adaptively.
+  int filters;
+};
+
+const EncoderSettings kDefaultEncoderSettings = {
+  Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY, 0
+};
+
+// Screenshots and UI images are mostly flat areas and repeated glyphs. The
+// SUB filter turns flat areas into runs of zeros, so trying every filter on
+// each row buys little, and zlib's fastest level still finds the repeats.
+// (Z_RLE is slightly faster again, but can't match repeated glyphs and easily
+// produces files several times larger.)
+const EncoderSettings kFastEncoderSettings = {
+  Z_BEST_SPEED, Z_DEFAULT_STRATEGY, PNG_FILTER_SUB
+};
+
+// Pixel transforms libpng applies to each input row as it copies it into its
+// own row buffer, which lets us hand it rows without converting them first.
+enum RowTransform {
+  ROW_TRANSFORM_NONE = 0,
+  // Input is BGR(A), swap it to RGB(A).
+  ROW_TRANSFORM_SWAP_RED_BLUE = 1 << 0,
+  // Input has a fourth byte per pixel which is dropped.
+  ROW_TRANSFORM_STRIP_FILLER = 1 << 1
+};
+
+#if defined(PNG_WRITE_BGR_SUPPORTED) && defined(PNG_WRITE_FILLER_SUPPORTED)
+const bool kCanTransformRows = true;
+#else
+const bool kCanTransformRows = false;
+#endif
+
+// Returns true if the Skia pixels in |input| are stored as RGBA or BGRA bytes
+// and none of them is partially transparent, in which case the premultiplied
+// data is identical to its unpremultiplied form and can be written directly.
+bool IsSkiaDataWritableAsIs(const unsigned char* input,
+                            const Size& size,
+                            int row_byte_width) {
+#if defined(ARCH_CPU_LITTLE_ENDIAN)
+  if (!kCanTransformRows || SK_A32_SHIFT != 24 ||
+      (SK_R32_SHIFT != 0 && SK_B32_SHIFT != 0)) {
+    return false;
+  }
+  for (int y = 0; y < size.height(); y++) {
+    const uint32_t* row =
+        reinterpret_cast<const uint32_t*>(&input[y * row_byte_width]);
+    for (int x = 0; x < size.width(); x++) {
+      int alpha = SkGetPackedA32(row[x]);
+      if (alpha != 0 && alpha != 255)
+        return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 // libpng uses a wacky setjmp-based API, which makes the compiler nervous.
 // We constrain all of the calls we make to libpng where the setjmp() is in
 // place to this function.
@@ -574,9 +639,10 @@ typedef void (*FormatConverter)(const unsigned char* in, int w,
 bool DoLibpngWrite(png_struct* png_ptr, png_info* info_ptr,
                    PngEncoderState* state,
                    int width, int height, int row_byte_width,
-                   const unsigned char* input, int compression_level,
+                   const unsigned char* input,
+                   const EncoderSettings& settings,
                    int png_output_color_type, int output_color_components,
-                   FormatConverter converter,
+                   FormatConverter converter, int row_transforms,
                    const std::vector<PNGCodec::Comment>& comments) {
 #ifdef PNG_TEXT_SUPPORTED
   CommentWriter comment_writer(comments);
@@ -591,7 +657,10 @@ bool DoLibpngWrite(png_struct* png_ptr, png_info* info_ptr,
     return false;
   }
 
-  png_set_compression_level(png_ptr, compression_level);
+  png_set_compression_level(png_ptr, settings.compression_level);
+  png_set_compression_strategy(png_ptr, settings.compression_strategy);
+  if (settings.filters)
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, settings.filters);
 
   // Set our callback for libpng to give us the data.
   png_set_write_fn(png_ptr, state, EncoderWriteCallback, FakeFlushCallback);
@@ -610,8 +679,18 @@ bool DoLibpngWrite(png_struct* png_ptr, png_info* info_ptr,
 
   png_write_info(png_ptr, info_ptr);
 
+#if defined(PNG_WRITE_BGR_SUPPORTED) && defined(PNG_WRITE_FILLER_SUPPORTED)
+  if (row_transforms & ROW_TRANSFORM_SWAP_RED_BLUE)
+    png_set_bgr(png_ptr);
+  if (row_transforms & ROW_TRANSFORM_STRIP_FILLER)
+    png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+  DCHECK(!row_transforms);
+#endif
+
   if (!converter) {
-    // No conversion needed, give the data directly to libpng.
+    // No conversion needed (or libpng does it for us), give the data directly
+    // to libpng.
     for (int y = 0; y < height; y ++) {
       png_write_row(png_ptr,
                     const_cast<unsigned char*>(&input[y * row_byte_width]));
@@ -630,17 +709,19 @@ bool DoLibpngWrite(png_struct* png_ptr, png_info* info_ptr,
   return true;
 }
 
-bool EncodeWithCompressionLevel(const unsigned char* input,
-                                PNGCodec::ColorFormat format,
-                                const Size& size,
-                                int row_byte_width,
-                                bool discard_transparency,
-                                const std::vector<PNGCodec::Comment>& comments,
-                                int compression_level,
-                                std::vector<unsigned char>* output) {
+bool EncodeWithSettings(const unsigned char* input,
+                        PNGCodec::ColorFormat format,
+                        const Size& size,
+                        int row_byte_width,
+                        bool discard_transparency,
+                        const std::vector<PNGCodec::Comment>& comments,
+                        const EncoderSettings& settings,
+                        std::vector<unsigned char>* output) {
   // Run to convert an input row into the output row format, NULL means no
   // conversion is necessary.
   FormatConverter converter = NULL;
+  // RowTransform flags for libpng to apply instead of |converter|.
+  int row_transforms = ROW_TRANSFORM_NONE;
 
   int input_color_components, output_color_components;
   int png_output_color_type;
@@ -656,7 +737,10 @@ bool EncodeWithCompressionLevel(const unsigned char* input,
       if (discard_transparency) {
         output_color_components = 3;
         png_output_color_type = PNG_COLOR_TYPE_RGB;
-        converter = ConvertRGBAtoRGB;
+        if (kCanTransformRows)
+          row_transforms = ROW_TRANSFORM_STRIP_FILLER;
+        else
+          converter = ConvertRGBAtoRGB;
       } else {
         output_color_components = 4;
         png_output_color_type = PNG_COLOR_TYPE_RGB_ALPHA;
@@ -669,11 +753,19 @@ bool EncodeWithCompressionLevel(const unsigned char* input,
       if (discard_transparency) {
         output_color_components = 3;
         png_output_color_type = PNG_COLOR_TYPE_RGB;
-        converter = ConvertBGRAtoRGB;
+        if (kCanTransformRows) {
+          row_transforms =
+              ROW_TRANSFORM_SWAP_RED_BLUE | ROW_TRANSFORM_STRIP_FILLER;
+        } else {
+          converter = ConvertBGRAtoRGB;
+        }
       } else {
         output_color_components = 4;
         png_output_color_type = PNG_COLOR_TYPE_RGB_ALPHA;
-        converter = ConvertBetweenBGRAandRGBA;
+        if (kCanTransformRows)
+          row_transforms = ROW_TRANSFORM_SWAP_RED_BLUE;
+        else
+          converter = ConvertBetweenBGRAandRGBA;
       }
       break;
 
@@ -701,6 +793,16 @@ bool EncodeWithCompressionLevel(const unsigned char* input,
           png_output_color_type = PNG_COLOR_TYPE_RGB_ALPHA;
           converter = ConvertSkiatoRGBA;
         }
+        // Only partially transparent pixels need to be unpremultiplied, and
+        // screenshots rarely have any. Otherwise let libpng reorder the
+        // channels as it copies each row.
+        if (IsSkiaDataWritableAsIs(input, size, row_byte_width)) {
+          converter = NULL;
+          if (SK_B32_SHIFT == 0)
+            row_transforms |= ROW_TRANSFORM_SWAP_RED_BLUE;
+          if (discard_transparency)
+            row_transforms |= ROW_TRANSFORM_STRIP_FILLER;
+        }
       }
       break;
 
@@ -727,15 +829,16 @@ bool EncodeWithCompressionLevel(const unsigned char* input,
   PngEncoderState state(output);
   bool success = DoLibpngWrite(png_ptr, info_ptr, &state,
                                size.width(), size.height(), row_byte_width,
-                               input, compression_level, png_output_color_type,
-                               output_color_components, converter, comments);
+                               input, settings, png_output_color_type,
+                               output_color_components, converter,
+                               row_transforms, comments);
 
   return success;
 }
 
 bool InternalEncodeSkBitmap(const SkBitmap& input,
                             bool discard_transparency,
-                            int compression_level,
+                            const EncoderSettings& settings,
                             std::vector<unsigned char>* output) {
   if (input.empty() || input.isNull())
     return false;
@@ -746,14 +849,14 @@ bool InternalEncodeSkBitmap(const SkBitmap& input,
   unsigned char* inputAddr = bpp == 1 ?
       reinterpret_cast<unsigned char*>(input.getAddr8(0, 0)) :
       reinterpret_cast<unsigned char*>(input.getAddr32(0, 0));    // bpp = 4
-  return EncodeWithCompressionLevel(
+  return EncodeWithSettings(
       inputAddr,
       PNGCodec::FORMAT_SkBitmap,
       Size(input.width(), input.height()),
       static_cast<int>(input.rowBytes()),
       discard_transparency,
       std::vector<PNGCodec::Comment>(),
-      compression_level,
+      settings,
       output);
 }
 
@@ -768,14 +871,31 @@ bool PNGCodec::Encode(const unsigned char* input,
                       bool discard_transparency,
                       const std::vector<Comment>& comments,
                       std::vector<unsigned char>* output) {
-  return EncodeWithCompressionLevel(input,
-                                    format,
-                                    size,
-                                    row_byte_width,
-                                    discard_transparency,
-                                    comments,
-                                    Z_DEFAULT_COMPRESSION,
-                                    output);
+  return EncodeWithSettings(input,
+                            format,
+                            size,
+                            row_byte_width,
+                            discard_transparency,
+                            comments,
+                            kDefaultEncoderSettings,
+                            output);
+}
+
+// static
+bool PNGCodec::FastEncode(const unsigned char* input,
+                          ColorFormat format,
+                          const Size& size,
+                          int row_byte_width,
+                          bool discard_transparency,
+                          std::vector<unsigned char>* output) {
+  return EncodeWithSettings(input,
+                            format,
+                            size,
+                            row_byte_width,
+                            discard_transparency,
+                            std::vector<Comment>(),
+                            kFastEncoderSettings,
+                            output);
 }
 
 // static
@@ -784,7 +904,7 @@ bool PNGCodec::EncodeBGRASkBitmap(const SkBitmap& input,
                                   std::vector<unsigned char>* output) {
   return InternalEncodeSkBitmap(input,
                                 discard_transparency,
-                                Z_DEFAULT_COMPRESSION,
+                                kDefaultEncoderSettings,
                                 output);
 }
 
@@ -793,7 +913,7 @@ bool PNGCodec::EncodeA8SkBitmap(const SkBitmap& input,
                                 std::vector<unsigned char>* output) {
   return InternalEncodeSkBitmap(input,
                                 false,
-                                Z_DEFAULT_COMPRESSION,
+                                kDefaultEncoderSettings,
                                 output);
 }
 
@@ -803,7 +923,7 @@ bool PNGCodec::FastEncodeBGRASkBitmap(const SkBitmap& input,
                                       std::vector<unsigned char>* output) {
   return InternalEncodeSkBitmap(input,
                                 discard_transparency,
-                                Z_BEST_SPEED,
+                                kFastEncoderSettings,
                                 output);
 }
 
@@ -78,6 +78,17 @@ class GFX_EXPORT PNGCodec {
                      const std::vector<Comment>& comments,
                      std::vector<unsigned char>* output);
 
+  // Like Encode() above, but trades compression ratio for speed: every row is
+  // written with the same (SUB) filter instead of the best one for that row,
+  // and compressed at zlib's fastest level. For screenshots and other UI
+  // images this is several times faster, at a similar size.
+  static bool FastEncode(const unsigned char* input,
+                         ColorFormat format,
+                         const Size& size,
+                         int row_byte_width,
+                         bool discard_transparency,
+                         std::vector<unsigned char>* output);
+
   // Call PNGCodec::Encode on the supplied SkBitmap |input|, which is assumed
   // to be kARGB_8888_Config, 32 bits per pixel. The params
   // |discard_transparency| and |output| are passed directly to Encode; refer to
@@ -87,9 +98,8 @@ class GFX_EXPORT PNGCodec {
                                  bool discard_transparency,
                                  std::vector<unsigned char>* output);
 
-  // Call PNGCodec::Encode on the supplied SkBitmap |input|. The difference
-  // between this and the previous method is that this restricts compression to
-  // zlib q1, which is just rle encoding.
+  // Call PNGCodec::FastEncode on the supplied SkBitmap |input|. Otherwise the
+  // same as EncodeBGRASkBitmap().
   static bool FastEncodeBGRASkBitmap(const SkBitmap& input,
                                      bool discard_transparency,
                                      std::vector<unsigned char>* output);
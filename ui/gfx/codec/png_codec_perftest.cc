@@ -0,0 +1,87 @@
+// Copyright 2014 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the default and fast PNG encoders on screenshot and thumbnail
+// sized images, reporting the time per encode and the encoded size.
+
+#include <vector>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkColorPriv.h"
+#include "ui/gfx/codec/png_codec.h"
+
+namespace gfx {
+
+namespace {
+
+const int kIterations = 10;
+
+// Approximates a screenshot of a web page: flat backgrounds and toolbars,
+// rows of "text" and a photo-like gradient.
+void MakeScreenshotBitmap(int w, int h, SkBitmap* bitmap) {
+  bitmap->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+  bitmap->allocPixels();
+  for (int y = 0; y < h; y++) {
+    uint32_t* row = bitmap->getAddr32(0, y);
+    for (int x = 0; x < w; x++) {
+      if (y < h / 10) {
+        // Toolbar.
+        row[x] = SkPackARGB32(255, 0xe0, 0xe4, 0xe8);
+      } else if (x > w / 2 && y > h / 2) {
+        // Image.
+        row[x] = SkPackARGB32(255, x * 255 / w, y * 255 / h,
+                              (x * y) & 0xff);
+      } else if ((y / 4) % 5 < 3 && ((x * 7) / 5 + y) % 9 < 4) {
+        // Text.
+        row[x] = SkPackARGB32(255, 0x20, 0x20, 0x20);
+      } else {
+        row[x] = SkPackARGB32(255, 0xff, 0xff, 0xff);
+      }
+    }
+  }
+}
+
+void RunEncodeBenchmark(const char* trace, int w, int h) {
+  SkBitmap bitmap;
+  MakeScreenshotBitmap(w, h, &bitmap);
+
+  std::vector<unsigned char> encoded;
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(PNGCodec::EncodeBGRASkBitmap(bitmap, true, &encoded));
+  base::TimeDelta default_time = base::TimeTicks::HighResNow() - start;
+  size_t default_bytes = encoded.size();
+
+  start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(PNGCodec::FastEncodeBGRASkBitmap(bitmap, true, &encoded));
+  base::TimeDelta fast_time = base::TimeTicks::HighResNow() - start;
+  size_t fast_bytes = encoded.size();
+
+  perf_test::PrintResult("png_encode", "_default", trace,
+                         default_time.InMillisecondsF() / kIterations, "ms",
+                         true);
+  perf_test::PrintResult("png_encode", "_fast", trace,
+                         fast_time.InMillisecondsF() / kIterations, "ms",
+                         true);
+  perf_test::PrintResult("png_encoded_size", "_default", trace,
+                         default_bytes, "bytes", true);
+  perf_test::PrintResult("png_encoded_size", "_fast", trace,
+                         fast_bytes, "bytes", true);
+}
+
+}  // namespace
+
+TEST(PNGCodecPerfTest, EncodeScreenshot) {
+  RunEncodeBenchmark("1280x800", 1280, 800);
+}
+
+TEST(PNGCodecPerfTest, EncodeThumbnail) {
+  RunEncodeBenchmark("212x132", 212, 132);
+}
+
+}  // namespace gfx
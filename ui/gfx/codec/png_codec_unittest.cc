@@ -1186,5 +1186,119 @@ TEST(PNGCodec, EncodeDecodeWithVaryingCompressionLevels) {
   EXPECT_TRUE(BitmapsAreEqual(decoded, original_bitmap));
 }
 
+TEST(PNGCodec, FastEncodeMatchesEncode) {
+  const int w = 20, h = 20;
+
+  std::vector<unsigned char> rgb, rgba, bgra;
+  MakeRGBImage(w, h, &rgb);
+  MakeRGBAImage(w, h, true, &rgba);
+  bgra.resize(rgba.size());
+  for (size_t i = 0; i < rgba.size(); i += 4) {
+    bgra[i + 0] = rgba[i + 2];
+    bgra[i + 1] = rgba[i + 1];
+    bgra[i + 2] = rgba[i + 0];
+    bgra[i + 3] = rgba[i + 3];
+  }
+
+  const struct {
+    const std::vector<unsigned char>* input;
+    PNGCodec::ColorFormat format;
+    int bytes_per_pixel;
+    bool discard_transparency;
+  } kCases[] = {
+    { &rgb, PNGCodec::FORMAT_RGB, 3, false },
+    { &rgba, PNGCodec::FORMAT_RGBA, 4, false },
+    { &rgba, PNGCodec::FORMAT_RGBA, 4, true },
+    { &bgra, PNGCodec::FORMAT_BGRA, 4, false },
+    { &bgra, PNGCodec::FORMAT_BGRA, 4, true },
+  };
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    const std::vector<unsigned char>& input = *kCases[i].input;
+    std::vector<unsigned char> encoded, encoded_fast;
+    ASSERT_TRUE(PNGCodec::Encode(&input[0], kCases[i].format, Size(w, h),
+                                 w * kCases[i].bytes_per_pixel,
+                                 kCases[i].discard_transparency,
+                                 std::vector<PNGCodec::Comment>(),
+                                 &encoded));
+    ASSERT_TRUE(PNGCodec::FastEncode(&input[0], kCases[i].format, Size(w, h),
+                                     w * kCases[i].bytes_per_pixel,
+                                     kCases[i].discard_transparency,
+                                     &encoded_fast));
+
+    // Both must decode to the same pixels.
+    std::vector<unsigned char> decoded, decoded_fast;
+    int outw, outh;
+    ASSERT_TRUE(PNGCodec::Decode(&encoded[0], encoded.size(),
+                                 PNGCodec::FORMAT_RGBA, &decoded,
+                                 &outw, &outh));
+    ASSERT_TRUE(PNGCodec::Decode(&encoded_fast[0], encoded_fast.size(),
+                                 PNGCodec::FORMAT_RGBA, &decoded_fast,
+                                 &outw, &outh));
+    ASSERT_EQ(w, outw);
+    ASSERT_EQ(h, outh);
+    EXPECT_TRUE(decoded == decoded_fast) << i;
+
+    // And the pixels must be the ones we started with.
+    if (kCases[i].format == PNGCodec::FORMAT_RGB ||
+        kCases[i].discard_transparency) {
+      std::vector<unsigned char> opaque_rgba;
+      MakeRGBAImage(w, h, false, &opaque_rgba);
+      EXPECT_TRUE(decoded == opaque_rgba) << i;
+    } else {
+      EXPECT_TRUE(decoded == rgba) << i;
+    }
+  }
+}
+
+// Bitmaps without partially transparent pixels are written without
+// unpremultiplying them first; make sure the channels still end up in the
+// right place.
+TEST(PNGCodec, EncodeBGRASkBitmapWithoutPartialTransparency) {
+  const int w = 20, h = 20;
+
+  SkBitmap original_bitmap;
+  original_bitmap.setConfig(SkBitmap::kARGB_8888_Config, w, h);
+  original_bitmap.allocPixels();
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      // Fully transparent pixels are all zero once premultiplied.
+      *original_bitmap.getAddr32(x, y) = (x + y) % 7 == 0 ?
+          SkPackARGB32(0, 0, 0, 0) :
+          SkPackARGB32(255, x * 12, y * 12, (x + y) * 6);
+    }
+  }
+
+  for (int discard_transparency = 0; discard_transparency < 2;
+       ++discard_transparency) {
+    std::vector<unsigned char> encoded, encoded_fast;
+    ASSERT_TRUE(PNGCodec::EncodeBGRASkBitmap(
+        original_bitmap, discard_transparency != 0, &encoded));
+    ASSERT_TRUE(PNGCodec::FastEncodeBGRASkBitmap(
+        original_bitmap, discard_transparency != 0, &encoded_fast));
+
+    std::vector<unsigned char> decoded, decoded_fast;
+    int outw, outh;
+    ASSERT_TRUE(PNGCodec::Decode(&encoded[0], encoded.size(),
+                                 PNGCodec::FORMAT_RGBA, &decoded,
+                                 &outw, &outh));
+    ASSERT_TRUE(PNGCodec::Decode(&encoded_fast[0], encoded_fast.size(),
+                                 PNGCodec::FORMAT_RGBA, &decoded_fast,
+                                 &outw, &outh));
+    EXPECT_TRUE(decoded == decoded_fast);
+
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        uint32_t original_pixel = *original_bitmap.getAddr32(x, y);
+        const unsigned char* decoded_pixel = &decoded[(y * w + x) * 4];
+        EXPECT_EQ(SkGetPackedR32(original_pixel), decoded_pixel[0]);
+        EXPECT_EQ(SkGetPackedG32(original_pixel), decoded_pixel[1]);
+        EXPECT_EQ(SkGetPackedB32(original_pixel), decoded_pixel[2]);
+        EXPECT_EQ(discard_transparency ?
+                      255u : SkGetPackedA32(original_pixel),
+                  decoded_pixel[3]);
+      }
+    }
+  }
+}
 
 }  // namespace gfx